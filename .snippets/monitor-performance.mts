@@ -1,4 +1,7 @@
-import { startSession, AudioQuality } from "pw-client";
+import { startSession, AudioQuality, AudioFormat } from "pw-client";
+import { writeFile } from "node:fs/promises";
+import { tmpdir } from "node:os";
+import { join } from "node:path";
 
 // SNIPSTART basic-monitoring
 console.log("📊 Basic Performance Monitoring Example:");
@@ -292,3 +295,163 @@ for (const quality of [
   console.log(); // Blank line between tests
 }
 // SNIPEND memory-monitoring
+
+console.log();
+
+// SNIPSTART stream-stats
+console.log("🩺 Stream Statistics Example:");
+
+async function streamStatsExample() {
+  await using session = await startSession();
+  await using stream = await session.createAudioOutputStream({
+    name: "Stream Stats",
+    channels: 2,
+    enableMonitoring: { intervalMs: 500 },
+  });
+
+  stream.on("stats", (stats) => {
+    console.log(
+      `underruns=${stats.underruns} zeroFilled=${stats.zeroFilledFrames} ` +
+        `fill=${(stats.fillRatio * 100).toFixed(1)}% ` +
+        `callback=${stats.meanCallbackMs.toFixed(3)}ms ` +
+        `(max ${stats.maxCallbackMs.toFixed(3)}ms)`
+    );
+  });
+
+  await stream.connect();
+
+  // Write in bursts with a stall in between to provoke one underrun
+  const burst = new Float64Array(stream.rate * stream.channels).map(
+    (_, i) => Math.sin(i * 0.02) * 0.1
+  );
+  await stream.writeFrames(burst);
+  await new Promise((resolve) => setTimeout(resolve, 1500));
+  await stream.writeFrames(burst);
+  await stream.isFinished();
+
+  const { underruns, dequeueFailures, slowCycles } = stream.stats;
+  console.log({ underruns, dequeueFailures, slowCycles });
+}
+
+await streamStatsExample();
+// SNIPEND stream-stats
+
+// SNIPSTART render-in-place
+console.log("🧱 Render In Place Example:");
+
+async function renderInPlaceExample() {
+  await using session = await startSession();
+  await using stream = await session.createAudioOutputStream({
+    name: "Render In Place",
+    channels: 2,
+    inputFormat: AudioFormat.Float32,
+  });
+  await stream.connect();
+
+  const { channels, rate } = stream;
+  const totalFrames = rate * 2;
+  let phase = 0;
+
+  for (let rendered = 0; rendered < totalFrames; ) {
+    await stream.waitForBuffer();
+
+    // A view of the stream's own buffer: no allocation, no copy on commit
+    const block = stream.acquireBuffer(stream.framesPerQuantum);
+    for (let i = 0; i < block.length; i += channels) {
+      const sample = Math.sin(phase) * 0.1;
+      phase += (2 * Math.PI * 440) / rate;
+      block.fill(sample, i, i + channels);
+    }
+    stream.commit(block);
+    rendered += block.length / channels;
+  }
+
+  await stream.isFinished();
+  console.log(`Rendered ${totalFrames} frames in place`);
+}
+
+await renderInPlaceExample();
+// SNIPEND render-in-place
+
+// SNIPSTART playback-timing
+console.log("⏱️ Playback Timing Example:");
+
+async function playbackTimingExample() {
+  await using session = await startSession();
+  await using stream = await session.createAudioOutputStream({
+    name: "Playback Timing",
+    channels: 2,
+  });
+  await stream.connect();
+
+  const tone = new Float64Array(stream.rate * stream.channels).map(
+    (_, i) => Math.sin(i * 0.02) * 0.1
+  );
+  const writing = stream.writeFrames(tone);
+
+  for (let i = 0; i < 5; i++) {
+    await new Promise((resolve) => setTimeout(resolve, 200));
+    const timing = stream.timing;
+    if (!timing) continue;
+
+    // Both clocks are CLOCK_MONOTONIC on Linux
+    const now = Number(process.hrtime.bigint());
+    const untilHeardMs = (timing.nextFramePresentationNs - now) / 1e6;
+    console.log(
+      `played=${timing.playedFrames} ` +
+        `latency=${(timing.latencyNs / 1e6).toFixed(2)}ms ` +
+        `next write heard in ${untilHeardMs.toFixed(2)}ms`
+    );
+  }
+
+  await writing;
+  await stream.isFinished();
+}
+
+await playbackTimingExample();
+// SNIPEND playback-timing
+
+// SNIPSTART trace-export
+console.log("🔬 Trace Export Example:");
+
+async function traceExportExample() {
+  await using session = await startSession();
+  await using stream = await session.createAudioOutputStream({
+    name: "Traced Stream",
+    channels: 2,
+    trace: { capacity: 16_384 },
+  });
+  await stream.connect();
+
+  const tone = new Float64Array(stream.rate * stream.channels).map(
+    (_, i) => Math.sin(i * 0.02) * 0.1
+  );
+  const writing = stream.writeFrames(tone);
+
+  // Block the event loop for 150ms to provoke a gap
+  await new Promise((resolve) => setTimeout(resolve, 300));
+  const blockedUntil = Date.now() + 150;
+  while (Date.now() < blockedUntil);
+
+  await writing;
+  await stream.isFinished();
+
+  const trace = stream.readTrace()!;
+  const bad = trace.events.filter((event) => event.underrun || event.slow);
+  console.log(`${trace.events.length} events, ${bad.length} bad cycles`);
+  for (const event of bad) {
+    console.log(
+      `${event.underrun ? "underrun" : "slow"} cycle at ` +
+        `${(event.startNs / 1e6).toFixed(3)}ms: ` +
+        `${event.producedFrames}/${event.requestedFrames} frames, ` +
+        `${event.queuedFrames} queued`
+    );
+  }
+
+  const path = join(tmpdir(), "stream-trace.json");
+  await writeFile(path, JSON.stringify(stream.exportTrace()));
+  console.log(`Open ${path} in https://ui.perfetto.dev`);
+}
+
+await traceExportExample();
+// SNIPEND trace-export
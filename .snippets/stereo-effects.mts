@@ -159,4 +159,23 @@ await stream.write(
 );
 // SNIPEND stereo-delay-effects
 
+// SNIPSTART planar-channels
+console.log("🎚️ Per-Channel Planes Demo");
+
+// Render each channel into its own array; the stream interleaves natively
+function renderPlanes(frequency: number, duration: number) {
+  const frames = Math.floor(stream.rate * duration);
+  const left = new Float64Array(frames);
+  const right = new Float64Array(frames);
+  for (let i = 0; i < frames; i++) {
+    const phase = (2 * Math.PI * frequency * i) / stream.rate;
+    left[i] = Math.sin(phase) * 0.2;
+    right[i] = Math.sin(phase * 1.5) * 0.2; // A fifth above
+  }
+  return [left, right];
+}
+
+await stream.writePlanar(renderPlanes(330, 2.0));
+// SNIPEND planar-channels
+
 console.log("✅ Channel interleaving and panning mathematics demo complete!");
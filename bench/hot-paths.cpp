@@ -0,0 +1,534 @@
+// Microbenchmarks for the code PipeWire's RT thread runs every quantum.
+//
+// Built only by `npm run bench:build`. It needs neither Node nor a PipeWire
+// daemon: the "sink" is a loop that drains the ring exactly the way
+// AudioOutputStream::readSource() and mixBuffer() do, so the numbers track
+// the ring, conversion and mixing code that fillBuffer() is made of.
+//
+// Usage: hot-paths [--json] [--filter <substring>]
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+#include "effect-chain.hpp"
+#include "file-source.hpp"
+#include "level-meter.hpp"
+#include "mixer.hpp"
+#include "oscillator.hpp"
+#include "planar.hpp"
+#include "resampler.hpp"
+#include "ring-buffer.hpp"
+#include "sample-convert.hpp"
+#include "stream-stats.hpp"
+#include "trace-ring.hpp"
+
+#define BENCH_CHANNELS 2
+#define BENCH_MIN_NS 200000000 // Run each case for at least 0.2s
+
+// Every heap allocation in the process is counted, so a case can report how
+// many happened while it ran; the RT paths must stay at zero
+static std::atomic<uint64_t> allocations(0);
+
+// The replacements hand out malloc() memory on purpose, so GCC's pairing of
+// operator new with free() is a false alarm here
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void* operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+#pragma GCC diagnostic pop
+
+namespace {
+
+struct Result {
+    std::string name;
+    double nsPerFrame;
+    double nsPerCall;
+    double allocationsPerQuantum;
+};
+
+struct Options {
+    bool json = false;
+    const char* filter = NULL;
+};
+
+std::vector<Result> results;
+Options options;
+
+bool selected(const std::string& name)
+{
+    return !options.filter || name.find(options.filter) != std::string::npos;
+}
+
+// Runs body(), which moves `frames` frames per call, until BENCH_MIN_NS have
+// passed; a warm-up pass keeps page faults and lazy init out of the numbers
+template <typename Body>
+void measure(const std::string& name, uint32_t frames, uint32_t quantum, Body body)
+{
+    if (!selected(name)) {
+        return;
+    }
+
+    for (int i = 0; i < 64; i++) {
+        body();
+    }
+
+    uint64_t calls = 0;
+    auto allocationsBefore = allocations.load(std::memory_order_relaxed);
+    auto started = steadyNanos();
+    int64_t elapsed;
+    do {
+        for (int i = 0; i < 256; i++) {
+            body();
+        }
+        calls += 256;
+        elapsed = steadyNanos() - started;
+    } while (elapsed < BENCH_MIN_NS);
+    auto allocated = allocations.load(std::memory_order_relaxed) - allocationsBefore;
+
+    auto totalFrames = (double)calls * frames;
+    results.push_back({
+        name,
+        elapsed / totalFrames,
+        (double)elapsed / calls,
+        allocated / (totalFrames / quantum),
+    });
+}
+
+std::vector<float> testSignal(size_t samples)
+{
+    std::vector<float> signal(samples);
+    for (size_t i = 0; i < samples; i++) {
+        signal[i] = 0.5f * std::sin(i * 0.01f);
+    }
+    return signal;
+}
+
+struct FormatCase {
+    const char* name;
+    spa_audio_format format;
+};
+
+const FormatCase outputFormats[] = {
+    { "u8", SPA_AUDIO_FORMAT_U8 },
+    { "s16", SPA_AUDIO_FORMAT_S16 },
+    { "s24_32", SPA_AUDIO_FORMAT_S24_32 },
+    { "s32", SPA_AUDIO_FORMAT_S32 },
+    { "f32", SPA_AUDIO_FORMAT_F32 },
+    { "f64", SPA_AUDIO_FORMAT_F64 },
+};
+
+void benchConversion()
+{
+    const uint32_t frames = 1024;
+    auto source = testSignal(frames * BENCH_CHANNELS);
+    std::vector<double> doubles(source.begin(), source.end());
+    std::vector<uint8_t> dest(frames * BENCH_CHANNELS * 8);
+
+    for (auto& output : outputFormats) {
+        for (auto dither : { false, true }) {
+            if (dither && SampleConverter::sampleSize(output.format) > 2) {
+                continue; // Dither only applies to 8/16-bit output
+            }
+
+            SampleConverter converter;
+            converter.configure(SPA_AUDIO_FORMAT_F32, output.format, dither);
+            measure(std::string("convert/f32-") + output.name + (dither ? "-dither" : ""), frames, frames, [&] {
+                converter.convert((const uint8_t*)source.data(), dest.data(), source.size());
+            });
+
+            converter.configure(SPA_AUDIO_FORMAT_F64, output.format, dither);
+            measure(std::string("convert/f64-") + output.name + (dither ? "-dither" : ""), frames, frames, [&] {
+                converter.convert((const uint8_t*)doubles.data(), dest.data(), doubles.size());
+            });
+        }
+    }
+}
+
+// One JS-side write() into the ring followed by as many RT-side quanta as it
+// fed; chunk sizes that don't divide the ring split the read spans
+void benchFill()
+{
+    const uint32_t stride = BENCH_CHANNELS * sizeof(float);
+    const uint32_t quanta[] = { 64, 256, 1024 };
+    const uint32_t chunks[] = { 1, 97, 256, 1024 };
+
+    for (auto quantum : quanta) {
+        for (auto chunk : chunks) {
+            RingBuffer ring;
+            ring.allocate((size_t)(quantum * 4 + chunk) * stride);
+
+            SampleConverter converter;
+            converter.configure(SPA_AUDIO_FORMAT_F32, SPA_AUDIO_FORMAT_S16, false);
+            auto source = testSignal((size_t)chunk * BENCH_CHANNELS);
+            std::vector<uint8_t> dest((size_t)quantum * BENCH_CHANNELS * 2);
+
+            auto name = "fill/q" + std::to_string(quantum) + "-chunk" + std::to_string(chunk);
+            measure(name, quantum, quantum, [&] {
+                while (ring.writable(ring.capacity()) >= (size_t)chunk * stride) {
+                    ring.write((const uint8_t*)source.data(), (size_t)chunk * stride, ring.capacity());
+                }
+
+                RingSpans spans;
+                auto output = dest.data();
+                auto read = ring.peek((size_t)quantum * stride, spans);
+                for (auto& span : spans.parts) {
+                    converter.convert(span.data, output, span.size / sizeof(float));
+                    output += span.size / stride * BENCH_CHANNELS * 2;
+                }
+                ring.skip(read);
+            });
+        }
+    }
+}
+
+// The native half of write(): copying a typed array's bytes into the ring
+void benchWrite()
+{
+    const uint32_t stride = BENCH_CHANNELS * sizeof(float);
+    const uint32_t sizes[] = { 1, 128, 1024 };
+
+    for (auto frames : sizes) {
+        RingBuffer ring;
+        ring.allocate((size_t)frames * stride * 4);
+        auto source = testSignal((size_t)frames * BENCH_CHANNELS);
+
+        measure("write/" + std::to_string(frames), frames, 256, [&] {
+            ring.write((const uint8_t*)source.data(), (size_t)frames * stride, ring.capacity());
+            ring.skip(ring.readable()); // Stand-in for the RT thread draining it
+        });
+    }
+}
+
+// writePlanar() interleaving into the ring, and fillPlanes() splitting a
+// rendered chunk into PipeWire's per-channel planes
+void benchPlanar()
+{
+    const uint32_t frames = 1024;
+    const uint32_t channelCounts[] = { 1, 2, 6 };
+    const uint32_t sampleSizes[] = { 2, 4, 8 };
+
+    for (auto channels : channelCounts) {
+        for (auto sampleSize : sampleSizes) {
+            std::vector<std::vector<uint8_t>> planeStorage(channels, std::vector<uint8_t>((size_t)frames * sampleSize));
+            std::vector<uint8_t*> planes;
+            for (auto& plane : planeStorage) {
+                planes.push_back(plane.data());
+            }
+            std::vector<uint8_t> interleaved((size_t)frames * channels * sampleSize);
+
+            auto suffix = std::to_string(channels) + "ch-" + std::to_string(sampleSize * 8) + "bit";
+            measure("planar/interleave-" + suffix, frames, 256, [&] {
+                interleave((const uint8_t* const*)planes.data(), interleaved.data(), channels, sampleSize, frames);
+            });
+            measure("planar/deinterleave-" + suffix, frames, 256, [&] {
+                deinterleave(interleaved.data(), planes.data(), channels, sampleSize, frames);
+            });
+        }
+    }
+}
+
+void benchResampler()
+{
+    const uint32_t quantum = 256;
+    const char* qualities[] = { "fast", "balanced", "best" };
+    const std::pair<uint32_t, uint32_t> conversions[] = { { 44100, 48000 }, { 48000, 44100 }, { 96000, 48000 } };
+
+    for (uint32_t quality = RESAMPLE_FAST; quality <= RESAMPLE_BEST; quality++) {
+        for (auto& [inputRate, outputRate] : conversions) {
+            Resampler resampler;
+            resampler.configure(inputRate, outputRate, BENCH_CHANNELS, quality, quantum);
+            auto source = testSignal((size_t)resampler.inputFramesFor(quantum) * 2 * BENCH_CHANNELS);
+            std::vector<float> output((size_t)quantum * BENCH_CHANNELS);
+
+            auto name = std::string("resample/") + qualities[quality] + "-" + std::to_string(inputRate) + "-" + std::to_string(outputRate);
+            measure(name, quantum, quantum, [&] {
+                auto needed = resampler.inputFramesFor(quantum);
+                memcpy(resampler.inputBuffer(), source.data(), (size_t)needed * BENCH_CHANNELS * sizeof(float));
+                resampler.commitInput(needed);
+                resampler.process(output.data(), quantum);
+            });
+        }
+    }
+}
+
+void benchGenerators()
+{
+    const uint32_t quantum = 256;
+    const std::pair<const char*, uint32_t> waveforms[] = {
+        { "sine", WAVEFORM_SINE },
+        { "square", WAVEFORM_SQUARE },
+        { "sawtooth", WAVEFORM_SAWTOOTH },
+        { "triangle", WAVEFORM_TRIANGLE },
+        { "white-noise", WAVEFORM_WHITE_NOISE },
+        { "pink-noise", WAVEFORM_PINK_NOISE },
+    };
+
+    for (auto& [name, waveform] : waveforms) {
+        Oscillator oscillator;
+        oscillator.reset(waveform, 440.0f, 0.5f, 0.0f);
+        std::vector<float> output(quantum);
+
+        measure(std::string("generate/") + name, quantum, quantum, [&] {
+            oscillator.render(output.data(), quantum, 48000);
+        });
+    }
+}
+
+void benchMixer()
+{
+    const uint32_t quantum = 256;
+    const uint32_t counts[] = { 1, 8, 32, MIXER_MAX_INPUTS };
+
+    for (auto count : counts) {
+        // The mixer's slot table is large, so keep it off the stack
+        auto mixer = std::make_unique<Mixer>();
+        for (uint32_t i = 0; i < count; i++) {
+            mixer->addInput(1, quantum * 4, 0.5f, (float)i / count * 2 - 1);
+        }
+        auto source = testSignal(quantum);
+        std::vector<float> bus((size_t)quantum * BENCH_CHANNELS);
+
+        measure("mix/" + std::to_string(count) + "-mono-inputs", quantum, quantum, [&] {
+            for (uint32_t i = 0; i < count; i++) {
+                mixer->write(i, source.data(), source.size());
+            }
+            std::fill(bus.begin(), bus.end(), 0.0f);
+            mixer->mixInto(bus.data(), quantum, BENCH_CHANNELS, 0);
+        });
+    }
+
+    // Inputs mid-ramp take the per-frame gain kernels; the ramps are long
+    // enough to stay active for the whole run
+    for (auto lane : { "gain", "pan" }) {
+        const uint32_t count = 8;
+        auto mixer = std::make_unique<Mixer>();
+        for (uint32_t i = 0; i < count; i++) {
+            mixer->addInput(1, quantum * 4, 0.5f, 0.0f);
+            mixer->automate(i, lane[0] == 'p', 1.0f, UINT32_MAX, 0, RAMP_LINEAR);
+        }
+        auto source = testSignal(quantum);
+        std::vector<float> bus((size_t)quantum * BENCH_CHANNELS);
+        uint64_t position = 0;
+
+        measure(std::string("mix/8-mono-inputs-") + lane + "-ramp", quantum, quantum, [&] {
+            for (uint32_t i = 0; i < count; i++) {
+                mixer->write(i, source.data(), source.size());
+            }
+            std::fill(bus.begin(), bus.end(), 0.0f);
+            mixer->mixInto(bus.data(), quantum, BENCH_CHANNELS, position);
+            position += quantum;
+        });
+    }
+
+    // A looping 16-bit stereo WAV decoded straight from its mapping
+    char path[] = "/tmp/hot-paths-XXXXXX";
+    auto fd = mkstemp(path);
+    if (fd >= 0) {
+        const uint32_t frames = 48000;
+        std::vector<int16_t> samples((size_t)frames * BENCH_CHANNELS);
+        for (size_t i = 0; i < samples.size(); i++) {
+            samples[i] = (int16_t)(std::sin(i * 0.01) * 16000);
+        }
+        uint32_t dataSize = (uint32_t)(samples.size() * sizeof(int16_t));
+        uint8_t header[44] = { 'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ', 16, 0, 0, 0,
+            1, 0, BENCH_CHANNELS, 0, 0x80, 0xBB, 0, 0, 0, 0, 0, 0, BENCH_CHANNELS * 2, 0, 16, 0, 'd', 'a', 't', 'a' };
+        memcpy(header + 40, &dataSize, 4);
+        auto written = write(fd, header, sizeof(header)) == sizeof(header)
+            && write(fd, samples.data(), dataSize) == (ssize_t)dataSize;
+        close(fd);
+
+        auto file = std::make_shared<FileSource>();
+        std::string error;
+        if (written && file->open(path, NULL, error)) {
+            file->start(0, true);
+            auto mixer = std::make_unique<Mixer>();
+            mixer->addFile(file, 0.5f, 0.0f);
+            std::vector<float> bus((size_t)quantum * BENCH_CHANNELS);
+
+            measure("mix/file-s16-stereo", quantum, quantum, [&] {
+                std::fill(bus.begin(), bus.end(), 0.0f);
+                mixer->mixInto(bus.data(), quantum, BENCH_CHANNELS, 0);
+            });
+        }
+        unlink(path);
+    }
+
+    // Cached mono samples retriggered as they end, each voice mixed in place
+    // from the shared samples; a polyphony below the voice count makes every
+    // trigger steal and fade out the oldest
+    for (auto polyphony : { 32u, 8u }) {
+        auto sample = std::make_shared<CachedSample>();
+        sample->samples = testSignal(quantum * 8);
+        sample->channels = 1;
+        sample->rate = 48000;
+        sample->frames = sample->samples.size();
+        auto mixer = std::make_unique<Mixer>();
+        std::vector<float> bus((size_t)quantum * BENCH_CHANNELS);
+        uint64_t position = 0;
+        uint32_t triggers = 0;
+
+        measure("mix/voices-polyphony-" + std::to_string(polyphony), quantum, quantum, [&] {
+            // Four voices start per quantum and last eight, so 32 would sound at once
+            for (uint32_t i = 0; i < 4; i++) {
+                mixer->addVoice(sample, position, 0.5f, (float)(triggers++ % 9) / 4 - 1, polyphony);
+            }
+            std::fill(bus.begin(), bus.end(), 0.0f);
+            mixer->mixInto(bus.data(), quantum, BENCH_CHANNELS, position);
+            position += quantum;
+        });
+    }
+}
+
+void benchMeter()
+{
+    const uint32_t quantum = 256;
+    auto source = testSignal((size_t)quantum * BENCH_CHANNELS);
+
+    for (auto truePeak : { false, true }) {
+        LevelMeter meter;
+        meter.configure(BENCH_CHANNELS, 48000, 30.0, truePeak);
+
+        measure(truePeak ? "meter/true-peak" : "meter/peak-rms", quantum, quantum, [&] {
+            meter.process(source.data(), quantum);
+        });
+    }
+}
+
+void benchEffects()
+{
+    // Each stage alone, then a mastering chain: two EQ bands into the limiter
+    const uint32_t quantum = 256;
+    const uint32_t rate = 48000;
+    const float eq[EFFECT_MAX_PARAMS] = { BIQUAD_PEAKING, 3000.0f, 1.0f, 3.0f, 1.0f };
+    const float highpass[EFFECT_MAX_PARAMS] = { BIQUAD_HIGHPASS, 40.0f, 0.7071f, 0.0f, 2.0f };
+    const float limiter[EFFECT_MAX_PARAMS] = { -1.0f, 5.0f, 50.0f, 0.0f, 0.0f };
+    const float delay[EFFECT_MAX_PARAMS] = { 12.5f, 0.3f, 0.5f, 3.0f, 0.0f };
+    const float wide[EFFECT_MAX_PARAMS] = { 1.0f, 1.5f, 0.0f, 0.0f, 0.0f };
+    const auto lookahead = (size_t)(EFFECT_LIMITER_MAX_LOOKAHEAD_MS * rate / 1000);
+    const std::tuple<const char*, uint32_t, const float*, size_t> stages[] = {
+        { "biquad", EFFECT_BIQUAD, eq, 0 },
+        { "limiter", EFFECT_LIMITER, limiter, lookahead },
+        { "delay", EFFECT_DELAY, delay, rate },
+        { "mid-side", EFFECT_MID_SIDE, wide, 0 },
+    };
+
+    auto source = testSignal((size_t)quantum * BENCH_CHANNELS);
+    std::vector<float> bus(source.size());
+    for (auto& [name, type, params, capacity] : stages) {
+        auto chain = std::make_unique<EffectChain>();
+        chain->insert(type, params, EFFECT_CHAIN_MAX_STAGES, capacity, BENCH_CHANNELS);
+
+        measure(std::string("effects/") + name, quantum, quantum, [&] {
+            memcpy(bus.data(), source.data(), bus.size() * sizeof(float));
+            chain->process(bus.data(), quantum, BENCH_CHANNELS, rate);
+        });
+    }
+
+    auto chain = std::make_unique<EffectChain>();
+    chain->insert(EFFECT_BIQUAD, highpass, EFFECT_CHAIN_MAX_STAGES, 0, BENCH_CHANNELS);
+    chain->insert(EFFECT_BIQUAD, eq, EFFECT_CHAIN_MAX_STAGES, 0, BENCH_CHANNELS);
+    chain->insert(EFFECT_LIMITER, limiter, EFFECT_CHAIN_MAX_STAGES, lookahead, BENCH_CHANNELS);
+    measure("effects/eq-limiter-chain", quantum, quantum, [&] {
+        memcpy(bus.data(), source.data(), bus.size() * sizeof(float));
+        chain->process(bus.data(), quantum, BENCH_CHANNELS, rate);
+    });
+}
+
+void benchTrace()
+{
+    // One record per process callback, as onProcess() appends it
+    const uint32_t quantum = 256;
+    TraceRing trace;
+    trace.configure(4096);
+
+    measure("trace/record-cycle", quantum, quantum, [&] {
+        trace.record({
+            .startNs = steadyNanos(),
+            .durationNs = 20000,
+            .kind = TRACE_CYCLE,
+            .requested = quantum,
+            .delivered = quantum,
+            .produced = quantum,
+            .queued = 1024,
+        });
+    });
+}
+
+void report()
+{
+    if (options.json) {
+        std::printf("{\n");
+        for (size_t i = 0; i < results.size(); i++) {
+            auto& result = results[i];
+            std::printf("  \"%s\": { \"nsPerFrame\": %.4f, \"nsPerCall\": %.2f, \"allocationsPerQuantum\": %.4f }%s\n",
+                result.name.c_str(), result.nsPerFrame, result.nsPerCall, result.allocationsPerQuantum,
+                i + 1 < results.size() ? "," : "");
+        }
+        std::printf("}\n");
+        return;
+    }
+
+    std::printf("%-28s %12s %12s %14s\n", "case", "ns/frame", "ns/call", "allocs/quantum");
+    for (auto& result : results) {
+        std::printf("%-28s %12.3f %12.1f %14.3f\n",
+            result.name.c_str(), result.nsPerFrame, result.nsPerCall, result.allocationsPerQuantum);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--json")) {
+            options.json = true;
+        } else if (!std::strcmp(argv[i], "--filter") && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else {
+            std::fprintf(stderr, "Usage: %s [--json] [--filter <substring>]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    results.reserve(128); // Keep our own bookkeeping out of the allocation counts
+    benchConversion();
+    benchFill();
+    benchWrite();
+    benchPlanar();
+    benchResampler();
+    benchGenerators();
+    benchMixer();
+    benchMeter();
+    benchEffects();
+    benchTrace();
+    report();
+    return 0;
+}
@@ -1,4 +1,7 @@
 {
+  "variables": {
+    "build_benchmarks%": "false"
+  },
   "targets": [
     {
       "target_name": "@jacobsoft/pipewire",
@@ -6,7 +9,26 @@
         "src/pipewire.cpp",
         "src/promises.cpp",
         "src/session.cpp",
-        "src/audio-output-stream.cpp"
+        "src/audio-output-stream.cpp",
+        "src/ring-buffer.cpp",
+        "src/sample-convert.cpp",
+        "src/shared-ring.cpp",
+        "src/mixer.cpp",
+        "src/automation.cpp",
+        "src/effect-chain.cpp",
+        "src/level-meter.cpp",
+        "src/oscillator.cpp",
+        "src/file-source.cpp",
+        "src/file-sink.cpp",
+        "src/sample-cache.cpp",
+        "src/stream-stats.cpp",
+        "src/stream-clock.cpp",
+        "src/trace-ring.cpp",
+        "src/stream-props.cpp",
+        "src/wakeup-channel.cpp",
+        "src/adaptive-buffer.cpp",
+        "src/planar.cpp",
+        "src/resampler.cpp"
       ],
       "cflags_cc": [
         "-std=c++20"
@@ -25,5 +47,41 @@
         ]
       },
     }
+  ],
+  "conditions": [
+    ["build_benchmarks=='true'", {
+      "targets": [
+        {
+          "target_name": "hot-paths",
+          "type": "executable",
+          "sources": [
+            "bench/hot-paths.cpp",
+            "src/ring-buffer.cpp",
+            "src/sample-convert.cpp",
+            "src/mixer.cpp",
+            "src/automation.cpp",
+            "src/effect-chain.cpp",
+            "src/level-meter.cpp",
+            "src/oscillator.cpp",
+            "src/file-source.cpp",
+            "src/stream-stats.cpp",
+            "src/trace-ring.cpp",
+            "src/planar.cpp",
+            "src/resampler.cpp"
+          ],
+          "cflags_cc": [
+            "-std=c++20",
+            "-O2"
+          ],
+          "cflags_cc!": [
+            "-fno-exceptions"
+          ],
+          "include_dirs": [
+            "src",
+            "<!@(pkg-config --cflags-only-I libspa-0.2 2>/dev/null | sed 's/-I//g' || echo '/usr/include/spa-0.2')",
+          ],
+        }
+      ]
+    }]
   ]
-}
\ No newline at end of file
+}
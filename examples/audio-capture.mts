@@ -0,0 +1,44 @@
+#!/usr/bin/env npx tsx
+
+/**
+ * Capturing audio with AudioInputStream
+ */
+
+import { startSession, AudioFormat } from "pw-client";
+
+async function printInputLevels(seconds: number) {
+  await using session = await startSession();
+  await using stream = await session.createAudioInputStream({
+    name: "Level Meter",
+    format: AudioFormat.Float32,
+    channels: 1,
+    batchFrames: 4800, // 100ms at 48kHz
+  });
+
+  await stream.connect();
+  console.log(`🎙️ Capturing ${stream.channels}ch @ ${stream.rate}Hz`);
+
+  let captured = 0;
+  for await (const batch of stream) {
+    // The batch is recycled once the loop moves on; copy it to keep it
+    let peak = 0;
+    for (const sample of batch) {
+      peak = Math.max(peak, Math.abs(sample));
+    }
+    console.log(`Peak: ${(20 * Math.log10(peak || 1e-9)).toFixed(1)} dBFS`);
+
+    captured += batch.length / stream.channels;
+    if (captured >= seconds * stream.rate) {
+      break;
+    }
+  }
+
+  if (stream.droppedFrames > 0) {
+    console.log(`⚠️ ${stream.droppedFrames} frames dropped`);
+  }
+}
+
+if (import.meta.url === `file://${process.argv[1]}`) {
+  await printInputLevels(1);
+  console.log("✅ Done");
+}
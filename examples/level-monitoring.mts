@@ -1,4 +1,4 @@
-import { startSession, AudioQuality } from "pw-client";
+import { startSession, AudioQuality, type PipeWireSession } from "pw-client";
 
 function* levelMonitor(
   generator: Iterable<number>,
@@ -36,6 +36,26 @@ function softLimit(sample: number, threshold = 0.8) {
   return sample;
 }
 
+async function meterStream(session: PipeWireSession) {
+  const stream = await session.createAudioOutputStream({
+    name: "Metered Output",
+    channels: 2,
+    // Peak and RMS computed natively, 30 readings a second
+    metering: { updatesPerSecond: 30, truePeak: true },
+  });
+
+  stream.on("levels", ({ peak, rms, truePeak = peak }) => {
+    const dB = (level: number) => (20 * Math.log10(level)).toFixed(1);
+    console.log(
+      `📊 L ${dB(peak[0])}dB peak, ${dB(rms[0])}dB RMS | ` +
+        `R ${dB(peak[1])}dB peak, ${dB(rms[1])}dB RMS | ` +
+        `true peak ${dB(Math.max(...truePeak))}dBTP`
+    );
+  });
+
+  return stream;
+}
+
 // Create a signal that gets progressively louder
 function* generateLoudSignal(sampleRate: number, duration: number) {
   const totalSamples = Math.floor(duration * sampleRate);
@@ -89,10 +109,29 @@ async function levelMonitoringDemo() {
       }
 
       await stream.write(limitedSignal());
-      console.log("✅ Level monitoring demo complete!");
     } finally {
       await stream.dispose();
     }
+
+    // The same signal again, metered natively instead of in JavaScript
+    const metered = await meterStream(session);
+    try {
+      await metered.connect();
+      console.log("🎛️ Native meters, stereo:");
+      const loud = generateLoudSignal(metered.rate, 4.0);
+      function* stereo() {
+        for (const sample of loud) {
+          const limited = softLimit(sample, 0.8);
+          yield limited;
+          yield limited * 0.5;
+        }
+      }
+      await metered.write(stereo());
+      await metered.isFinished();
+      console.log("✅ Level monitoring demo complete!");
+    } finally {
+      await metered.dispose();
+    }
   } finally {
     await session.dispose();
   }
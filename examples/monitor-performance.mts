@@ -1,4 +1,4 @@
-import { startSession, AudioQuality } from "pw-client";
+import { startSession, AudioQuality, AudioFormat } from "pw-client";
 
 console.log("📊 Basic Performance Monitoring Example:");
 
@@ -284,3 +284,76 @@ for (const quality of [
   await memoryUsageTest(quality);
   console.log(); // Blank line between tests
 }
+
+console.log();
+
+console.log("🩺 Stream Statistics Example:");
+
+async function streamStatsExample() {
+  await using session = await startSession();
+  await using stream = await session.createAudioOutputStream({
+    name: "Stream Stats",
+    channels: 2,
+    enableMonitoring: { intervalMs: 500 },
+  });
+
+  stream.on("stats", (stats) => {
+    console.log(
+      `underruns=${stats.underruns} zeroFilled=${stats.zeroFilledFrames} ` +
+        `fill=${(stats.fillRatio * 100).toFixed(1)}% ` +
+        `callback=${stats.meanCallbackMs.toFixed(3)}ms ` +
+        `(max ${stats.maxCallbackMs.toFixed(3)}ms)`,
+    );
+  });
+
+  await stream.connect();
+
+  // Write in bursts with a stall in between to provoke one underrun
+  const burst = new Float64Array(stream.rate * stream.channels).map(
+    (_, i) => Math.sin(i * 0.02) * 0.1,
+  );
+  await stream.writeFrames(burst);
+  await new Promise((resolve) => setTimeout(resolve, 1500));
+  await stream.writeFrames(burst);
+  await stream.isFinished();
+
+  const { underruns, dequeueFailures, slowCycles } = stream.stats;
+  console.log({ underruns, dequeueFailures, slowCycles });
+}
+
+await streamStatsExample();
+
+console.log("🧱 Render In Place Example:");
+
+async function renderInPlaceExample() {
+  await using session = await startSession();
+  await using stream = await session.createAudioOutputStream({
+    name: "Render In Place",
+    channels: 2,
+    inputFormat: AudioFormat.Float32,
+  });
+  await stream.connect();
+
+  const { channels, rate } = stream;
+  const totalFrames = rate * 2;
+  let phase = 0;
+
+  for (let rendered = 0; rendered < totalFrames; ) {
+    await stream.waitForBuffer();
+
+    // A view of the stream's own buffer: no allocation, no copy on commit
+    const block = stream.acquireBuffer(stream.framesPerQuantum);
+    for (let i = 0; i < block.length; i += channels) {
+      const sample = Math.sin(phase) * 0.1;
+      phase += (2 * Math.PI * 440) / rate;
+      block.fill(sample, i, i + channels);
+    }
+    stream.commit(block);
+    rendered += block.length / channels;
+  }
+
+  await stream.isFinished();
+  console.log(`Rendered ${totalFrames} frames in place`);
+}
+
+await renderInPlaceExample();
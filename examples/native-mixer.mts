@@ -0,0 +1,86 @@
+#!/usr/bin/env npx tsx
+
+/**
+ * Mixing many voices natively on one stream
+ */
+
+import { setTimeout } from "node:timers/promises";
+import { startSession, AudioFormat, RampCurve } from "pw-client";
+
+function renderTone(frequency: number, seconds: number, rate: number) {
+  const samples = new Float32Array(Math.floor(seconds * rate));
+  for (let i = 0; i < samples.length; i++) {
+    const envelope = 1 - i / samples.length;
+    samples[i] = Math.sin((i / rate) * frequency * Math.PI * 2) * envelope;
+  }
+  return samples;
+}
+
+async function playChordWithNativeMixer() {
+  await using session = await startSession();
+  await using stream = await session.createAudioOutputStream({
+    name: "Native Mixer",
+    inputFormat: AudioFormat.Float32,
+    channels: 2,
+  });
+
+  await stream.connect();
+
+  // Each voice is a mono input with its own gain and pan; the sum is
+  // computed on PipeWire's real-time thread
+  const frequencies = [261.63, 329.63, 392.0, 523.25];
+  const voices = frequencies.map((frequency, index) => ({
+    input: stream.addMixerInput({
+      gain: 0.15,
+      pan: -0.75 + (index * 1.5) / (frequencies.length - 1),
+    }),
+    samples: renderTone(frequency, 2, stream.rate),
+  }));
+
+  await Promise.all(voices.map(({ input, samples }) => input.write(samples)));
+  await stream.isFinished();
+
+  for (const { input } of voices) {
+    input.remove();
+  }
+}
+
+async function crossfadeWithNativeRamps() {
+  await using session = await startSession();
+  await using stream = await session.createAudioOutputStream({
+    name: "Native Crossfade",
+    channels: 2,
+  });
+
+  await stream.connect();
+
+  const low = stream.addGenerator({ frequency: 220, gain: 0.3, pan: -1 });
+  const high = stream.addGenerator({ frequency: 330, gain: 0, pan: 1 });
+
+  // Ramps are rendered frame by frame on the real-time thread, starting
+  // at exact frames of the stream's render timeline
+  const seconds = stream.renderRate;
+  const start = stream.renderPosition + seconds;
+  low.rampGain(0, 3 * seconds, { startFrame: start });
+  high.rampGain(0.3, 3 * seconds, { startFrame: start });
+  low.rampPan(1, 3 * seconds, { startFrame: start });
+  high.rampPan(-1, 3 * seconds, { startFrame: start });
+
+  // Then fade the whole stream out, evenly in decibels
+  stream.rampGain(0, seconds, {
+    startFrame: start + 3 * seconds,
+    curve: RampCurve.Exponential,
+  });
+  await setTimeout(5000);
+
+  low.remove();
+  high.remove();
+}
+
+if (import.meta.url === `file://${process.argv[1]}`) {
+  console.log("🎛️ Playing a four-voice chord through the native mixer...");
+  await playChordWithNativeMixer();
+  console.log("🎚️ Crossfading two generators with native ramps...");
+  await crossfadeWithNativeRamps();
+  console.log("✅ Done");
+}
@@ -1,4 +1,5 @@
-import { startSession, AudioQuality } from "pw-client";
+import { setTimeout } from "node:timers/promises";
+import { startSession, AudioQuality, Waveform } from "pw-client";
 import {
   generateSineWave,
   generateNoise,
@@ -98,3 +99,28 @@ function* bandLimitedSawtooth(
 // Demo the band-limited sawtooth
 console.log("🎵 Playing band-limited sawtooth (reduces aliasing)...");
 await stream.write(bandLimitedSawtooth(440, 1.0));
+
+// Native generators render on the real-time thread; JavaScript only
+// posts parameter changes, so a sweep costs no per-sample work here
+console.log("🎵 Playing native generators...");
+const tone = stream.addGenerator({ frequency: 220, amplitude: 0.3 });
+for (const waveform of [
+  Waveform.Sine,
+  Waveform.Square,
+  Waveform.Sawtooth,
+  Waveform.Triangle,
+]) {
+  tone.waveform = waveform;
+  for (let step = 0; step < 20; step++) {
+    tone.frequency = 220 * 2 ** (step / 12); // Up a semitone per step
+    await setTimeout(25);
+  }
+}
+tone.remove();
+
+const noise = stream.addGenerator({
+  waveform: Waveform.PinkNoise,
+  amplitude: 0.2,
+});
+await setTimeout(1000);
+noise.remove();
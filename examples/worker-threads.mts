@@ -0,0 +1,91 @@
+#!/usr/bin/env npx tsx
+
+/**
+ * Rendering audio from worker threads
+ */
+
+import { isMainThread, Worker, workerData } from "node:worker_threads";
+import { startSession, AudioFormat, SharedRingWriter } from "pw-client";
+
+async function playFromWorker(frequency: number) {
+  // Each worker loads the addon into its own environment and gets its own
+  // session, PipeWire thread loop and streams
+  await using session = await startSession();
+  await using stream = await session.createAudioOutputStream({
+    name: `Worker ${frequency}Hz`,
+    inputFormat: AudioFormat.Float32,
+    channels: 2,
+  });
+
+  await stream.connect();
+
+  const frames = new Float32Array(stream.rate * stream.channels);
+  for (let i = 0; i < frames.length; i += 2) {
+    const sample = Math.sin((i / 2 / stream.rate) * frequency * Math.PI * 2);
+    frames[i] = frames[i + 1] = sample * 0.1;
+  }
+
+  await stream.writeFrames(frames);
+  await stream.isFinished();
+}
+
+async function playThroughSharedRing() {
+  await using session = await startSession();
+  await using stream = await session.createAudioOutputStream({
+    name: "Shared Ring",
+    inputFormat: AudioFormat.Float32,
+    channels: 2,
+    sharedRing: { frames: 1024 },
+  });
+
+  await stream.connect();
+
+  // The worker writes straight into the ring PipeWire reads from
+  const worker = new Worker(new URL(import.meta.url), {
+    workerData: { role: "ring", ring: stream.sharedRing, seconds: 1 },
+  });
+  await new Promise((resolve) => worker.once("exit", resolve));
+  await stream.isFinished();
+}
+
+function renderIntoRing(buffer: SharedArrayBuffer, seconds: number) {
+  const ring = new SharedRingWriter(buffer);
+  const block = new Float32Array(128 * ring.channels);
+  let phase = 0;
+
+  for (let written = 0; written < seconds * 48_000; written += 128) {
+    const rate = ring.rate || 48_000;
+    for (let i = 0; i < block.length; i += ring.channels) {
+      block.fill(Math.sin(phase) * 0.1, i, i + ring.channels);
+      phase += (330 * Math.PI * 2) / rate;
+    }
+
+    ring.waitForSpace(128);
+    ring.write(block);
+  }
+}
+
+if (!isMainThread) {
+  if (workerData.role === "ring") {
+    renderIntoRing(workerData.ring, workerData.seconds);
+  } else {
+    await playFromWorker(workerData.frequency);
+  }
+} else if (import.meta.url === `file://${process.argv[1]}`) {
+  console.log("🧵 Playing a chord from three workers...");
+  const workers = [262, 330, 392].map(
+    (frequency) =>
+      new Worker(new URL(import.meta.url), {
+        workerData: { role: "stream", frequency },
+      }),
+  );
+  await Promise.all(
+    workers.map(
+      (worker) => new Promise((resolve) => worker.once("exit", resolve)),
+    ),
+  );
+
+  console.log("🧵 Playing through a shared ring filled by a worker...");
+  await playThroughSharedRing();
+  console.log("✅ Done");
+}
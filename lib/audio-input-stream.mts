@@ -0,0 +1,495 @@
+import EventEmitter, { once } from "node:events";
+import { AudioFormat } from "./audio-format.mjs";
+import { AudioQuality, getRatePreferences } from "./audio-quality.mjs";
+import type { AudioOutputStreamProps } from "./audio-output-stream.mjs";
+import type { NativePipeWireSession } from "./session.mjs";
+import * as Props from "./props.mjs";
+import { throttleProps } from "./stream-props.mjs";
+import {
+  type Latency,
+  type StreamState,
+  type StreamStateEnum,
+  streamStateToName,
+} from "./stream.mjs";
+import {
+  toNativeBufferRequest,
+  type BufferConfig,
+  type NativeBufferRequest,
+} from "./buffer-config.mjs";
+
+export interface NativeAudioInputStream {
+  connect: (options?: {
+    preferredFormats?: Array<number>;
+    preferredRates?: Array<number>;
+  }) => Promise<void>;
+  disconnect: () => Promise<void>;
+  get framesPerQuantum(): number;
+  get bufferSize(): number;
+  get readableFrames(): number;
+  get droppedFrames(): number;
+  get props(): AudioOutputStreamProps;
+  read: (data: Float32Array | Float64Array) => number; // Returns number of frames copied
+  waitForData: (minFrames: number) => Promise<number>; // Returns number of frames readable
+  destroy: () => Promise<void>;
+}
+
+/**
+ * Configuration options for creating audio capture streams.
+ * All options are optional with sensible defaults.
+ *
+ * @property name - Human-readable name displayed in PipeWire clients (default: "Node.js Audio")
+ * @property rate - Sample rate in Hz (default: 48000)
+ * @property channels - Number of audio channels (default: 2 for stereo)
+ * @property role - Audio role hint for PipeWire routing (default: "Music")
+ * @property quality - Quality preset that affects rate negotiation and buffering (default: AudioQuality.Standard)
+ * @property preferredRates - Override sample rate negotiation order
+ * @property autoConnect - Whether to auto-connect on the first read (default: false)
+ * @property buffering - Size of the native capture ring; audio captured while
+ *   it is full is dropped and counted in `droppedFrames`
+ * @property format - Sample format of delivered batches; must be
+ *   `AudioFormat.Float32` or `AudioFormat.Float64` (default: `AudioFormat.Float32`)
+ * @property batchFrames - Frames per delivered batch (default: 4 quanta)
+ * @property poolSize - Number of batch buffers kept for reuse (default: 4)
+ * @property propsIntervalMs - Deliver `propsChange` at most this often (default: 50)
+ *
+ * @example
+ * ```typescript
+ * const opts: AudioInputStreamOpts = {
+ *   name: "Level Meter",
+ *   channels: 1,
+ *   batchFrames: 1024,
+ * };
+ * ```
+ */
+export interface AudioInputStreamOpts {
+  name?: string;
+  rate?: number;
+  channels?: number;
+  role?:
+    | "Movie"
+    | "Music"
+    | "Camera"
+    | "Screen"
+    | "Communication"
+    | "Game"
+    | "Notification"
+    | "DSP"
+    | "Production"
+    | "Accessibility"
+    | "Test";
+  quality?: AudioQuality;
+  preferredRates?: Array<number>;
+  autoConnect?: boolean;
+  buffering?: BufferConfig;
+  format?: AudioFormat;
+  batchFrames?: number;
+  poolSize?: number;
+  propsIntervalMs?: number;
+}
+
+interface AudioInputEvents {
+  propsChange: [AudioOutputStreamProps];
+  formatChange: [{ format: AudioFormat; channels: number; rate: number }];
+  latencyChange: [Latency];
+  unknownParamChange: [number];
+  stateChange: [StreamState];
+  error: [Error];
+}
+
+/**
+ * Audio capture stream for recording samples from PipeWire.
+ *
+ * Captured audio is buffered natively and handed to JavaScript in batches of
+ * `batchFrames` frames. Batch arrays come from a small pool and are reused:
+ * call `release()` when done with one, or iterate the stream with
+ * `for await`, which releases each batch when the next one is requested.
+ *
+ * @interface AudioInputStream
+ * @extends EventEmitter
+ *
+ * @example
+ * ```typescript
+ * await using stream = await session.createAudioInputStream({ channels: 1 });
+ * await stream.connect();
+ *
+ * for await (const batch of stream) {
+ *   analyse(batch); // Copy the data if you need it after this iteration
+ * }
+ * ```
+ *
+ * Emits the same `formatChange`, `stateChange`, `latencyChange`,
+ * `propsChange`, `unknownParamChange` and `error` events as
+ * {@link AudioOutputStream}.
+ */
+export interface AudioInputStream
+  extends EventEmitter<AudioInputEvents>,
+    AsyncIterable<Float32Array | Float64Array> {
+  /**
+   * Connect the stream to PipeWire audio system.
+   * Triggers format negotiation and starts capturing.
+   */
+  connect: () => Promise<void>;
+
+  /**
+   * Disconnect the stream from PipeWire.
+   * Stops capturing; audio already buffered can still be read.
+   */
+  disconnect: () => Promise<void>;
+
+  /**
+   * Wait for the next batch of captured audio.
+   *
+   * @returns Interleaved samples, `batchFrames * channels` long. The array is
+   *   borrowed from the stream's pool; pass it to `release()` when done.
+   */
+  read: () => Promise<Float32Array | Float64Array>;
+
+  /**
+   * Return a batch obtained from `read()` to the pool for reuse.
+   * The batch must not be used afterwards. Releasing it again does nothing.
+   */
+  release: (batch: Float32Array | Float64Array) => void;
+
+  /**
+   * Dispose of the stream and release all resources.
+   */
+  dispose: () => Promise<void>;
+
+  /**
+   * Get the negotiated audio format after connection.
+   * Available only after successful connect().
+   */
+  get format(): AudioFormat;
+
+  /**
+   * Get the negotiated number of audio channels.
+   * Available only after successful connect().
+   */
+  get channels(): number;
+
+  /**
+   * Get the negotiated sample rate in Hz.
+   * Available only after successful connect().
+   */
+  get rate(): number;
+
+  /**
+   * Number of frames per batch delivered by `read()`.
+   */
+  get batchFrames(): number;
+
+  /**
+   * Frames captured so far that were dropped because the native ring was
+   * full (JavaScript fell behind).
+   */
+  get droppedFrames(): number;
+
+  /**
+   * Stream properties as PipeWire last reported them.
+   */
+  get props(): AudioOutputStreamProps;
+
+  /**
+   * Check if the stream is currently connected to PipeWire.
+   */
+  get isConnected(): boolean;
+
+  /**
+   * Automatic resource cleanup for `await using` syntax.
+   * Equivalent to calling dispose().
+   */
+  [Symbol.asyncDispose]: () => Promise<void>;
+}
+
+export class AudioInputStreamImpl
+  extends EventEmitter<AudioInputEvents>
+  implements AudioInputStream
+{
+  static async create(
+    session: NativePipeWireSession,
+    opts?: AudioInputStreamOpts
+  ): Promise<AudioInputStream> {
+    const stream = new AudioInputStreamImpl();
+    await stream.#init(session, opts);
+    return stream;
+  }
+
+  #nativeStream!: NativeAudioInputStream;
+  #quality = AudioQuality.Standard;
+  #preferredRates?: Array<number>;
+  #isConnected = false;
+  #autoConnect = false;
+  #isDisposed = false;
+
+  #sampleFormat: AudioFormat = AudioFormat.Float32;
+  #requestedBatchFrames?: number;
+  #batchFrames = 0;
+  #poolSize = 4;
+  #pool: Array<Float32Array | Float64Array> = [];
+  #propsThrottle?: ReturnType<typeof throttleProps>;
+
+  #negotiatedFormat!: AudioFormat;
+  #negotiatedChannels = 2;
+  #negotiatedRate = 48_000;
+
+  private constructor() {
+    super();
+  }
+
+  async #init(
+    session: NativePipeWireSession,
+    opts: AudioInputStreamOpts = {}
+  ) {
+    const {
+      name = "PipeWireStream",
+      rate = 48_000,
+      channels = 2,
+      role,
+      quality = AudioQuality.Standard,
+      preferredRates,
+      autoConnect = false,
+      buffering,
+      format = AudioFormat.Float32,
+      batchFrames,
+      poolSize = 4,
+      propsIntervalMs = 50,
+    } = opts;
+
+    if (format !== AudioFormat.Float32 && format !== AudioFormat.Float64) {
+      throw new Error("format must be AudioFormat.Float32 or Float64");
+    }
+    if (batchFrames !== undefined && !(batchFrames >= 1)) {
+      throw new Error("batchFrames must be at least 1");
+    }
+
+    this.#autoConnect = autoConnect;
+    this.#quality = quality;
+    this.#preferredRates = preferredRates;
+    this.#sampleFormat = format;
+    this.#requestedBatchFrames = batchFrames && Math.floor(batchFrames);
+    this.#poolSize = Math.max(1, poolSize);
+    this.#negotiatedChannels = channels;
+    this.#propsThrottle = throttleProps(propsIntervalMs, () => {
+      if (this.listenerCount("propsChange")) {
+        this.emit("propsChange", this.#nativeStream.props);
+      }
+    });
+
+    this.#nativeStream = await this.#createNativeStream(session, {
+      name,
+      rate,
+      channels,
+      buffering: toNativeBufferRequest(buffering, quality),
+      props: this.#buildMediaProps(role),
+    });
+  }
+
+  #buildMediaProps(role?: string) {
+    const props: Record<string, string> = {
+      [Props.Media.Type]: "Audio",
+      [Props.Media.Category]: "Capture",
+    };
+
+    if (role) {
+      props[Props.Media.Role] = role;
+    }
+
+    return props;
+  }
+
+  async #createNativeStream(
+    session: NativePipeWireSession,
+    config: {
+      name: string;
+      rate: number;
+      channels: number;
+      props: Record<string, string>;
+      buffering?: NativeBufferRequest;
+    }
+  ) {
+    return await session.createAudioInputStream({
+      name: config.name,
+      inputFormat: this.#sampleFormat.enumValue,
+      dither: false,
+      rate: config.rate,
+      channels: config.channels,
+      props: config.props,
+      buffering: config.buffering,
+      onStateChange: (state: StreamStateEnum, error: string) => {
+        const streamState = streamStateToName[state];
+        if (streamState) {
+          this.emit("stateChange", streamState);
+        }
+        if (error) {
+          this.emit("error", new Error(error));
+        }
+      },
+      onLatencyChange: (latency: Latency) =>
+        this.emit("latencyChange", latency),
+      onPropsChange: () => this.#propsThrottle?.notify(),
+      onUnknownParamChange: (param: number) =>
+        this.emit("unknownParamChange", param),
+      onFormatChange: (format: {
+        format: number;
+        channels: number;
+        rate: number;
+      }) => this.#handleFormatChange(format),
+    });
+  }
+
+  #handleFormatChange(format: {
+    format: number;
+    channels: number;
+    rate: number;
+  }) {
+    const newFormat = AudioFormat.fromEnum(format.format);
+    if (!newFormat) {
+      throw new Error(`Unknown format: ${format.format}`);
+    }
+
+    if (format.channels !== this.#negotiatedChannels) {
+      this.#pool = []; // Pooled batches are sized for the old channel count
+    }
+
+    this.#negotiatedFormat = newFormat;
+    this.#negotiatedChannels = format.channels;
+    this.#negotiatedRate = format.rate;
+
+    this.emit("formatChange", {
+      format: newFormat,
+      channels: format.channels,
+      rate: format.rate,
+    });
+  }
+
+  async connect() {
+    if (this.#isConnected) {
+      return; // Already connected
+    }
+
+    const preferredRates =
+      this.#preferredRates ?? getRatePreferences(this.#quality);
+
+    const formatNegotiation =
+      !this.#negotiatedFormat && once(this, "formatChange");
+
+    // Only the delivery format is offered; PipeWire converts from the source
+    await this.#nativeStream.connect({
+      preferredFormats: [this.#sampleFormat.enumValue],
+      preferredRates,
+    });
+
+    await formatNegotiation;
+    this.#batchFrames =
+      this.#requestedBatchFrames ?? this.#nativeStream.framesPerQuantum * 4;
+    this.#isConnected = true;
+  }
+
+  async disconnect() {
+    if (!this.#isConnected) {
+      return; // Already disconnected
+    }
+
+    await this.#nativeStream.disconnect();
+    this.#isConnected = false;
+  }
+
+  get isConnected(): boolean {
+    return this.#isConnected;
+  }
+
+  async read() {
+    if (!this.#isConnected && this.#autoConnect) {
+      await this.connect();
+    }
+
+    if (!this.#isConnected) {
+      throw new Error(
+        "Stream must be connected before reading audio data. Call await stream.connect() first."
+      );
+    }
+
+    // One wakeup per batch: the native side signals only once it is full
+    await this.#nativeStream.waitForData(this.#batchFrames);
+
+    const batch = this.#pool.pop() ?? this.#createBatch();
+    const frames = this.#nativeStream.read(batch);
+    return frames * this.#negotiatedChannels === batch.length
+      ? batch
+      : batch.subarray(0, frames * this.#negotiatedChannels);
+  }
+
+  release(batch: Float32Array | Float64Array) {
+    const length = this.#batchFrames * this.#negotiatedChannels;
+    if (
+      this.#pool.length < this.#poolSize &&
+      batch.byteOffset === 0 &&
+      batch.buffer.byteLength === length * this.#sampleFormat.byteSize &&
+      // Releasing twice, or a short batch and then its full one, would
+      // hand the same memory to two reads
+      !this.#pool.some((pooled) => pooled.buffer === batch.buffer)
+    ) {
+      if (batch.length === length) {
+        this.#pool.push(batch);
+      } else {
+        const ctor =
+          batch instanceof Float32Array ? Float32Array : Float64Array;
+        this.#pool.push(new ctor(batch.buffer, 0, length));
+      }
+    }
+  }
+
+  #createBatch(): Float32Array | Float64Array {
+    const length = this.#batchFrames * this.#negotiatedChannels;
+    return this.#sampleFormat === AudioFormat.Float32
+      ? new Float32Array(length)
+      : new Float64Array(length);
+  }
+
+  async *[Symbol.asyncIterator]() {
+    while (!this.#isDisposed) {
+      const batch = await this.read();
+      try {
+        yield batch;
+      } finally {
+        this.release(batch);
+      }
+    }
+  }
+
+  get format(): AudioFormat {
+    return this.#negotiatedFormat;
+  }
+
+  get channels(): number {
+    return this.#negotiatedChannels;
+  }
+
+  get rate(): number {
+    return this.#negotiatedRate;
+  }
+
+  get batchFrames(): number {
+    return this.#batchFrames;
+  }
+
+  get droppedFrames(): number {
+    return this.#nativeStream.droppedFrames;
+  }
+
+  get props(): AudioOutputStreamProps {
+    return this.#nativeStream.props;
+  }
+
+  async dispose() {
+    this.#isDisposed = true;
+    this.#pool = [];
+    this.#propsThrottle?.cancel();
+    await this.#nativeStream.destroy();
+    this.#isConnected = false;
+  }
+
+  [Symbol.asyncDispose]() {
+    return this.dispose();
+  }
+}
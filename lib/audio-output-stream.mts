@@ -5,7 +5,11 @@ import {
   getFormatPreferences,
   getRatePreferences,
 } from "./audio-quality.mjs";
-import type { NativePipeWireSession } from "./session.mjs";
+import { ResampleQuality } from "./resample-quality.mjs";
+import type {
+  NativePipeWireSession,
+  NativeStreamOptions,
+} from "./session.mjs";
 import * as Props from "./props.mjs";
 import {
   type Latency,
@@ -13,24 +17,128 @@ import {
   type StreamStateEnum,
   streamStateToName,
 } from "./stream.mjs";
-import { adaptSamples } from "./format-negotiation.mjs";
 import {
-  BufferStrategy,
-  getBufferConfigForQuality,
+  toNativeBufferRequest,
   type BufferConfig,
+  type NativeBufferRequest,
 } from "./buffer-config.mjs";
+import { createSharedRing } from "./shared-ring.mjs";
+import {
+  MixerInputImpl,
+  type MixerInput,
+  type MixerInputOpts,
+  type NativeMixer,
+} from "./mixer-input.mjs";
+import {
+  GeneratorImpl,
+  type Generator,
+  type GeneratorOpts,
+  type NativeGenerators,
+} from "./generator.mjs";
+import {
+  FilePlaybackImpl,
+  type FilePlayback,
+  type NativeFiles,
+  type PlayFileOpts,
+} from "./file-playback.mjs";
+import {
+  ScheduledClipImpl,
+  type NativeClips,
+  type ScheduledClip,
+  type ScheduleOpts,
+} from "./scheduled-clip.mjs";
+import {
+  EffectImpl,
+  toNativeEffectParams,
+  type Effect,
+  type EffectOpts,
+  type EffectType,
+  type InsertEffectOpts,
+  type NativeEffects,
+} from "./effects.mjs";
+import type { NativeVoices, TriggerOpts } from "./sample-cache.mjs";
+import type {
+  NativeOfflineRender,
+  OfflineRenderOpts,
+  OfflineRenderResult,
+} from "./offline-render.mjs";
+import {
+  assertScheduled,
+  RampCurve,
+  type AutomationLaneName,
+  type RampOpts,
+} from "./automation.mjs";
+import {
+  toNativeMetering,
+  type MeteringOpts,
+  type StreamLevels,
+} from "./level-meter.mjs";
+import {
+  ControlBatch,
+  throttleProps,
+  type NativeControls,
+  type StreamControls,
+} from "./stream-props.mjs";
+import {
+  toStreamStats,
+  type NativeStreamStats,
+  type StreamStats,
+} from "./stream-stats.mjs";
+import type { StreamTiming } from "./stream-timing.mjs";
+import {
+  decodeTrace,
+  GcTracer,
+  toChromeTrace,
+  toNativeTrace,
+  type ChromeTrace,
+  type NativeTrace,
+  type StreamTrace,
+  type TraceOpts,
+} from "./stream-trace.mjs";
 
-export interface NativeAudioOutputStream {
+// Effect target of the stream's own chain; mixer inputs use their id
+const STREAM_BUS = -1;
+
+export interface NativeAudioOutputStream
+  extends NativeMixer,
+    NativeGenerators,
+    NativeFiles,
+    NativeClips,
+    NativeOfflineRender,
+    NativeTrace,
+    NativeEffects,
+    NativeVoices {
   connect: (options?: {
     preferredFormats?: Array<number>;
     preferredRates?: Array<number>;
   }) => Promise<void>;
   disconnect: () => Promise<void>;
+  setActive: (active: boolean) => void;
   get writableFrames(): number;
   get framesPerQuantum(): number;
   get bufferSize(): number;
-  write: (data: ArrayBuffer) => void;
-  waitForBuffer: () => Promise<number>; // Returns number of frames available for writing
+  get stats(): NativeStreamStats;
+  get levels(): StreamLevels | undefined;
+  get props(): AudioOutputStreamProps; // Built from the native snapshot on every read
+  setControls: (controls: NativeControls) => void;
+  get renderPosition(): number;
+  get timing(): StreamTiming | undefined;
+  write: (data: ArrayBuffer | ArrayBufferView) => number; // Returns number of frames accepted
+  writePlanar: (
+    planes: ReadonlyArray<Float32Array | Float64Array>,
+    offset?: number
+  ) => number; // Returns number of frames accepted from offset
+  acquireBuffer: (frames?: number) => Float32Array | Float64Array; // A view of the ring itself
+  commit: (buffer: Float32Array | Float64Array, frames?: number) => number;
+  waitForBuffer: (opts?: { minFrames?: number }) => Promise<number>; // Returns number of frames available for writing
+  automate: (
+    lane: AutomationLaneName,
+    target: number,
+    frames: number,
+    startFrame: number,
+    curve: RampCurve
+  ) => boolean; // false when the lane's queue is full
+  resetAutomation: () => void; // Gain back to 1 and pan to 0, ramps cancelled
   isFinished: () => Promise<void>;
   destroy: () => Promise<void>;
 }
@@ -41,6 +149,12 @@ export interface NativeAudioOutputStream {
  *
  * @property name - Human-readable name displayed in PipeWire clients (default: "Node.js Audio")
  * @property rate - Sample rate in Hz (default: 48000)
+ * @property renderRate - Always take audio at this rate in Hz, resampling on
+ *   the real-time thread when the graph negotiates a different one. Offered
+ *   first in rate negotiation unless `preferredRates` is given (default: none,
+ *   audio is written at the negotiated rate)
+ * @property resampleQuality - Filter quality when `renderRate` needs resampling
+ *   (default: ResampleQuality.Balanced)
  * @property channels - Number of audio channels (default: 2 for stereo)
  * @property role - Audio role hint for PipeWire routing (default: "Music")
  * @property quality - Quality preset that affects format negotiation (default: AudioQuality.Standard)
@@ -48,7 +162,34 @@ export interface NativeAudioOutputStream {
  * @property preferredRates - Override sample rate negotiation order
  * @property autoConnect - Whether to auto-connect after creation (default: false)
  * @property buffering - Buffer configuration for performance optimization
- * @property enableMonitoring - Enable performance monitoring and diagnostics (default: false)
+ * @property inputFormat - Sample format of data handed to `write()`; must be
+ *   `AudioFormat.Float32` or `AudioFormat.Float64` (default: `AudioFormat.Float64`).
+ *   The native layer converts to the negotiated format.
+ * @property dither - Apply TPDF dither when converting to 8/16-bit formats (default: false)
+ * @property sharedRing - Read audio from a SharedArrayBuffer ring of at least
+ *   `frames` frames instead of `write()`; fill it from a worker with
+ *   `SharedRingWriter` (see `stream.sharedRing`)
+ * @property watermarks - Backpressure thresholds as fractions of the buffer:
+ *   writes fill it up to `high` (default: 1), and a blocked writer wakes once
+ *   it has drained to `low` (default: one quantum below `high`). A wide gap
+ *   means fewer, larger batches of rendering.
+ * @property enableMonitoring - Emit a `stats` event while connected, once a
+ *   second or every `intervalMs` (default: false)
+ * @property propsIntervalMs - Deliver `propsChange` at most this often;
+ *   changes in between are merged natively and only the latest is delivered
+ *   (default: 50)
+ * @property metering - Meter the output per channel on the real-time thread,
+ *   emitting a `levels` event and updating `stream.levels` at
+ *   `updatesPerSecond` (default: false)
+ * @property trace - Record every process callback, `write()` and wakeup,
+ *   plus garbage collection pauses, in a fixed-size native ring for
+ *   `readTrace()` and `exportTrace()` (default: false)
+ * @property effects - Up to 8 native effects to insert into the stream's
+ *   chain, in order, before it connects: an always-on safety limiter, say
+ *   (see `insertEffect()`). If one is rejected, creation fails and no
+ *   stream is left behind
+ * @property polyphony - Most voices `trigger()` plays at once, from 1 to 64;
+ *   triggering another fades out the oldest (default: 32)
  *
  * @example
  * ```typescript
@@ -65,6 +206,8 @@ export interface NativeAudioOutputStream {
 export interface AudioOutputStreamOpts {
   name?: string;
   rate?: number;
+  renderRate?: number;
+  resampleQuality?: ResampleQuality;
   channels?: number;
   role?:
     | "Movie"
@@ -83,21 +226,33 @@ export interface AudioOutputStreamOpts {
   preferredRates?: Array<number>;
   autoConnect?: boolean;
   buffering?: BufferConfig;
-  enableMonitoring?: boolean;
+  inputFormat?: AudioFormat;
+  dither?: boolean;
+  sharedRing?: { frames: number };
+  watermarks?: { low?: number; high?: number };
+  enableMonitoring?: boolean | { intervalMs?: number };
+  propsIntervalMs?: number;
+  metering?: boolean | MeteringOpts;
+  trace?: boolean | TraceOpts;
+  effects?: Array<EffectOpts>;
+  polyphony?: number;
 }
 
+/**
+ * Stream properties as PipeWire last reported them. Per-channel values are
+ * typed arrays in channel order; `channelMap` holds each channel's SPA
+ * position id. Properties PipeWire has not reported yet are absent, and the
+ * arrays empty.
+ */
 export interface AudioOutputStreamProps {
   volume: number;
   mute: boolean;
   monitorMute: boolean;
   softMute: boolean;
-  channels: Array<{
-    id: number;
-    volume: number;
-    mute: boolean;
-    monitorVolume: number;
-    softVolume: number;
-  }>;
+  channelVolumes: Float32Array;
+  channelMap: Uint32Array;
+  monitorVolumes: Float32Array;
+  softVolumes: Float32Array;
   params: Record<string, unknown>;
 }
 
@@ -108,7 +263,12 @@ interface AudioEvents {
   unknownParamChange: [number];
   stateChange: [StreamState];
   error: [Error];
-  bufferAdjusted: [{ oldSize: number; newSize: number; reason: string }];
+  bufferAdjusted: [
+    { oldSize: number; newSize: number; reason: "underrun" | "stable" },
+  ];
+  stats: [StreamStats];
+  levels: [StreamLevels];
+  quantumChange: [{ framesPerQuantum: number; rate: number }];
 }
 
 /**
@@ -170,13 +330,15 @@ interface AudioEvents {
  * ```
  *
  * ### `propsChange`
- * Emitted when stream properties (volume, mute, etc.) change.
+ * Emitted when stream properties (volume, mute, etc.) change. Changes are
+ * merged natively and delivered at most every `propsIntervalMs`, so a burst
+ * of them (a volume slider being dragged) arrives as its latest state.
  *
  * **Event payload:** `AudioOutputStreamProps`
  *
  * ```typescript
- * stream.on('propsChange', (props) => {
- *   console.log(`Volume: ${props.volume}, Muted: ${props.mute}`);
+ * stream.on('propsChange', ({ volume, mute, channelVolumes }) => {
+ *   console.log(`Volume: ${volume}, Muted: ${mute}, L/R: ${channelVolumes}`);
  * });
  * ```
  *
@@ -191,6 +353,56 @@ interface AudioEvents {
  * });
  * ```
  *
+ * ### `bufferAdjusted`
+ * Emitted when `BufferStrategy.Adaptive` resizes the buffer: it grows after
+ * an underrun and shrinks after a long run of clean playback. Adjustments
+ * made before the event loop runs are reported together.
+ *
+ * **Event payload:** `{ oldSize: number, newSize: number, reason: "underrun" | "stable" }` (sizes in bytes)
+ *
+ * ```typescript
+ * stream.on('bufferAdjusted', ({ oldSize, newSize, reason }) => {
+ *   console.log(`Buffer ${oldSize} -> ${newSize} bytes (${reason})`);
+ * });
+ * ```
+ *
+ * ### `quantumChange`
+ * Emitted when the graph's cycle size or rate changes, for example when
+ * another client asks for lower latency. `framesPerQuantum` is the number of
+ * frames this stream is asked for per cycle; `rate` is the graph rate.
+ *
+ * **Event payload:** `{ framesPerQuantum: number, rate: number }`
+ *
+ * ```typescript
+ * stream.on('quantumChange', ({ framesPerQuantum }) => {
+ *   blockSize = framesPerQuantum; // Render one cycle per block
+ * });
+ * ```
+ *
+ * ### `stats`
+ * Emitted periodically while connected when `enableMonitoring` is set.
+ *
+ * **Event payload:** `StreamStats`
+ *
+ * ```typescript
+ * stream.on('stats', ({ underruns, fillRatio }) => {
+ *   console.log(`${underruns} underruns, ${(fillRatio * 100).toFixed(1)}% filled`);
+ * });
+ * ```
+ *
+ * ### `levels`
+ * Emitted at `metering.updatesPerSecond` while audio plays, when `metering`
+ * is set. Readings that finish before the event loop runs are coalesced into
+ * the latest one.
+ *
+ * **Event payload:** `StreamLevels`
+ *
+ * ```typescript
+ * stream.on('levels', ({ peak, rms }) => {
+ *   meterBar.update(20 * Math.log10(peak[0]), 20 * Math.log10(rms[0]));
+ * });
+ * ```
+ *
  * ### `unknownParamChange`
  * Emitted when PipeWire sends an unrecognized parameter change.
  *
@@ -206,6 +418,8 @@ export interface AudioOutputStream extends EventEmitter<AudioEvents> {
   /**
    * Connect the stream to PipeWire audio system.
    * Triggers format negotiation and initializes audio processing.
+   * Reconnecting offers the previously negotiated format first, so an
+   * unchanged graph accepts it without another round of negotiation.
    */
   connect: () => Promise<void>;
 
@@ -215,12 +429,302 @@ export interface AudioOutputStream extends EventEmitter<AudioEvents> {
    */
   disconnect: () => Promise<void>;
 
+  /**
+   * Pause a connected stream. It stays connected with its negotiated format
+   * and buffers, but PipeWire stops scheduling it, so it costs nothing per
+   * cycle.
+   */
+  pause: () => void;
+
+  /**
+   * Resume a paused stream; audio starts within about one quantum.
+   */
+  resume: () => void;
+
   /**
    * Write audio samples to the stream.
-   * Samples are JavaScript Numbers (-1.0 to 1.0) converted to negotiated format.
+   * Samples are JavaScript Numbers (-1.0 to 1.0); the native layer converts
+   * them to the negotiated format. Overlapping calls to `write()`,
+   * `writeFrames()` and `writePlanar()` are queued and play in call order.
    */
   write: (samples: Iterable<number>) => Promise<void>;
 
+  /**
+   * Write pre-rendered interleaved frames to the stream.
+   * Fast path for bulk audio: the typed array (or a `subarray()` view of one)
+   * is copied straight into the native buffer with no per-sample JavaScript.
+   * Float32 data fed to a Float32 `inputFormat` stream (and Float64 to
+   * Float64) is copied as-is; the other width is converted while copying.
+   *
+   * @param frames - Interleaved samples; length must be a multiple of `channels`
+   *
+   * @example
+   * ```typescript
+   * const frames = new Float32Array(stream.rate * stream.channels);
+   * renderInto(frames);
+   * await stream.writeFrames(frames);
+   * ```
+   */
+  writeFrames: (frames: Float32Array | Float64Array) => Promise<void>;
+
+  /**
+   * Write one array per channel instead of interleaved frames.
+   * The planes are interleaved natively (with SIMD for stereo) on their way
+   * into the buffer, so per-channel DSP needs no JavaScript interleave loop.
+   * If the graph negotiated a planar format (e.g. `AudioFormat.Float32Planar`
+   * via `preferredFormats`), the real-time thread hands PipeWire one plane
+   * per channel as well.
+   *
+   * @param planes - One array per channel, all the same length, of the
+   * stream's `inputFormat` type
+   *
+   * @example
+   * ```typescript
+   * const left = new Float32Array(1024);
+   * const right = new Float32Array(1024);
+   * renderStereo(left, right);
+   * await stream.writePlanar([left, right]);
+   * ```
+   */
+  writePlanar: (
+    planes: ReadonlyArray<Float32Array | Float64Array>
+  ) => Promise<void>;
+
+  /**
+   * Borrow space in the stream's own buffer to render into.
+   * The returned array (Float32 or Float64, per `inputFormat`) is a view of
+   * native memory, so nothing is allocated or copied per block. It holds up
+   * to `frames` interleaved frames (default: all writable frames) and may be
+   * shorter, or empty when the buffer is full; wait with `waitForBuffer()`.
+   * Pass it to `commit()` to queue it for playback; acquiring again, or
+   * calling `write()`, abandons the previous buffer. Its `.buffer` covers
+   * only the acquired space. Throws while a `write()`, `writeFrames()` or
+   * `writePlanar()` is still in progress, as does `commit()`.
+   *
+   * @param frames - Most frames wanted
+   *
+   * @example
+   * ```typescript
+   * for (;;) {
+   *   await stream.waitForBuffer();
+   *   const block = stream.acquireBuffer(stream.framesPerQuantum);
+   *   render(block);
+   *   stream.commit(block);
+   * }
+   * ```
+   */
+  acquireBuffer: (frames?: number) => Float32Array | Float64Array;
+
+  /**
+   * Queue a buffer from `acquireBuffer()` for playback without copying it.
+   *
+   * @param buffer - The array most recently returned by `acquireBuffer()`
+   * @param frames - Frames actually rendered (default: the whole buffer)
+   */
+  commit: (buffer: Float32Array | Float64Array, frames?: number) => void;
+
+  /**
+   * Attach a native mixer input to the stream.
+   * Inputs are summed with audio from `write()` on the PipeWire real-time
+   * thread, so many voices can share one stream without per-voice
+   * JavaScript on each quantum. A stream mixes at most 64 inputs.
+   *
+   * @param opts - Channel layout, buffer size, gain and pan of the input
+   *
+   * @example
+   * ```typescript
+   * const left = stream.addMixerInput({ pan: -1 });
+   * const right = stream.addMixerInput({ pan: 1, gain: 0.5 });
+   * await Promise.all([left.write(kick), right.write(hats)]);
+   * ```
+   */
+  addMixerInput: (opts?: MixerInputOpts) => MixerInput;
+
+  /**
+   * Attach a native tone or noise generator to the stream.
+   * The generator is synthesized on the PipeWire real-time thread and mixed
+   * like a mono mixer input, so JavaScript only sends parameter changes.
+   * It shares the stream's 64 mixer slots.
+   *
+   * @param opts - Waveform, frequency, amplitude, phase, gain and pan
+   *
+   * @example
+   * ```typescript
+   * const beep = stream.addGenerator({
+   *   waveform: Waveform.Square,
+   *   frequency: 880,
+   *   amplitude: 0.2,
+   * });
+   * await setTimeout(150);
+   * beep.remove();
+   * ```
+   */
+  addGenerator: (opts?: GeneratorOpts) => Generator;
+
+  /**
+   * Play a WAV or headerless PCM file through the stream's mixer.
+   * The file is memory-mapped and paged in off the JavaScript thread, then
+   * decoded on the PipeWire real-time thread as it is mixed. It shares the
+   * stream's 64 mixer slots and must be at the stream's render rate; create
+   * the stream with `renderRate` set to the file's rate to play it on any
+   * graph.
+   *
+   * @param path - File to play
+   * @param opts - Start offset, looping, gain, pan and the raw PCM layout
+   * @returns The playback, once the file is mapped and mixing
+   *
+   * @example
+   * ```typescript
+   * const stream = await session.createAudioOutputStream({
+   *   renderRate: 44_100,
+   * });
+   * const chime = await stream.playFile("chime.wav", { gain: 0.5 });
+   * await chime.finished();
+   * ```
+   */
+  playFile: (path: string, opts?: PlayFileOpts) => Promise<FilePlayback>;
+
+  /**
+   * Play samples starting at an exact frame, or at an exact time by the
+   * stream's `timing`. The samples are copied into a native mixer slot that
+   * stays silent until the start frame comes up and then mixes from that
+   * offset inside the quantum, so no leading silence is written or stored.
+   * The slot is freed once the clip has played.
+   *
+   * @param samples - Float32 samples, interleaved when `channels` > 1
+   * @param opts - Start frame or time, channel count, gain and pan
+   *
+   * @example
+   * ```typescript
+   * // Four clicks a quarter of a second apart, starting one second from now
+   * const start = stream.renderPosition + stream.renderRate;
+   * for (let i = 0; i < 4; i++) {
+   *   stream.schedule(click, { atFrame: start + (i * stream.renderRate) / 4 });
+   * }
+   * ```
+   */
+  schedule: (samples: Float32Array, opts: ScheduleOpts) => ScheduledClip;
+
+  /**
+   * Play a sample loaded with `session.loadSample()`. The voice mixes the
+   * session's cached copy in place on the PipeWire real-time thread and
+   * frees its mixer slot when it ends, so nothing is copied, allocated or
+   * tracked in JavaScript. Once `polyphony` voices are playing, each new
+   * one steals the oldest, which fades out over a few milliseconds instead
+   * of clicking.
+   *
+   * @param id - Sample to play
+   * @param opts - Gain, pan and start frame or time
+   * @returns Frame on the `renderPosition` timeline the voice starts at
+   *
+   * @example
+   * ```typescript
+   * session.loadSample("footstep", footstep);
+   * stream.trigger("footstep", { pan: -0.3 });
+   * stream.trigger("footstep", { atFrame: stream.renderPosition + 12_000 });
+   * ```
+   */
+  trigger: (id: string, opts?: TriggerOpts) => number;
+
+  /**
+   * Render the stream to a file as fast as the CPU allows, instead of
+   * playing it through the graph. Files, scheduled clips, generators, mixer
+   * inputs and automation all render exactly as they would play, on the same
+   * timeline, and `renderPosition` advances by the frames rendered. Audio
+   * comes from what the sources already hold: nothing waits for `write()`
+   * or mixer input writes. The stream must be disconnected, and stays so
+   * until the render finishes.
+   *
+   * @param path - File to write
+   * @param opts - Length, sample format, rate and container
+   * @returns What was written
+   *
+   * @example
+   * ```typescript
+   * const stream = await session.createAudioOutputStream({
+   *   renderRate: 48_000,
+   *   autoConnect: false,
+   * });
+   * await stream.playFile("stems/drums.wav");
+   * await stream.playFile("stems/bass.wav", { gain: 0.8 });
+   * await stream.renderToFile("bounce.wav", {
+   *   frames: 48_000 * 600, // Ten minutes, rendered in seconds
+   *   format: AudioFormat.Int16,
+   * });
+   * ```
+   */
+  renderToFile: (
+    path: string,
+    opts: OfflineRenderOpts
+  ) => Promise<OfflineRenderResult>;
+
+  /**
+   * Insert a native effect into the stream's chain. The chain runs on the
+   * PipeWire real-time thread over everything the stream plays, after the
+   * mixer and master gain and before metering, so a safety limiter or EQ
+   * costs microseconds per quantum instead of JavaScript per sample.
+   *
+   * @param opts - Effect type, its parameters and its place in the chain
+   * @returns The effect, already running
+   *
+   * @example
+   * ```typescript
+   * stream.insertEffect({ type: "biquad", shape: BiquadShape.Highpass, frequency: 40 });
+   * const limiter = stream.insertEffect({ type: "limiter", thresholdDb: -1 });
+   * ```
+   */
+  insertEffect: <T extends EffectType>(
+    opts: Extract<EffectOpts, { type: T }> & InsertEffectOpts
+  ) => Effect<T>;
+
+  /**
+   * Ramp the stream's master gain to `target` over `frames` frames. The ramp
+   * is rendered sample by sample on the PipeWire real-time thread, after
+   * mixing, so it reaches the speakers exactly at the frames it was
+   * scheduled for however much audio is already buffered.
+   *
+   * @param target - Linear gain to end at
+   * @param frames - Length of the ramp at `renderRate`; 0 jumps
+   * @param opts - Start frame on the `renderPosition` timeline and curve
+   *
+   * @example
+   * ```typescript
+   * // Fade everything out over two seconds, starting one second from now
+   * stream.rampGain(0, stream.renderRate * 2, {
+   *   startFrame: stream.renderPosition + stream.renderRate,
+   *   curve: RampCurve.Exponential,
+   * });
+   * ```
+   */
+  rampGain: (target: number, frames: number, opts?: RampOpts) => void;
+
+  /**
+   * Ramp the stream's master balance to `target`, from -1 (left only) to
+   * +1 (right only), over `frames` frames. Only stereo streams are balanced.
+   */
+  rampPan: (target: number, frames: number, opts?: RampOpts) => void;
+
+  /**
+   * Wait until at least `minFrames` frames can be written, for renderers
+   * that fill several quanta per wakeup.
+   * Without `minFrames` the stream's `watermarks` decide.
+   *
+   * @returns The number of frames that can be written without waiting
+   *
+   * @example
+   * ```typescript
+   * const frames = await stream.waitForBuffer({ minFrames: 1024 });
+   * await stream.writeFrames(render(frames));
+   * ```
+   */
+  waitForBuffer: (opts?: { minFrames?: number }) => Promise<number>;
+
+  /**
+   * Frames that can be written right now without waiting (up to the high
+   * watermark).
+   */
+  get writableFrames(): number;
+
   /**
    * Wait for all buffered audio to finish playing.
    * Useful for ensuring complete playback before cleanup.
@@ -251,6 +755,38 @@ export interface AudioOutputStream extends EventEmitter<AudioEvents> {
    */
   get rate(): number;
 
+  /**
+   * Get the rate in Hz that `write()` and the other writers take audio at:
+   * the `renderRate` option when one was given, otherwise the negotiated rate.
+   */
+  get renderRate(): number;
+
+  /**
+   * Frames rendered so far at `renderRate`: the timeline ramps are scheduled
+   * on. Audio written now is rendered once everything already buffered
+   * has played.
+   */
+  get renderPosition(): number;
+
+  /**
+   * Where playback actually is, from PipeWire's own clock: frames played,
+   * output latency and when the next frame written will be heard. The
+   * times are sampled on the real-time thread in every process callback,
+   * so reading them adds no JavaScript timing jitter. Undefined until the
+   * stream has processed its first cycle.
+   *
+   * @example
+   * ```typescript
+   * const timing = stream.timing;
+   * if (timing) {
+   *   // Show the video frame whose audio is reaching the speakers now
+   *   const seconds = timing.playedFrames / stream.renderRate;
+   *   video.seek(seconds);
+   * }
+   * ```
+   */
+  get timing(): StreamTiming | undefined;
+
   /**
    * Get the buffer size in bytes.
    * This represents the total internal buffer size as negotiated
@@ -261,6 +797,75 @@ export interface AudioOutputStream extends EventEmitter<AudioEvents> {
    */
   get bufferSize(): number;
 
+  /**
+   * Frames PipeWire asks this stream for each cycle. Tracks the live graph
+   * quantum once connected; `quantumChange` is emitted when it changes.
+   */
+  get framesPerQuantum(): number;
+
+  /**
+   * The SharedArrayBuffer ring the stream plays from, when created with the
+   * `sharedRing` option. Post it to a worker and wrap it in a
+   * `SharedRingWriter`; `write()` and `writeFrames()` are unavailable.
+   */
+  get sharedRing(): SharedArrayBuffer | undefined;
+
+  /**
+   * Playback counters kept by the PipeWire real-time thread: underruns,
+   * zero-filled frames, missed buffers and process callback timing.
+   * Cheap enough to read on every write.
+   */
+  get stats(): StreamStats;
+
+  /**
+   * The individual cycles, writes, wakeups and GC pauses the trace ring
+   * holds, oldest first, when the stream was created with `trace`. Reading
+   * does not clear the ring; it keeps the latest `trace.capacity` events.
+   */
+  readTrace: () => StreamTrace | undefined;
+
+  /**
+   * The trace as Chrome trace events, with the real-time thread and
+   * JavaScript on separate tracks, when the stream was created with `trace`.
+   *
+   * @example
+   * ```typescript
+   * const stream = await session.createAudioOutputStream({ trace: true });
+   * // ... play until something glitches ...
+   * await writeFile("glitch.json", JSON.stringify(stream.exportTrace()));
+   * // Open glitch.json in https://ui.perfetto.dev or chrome://tracing
+   * ```
+   */
+  exportTrace: () => ChromeTrace | undefined;
+
+  /**
+   * Stream properties as PipeWire last reported them.
+   */
+  get props(): AudioOutputStreamProps;
+
+  /**
+   * Change the stream's volume, mute or per-channel volumes. Calls made in
+   * the same turn of the event loop are merged and sent to PipeWire as one
+   * control update; `propsChange` reports the result.
+   *
+   * @param controls - Controls to change; others keep their values
+   *
+   * @example
+   * ```typescript
+   * stream.setProps({ volume: 0.5, channelVolumes: [1, 0.8] });
+   * stream.setProps({ mute: false }); // Sent together with the call above
+   * ```
+   */
+  setProps: (controls: StreamControls) => void;
+
+  /**
+   * The latest reading of the native level meters, when the stream was
+   * created with `metering`: per-channel peak and RMS of the audio handed
+   * to PipeWire. Reading it costs no scan of the audio, so it can be polled
+   * for many streams.
+   */
+  get levels(): StreamLevels | undefined;
+
   /**
    * Check if the stream is currently connected to PipeWire.
    */
@@ -290,34 +895,115 @@ export class AudioOutputStreamImpl
     opts?: AudioOutputStreamOpts
   ): Promise<AudioOutputStream> {
     const stream = new AudioOutputStreamImpl();
-    await stream.#init(session, opts);
+    const native = await session.createAudioOutputStream(
+      stream.#configure(opts)
+    );
+    try {
+      stream.#attach(native);
+    } catch (error) {
+      await native.destroy();
+      throw error;
+    }
     return stream;
   }
 
+  static async createAll(
+    session: NativePipeWireSession,
+    optsList: Array<AudioOutputStreamOpts | undefined>
+  ): Promise<Array<AudioOutputStream>> {
+    const streams = optsList.map(() => new AudioOutputStreamImpl());
+    const natives = await session.createAudioOutputStreams(
+      streams.map((stream, i) => stream.#configure(optsList[i]))
+    );
+    try {
+      streams.forEach((stream, i) => stream.#attach(natives[i]));
+    } catch (error) {
+      // An effect the native side rejected: none of the batch is usable
+      await Promise.all(natives.map((native) => native.destroy()));
+      throw error;
+    }
+    return streams;
+  }
+
+  static async connectAll(
+    session: NativePipeWireSession,
+    streams: Array<AudioOutputStream>
+  ) {
+    const pending: Array<AudioOutputStreamImpl> = [];
+    for (const stream of new Set(streams)) {
+      if (!(stream instanceof AudioOutputStreamImpl)) {
+        throw new TypeError("connectAll() only connects output streams");
+      }
+      if (!stream.#isConnected) {
+        pending.push(stream);
+      }
+    }
+
+    const negotiations = pending.map(
+      (stream) => !stream.#negotiatedFormat && once(stream, "formatChange")
+    );
+    await session.connectStreams(
+      pending.map((stream) => ({
+        stream: stream.#nativeStream,
+        ...stream.#connectRequest(),
+      }))
+    );
+
+    await Promise.all(negotiations);
+    for (const stream of pending) {
+      stream.#isConnected = true;
+      stream.#startMonitoring();
+    }
+  }
+
   #nativeStream!: NativeAudioOutputStream;
   #connectionConfig!: {
     quality: AudioQuality;
     preferredFormats?: Array<AudioFormat>;
     preferredRates?: Array<number>;
   };
+  #renderRate?: number;
   #isConnected = false;
   #autoConnect = false;
 
+  #inputFormat: AudioFormat = AudioFormat.Float64;
+  #sharedRing?: SharedArrayBuffer;
   #negotiatedFormat!: AudioFormat;
   #negotiatedChannels = 2;
   #negotiatedRate = 48_000;
+  #monitoringIntervalMs?: number;
+  #monitoringTimer?: NodeJS.Timeout;
+  #propsThrottle?: ReturnType<typeof throttleProps>;
+  #name = "PipeWireStream";
+  #gcTracer?: GcTracer;
+  #traceGc = false;
+  #effects: Array<EffectOpts> = [];
+  #polyphony = 32;
+  // write(), writeFrames() and writePlanar() run one after another, so one
+  // never acquires or advances the ring while another holds a region of it
+  #writes: Promise<void> = Promise.resolve();
+  #pendingWrites = 0;
+  readonly #oneShots = new Set<FilePlaybackImpl | ScheduledClipImpl>();
+  // Mixer inputs, generators and effects handed out and not yet removed
+  readonly #owned = new Set<{ remove: () => void }>();
+  readonly #controls = new ControlBatch((controls) => {
+    try {
+      this.#nativeStream.setControls(controls);
+    } catch (error) {
+      this.emit("error", error as Error);
+    }
+  });
 
   private constructor() {
     super();
   }
 
-  async #init(
-    session: NativePipeWireSession,
-    opts: AudioOutputStreamOpts = {}
-  ) {
+  #configure(opts: AudioOutputStreamOpts = {}): NativeStreamOptions {
     const {
       name = "PipeWireStream",
       rate = 48_000,
+      renderRate,
+      resampleQuality = ResampleQuality.Balanced,
       channels = 2,
       role,
       quality = AudioQuality.Standard,
@@ -325,21 +1011,81 @@ export class AudioOutputStreamImpl
       preferredRates,
       autoConnect = false,
       buffering,
-      enableMonitoring: _enableMonitoring = false,
+      inputFormat = AudioFormat.Float64,
+      dither = false,
+      sharedRing,
+      watermarks,
+      enableMonitoring = false,
+      propsIntervalMs = 50,
+      metering = false,
+      trace = false,
+      effects = [],
+      polyphony = 32,
     } = opts;
 
+    if (
+      inputFormat !== AudioFormat.Float32 &&
+      inputFormat !== AudioFormat.Float64
+    ) {
+      throw new Error("inputFormat must be AudioFormat.Float32 or Float64");
+    }
+    if (!Number.isInteger(polyphony) || polyphony < 1 || polyphony > 64) {
+      throw new RangeError("polyphony must be a whole number from 1 to 64");
+    }
+    if (effects.length > 8) {
+      throw new RangeError("effects holds at most 8 effects");
+    }
+
+    this.#name = name;
     this.#autoConnect = autoConnect;
+    this.#inputFormat = inputFormat;
+    this.#renderRate = renderRate;
     this.#connectionConfig = { quality, preferredFormats, preferredRates };
+    this.#propsThrottle = throttleProps(propsIntervalMs, () => {
+      if (this.listenerCount("propsChange")) {
+        this.emit("propsChange", this.#nativeStream.props);
+      }
+    });
+    if (enableMonitoring) {
+      this.#monitoringIntervalMs =
+        (enableMonitoring !== true && enableMonitoring.intervalMs) || 1000;
+    }
+    if (sharedRing) {
+      this.#sharedRing = createSharedRing(
+        sharedRing.frames,
+        channels,
+        inputFormat
+      );
+    }
 
-    this.#nativeStream = await this.#createNativeStream(session, {
+    this.#traceGc = !!trace && (trace === true || trace.gc !== false);
+    this.#effects = effects;
+    this.#polyphony = polyphony;
+    return this.#nativeOptions({
       name,
-      rate,
+      rate: renderRate ?? rate,
+      renderRate,
+      resampleQuality,
       channels,
-      buffering: this.#buildBufferingConfig(buffering, quality),
+      dither,
+      buffering: toNativeBufferRequest(buffering, quality),
+      watermarks,
+      metering: toNativeMetering(metering),
+      trace: toNativeTrace(trace),
       props: this.#buildMediaProps(role),
     });
   }
 
+  #attach(native: NativeAudioOutputStream) {
+    this.#nativeStream = native;
+    for (const effect of this.#effects) {
+      native.insertEffect(STREAM_BUS, toNativeEffectParams(effect));
+    }
+    if (this.#traceGc) {
+      this.#gcTracer = new GcTracer(native);
+    }
+  }
+
   #buildMediaProps(role?: string) {
     const props: Record<string, string> = {
       [Props.Media.Type]: "Audio",
@@ -353,53 +1099,33 @@ export class AudioOutputStreamImpl
     return props;
   }
 
-  #buildBufferingConfig(
-    bufferConfig?: BufferConfig,
-    quality: AudioQuality = AudioQuality.Standard
-  ) {
-    const effectiveBufferConfig =
-      bufferConfig ?? getBufferConfigForQuality(quality);
-
-    switch (effectiveBufferConfig.strategy) {
-      case BufferStrategy.MinimalLatency:
-        return { requestedQuanta: 1 };
-      case BufferStrategy.LowLatency:
-        return { requestedQuanta: 2 };
-      case BufferStrategy.Balanced:
-        return { requestedQuanta: 4 };
-      case BufferStrategy.Smooth:
-        return { requestedQuanta: 8 };
-      case BufferStrategy.QuantumMultiplier:
-        return { requestedQuanta: effectiveBufferConfig.multiplier };
-      case BufferStrategy.MaxSize:
-        return { requestedBytes: effectiveBufferConfig.bytes };
-      case BufferStrategy.MaxLatency:
-        return { requestedMs: effectiveBufferConfig.milliseconds };
-    }
-  }
-
-  async #createNativeStream(
-    session: NativePipeWireSession,
-    config: {
-      name: string;
-      rate: number;
-      channels: number;
-      props: Record<string, string>;
-      buffering?: {
-        requestedQuanta?: number;
-        requestedBytes?: number;
-        requestedMs?: number;
-      };
-    }
-  ) {
-    return await session.createAudioOutputStream({
+  #nativeOptions(config: {
+    name: string;
+    rate: number;
+    renderRate?: number;
+    resampleQuality: ResampleQuality;
+    channels: number;
+    dither: boolean;
+    props: Record<string, string>;
+    buffering?: NativeBufferRequest;
+    watermarks?: { low?: number; high?: number };
+    metering?: { updatesPerSecond: number; truePeak: boolean };
+    trace?: { capacity: number };
+  }): NativeStreamOptions {
+    return {
       name: config.name,
-      format: AudioFormat.Float64.enumValue,
-      bytesPerSample: AudioFormat.Float64.byteSize,
+      inputFormat: this.#inputFormat.enumValue,
+      dither: config.dither,
+      sharedRing: this.#sharedRing && new Uint8Array(this.#sharedRing),
       rate: config.rate,
+      renderRate: config.renderRate,
+      resampleQuality: config.resampleQuality,
       channels: config.channels,
       props: config.props,
       buffering: config.buffering,
+      watermarks: config.watermarks,
+      metering: config.metering,
+      trace: config.trace,
       onStateChange: (state: StreamStateEnum, error: string) => {
         const streamState = streamStateToName[state];
         if (streamState) {
@@ -411,16 +1137,28 @@ export class AudioOutputStreamImpl
       },
       onLatencyChange: (latency: Latency) =>
         this.emit("latencyChange", latency),
-      onPropsChange: (props: AudioOutputStreamProps) =>
-        this.emit("propsChange", props),
+      onPropsChange: () => this.#propsThrottle?.notify(),
       onUnknownParamChange: (param: number) =>
         this.emit("unknownParamChange", param),
+      onBufferAdjusted: (adjustment: {
+        oldSize: number;
+        newSize: number;
+        reason: string;
+      }) =>
+        this.emit("bufferAdjusted", {
+          ...adjustment,
+          reason: adjustment.reason as "underrun" | "stable",
+        }),
+      onQuantumChange: (quantum: { framesPerQuantum: number; rate: number }) =>
+        this.emit("quantumChange", quantum),
+      onLevels: (levels: StreamLevels) => this.emit("levels", levels),
+      onInputEnded: () => this.#pollOneShots(),
       onFormatChange: (format: {
         format: number;
         channels: number;
         rate: number;
       }) => this.#handleFormatChange(format),
-    });
+    };
   }
 
   #handleFormatChange(format: {
@@ -451,25 +1189,34 @@ export class AudioOutputStreamImpl
       return; // Already connected
     }
 
-    const preferredFormats =
-      this.#connectionConfig.preferredFormats ??
-      getFormatPreferences(this.#connectionConfig.quality);
-
-    const preferredRates =
-      this.#connectionConfig.preferredRates ??
-      getRatePreferences(this.#connectionConfig.quality);
-
     // If format already negotiated, we can reuse it
     const formatNegotiation =
       !this.#negotiatedFormat && once(this, "formatChange");
 
-    await this.#nativeStream.connect({
-      preferredFormats: preferredFormats.map((f) => f.enumValue),
-      preferredRates,
-    });
+    await this.#nativeStream.connect(this.#connectRequest());
 
     await formatNegotiation;
     this.#isConnected = true;
+    this.#startMonitoring();
+  }
+
+  #connectRequest() {
+    const preferredFormats =
+      this.#connectionConfig.preferredFormats ??
+      getFormatPreferences(this.#connectionConfig.quality);
+
+    // Ask for the render rate first; resampling covers any other outcome
+    const preferredRates = this.#connectionConfig.preferredRates ?? [
+      ...(this.#renderRate ? [this.#renderRate] : []),
+      ...getRatePreferences(this.#connectionConfig.quality).filter(
+        (rate) => rate !== this.#renderRate
+      ),
+    ];
+
+    return {
+      preferredFormats: preferredFormats.map((f) => f.enumValue),
+      preferredRates,
+    };
   }
 
   async disconnect() {
@@ -479,64 +1226,298 @@ export class AudioOutputStreamImpl
 
     await this.#nativeStream.disconnect();
     this.#isConnected = false;
+    this.#stopMonitoring();
+  }
+
+  pause() {
+    if (!this.#isConnected) {
+      throw new Error("Only a connected stream can be paused");
+    }
+    this.#nativeStream.setActive(false);
+  }
+
+  resume() {
+    if (!this.#isConnected) {
+      throw new Error("Only a connected stream can be resumed");
+    }
+    this.#nativeStream.setActive(true);
+  }
+
+  #startMonitoring() {
+    if (this.#monitoringIntervalMs && !this.#monitoringTimer) {
+      this.#monitoringTimer = setInterval(
+        () => this.emit("stats", this.stats),
+        this.#monitoringIntervalMs
+      );
+      this.#monitoringTimer.unref();
+    }
+  }
+
+  #stopMonitoring() {
+    clearInterval(this.#monitoringTimer);
+    this.#monitoringTimer = undefined;
   }
 
   get isConnected(): boolean {
     return this.#isConnected;
   }
 
-  async write(samples: Iterable<number>) {
+  write(samples: Iterable<number>) {
+    return this.#queueWrite(() => this.#writeIterable(samples));
+  }
+
+  writeFrames(frames: Float32Array | Float64Array) {
+    return this.#queueWrite(() => this.#writeFrames(frames));
+  }
+
+  writePlanar(planes: ReadonlyArray<Float32Array | Float64Array>) {
+    return this.#queueWrite(() => this.#writePlanar(planes));
+  }
+
+  #queueWrite(write: () => Promise<void>) {
+    this.#pendingWrites++;
+    return this.#queue(write).finally(() => this.#pendingWrites--);
+  }
+
+  #queue<T>(task: () => Promise<T>) {
+    const result = this.#writes.then(task);
+    this.#writes = result.then(
+      () => undefined,
+      () => undefined // A failed write doesn't stop the next
+    );
+    return result;
+  }
+
+  // acquireBuffer() and commit() are synchronous and cannot wait their
+  // turn, so they refuse to run while a queued write may hold the ring
+  #assertNoPendingWrite(method: string) {
+    if (this.#pendingWrites) {
+      throw new Error(
+        `${method}() cannot be used while a write() is in progress; await it first`
+      );
+    }
+  }
+
+  async #writeIterable(samples: Iterable<number>) {
+    await this.#ensureConnected();
+
+    const channels = this.#negotiatedChannels;
+
+    // Samples go straight into the native ring, one quantum at a time
+    let block = await this.#acquireQuantum();
+    let offset = 0;
+
+    for (const sample of samples) {
+      if (offset >= block.length) {
+        this.#nativeStream.commit(block);
+        block = await this.#acquireQuantum();
+        offset = 0;
+      }
+      block[offset++] = sample;
+    }
+
+    // Commit what was filled, padded to a whole frame
+    const frames = Math.ceil(offset / channels);
+    block.fill(0, offset, frames * channels);
+    this.#nativeStream.commit(block, frames);
+  }
+
+  async #writeFrames(frames: Float32Array | Float64Array) {
+    await this.#ensureConnected();
+
+    if (frames.length % this.#negotiatedChannels !== 0) {
+      throw new Error(
+        `writeFrames() needs whole frames: ${frames.length} samples is not a multiple of ${this.#negotiatedChannels} channels`
+      );
+    }
+
+    await this.#writeSamples(frames);
+  }
+
+  async #writePlanar(planes: ReadonlyArray<Float32Array | Float64Array>) {
+    await this.#ensureConnected();
+
+    const frames = planes[0]?.length ?? 0;
+    let written = this.#nativeStream.writePlanar(planes);
+    while (written < frames) {
+      await this.#nativeStream.waitForBuffer();
+      written += this.#nativeStream.writePlanar(planes, written);
+    }
+  }
+
+  async #ensureConnected() {
     if (!this.#isConnected && this.#autoConnect) {
       await this.connect();
     }
 
+    this.#assertConnected();
+  }
+
+  async #acquireQuantum() {
+    const frames = this.#nativeStream.framesPerQuantum;
+    let block = this.#nativeStream.acquireBuffer(frames);
+    while (!block.length) {
+      await this.#nativeStream.waitForBuffer();
+      block = this.#nativeStream.acquireBuffer(frames);
+    }
+    return block;
+  }
+
+  #assertConnected() {
     if (!this.#isConnected) {
       throw new Error(
         "Stream must be connected before writing audio data. Call await stream.connect() first."
       );
     }
+  }
 
-    if (this.#negotiatedFormat !== AudioFormat.Float64) {
-      samples = adaptSamples(samples, this.#negotiatedFormat);
+  /**
+   * Hands a view to the native ring, waiting for space whenever the ring
+   * accepts only part of it.
+   */
+  async #writeSamples(samples: Float32Array | Float64Array) {
+    const channels = this.#negotiatedChannels;
+
+    let written = this.#nativeStream.write(samples) * channels;
+    while (written < samples.length) {
+      await this.#nativeStream.waitForBuffer();
+      written += this.#nativeStream.write(samples.subarray(written)) * channels;
     }
+  }
 
-    const framesPerQuantum = this.#nativeStream.framesPerQuantum;
-    const samplesPerQuantum = framesPerQuantum * this.#negotiatedChannels;
+  addMixerInput(opts?: MixerInputOpts): MixerInput {
+    return this.#own(
+      (onRemove) => new MixerInputImpl(this.#nativeStream, opts, onRemove)
+    );
+  }
 
-    let quantumBuffer = this.#negotiatedFormat.BufferClass(samplesPerQuantum);
-    let quantumOffset = 0;
-    let availableFrames = this.#nativeStream.writableFrames;
+  addGenerator(opts?: GeneratorOpts): Generator {
+    return this.#own(
+      (onRemove) => new GeneratorImpl(this.#nativeStream, opts, onRemove)
+    );
+  }
 
-    for (const sample of samples) {
-      quantumBuffer.set(quantumOffset++, sample);
+  #own<T extends { remove: () => void }>(
+    create: (onRemove: () => void) => T
+  ): T {
+    const owned: T = create(() => this.#owned.delete(owned));
+    this.#owned.add(owned);
+    return owned;
+  }
 
-      if (quantumOffset >= samplesPerQuantum) {
-        if (availableFrames < framesPerQuantum) {
-          availableFrames = await this.#nativeStream.waitForBuffer();
-        }
+  async playFile(path: string, opts?: PlayFileOpts): Promise<FilePlayback> {
+    const playback = await FilePlaybackImpl.create(
+      this.#nativeStream,
+      path,
+      opts
+    );
+    this.#track(playback);
+    playback.poll(); // A short file may have ended before it was tracked
+    return playback;
+  }
 
-        this.#nativeStream.write(quantumBuffer.buffer);
-        availableFrames -= framesPerQuantum;
+  schedule(samples: Float32Array, opts: ScheduleOpts): ScheduledClip {
+    const clip = new ScheduledClipImpl(this.#nativeStream, samples, opts);
+    this.#track(clip);
+    return clip;
+  }
 
-        // Reset for next quantum
-        quantumBuffer = this.#negotiatedFormat.BufferClass(samplesPerQuantum);
-        quantumOffset = 0;
-      }
+  trigger(
+    id: string,
+    { gain = 1, pan = 0, atFrame = NaN, atTimeNs = NaN }: TriggerOpts = {}
+  ): number {
+    if (!Number.isNaN(atFrame) && !Number.isNaN(atTimeNs)) {
+      throw new TypeError("trigger() takes atFrame or atTimeNs, not both");
     }
+    return this.#nativeStream.triggerSample(
+      id,
+      gain,
+      pan,
+      atFrame,
+      atTimeNs,
+      this.#polyphony
+    );
+  }
 
-    // Send any remaining partial quantum
-    if (quantumOffset > 0) {
-      const partialFrames = Math.ceil(quantumOffset / this.#negotiatedChannels);
+  insertEffect<T extends EffectType>(
+    opts: Extract<EffectOpts, { type: T }> & InsertEffectOpts
+  ): Effect<T> {
+    return this.#own(
+      (onRemove) =>
+        new EffectImpl<T>(this.#nativeStream, STREAM_BUS, opts, onRemove)
+    );
+  }
 
-      // If no buffer space available for the partial quantum, wait for it
-      if (availableFrames < partialFrames) {
-        await this.#nativeStream.waitForBuffer();
-      }
+  async renderToFile(
+    path: string,
+    { frames, format, rate, container = "wav" }: OfflineRenderOpts
+  ): Promise<OfflineRenderResult> {
+    if (this.#isConnected) {
+      throw new Error("Disconnect the stream before rendering offline");
+    }
+    return this.#nativeStream.renderOffline(path, {
+      frames,
+      format: format?.enumValue,
+      rate,
+      wav: container === "wav",
+    });
+  }
 
-      this.#nativeStream.write(quantumBuffer.subarray(0, quantumOffset).buffer);
+  // Files and clips free their own slots once the RT thread reports them done
+  #track(oneShot: FilePlaybackImpl | ScheduledClipImpl) {
+    this.#oneShots.add(oneShot);
+    oneShot.finished().then(() => this.#oneShots.delete(oneShot));
+  }
+
+  #pollOneShots() {
+    for (const oneShot of this.#oneShots) {
+      oneShot.poll();
     }
   }
 
+  rampGain(target: number, frames: number, opts?: RampOpts) {
+    this.#automate("gain", target, frames, opts);
+  }
+
+  rampPan(target: number, frames: number, opts?: RampOpts) {
+    this.#automate("pan", target, frames, opts);
+  }
+
+  #automate(
+    lane: AutomationLaneName,
+    target: number,
+    frames: number,
+    { startFrame = 0, curve = RampCurve.Linear }: RampOpts = {}
+  ) {
+    assertScheduled(
+      this.#nativeStream.automate(lane, target, frames, startFrame, curve)
+    );
+  }
+
+  acquireBuffer(frames?: number) {
+    this.#assertConnected();
+    this.#assertNoPendingWrite("acquireBuffer");
+    return this.#nativeStream.acquireBuffer(frames);
+  }
+
+  commit(buffer: Float32Array | Float64Array, frames?: number) {
+    this.#assertConnected();
+    this.#assertNoPendingWrite("commit");
+    this.#nativeStream.commit(buffer, frames);
+  }
+
+  waitForBuffer(opts?: { minFrames?: number }) {
+    // Queued behind writes, so the space it reports is space they left
+    return this.#queue(async () => {
+      await this.#ensureConnected();
+      return this.#nativeStream.waitForBuffer(opts);
+    });
+  }
+
+  get writableFrames(): number {
+    return this.#nativeStream.writableFrames;
+  }
+
   isFinished() {
     return this.#nativeStream.isFinished();
   }
@@ -553,11 +1534,98 @@ export class AudioOutputStreamImpl
     return this.#negotiatedRate;
   }
 
+  get renderRate(): number {
+    return this.#renderRate ?? this.#negotiatedRate;
+  }
+
+  get renderPosition(): number {
+    return this.#nativeStream.renderPosition;
+  }
+
+  get timing(): StreamTiming | undefined {
+    return this.#nativeStream.timing;
+  }
+
   get bufferSize(): number {
     return this.#nativeStream.bufferSize;
   }
 
+  get framesPerQuantum(): number {
+    return this.#nativeStream.framesPerQuantum;
+  }
+
+  get sharedRing(): SharedArrayBuffer | undefined {
+    return this.#sharedRing;
+  }
+
+  get stats(): StreamStats {
+    return toStreamStats(this.#nativeStream.stats);
+  }
+
+  get levels(): StreamLevels | undefined {
+    return this.#nativeStream.levels;
+  }
+
+  readTrace(): StreamTrace | undefined {
+    const native = this.#nativeStream.readTrace();
+    return native && decodeTrace(native);
+  }
+
+  exportTrace(): ChromeTrace | undefined {
+    const trace = this.readTrace();
+    return trace && toChromeTrace(trace, this.#name);
+  }
+
+  get props(): AudioOutputStreamProps {
+    return this.#nativeStream.props;
+  }
+
+  setProps(controls: StreamControls) {
+    const { channelVolumes } = controls;
+    if (channelVolumes && channelVolumes.length !== this.channels) {
+      throw new RangeError(
+        `channelVolumes needs one volume per channel (${this.channels})`
+      );
+    }
+    this.#controls.set(controls);
+  }
+
+  /**
+   * Undo whatever the stream was used for since it was created: stop its
+   * files and clips, remove its mixer inputs, generators and inserted
+   * effects, cancel its ramps and put its props back to full volume.
+   * Effects from the `effects` option stay.
+   *
+   * @internal Used by the stream pool before a stream is checked out again
+   */
+  reset() {
+    this.#stopOneShots();
+    for (const owned of [...this.#owned]) {
+      owned.remove();
+    }
+    this.#nativeStream.resetAutomation();
+    this.setProps({
+      volume: 1,
+      mute: false,
+      channelVolumes: new Array(this.channels).fill(1),
+    });
+  }
+
+  #stopOneShots() {
+    for (const oneShot of this.#oneShots) {
+      if (oneShot instanceof FilePlaybackImpl) {
+        oneShot.stop();
+      } else {
+        oneShot.cancel();
+      }
+    }
+  }
+
   async dispose() {
+    this.#stopMonitoring();
+    this.#propsThrottle?.cancel();
+    this.#gcTracer?.stop();
+    this.#stopOneShots();
     await this.#nativeStream.destroy();
     this.#isConnected = false;
   }
@@ -0,0 +1,44 @@
+/**
+ * Gain and pan ramps rendered natively, frame by frame.
+ */
+
+/**
+ * Shape of a gain or pan ramp.
+ *
+ * @enum RampCurve
+ */
+export enum RampCurve {
+  /** Equal steps per frame; right for pans and crossfades */
+  Linear = "linear",
+  /**
+   * Equal steps in decibels per frame, which sounds even for fades. Levels
+   * below -80dB are treated as -80dB, so a fade to 0 lands there at the end.
+   */
+  Exponential = "exponential",
+}
+
+/**
+ * When and how a ramp runs.
+ *
+ * @property startFrame - Frame on the stream's `renderPosition` timeline where
+ *   the ramp begins; a ramp whose start has already passed still ends on
+ *   schedule. 0 starts it as soon as the previous ramp on the same level has
+ *   finished (default: 0)
+ * @property curve - Ramp shape (default: RampCurve.Linear)
+ */
+export interface RampOpts {
+  startFrame?: number;
+  curve?: RampCurve;
+}
+
+export type AutomationLaneName = "gain" | "pan";
+
+/**
+ * Check the result of scheduling a ramp natively. Each level holds up to 32
+ * ramps that have not started yet.
+ */
+export function assertScheduled(scheduled: boolean) {
+  if (!scheduled) {
+    throw new RangeError("Too many ramps scheduled on this level");
+  }
+}
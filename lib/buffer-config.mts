@@ -23,6 +23,8 @@ export enum BufferStrategy {
   MaxSize = "max-size",
   /** User specifies quantum multiplier (for PipeWire experts) */
   QuantumMultiplier = "quanta",
+  /** Starts small and grows after underruns, shrinking again once playback is stable */
+  Adaptive = "adaptive",
 }
 
 /**
@@ -35,7 +37,16 @@ export type BufferConfig =
   | { strategy: BufferStrategy.Smooth }
   | { strategy: BufferStrategy.MaxLatency; milliseconds: number }
   | { strategy: BufferStrategy.MaxSize; bytes: number }
-  | { strategy: BufferStrategy.QuantumMultiplier; multiplier: number };
+  | { strategy: BufferStrategy.QuantumMultiplier; multiplier: number }
+  | {
+      strategy: BufferStrategy.Adaptive;
+      minMilliseconds?: number;
+      maxMilliseconds?: number;
+    };
+
+/** Default latency range for BufferStrategy.Adaptive. */
+const ADAPTIVE_MIN_MILLISECONDS = 5;
+const ADAPTIVE_MAX_MILLISECONDS = 80;
 
 /**
  * Get recommended buffer configuration for an audio quality level.
@@ -53,3 +64,53 @@ export function getBufferConfigForQuality(quality: AudioQuality): BufferConfig {
       return { strategy: BufferStrategy.Balanced };
   }
 }
+
+/**
+ * Native buffer request derived from a buffer configuration.
+ * @internal
+ */
+export interface NativeBufferRequest {
+  requestedQuanta?: number;
+  requestedBytes?: number;
+  requestedMs?: number;
+  adaptive?: { minMs: number; maxMs: number };
+}
+
+/**
+ * Translates a buffer configuration (or the quality default) into the
+ * request understood by the native stream.
+ * @internal
+ */
+export function toNativeBufferRequest(
+  bufferConfig?: BufferConfig,
+  quality: AudioQuality = AudioQuality.Standard
+): NativeBufferRequest {
+  const effectiveBufferConfig =
+    bufferConfig ?? getBufferConfigForQuality(quality);
+
+  switch (effectiveBufferConfig.strategy) {
+    case BufferStrategy.MinimalLatency:
+      return { requestedQuanta: 1 };
+    case BufferStrategy.LowLatency:
+      return { requestedQuanta: 2 };
+    case BufferStrategy.Balanced:
+      return { requestedQuanta: 4 };
+    case BufferStrategy.Smooth:
+      return { requestedQuanta: 8 };
+    case BufferStrategy.QuantumMultiplier:
+      return { requestedQuanta: effectiveBufferConfig.multiplier };
+    case BufferStrategy.MaxSize:
+      return { requestedBytes: effectiveBufferConfig.bytes };
+    case BufferStrategy.MaxLatency:
+      return { requestedMs: effectiveBufferConfig.milliseconds };
+    case BufferStrategy.Adaptive:
+      return {
+        adaptive: {
+          minMs:
+            effectiveBufferConfig.minMilliseconds ?? ADAPTIVE_MIN_MILLISECONDS,
+          maxMs:
+            effectiveBufferConfig.maxMilliseconds ?? ADAPTIVE_MAX_MILLISECONDS,
+        },
+      };
+  }
+}
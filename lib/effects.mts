@@ -0,0 +1,250 @@
+/**
+ * Native DSP effects run on an output stream's bus or on a mixer input.
+ */
+
+/**
+ * Filter response of a biquad stage.
+ *
+ * @enum BiquadShape
+ */
+export enum BiquadShape {
+  Lowpass = "lowpass",
+  Highpass = "highpass",
+  /** Constant 0 dB peak at `frequency` */
+  Bandpass = "bandpass",
+  Notch = "notch",
+  /** Boosts or cuts `gainDb` around `frequency` */
+  Peaking = "peaking",
+  /** Boosts or cuts `gainDb` below `frequency` */
+  Lowshelf = "lowshelf",
+  /** Boosts or cuts `gainDb` above `frequency` */
+  Highshelf = "highshelf",
+  /** Shifts phase around `frequency`, leaving every level unchanged */
+  Allpass = "allpass",
+}
+
+export interface NativeEffects {
+  // target -1 is the stream's own bus, anything else a mixer input id
+  insertEffect: (target: number, opts: Record<string, unknown>) => number;
+  setEffectParams: (
+    target: number,
+    id: number,
+    params: Record<string, unknown>
+  ) => boolean; // false once the effect or its input is gone
+  setEffectBypass: (target: number, id: number, bypassed: boolean) => boolean;
+  removeEffect: (target: number, id: number) => boolean;
+}
+
+/**
+ * A biquad filter, from the Audio EQ Cookbook.
+ *
+ * @property shape - Filter response (default: BiquadShape.Lowpass)
+ * @property frequency - Cutoff or centre frequency in Hz (default: 1000)
+ * @property q - Resonance; 0.7071 is maximally flat (default: 0.7071)
+ * @property gainDb - Boost or cut of peaking and shelving shapes
+ *   (default: 0)
+ * @property sections - Identical filters in series, 1 to 4, for steeper
+ *   slopes: each adds 12 dB per octave to a lowpass or highpass (default: 1)
+ */
+export interface BiquadParams {
+  shape?: BiquadShape;
+  frequency?: number;
+  q?: number;
+  gainDb?: number;
+  sections?: number;
+}
+
+/**
+ * A brickwall limiter that sees its peaks coming.
+ *
+ * @property thresholdDb - Ceiling in dBFS that no sample exceeds
+ *   (default: -1)
+ * @property lookaheadMs - How far ahead it looks, up to 20 ms; the stream
+ *   is delayed by this much (default: 5)
+ * @property releaseMs - Time for the gain to recover after a peak
+ *   (default: 50)
+ */
+export interface LimiterParams {
+  thresholdDb?: number;
+  lookaheadMs?: number;
+  releaseMs?: number;
+}
+
+/**
+ * A feedback delay whose time can be changed smoothly while it runs.
+ *
+ * @property delayMs - Delay time; fractional frames are interpolated
+ *   (default: 250)
+ * @property feedback - Share of the delayed signal fed back in, -0.99 to
+ *   0.99 (default: 0)
+ * @property mix - 0 for the dry signal only, 1 for the delayed signal only
+ *   (default: 0.5)
+ * @property channels - Channels to delay; the others pass through, which
+ *   gives a Haas effect when one side of a stereo stream is delayed
+ *   (default: all)
+ */
+export interface DelayParams {
+  delayMs?: number;
+  feedback?: number;
+  mix?: number;
+  channels?: Array<number>;
+}
+
+/**
+ * A mid/side matrix for stereo: width below 1 narrows the image and above
+ * 1 widens it. Has no effect on other channel counts.
+ *
+ * @property midGain - Gain of the sum of both channels (default: 1)
+ * @property sideGain - Gain of their difference (default: 1)
+ */
+export interface MidSideParams {
+  midGain?: number;
+  sideGain?: number;
+}
+
+interface EffectParamsByType {
+  biquad: BiquadParams;
+  limiter: LimiterParams;
+  delay: DelayParams;
+  "mid-side": MidSideParams;
+}
+
+export type EffectType = keyof EffectParamsByType;
+
+/**
+ * An effect to insert. `maxDelayMs` sizes a delay's memory up front, so
+ * `delayMs` can later be raised to it (default: 1000, at most 10000).
+ *
+ * @example
+ * ```typescript
+ * const options: EffectOpts = {
+ *   type: "biquad",
+ *   shape: BiquadShape.Highpass,
+ *   frequency: 80,
+ * };
+ * ```
+ */
+export type EffectOpts =
+  | ({ type: "biquad" } & BiquadParams)
+  | ({ type: "limiter" } & LimiterParams)
+  | ({ type: "delay"; maxDelayMs?: number } & DelayParams)
+  | ({ type: "mid-side" } & MidSideParams);
+
+/**
+ * Where to insert an effect.
+ *
+ * @property index - Position in the chain, 0 for first (default: last)
+ */
+export interface InsertEffectOpts {
+  index?: number;
+}
+
+/**
+ * A native DSP stage in an effect chain.
+ *
+ * Effects run on the PipeWire real-time thread, in chain order, on the
+ * Float32 bus: a stream's chain after its mixer and automation, a mixer
+ * input's before its gain and pan. Updates are posted without locking and
+ * heard on the next processing cycle. A chain holds up to 8 effects.
+ *
+ * @example
+ * ```typescript
+ * const eq = stream.insertEffect({ type: "biquad", shape: BiquadShape.Peaking });
+ * eq.update({ frequency: 2500, gainDb: -4 });
+ * eq.bypassed = true; // A/B against the dry signal
+ * ```
+ */
+export interface Effect<T extends EffectType = EffectType> {
+  /** Kind of effect. */
+  get type(): T;
+
+  /**
+   * Whether the effect is skipped. It keeps its settings and its place in
+   * the chain.
+   */
+  get bypassed(): boolean;
+  set bypassed(value: boolean);
+
+  /** Change parameters; those left out keep their current values. */
+  update: (params: EffectParamsByType[T]) => void;
+
+  /** Take the effect out of its chain. */
+  remove: () => void;
+}
+
+/** @internal */
+export function toNativeEffectParams(params: object): Record<string, unknown> {
+  const { channels, ...rest } = params as { channels?: Array<number> };
+  return channels
+    ? {
+        ...rest,
+        channelMask: channels.reduce((mask, ch) => mask | (1 << ch), 0),
+      }
+    : rest;
+}
+
+export class EffectImpl<T extends EffectType> implements Effect<T> {
+  readonly #native: NativeEffects;
+  readonly #target: number;
+  readonly #id: number;
+  readonly #type: T;
+  #bypassed = false;
+  #removed = false;
+  readonly #onRemove?: () => void;
+
+  constructor(
+    native: NativeEffects,
+    target: number,
+    opts: EffectOpts & InsertEffectOpts,
+    onRemove?: () => void
+  ) {
+    this.#native = native;
+    this.#target = target;
+    this.#onRemove = onRemove;
+    this.#type = opts.type as T;
+    this.#id = native.insertEffect(target, toNativeEffectParams(opts));
+  }
+
+  get type() {
+    return this.#type;
+  }
+
+  get bypassed() {
+    return this.#bypassed;
+  }
+
+  set bypassed(value: boolean) {
+    this.#assertPresent(
+      this.#native.setEffectBypass(this.#target, this.#id, value)
+    );
+    this.#bypassed = value;
+  }
+
+  update(params: EffectParamsByType[T]) {
+    this.#assertPresent(
+      this.#native.setEffectParams(
+        this.#target,
+        this.#id,
+        toNativeEffectParams(params)
+      )
+    );
+  }
+
+  remove() {
+    if (!this.#removed) {
+      this.#removed = true;
+      this.#native.removeEffect(this.#target, this.#id);
+      this.#onRemove?.();
+    }
+  }
+
+  #assertPresent(present: boolean) {
+    if (this.#removed || !present) {
+      if (!this.#removed) {
+        this.#removed = true;
+        this.#onRemove?.();
+      }
+      throw new Error("Effect has been removed");
+    }
+  }
+}
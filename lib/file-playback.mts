@@ -0,0 +1,308 @@
+/**
+ * Audio files played natively by an audio output stream's mixer.
+ */
+
+import type { AudioFormat } from "./audio-format.mjs";
+import {
+  assertScheduled,
+  RampCurve,
+  type AutomationLaneName,
+  type RampOpts,
+} from "./automation.mjs";
+import type { NativeMixer } from "./mixer-input.mjs";
+
+export interface NativeFiles {
+  playFile: (
+    path: string,
+    opts: {
+      offset?: number;
+      loop?: boolean;
+      gain?: number;
+      pan?: number;
+      raw?: { format: number; channels: number; rate?: number };
+    }
+  ) => Promise<{ id: number; channels: number; rate: number; frames: number }>;
+  getFileState: (
+    id: number
+  ) => { position: number; ended: boolean } | undefined; // undefined once the slot is freed
+  setFileLooping: (id: number, loop: boolean) => boolean;
+}
+
+/**
+ * Layout of a headerless PCM file.
+ *
+ * @property format - Sample format: Uint8, Int16, Int24_32, Int32, Float32
+ *   or Float64, little-endian and interleaved
+ * @property channels - Number of interleaved channels
+ * @property rate - Sample rate in Hz (default: the stream's render rate)
+ */
+export interface RawFileFormat {
+  format: AudioFormat;
+  channels: number;
+  rate?: number;
+}
+
+/**
+ * Options for playing a file.
+ *
+ * @property offset - Frame to start playing from (default: 0)
+ * @property loop - Start again from the beginning at the end of the file
+ *   (default: false)
+ * @property gain - Linear gain applied while mixing (default: 1.0)
+ * @property pan - -1 (left) to +1 (right); pans mono files and balances
+ *   stereo ones (default: 0)
+ * @property raw - Read the file as headerless PCM in this layout instead of
+ *   as a WAV file
+ */
+export interface PlayFileOpts {
+  offset?: number;
+  loop?: boolean;
+  gain?: number;
+  pan?: number;
+  raw?: RawFileFormat;
+}
+
+/**
+ * A file being decoded and mixed on the PipeWire real-time thread.
+ *
+ * The file is memory-mapped and paged in before playback starts, so the
+ * real-time thread only converts samples it already has in memory; no
+ * JavaScript runs per quantum. A playing file takes one of the stream's 64
+ * mixer slots until it ends or is stopped.
+ *
+ * @example
+ * ```typescript
+ * const music = await stream.playFile("theme.wav", { loop: true });
+ * music.rampGain(0.3, stream.renderRate); // Duck under dialogue
+ * music.loop = false; // Let it finish this time round
+ * await music.finished();
+ * ```
+ */
+export interface FilePlayback {
+  /** Number of channels in the file. */
+  get channels(): number;
+
+  /** Sample rate of the file in Hz. */
+  get rate(): number;
+
+  /** Length of the file in frames. */
+  get frames(): number;
+
+  /** Frame that will be mixed next, as of the last processing cycle. */
+  get position(): number;
+
+  /** Whether playback reached the end of the file or was stopped. */
+  get ended(): boolean;
+
+  /**
+   * Whether playback starts again from the beginning at the end of the
+   * file. Can be changed while the file plays.
+   */
+  get loop(): boolean;
+  set loop(value: boolean);
+
+  /**
+   * Linear gain applied while mixing: the last value set or ramped to.
+   * Setting it cancels the gain ramps that have not finished.
+   */
+  get gain(): number;
+  set gain(value: number);
+
+  /**
+   * Pan (mono) or balance (stereo) from -1 (left) to +1 (right): the last
+   * value set or ramped to. Setting it cancels unfinished pan ramps.
+   */
+  get pan(): number;
+  set pan(value: number);
+
+  /** Ramp the mixing gain natively, as `MixerInput.rampGain()` does. */
+  rampGain: (target: number, frames: number, opts?: RampOpts) => void;
+
+  /** Ramp the pan natively, as `MixerInput.rampPan()` does. */
+  rampPan: (target: number, frames: number, opts?: RampOpts) => void;
+
+  /** Stop playing and free the mixer slot. */
+  stop: () => void;
+
+  /** Resolves when playback reaches the end of the file or is stopped. */
+  finished: () => Promise<void>;
+}
+
+export class FilePlaybackImpl implements FilePlayback {
+  readonly #mixer: NativeMixer & NativeFiles;
+  readonly #id: number;
+  readonly #channels: number;
+  readonly #rate: number;
+  readonly #frames: number;
+  readonly #finished: Promise<void>;
+  #resolveFinished!: () => void;
+  #loop: boolean;
+  #gain: number;
+  #pan: number;
+  #position: number;
+  #stopped = false;
+
+  static async create(
+    mixer: NativeMixer & NativeFiles,
+    path: string,
+    opts: PlayFileOpts = {}
+  ) {
+    const { offset = 0, loop = false, gain = 1, pan = 0, raw } = opts;
+    const clampedPan = Math.max(-1, Math.min(1, pan));
+    const info = await mixer.playFile(path, {
+      offset,
+      loop,
+      gain,
+      pan: clampedPan,
+      raw: raw && { ...raw, format: raw.format.enumValue },
+    });
+    return new FilePlaybackImpl(mixer, info, {
+      offset,
+      loop,
+      gain,
+      pan: clampedPan,
+    });
+  }
+
+  private constructor(
+    mixer: NativeMixer & NativeFiles,
+    info: { id: number; channels: number; rate: number; frames: number },
+    opts: Required<Omit<PlayFileOpts, "raw">>
+  ) {
+    this.#mixer = mixer;
+    this.#id = info.id;
+    this.#channels = info.channels;
+    this.#rate = info.rate;
+    this.#frames = info.frames;
+    this.#loop = opts.loop;
+    this.#gain = opts.gain;
+    this.#pan = opts.pan;
+    this.#position = opts.offset;
+    this.#finished = new Promise((resolve) => {
+      this.#resolveFinished = resolve;
+    });
+  }
+
+  /**
+   * Check whether the file ended and free its slot if it did.
+   * Called by the stream when the real-time thread reports ended files.
+   *
+   * @internal
+   */
+  poll() {
+    if (this.#stopped) {
+      return true;
+    }
+    const state = this.#mixer.getFileState(this.#id);
+    if (state) {
+      this.#position = state.position;
+    }
+    if (!state || state.ended) {
+      this.stop();
+    }
+    return this.#stopped;
+  }
+
+  get channels() {
+    return this.#channels;
+  }
+
+  get rate() {
+    return this.#rate;
+  }
+
+  get frames() {
+    return this.#frames;
+  }
+
+  get position() {
+    if (!this.#stopped) {
+      this.#position =
+        this.#mixer.getFileState(this.#id)?.position ?? this.#position;
+    }
+    return this.#position;
+  }
+
+  get ended() {
+    return this.#stopped || !!this.#mixer.getFileState(this.#id)?.ended;
+  }
+
+  get loop() {
+    return this.#loop;
+  }
+
+  set loop(value: boolean) {
+    if (!this.#stopped) {
+      this.#loop = value;
+      this.#mixer.setFileLooping(this.#id, value);
+    }
+  }
+
+  get gain() {
+    return this.#gain;
+  }
+
+  set gain(value: number) {
+    this.#gain = value;
+    if (!this.#stopped) {
+      this.#mixer.setMixerInputLevels(this.#id, this.#gain, NaN);
+    }
+  }
+
+  get pan() {
+    return this.#pan;
+  }
+
+  set pan(value: number) {
+    this.#pan = Math.max(-1, Math.min(1, value));
+    if (!this.#stopped) {
+      this.#mixer.setMixerInputLevels(this.#id, NaN, this.#pan);
+    }
+  }
+
+  rampGain(target: number, frames: number, opts?: RampOpts) {
+    this.#automate("gain", target, frames, opts);
+    this.#gain = target;
+  }
+
+  rampPan(target: number, frames: number, opts?: RampOpts) {
+    const clamped = Math.max(-1, Math.min(1, target));
+    this.#automate("pan", clamped, frames, opts);
+    this.#pan = clamped;
+  }
+
+  stop() {
+    if (!this.#stopped) {
+      this.#position =
+        this.#mixer.getFileState(this.#id)?.position ?? this.#position;
+      this.#stopped = true;
+      this.#mixer.removeMixerInput(this.#id);
+      this.#resolveFinished();
+    }
+  }
+
+  finished() {
+    return this.#finished;
+  }
+
+  #automate(
+    lane: AutomationLaneName,
+    target: number,
+    frames: number,
+    { startFrame = 0, curve = RampCurve.Linear }: RampOpts = {}
+  ) {
+    if (this.#stopped) {
+      throw new Error("File playback has stopped");
+    }
+    assertScheduled(
+      this.#mixer.automateMixerInput(
+        this.#id,
+        lane,
+        target,
+        frames,
+        startFrame,
+        curve
+      )
+    );
+  }
+}
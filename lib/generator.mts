@@ -0,0 +1,246 @@
+/**
+ * Native signal generators attached to an audio output stream.
+ */
+
+import {
+  assertScheduled,
+  RampCurve,
+  type AutomationLaneName,
+  type RampOpts,
+} from "./automation.mjs";
+import type { NativeMixer } from "./mixer-input.mjs";
+
+/**
+ * Signal a generator produces.
+ *
+ * @enum Waveform
+ */
+export enum Waveform {
+  Sine = "sine",
+  /** Band-limited, so high notes do not alias */
+  Square = "square",
+  /** Band-limited, rising from -1 to +1 each cycle */
+  Sawtooth = "sawtooth",
+  /** Band-limited */
+  Triangle = "triangle",
+  /** Equal energy per Hz; `frequency` and `phase` are ignored */
+  WhiteNoise = "white-noise",
+  /** Equal energy per octave; `frequency` and `phase` are ignored */
+  PinkNoise = "pink-noise",
+}
+
+export interface NativeGenerators {
+  addGenerator: (opts: {
+    waveform?: Waveform;
+    frequency?: number;
+    amplitude?: number;
+    phase?: number;
+    gain?: number;
+    pan?: number;
+  }) => number;
+  setGeneratorParams: (id: number, params: GeneratorParams) => boolean;
+}
+
+/**
+ * Parameters of a generator that can change while it plays.
+ *
+ * @property waveform - Signal to produce (default: Waveform.Sine)
+ * @property frequency - Frequency in Hz (default: 440)
+ * @property amplitude - Peak level from 0 to 1; changes are ramped over
+ *   one processing cycle so they do not click (default: 1)
+ * @property phase - Position in the cycle, from 0 to 1, to jump to on the
+ *   next processing cycle (default: 0)
+ */
+export interface GeneratorParams {
+  waveform?: Waveform;
+  frequency?: number;
+  amplitude?: number;
+  phase?: number;
+}
+
+/**
+ * Options for a generator: its initial parameters plus the gain and pan it
+ * is mixed with.
+ *
+ * @property gain - Linear gain applied while mixing (default: 1.0)
+ * @property pan - -1 (left) to +1 (right), constant-power (default: 0)
+ */
+export interface GeneratorOpts extends GeneratorParams {
+  gain?: number;
+  pan?: number;
+}
+
+/**
+ * A mono tone or noise source synthesized by the native mixer.
+ *
+ * Samples are rendered on the PipeWire real-time thread as the stream
+ * plays, so a generator costs no JavaScript per quantum. Setting a
+ * parameter posts it without locking; the change is heard on the next
+ * processing cycle. A generator takes one of the stream's 64 mixer slots.
+ *
+ * @example
+ * ```typescript
+ * const tone = stream.addGenerator({ frequency: 440, amplitude: 0.3 });
+ * tone.frequency = 880; // Up an octave on the next cycle
+ * tone.set({ waveform: Waveform.Sawtooth, amplitude: 0.2 });
+ * tone.rampPan(1, stream.renderRate); // Sweep right over one second
+ * tone.remove();
+ * ```
+ */
+export interface Generator extends Required<GeneratorParams> {
+  /** Update several parameters at once. */
+  set: (params: GeneratorParams) => void;
+
+  /** Stop the generator and free its mixer slot. */
+  remove: () => void;
+
+  /**
+   * Linear gain applied while mixing: the last value set or ramped to.
+   * Setting it cancels the gain ramps that have not finished.
+   */
+  get gain(): number;
+  set gain(value: number);
+
+  /**
+   * Pan from -1 (left) to +1 (right): the last value set or ramped to.
+   * Setting it cancels unfinished pan ramps.
+   */
+  get pan(): number;
+  set pan(value: number);
+
+  /** Ramp the mixing gain natively, as `MixerInput.rampGain()` does. */
+  rampGain: (target: number, frames: number, opts?: RampOpts) => void;
+
+  /** Ramp the pan natively, as `MixerInput.rampPan()` does. */
+  rampPan: (target: number, frames: number, opts?: RampOpts) => void;
+}
+
+export class GeneratorImpl implements Generator {
+  readonly #mixer: NativeMixer & NativeGenerators;
+  readonly #id: number;
+  #params: Required<GeneratorParams>;
+  #gain: number;
+  #pan: number;
+  #removed = false;
+  readonly #onRemove?: () => void;
+
+  constructor(
+    mixer: NativeMixer & NativeGenerators,
+    opts: GeneratorOpts = {},
+    onRemove?: () => void
+  ) {
+    const {
+      waveform = Waveform.Sine,
+      frequency = 440,
+      amplitude = 1,
+      phase = 0,
+      gain = 1,
+      pan = 0,
+    } = opts;
+
+    this.#mixer = mixer;
+    this.#onRemove = onRemove;
+    this.#params = { waveform, frequency, amplitude, phase };
+    this.#gain = gain;
+    this.#pan = Math.max(-1, Math.min(1, pan));
+    this.#id = mixer.addGenerator({ ...this.#params, gain, pan: this.#pan });
+  }
+
+  set(params: GeneratorParams) {
+    if (this.#removed) {
+      throw new Error("Generator has been removed");
+    }
+    this.#params = { ...this.#params, ...params };
+    this.#mixer.setGeneratorParams(this.#id, params);
+  }
+
+  remove() {
+    if (!this.#removed) {
+      this.#removed = true;
+      this.#mixer.removeMixerInput(this.#id);
+      this.#onRemove?.();
+    }
+  }
+
+  get waveform() {
+    return this.#params.waveform;
+  }
+
+  set waveform(waveform: Waveform) {
+    this.set({ waveform });
+  }
+
+  get frequency() {
+    return this.#params.frequency;
+  }
+
+  set frequency(frequency: number) {
+    this.set({ frequency });
+  }
+
+  get amplitude() {
+    return this.#params.amplitude;
+  }
+
+  set amplitude(amplitude: number) {
+    this.set({ amplitude });
+  }
+
+  get phase() {
+    return this.#params.phase;
+  }
+
+  set phase(phase: number) {
+    this.set({ phase });
+  }
+
+  get gain() {
+    return this.#gain;
+  }
+
+  set gain(value: number) {
+    this.#gain = value;
+    this.#mixer.setMixerInputLevels(this.#id, this.#gain, NaN);
+  }
+
+  get pan() {
+    return this.#pan;
+  }
+
+  set pan(value: number) {
+    this.#pan = Math.max(-1, Math.min(1, value));
+    this.#mixer.setMixerInputLevels(this.#id, NaN, this.#pan);
+  }
+
+  rampGain(target: number, frames: number, opts?: RampOpts) {
+    this.#automate("gain", target, frames, opts);
+    this.#gain = target;
+  }
+
+  rampPan(target: number, frames: number, opts?: RampOpts) {
+    const clamped = Math.max(-1, Math.min(1, target));
+    this.#automate("pan", clamped, frames, opts);
+    this.#pan = clamped;
+  }
+
+  #automate(
+    lane: AutomationLaneName,
+    target: number,
+    frames: number,
+    { startFrame = 0, curve = RampCurve.Linear }: RampOpts = {}
+  ) {
+    if (this.#removed) {
+      throw new Error("Generator has been removed");
+    }
+    assertScheduled(
+      this.#mixer.automateMixerInput(
+        this.#id,
+        lane,
+        target,
+        frames,
+        startFrame,
+        curve
+      )
+    );
+  }
+}
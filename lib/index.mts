@@ -1,8 +1,61 @@
-export { startSession, type PipeWireSession } from "./session.mjs";
+export {
+  startSession,
+  type PipeWireSession,
+  type SessionOpts,
+  type SessionLoopStats,
+} from "./session.mjs";
 export { AudioQuality } from "./audio-quality.mjs";
 export { AudioFormat } from "./audio-format.mjs";
+export { ResampleQuality } from "./resample-quality.mjs";
 export type {
   AudioOutputStream,
   AudioOutputStreamOpts,
+  AudioOutputStreamProps,
 } from "./audio-output-stream.mjs";
+export type {
+  AudioInputStream,
+  AudioInputStreamOpts,
+} from "./audio-input-stream.mjs";
+export type { MixerInput, MixerInputOpts } from "./mixer-input.mjs";
+export { Waveform } from "./generator.mjs";
+export type {
+  Generator,
+  GeneratorOpts,
+  GeneratorParams,
+} from "./generator.mjs";
+export type {
+  FilePlayback,
+  PlayFileOpts,
+  RawFileFormat,
+} from "./file-playback.mjs";
+export type { ScheduledClip, ScheduleOpts } from "./scheduled-clip.mjs";
+export type { LoadSampleOpts, TriggerOpts } from "./sample-cache.mjs";
+export { BiquadShape } from "./effects.mjs";
+export type {
+  BiquadParams,
+  DelayParams,
+  Effect,
+  EffectOpts,
+  EffectType,
+  InsertEffectOpts,
+  LimiterParams,
+  MidSideParams,
+} from "./effects.mjs";
+export type {
+  ChromeTrace,
+  StreamTrace,
+  TraceEvent,
+  TraceOpts,
+} from "./stream-trace.mjs";
+export type {
+  OfflineRenderOpts,
+  OfflineRenderResult,
+} from "./offline-render.mjs";
+export type { StreamStats } from "./stream-stats.mjs";
+export type { StreamTiming } from "./stream-timing.mjs";
+export type { MeteringOpts, StreamLevels } from "./level-meter.mjs";
+export type { StreamControls } from "./stream-props.mjs";
+export type { StreamPool, StreamPoolOpts } from "./stream-pool.mjs";
+export { RampCurve, type RampOpts } from "./automation.mjs";
 export { BufferStrategy } from "./buffer-config.mjs";
+export { SharedRingWriter } from "./shared-ring.mjs";
@@ -0,0 +1,45 @@
+/**
+ * Native peak and RMS level meters.
+ */
+
+/**
+ * How a stream meters its output.
+ *
+ * @property updatesPerSecond - Readings per second; each one covers the audio
+ *   since the previous reading (default: 30)
+ * @property truePeak - Also measure the true (inter-sample) peak by 4x
+ *   oversampling, as ITU-R BS.1770 describes. Costs noticeably more CPU on
+ *   the real-time thread than peak and RMS alone (default: false)
+ */
+export interface MeteringOpts {
+  updatesPerSecond?: number;
+  truePeak?: boolean;
+}
+
+/**
+ * One level reading, with one entry per channel. Levels are linear, where
+ * 1.0 is full scale; use `20 * Math.log10(level)` for dBFS.
+ *
+ * @property peak - Largest absolute sample
+ * @property rms - Root mean square level
+ * @property truePeak - Largest absolute value between samples once
+ *   reconstructed; only present when metering with `truePeak`
+ * @property windows - Readings taken since the stream was created; a reading
+ *   with the same count as the last one is not new
+ */
+export interface StreamLevels {
+  peak: Array<number>;
+  rms: Array<number>;
+  truePeak?: Array<number>;
+  windows: number;
+}
+
+/** @internal */
+export function toNativeMetering(metering: boolean | MeteringOpts) {
+  if (!metering) {
+    return undefined;
+  }
+  const { updatesPerSecond = 30, truePeak = false } =
+    metering === true ? {} : metering;
+  return { updatesPerSecond, truePeak };
+}
@@ -0,0 +1,267 @@
+/**
+ * Native mixer inputs attached to an audio output stream.
+ */
+
+import {
+  assertScheduled,
+  RampCurve,
+  type AutomationLaneName,
+  type RampOpts,
+} from "./automation.mjs";
+import {
+  EffectImpl,
+  type Effect,
+  type EffectOpts,
+  type EffectType,
+  type InsertEffectOpts,
+  type NativeEffects,
+} from "./effects.mjs";
+
+export interface NativeMixer {
+  addMixerInput: (opts: {
+    channels?: number;
+    frames?: number;
+    gain?: number;
+    pan?: number;
+  }) => number;
+  removeMixerInput: (id: number) => boolean;
+  setMixerInputLevels: (id: number, gain: number, pan: number) => boolean; // NaN leaves a level unchanged
+  automateMixerInput: (
+    id: number,
+    lane: AutomationLaneName,
+    target: number,
+    frames: number,
+    startFrame: number,
+    curve: RampCurve
+  ) => boolean; // false when the lane's queue is full
+  writeMixerInput: (id: number, samples: Float32Array) => number; // Returns number of frames accepted
+  getMixerInputFrames: (id: number) => { writable: number; queued: number };
+  waitForMixerSpace: () => Promise<void>;
+}
+
+/**
+ * Options for a mixer input.
+ *
+ * @property channels - 1 for a mono source panned onto the stream, or the
+ *   stream's channel count for an interleaved source (default: 1)
+ * @property bufferFrames - Capacity of the input's native buffer in frames
+ *   (default: the stream's buffer size)
+ * @property gain - Linear gain applied while mixing (default: 1.0)
+ * @property pan - -1 (left) to +1 (right); sets the constant-power pan
+ *   position of mono inputs and the balance of stereo inputs (default: 0)
+ */
+export interface MixerInputOpts {
+  channels?: number;
+  bufferFrames?: number;
+  gain?: number;
+  pan?: number;
+}
+
+/**
+ * One source summed into an output stream by the native mixer.
+ *
+ * Mixing happens on the PipeWire real-time thread, so dozens of voices cost
+ * one stream and no per-voice JavaScript per quantum. Gain and pan changes
+ * take effect on the next processing cycle; ramps are applied sample by
+ * sample at the frames they are scheduled for.
+ *
+ * @example
+ * ```typescript
+ * const voice = stream.addMixerInput({ pan: -0.5, gain: 0.8 });
+ * await voice.write(renderedSamples); // Float32Array, mono
+ * voice.rampGain(0, stream.renderRate * 2); // Two-second fade out
+ * ```
+ */
+export interface MixerInput {
+  /**
+   * Write Float32 samples to this input, waiting for space as needed.
+   * Samples are interleaved when the input has more than one channel.
+   */
+  write: (samples: Float32Array) => Promise<void>;
+
+  /**
+   * Detach the input; queued samples that have not been mixed are dropped.
+   */
+  remove: () => void;
+
+  /**
+   * Linear gain applied while mixing: the last value set or ramped to.
+   * Setting it cancels the gain ramps that have not finished.
+   */
+  get gain(): number;
+  set gain(value: number);
+
+  /**
+   * Pan (mono) or balance (stereo) from -1 (left) to +1 (right): the last
+   * value set or ramped to. Setting it cancels unfinished pan ramps.
+   */
+  get pan(): number;
+  set pan(value: number);
+
+  /**
+   * Ramp the gain to `target` over `frames` frames, natively.
+   *
+   * @param target - Linear gain to end at
+   * @param frames - Length of the ramp at the stream's render rate; 0 jumps
+   * @param opts - Start frame and curve of the ramp
+   */
+  rampGain: (target: number, frames: number, opts?: RampOpts) => void;
+
+  /**
+   * Ramp the pan to `target` (-1 to +1) over `frames` frames, natively.
+   */
+  rampPan: (target: number, frames: number, opts?: RampOpts) => void;
+
+  /**
+   * Insert a native effect into this input's own chain, which runs on the
+   * input's channels before its gain and pan are applied. The chain goes
+   * with the input when it is removed.
+   *
+   * @param opts - Effect type, its parameters and its place in the chain
+   */
+  insertEffect: <T extends EffectType>(
+    opts: Extract<EffectOpts, { type: T }> & InsertEffectOpts
+  ) => Effect<T>;
+
+  /** Number of channels per frame written to this input. */
+  get channels(): number;
+
+  /** Frames that can be written without waiting. */
+  get writableFrames(): number;
+
+  /** Frames written but not yet mixed. */
+  get queuedFrames(): number;
+}
+
+export class MixerInputImpl implements MixerInput {
+  readonly #mixer: NativeMixer & NativeEffects;
+  readonly #id: number;
+  readonly #channels: number;
+  #gain: number;
+  #pan: number;
+  #removed = false;
+  readonly #onRemove?: () => void;
+
+  constructor(
+    mixer: NativeMixer & NativeEffects,
+    opts: MixerInputOpts = {},
+    onRemove?: () => void
+  ) {
+    const { channels = 1, bufferFrames, gain = 1, pan = 0 } = opts;
+
+    this.#mixer = mixer;
+    this.#onRemove = onRemove;
+    this.#channels = channels;
+    this.#gain = gain;
+    this.#pan = Math.max(-1, Math.min(1, pan));
+    this.#id = mixer.addMixerInput({
+      channels,
+      frames: bufferFrames,
+      gain,
+      pan: this.#pan,
+    });
+  }
+
+  async write(samples: Float32Array) {
+    if (this.#removed) {
+      throw new Error("Mixer input has been removed");
+    }
+    if (samples.length % this.#channels !== 0) {
+      throw new Error(
+        `write() needs whole frames: ${samples.length} samples is not a multiple of ${this.#channels} channels`
+      );
+    }
+
+    let written =
+      this.#mixer.writeMixerInput(this.#id, samples) * this.#channels;
+    while (written < samples.length && !this.#removed) {
+      await this.#mixer.waitForMixerSpace();
+      written +=
+        this.#mixer.writeMixerInput(this.#id, samples.subarray(written)) *
+        this.#channels;
+    }
+  }
+
+  remove() {
+    if (!this.#removed) {
+      this.#removed = true;
+      this.#mixer.removeMixerInput(this.#id);
+      this.#onRemove?.();
+    }
+  }
+
+  get gain() {
+    return this.#gain;
+  }
+
+  set gain(value: number) {
+    this.#gain = value;
+    this.#mixer.setMixerInputLevels(this.#id, this.#gain, NaN);
+  }
+
+  get pan() {
+    return this.#pan;
+  }
+
+  set pan(value: number) {
+    this.#pan = Math.max(-1, Math.min(1, value));
+    this.#mixer.setMixerInputLevels(this.#id, NaN, this.#pan);
+  }
+
+  rampGain(target: number, frames: number, opts?: RampOpts) {
+    this.#automate("gain", target, frames, opts);
+    this.#gain = target;
+  }
+
+  rampPan(target: number, frames: number, opts?: RampOpts) {
+    const clamped = Math.max(-1, Math.min(1, target));
+    this.#automate("pan", clamped, frames, opts);
+    this.#pan = clamped;
+  }
+
+  #automate(
+    lane: AutomationLaneName,
+    target: number,
+    frames: number,
+    { startFrame = 0, curve = RampCurve.Linear }: RampOpts = {}
+  ) {
+    if (this.#removed) {
+      throw new Error("Mixer input has been removed");
+    }
+    assertScheduled(
+      this.#mixer.automateMixerInput(
+        this.#id,
+        lane,
+        target,
+        frames,
+        startFrame,
+        curve
+      )
+    );
+  }
+
+  insertEffect<T extends EffectType>(
+    opts: Extract<EffectOpts, { type: T }> & InsertEffectOpts
+  ): Effect<T> {
+    if (this.#removed) {
+      throw new Error("Mixer input has been removed");
+    }
+    return new EffectImpl<T>(this.#mixer, this.#id, opts);
+  }
+
+  get channels() {
+    return this.#channels;
+  }
+
+  get writableFrames() {
+    return this.#removed
+      ? 0
+      : this.#mixer.getMixerInputFrames(this.#id).writable;
+  }
+
+  get queuedFrames() {
+    return this.#removed
+      ? 0
+      : this.#mixer.getMixerInputFrames(this.#id).queued;
+  }
+}
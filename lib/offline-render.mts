@@ -0,0 +1,41 @@
+/**
+ * Rendering an output stream to a file instead of the PipeWire graph.
+ */
+
+import type { AudioFormat } from "./audio-format.mjs";
+
+export interface NativeOfflineRender {
+  renderOffline: (
+    path: string,
+    opts: { frames: number; format?: number; rate?: number; wav?: boolean }
+  ) => Promise<OfflineRenderResult>;
+}
+
+/**
+ * Options for an offline render.
+ *
+ * @property frames - Length of the render in frames at `rate`
+ * @property format - Sample format written: Uint8, Int16, Int32, Float32 or
+ *   Float64, plus Int24_32 for raw files (default: AudioFormat.Float32)
+ * @property rate - Sample rate written; audio is resampled to it from the
+ *   render rate when they differ (default: the stream's render rate)
+ * @property container - `"wav"` for a WAV file, `"raw"` for headerless
+ *   interleaved samples (default: "wav")
+ */
+export interface OfflineRenderOpts {
+  frames: number;
+  format?: AudioFormat;
+  rate?: number;
+  container?: "wav" | "raw";
+}
+
+/**
+ * What an offline render wrote.
+ *
+ * @property frames - Frames rendered
+ * @property bytes - Sample bytes written, excluding any header
+ */
+export interface OfflineRenderResult {
+  frames: number;
+  bytes: number;
+}
@@ -0,0 +1,38 @@
+/**
+ * Filter quality for streams created with a fixed `renderRate`, trading CPU
+ * time on the real-time thread against how cleanly audio survives the rate
+ * conversion.
+ *
+ * @enum ResampleQuality
+ *
+ * @example
+ * ```typescript
+ * // Always render at 48kHz, whatever rate the graph runs at
+ * const stream = await session.createAudioOutputStream({
+ *   renderRate: 48_000,
+ *   resampleQuality: ResampleQuality.Best,
+ * });
+ * ```
+ */
+export enum ResampleQuality {
+  /**
+   * Shortest filter, for voice, games and system sounds.
+   * Performance: Lowest CPU usage, some aliasing near Nyquist
+   * Filter: 16 taps, passband to 85% of Nyquist
+   */
+  Fast = "fast",
+
+  /**
+   * Good enough for music playback on most hardware.
+   * Performance: Roughly 1.5x the cost of Fast
+   * Filter: 32 taps, passband to 91% of Nyquist
+   */
+  Balanced = "balanced",
+
+  /**
+   * Longest filter, for critical listening.
+   * Performance: Roughly 3x the cost of Fast
+   * Filter: 64 taps, passband to 95% of Nyquist
+   */
+  Best = "best",
+}
@@ -0,0 +1,58 @@
+/**
+ * Samples cached natively by a session and triggered on its output streams.
+ */
+
+export interface NativeSampleCache {
+  loadSample: (
+    id: string,
+    samples: Float32Array | Float64Array,
+    opts: { channels?: number; rate?: number }
+  ) => void;
+  unloadSample: (id: string) => boolean;
+}
+
+export interface NativeVoices {
+  // Positional, NaN for "now", so that a trigger builds no options object;
+  // returns the start frame
+  triggerSample: (
+    id: string,
+    gain: number,
+    pan: number,
+    atFrame: number,
+    atTimeNs: number,
+    polyphony: number
+  ) => number;
+}
+
+/**
+ * How a sample is stored.
+ *
+ * @property channels - 1 for mono, or the channel count of the streams that
+ *   will play it for interleaved samples (default: 1)
+ * @property rate - Sample rate of the samples; when given, streams that
+ *   render at another rate refuse to trigger it (default: unchecked)
+ */
+export interface LoadSampleOpts {
+  channels?: number;
+  rate?: number;
+}
+
+/**
+ * How a triggered sample plays. Give at most one of `atFrame` and
+ * `atTimeNs`; with neither, or a moment already rendered, the sample plays
+ * as soon as possible.
+ *
+ * @property gain - Linear gain applied while mixing (default: 1.0)
+ * @property pan - -1 (left) to +1 (right); pans mono samples and balances
+ *   stereo ones (default: 0)
+ * @property atFrame - Frame on the `renderPosition` timeline to start at
+ * @property atTimeNs - `CLOCK_MONOTONIC` time, in nanoseconds, at which the
+ *   first frame should reach the device; converted with the stream's
+ *   `timing`
+ */
+export interface TriggerOpts {
+  gain?: number;
+  pan?: number;
+  atFrame?: number;
+  atTimeNs?: number;
+}
@@ -0,0 +1,243 @@
+/**
+ * Clips scheduled to start at an exact frame of an output stream.
+ */
+
+import {
+  assertScheduled,
+  RampCurve,
+  type AutomationLaneName,
+  type RampOpts,
+} from "./automation.mjs";
+import type { NativeMixer } from "./mixer-input.mjs";
+
+export interface NativeClips {
+  scheduleClip: (
+    samples: Float32Array,
+    opts: {
+      channels?: number;
+      atFrame?: number;
+      atTimeNs?: number;
+      gain?: number;
+      pan?: number;
+    }
+  ) => { id: number; startFrame: number };
+  hasMixerInputEnded: (id: number) => boolean;
+}
+
+/**
+ * When and how a clip plays. Give exactly one of `atFrame` and `atTimeNs`;
+ * a moment that has already been rendered plays as soon as possible.
+ *
+ * @property atFrame - Frame on the `renderPosition` timeline to start at
+ * @property atTimeNs - `CLOCK_MONOTONIC` time, in nanoseconds, at which the
+ *   first frame should reach the device; converted with the stream's
+ *   `timing`
+ * @property channels - 1 for a mono clip panned onto the stream, or the
+ *   stream's channel count for interleaved samples (default: 1)
+ * @property gain - Linear gain applied while mixing (default: 1.0)
+ * @property pan - -1 (left) to +1 (right); pans mono clips and balances
+ *   stereo ones (default: 0)
+ */
+export interface ScheduleOpts {
+  atFrame?: number;
+  atTimeNs?: number;
+  channels?: number;
+  gain?: number;
+  pan?: number;
+}
+
+/**
+ * Samples copied into the native mixer, held silently until their start
+ * frame and then mixed from that exact offset inside the quantum.
+ *
+ * Nothing is padded with silence and no JavaScript runs while the clip
+ * waits or plays. A clip takes one of the stream's 64 mixer slots from the
+ * moment it is scheduled until it has played or is cancelled.
+ *
+ * @example
+ * ```typescript
+ * const beat = stream.renderRate / 2; // 120 BPM
+ * const start = stream.renderPosition + stream.renderRate;
+ * for (let i = 0; i < 8; i++) {
+ *   stream.schedule(kick, { atFrame: start + i * beat });
+ * }
+ * ```
+ */
+export interface ScheduledClip {
+  /** Frame on the `renderPosition` timeline the clip starts at. */
+  get startFrame(): number;
+
+  /** Number of channels per frame in the clip. */
+  get channels(): number;
+
+  /** Length of the clip in frames. */
+  get frames(): number;
+
+  /** Whether the clip has played to its end or was cancelled. */
+  get ended(): boolean;
+
+  /**
+   * Linear gain applied while mixing: the last value set or ramped to.
+   * Setting it cancels the gain ramps that have not finished.
+   */
+  get gain(): number;
+  set gain(value: number);
+
+  /**
+   * Pan (mono) or balance (stereo) from -1 (left) to +1 (right): the last
+   * value set or ramped to. Setting it cancels unfinished pan ramps.
+   */
+  get pan(): number;
+  set pan(value: number);
+
+  /** Ramp the mixing gain natively, as `MixerInput.rampGain()` does. */
+  rampGain: (target: number, frames: number, opts?: RampOpts) => void;
+
+  /** Ramp the pan natively, as `MixerInput.rampPan()` does. */
+  rampPan: (target: number, frames: number, opts?: RampOpts) => void;
+
+  /** Drop the clip, whether or not it has started, and free its slot. */
+  cancel: () => void;
+
+  /** Resolves when the clip has played to its end or is cancelled. */
+  finished: () => Promise<void>;
+}
+
+export class ScheduledClipImpl implements ScheduledClip {
+  readonly #mixer: NativeMixer & NativeClips;
+  readonly #id: number;
+  readonly #startFrame: number;
+  readonly #channels: number;
+  readonly #frames: number;
+  readonly #finished: Promise<void>;
+  #resolveFinished!: () => void;
+  #gain: number;
+  #pan: number;
+  #cancelled = false;
+
+  constructor(
+    mixer: NativeMixer & NativeClips,
+    samples: Float32Array,
+    opts: ScheduleOpts
+  ) {
+    const { atFrame, atTimeNs, channels = 1, gain = 1, pan = 0 } = opts;
+    if ((atFrame === undefined) === (atTimeNs === undefined)) {
+      throw new TypeError(
+        "schedule() needs exactly one of atFrame or atTimeNs"
+      );
+    }
+
+    this.#mixer = mixer;
+    this.#channels = channels;
+    this.#frames = Math.floor(samples.length / channels);
+    this.#gain = gain;
+    this.#pan = Math.max(-1, Math.min(1, pan));
+    const { id, startFrame } = mixer.scheduleClip(samples, {
+      channels,
+      atFrame,
+      atTimeNs,
+      gain,
+      pan: this.#pan,
+    });
+    this.#id = id;
+    this.#startFrame = startFrame;
+    this.#finished = new Promise((resolve) => {
+      this.#resolveFinished = resolve;
+    });
+  }
+
+  /**
+   * Free the slot if the clip has played out.
+   * Called by the stream when the real-time thread reports ended inputs.
+   *
+   * @internal
+   */
+  poll() {
+    if (!this.#cancelled && this.#mixer.hasMixerInputEnded(this.#id)) {
+      this.cancel();
+    }
+    return this.#cancelled;
+  }
+
+  get startFrame() {
+    return this.#startFrame;
+  }
+
+  get channels() {
+    return this.#channels;
+  }
+
+  get frames() {
+    return this.#frames;
+  }
+
+  get ended() {
+    return this.#cancelled || this.#mixer.hasMixerInputEnded(this.#id);
+  }
+
+  get gain() {
+    return this.#gain;
+  }
+
+  set gain(value: number) {
+    this.#gain = value;
+    if (!this.#cancelled) {
+      this.#mixer.setMixerInputLevels(this.#id, this.#gain, NaN);
+    }
+  }
+
+  get pan() {
+    return this.#pan;
+  }
+
+  set pan(value: number) {
+    this.#pan = Math.max(-1, Math.min(1, value));
+    if (!this.#cancelled) {
+      this.#mixer.setMixerInputLevels(this.#id, NaN, this.#pan);
+    }
+  }
+
+  rampGain(target: number, frames: number, opts?: RampOpts) {
+    this.#automate("gain", target, frames, opts);
+    this.#gain = target;
+  }
+
+  rampPan(target: number, frames: number, opts?: RampOpts) {
+    const clamped = Math.max(-1, Math.min(1, target));
+    this.#automate("pan", clamped, frames, opts);
+    this.#pan = clamped;
+  }
+
+  cancel() {
+    if (!this.#cancelled) {
+      this.#cancelled = true;
+      this.#mixer.removeMixerInput(this.#id);
+      this.#resolveFinished();
+    }
+  }
+
+  finished() {
+    return this.#finished;
+  }
+
+  #automate(
+    lane: AutomationLaneName,
+    target: number,
+    frames: number,
+    { startFrame = 0, curve = RampCurve.Linear }: RampOpts = {}
+  ) {
+    if (this.#cancelled) {
+      throw new Error("Clip has been cancelled");
+    }
+    assertScheduled(
+      this.#mixer.automateMixerInput(
+        this.#id,
+        lane,
+        target,
+        frames,
+        startFrame,
+        curve
+      )
+    );
+  }
+}
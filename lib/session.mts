@@ -4,8 +4,21 @@ import {
   type NativeAudioOutputStream,
   type AudioOutputStream,
   type AudioOutputStreamOpts,
-  type AudioOutputStreamProps,
 } from "./audio-output-stream.mjs";
+import {
+  StreamPoolImpl,
+  type StreamPool,
+  type StreamPoolOpts,
+} from "./stream-pool.mjs";
+import {
+  AudioInputStreamImpl,
+  type NativeAudioInputStream,
+  type AudioInputStream,
+  type AudioInputStreamOpts,
+} from "./audio-input-stream.mjs";
+import type { NativeBufferRequest } from "./buffer-config.mjs";
+import type { LoadSampleOpts, NativeSampleCache } from "./sample-cache.mjs";
+import type { StreamLevels } from "./level-meter.mjs";
 import type { Latency, StreamStateEnum } from "./stream.mjs";
 
 const require = createRequire(import.meta.url);
@@ -17,33 +30,95 @@ interface NativeModule {
   startSession: () => Promise<NativePipeWireSession>;
 }
 
-export interface NativePipeWireSession {
-  start: () => Promise<void>;
-  createAudioOutputStream: (opts: {
-    name: string;
+export interface NativeStreamOptions {
+  name: string;
+  inputFormat: number;
+  dither: boolean;
+  sharedRing?: Uint8Array;
+  rate: number;
+  renderRate?: number;
+  resampleQuality?: string;
+  channels: number;
+  buffering?: NativeBufferRequest;
+  watermarks?: { low?: number; high?: number };
+  metering?: { updatesPerSecond: number; truePeak: boolean };
+  trace?: { capacity: number };
+  props: Record<string, string>;
+  onStateChange: (state: StreamStateEnum, error: string) => void;
+  onPropsChange: () => void; // Read the coalesced props from `props`
+  onFormatChange: (format: {
     format: number;
-    bytesPerSample: number;
-    rate: number;
     channels: number;
-    buffering?: {
-      requestedQuanta?: number;
-      requestedBytes?: number;
-      requestedMs?: number;
-    };
-    props: Record<string, string>;
-    onStateChange: (state: StreamStateEnum, error: string) => void;
-    onPropsChange: (props: AudioOutputStreamProps) => void;
-    onFormatChange: (format: {
-      format: number;
-      channels: number;
-      rate: number;
-    }) => void;
-    onLatencyChange: (latency: Latency) => void;
-    onUnknownParamChange: (param: number) => void;
-  }) => Promise<NativeAudioOutputStream>;
+    rate: number;
+  }) => void;
+  onLatencyChange: (latency: Latency) => void;
+  onUnknownParamChange: (param: number) => void;
+  onBufferAdjusted?: (adjustment: {
+    oldSize: number;
+    newSize: number;
+    reason: string;
+  }) => void;
+  onQuantumChange?: (quantum: { framesPerQuantum: number; rate: number }) => void;
+  onLevels?: (levels: StreamLevels) => void;
+  onInputEnded?: () => void;
+}
+
+export interface NativePipeWireSession extends NativeSampleCache {
+  start: (opts?: SessionOpts) => Promise<void>;
+  get loops(): Array<SessionLoopStats>;
+  createAudioOutputStream: (
+    opts: NativeStreamOptions
+  ) => Promise<NativeAudioOutputStream>;
+  createAudioInputStream: (
+    opts: NativeStreamOptions
+  ) => Promise<NativeAudioInputStream>;
+  createAudioOutputStreams: (
+    opts: Array<NativeStreamOptions>
+  ) => Promise<Array<NativeAudioOutputStream>>;
+  connectStreams: (
+    requests: Array<{
+      stream: NativeAudioOutputStream;
+      preferredFormats: Array<number>;
+      preferredRates: Array<number>;
+    }>
+  ) => Promise<void>;
   destroy: () => Promise<void>;
 }
 
+/**
+ * Configuration options for `startSession()`.
+ *
+ * @property loops - Number of PipeWire thread loops to spread streams across.
+ *   Each stream's control calls and non-real-time callbacks run on its loop,
+ *   so sessions with many streams scale across cores (default: 1)
+ * @property rtPriority - Real-time priority (1-99) requested, through RTKit
+ *   where available, for the thread that processes each stream's audio. It
+ *   is applied once the stream's first cycle has been delivered. When unset,
+ *   those threads keep the priority PipeWire gave them. Loop threads only
+ *   make control calls and always keep normal priority.
+ * @property cpus - CPUs to pin to. Loop `i` and the audio threads of the
+ *   streams on it run on `cpus[i % cpus.length]` (default: no pinning)
+ *
+ * @example
+ * ```typescript
+ * const session = await startSession({ loops: 4, cpus: [2, 3, 4, 5] });
+ * ```
+ */
+export interface SessionOpts {
+  loops?: number;
+  rtPriority?: number;
+  cpus?: Array<number>;
+}
+
+/**
+ * A session loop's current load.
+ *
+ * @property streams - Streams placed on the loop
+ */
+export interface SessionLoopStats {
+  streams: number;
+}
+
 /**
  * PipeWire session that manages the connection to the PipeWire audio server.
  *
@@ -71,9 +146,9 @@ export class PipeWireSession {
    * Creates and starts a new PipeWire session.
    * @internal Use `startSession()` function instead
    */
-  static async start() {
+  static async start(opts?: SessionOpts) {
     const session = new PipeWireSession();
-    await session.#start();
+    await session.#start(opts);
     return session;
   }
 
@@ -81,8 +156,16 @@ export class PipeWireSession {
     this.#nativeSession = new NativePipeWireSession();
   }
 
-  #start() {
-    return this.#nativeSession.start();
+  #start(opts?: SessionOpts) {
+    return this.#nativeSession.start(opts);
+  }
+
+  /**
+   * The session's thread loops and how many streams each holds. New streams
+   * go to the loop with the fewest.
+   */
+  get loops(): Array<SessionLoopStats> {
+    return this.#nativeSession.loops;
   }
 
   /**
@@ -110,6 +193,139 @@ export class PipeWireSession {
     return AudioOutputStreamImpl.create(this.#nativeSession, opts);
   }
 
+  /**
+   * Creates several audio output streams at once. Every stream is validated
+   * before any is built, then all of them are built by one native call that
+   * takes each session loop's lock once, rather than once per stream.
+   *
+   * @param optsList - Configuration for each stream, as for
+   *   `createAudioOutputStream()`
+   * @returns Promise resolving to the streams, in the order of `optsList`
+   * @throws Will reject, creating none of the streams, if any options are
+   *   invalid
+   *
+   * @example
+   * ```typescript
+   * const voices = await session.createAudioOutputStreams(
+   *   Array.from({ length: 8 }, (_, i) => ({ name: `Voice ${i}` }))
+   * );
+   * await session.connectAll(voices);
+   * ```
+   */
+  createAudioOutputStreams(
+    optsList: Array<AudioOutputStreamOpts | undefined>
+  ): Promise<Array<AudioOutputStream>> {
+    if (!this.#nativeSession) {
+      throw new Error("Session has been disposed");
+    }
+    return AudioOutputStreamImpl.createAll(this.#nativeSession, optsList);
+  }
+
+  /**
+   * Connects several output streams at once: the format offers for every
+   * stream are built and connected under a single lock of each session
+   * loop, and negotiation for all of them runs concurrently. Streams that
+   * are already connected are skipped.
+   *
+   * @param streams - Output streams created by this session
+   * @returns Promise resolving once every stream has negotiated a format
+   */
+  connectAll(streams: Array<AudioOutputStream>): Promise<void> {
+    if (!this.#nativeSession) {
+      throw new Error("Session has been disposed");
+    }
+    return AudioOutputStreamImpl.connectAll(this.#nativeSession, streams);
+  }
+
+  /**
+   * Creates a new audio capture stream.
+   *
+   * @param opts - Stream configuration options (all optional)
+   * @returns Promise resolving to AudioInputStream instance
+   * @throws Will reject if session is disposed or stream creation fails
+   *
+   * @example
+   * ```typescript
+   * const stream = await session.createAudioInputStream({
+   *   name: "My Recorder",
+   *   channels: 1
+   * });
+   * ```
+   */
+  createAudioInputStream(
+    opts?: AudioInputStreamOpts
+  ): Promise<AudioInputStream> {
+    if (!this.#nativeSession) {
+      throw new Error("Session has been disposed");
+    }
+    return AudioInputStreamImpl.create(this.#nativeSession, opts);
+  }
+
+  /**
+   * Creates a pool of output streams that are connected, negotiated and
+   * paused ahead of time, for sounds that must start within a quantum.
+   *
+   * @param opts - Pool size and the options each stream is created with
+   * @returns Promise resolving once every pooled stream is ready
+   *
+   * @example
+   * ```typescript
+   * const pool = await session.createStreamPool({
+   *   size: 4,
+   *   stream: { name: "Notifications", role: "Notification" },
+   * });
+   * ```
+   */
+  createStreamPool(opts?: StreamPoolOpts): Promise<StreamPool> {
+    if (!this.#nativeSession) {
+      throw new Error("Session has been disposed");
+    }
+    return StreamPoolImpl.create(
+      (streamOpts) =>
+        this.createAudioOutputStream(
+          streamOpts
+        ) as Promise<AudioOutputStreamImpl>,
+      opts
+    );
+  }
+
+  /**
+   * Store decoded PCM natively under `id`, so any output stream of the
+   * session can `trigger()` it. The samples are copied once, converted to
+   * the Float32 the mixer sums in, and shared by every voice that plays
+   * them: repeated playback transfers and allocates nothing. Loading under
+   * an `id` already in use replaces that sample; voices playing the old one
+   * finish with it.
+   *
+   * @param id - Name to trigger the sample by
+   * @param samples - Float32 or Float64 samples, interleaved when
+   *   `channels` > 1
+   * @param opts - Channel count and sample rate
+   *
+   * @example
+   * ```typescript
+   * session.loadSample("click", clickSamples, { rate: 48_000 });
+   * stream.trigger("click", { gain: 0.5 });
+   * ```
+   */
+  loadSample(
+    id: string,
+    samples: Float32Array | Float64Array,
+    opts: LoadSampleOpts = {}
+  ) {
+    this.#nativeSession.loadSample(id, samples, opts);
+  }
+
+  /**
+   * Drop a loaded sample. Voices already playing it finish first, and its
+   * memory is freed once the last of them has ended.
+   *
+   * @returns Whether a sample was loaded under `id`
+   */
+  unloadSample(id: string): boolean {
+    return this.#nativeSession.unloadSample(id);
+  }
+
   /**
    * Disposes the session and releases PipeWire resources.
    *
@@ -139,6 +355,7 @@ export class PipeWireSession {
  * This is the main entry point for the pw-client API. Sessions manage
  * connections to the PipeWire audio server and create audio streams.
  *
+ * @param opts - Session configuration options (all optional)
  * @returns Promise resolving to a started PipeWireSession
  * @throws Will reject if PipeWire connection fails or daemon unavailable
  *
@@ -156,6 +373,6 @@ export class PipeWireSession {
  * await using session = await startSession();
  * ```
  */
-export async function startSession() {
-  return await PipeWireSession.start();
+export async function startSession(opts?: SessionOpts) {
+  return await PipeWireSession.start(opts);
 }
@@ -0,0 +1,150 @@
+import { AudioFormat } from "./audio-format.mjs";
+
+// Header layout shared with src/shared-ring.hpp. All fields are 32-bit; the
+// indices are free-running frame counters, so the capacity is a power of two.
+const HEADER_BYTES = 128;
+const WRITE_INDEX = 0;
+const CAPACITY = 1;
+const CHANNELS = 2;
+const SAMPLE_BYTES = 3;
+const READ_INDEX = 16;
+const RATE = 17;
+const SLEEP_WORD = 31; // Never written; Atomics.wait() on it is a plain sleep
+
+/**
+ * Allocates a SharedArrayBuffer laid out as a stream ring.
+ *
+ * @param frames - Minimum capacity in frames; rounded up to a power of two
+ * @param channels - Interleaved channel count, matching the stream
+ * @param inputFormat - `AudioFormat.Float32` or `AudioFormat.Float64`
+ * @internal
+ */
+export function createSharedRing(
+  frames: number,
+  channels: number,
+  inputFormat: AudioFormat
+): SharedArrayBuffer {
+  const capacity = 2 ** Math.ceil(Math.log2(Math.max(frames, 1)));
+  const buffer = new SharedArrayBuffer(
+    HEADER_BYTES + capacity * channels * inputFormat.byteSize
+  );
+
+  const header = new Uint32Array(buffer, 0, HEADER_BYTES / 4);
+  header[CAPACITY] = capacity;
+  header[CHANNELS] = channels;
+  header[SAMPLE_BYTES] = inputFormat.byteSize;
+  return buffer;
+}
+
+/**
+ * Producer side of a stream's shared ring, for rendering audio in a worker
+ * thread. The PipeWire real-time thread reads the ring directly, so writing
+ * through it involves no native calls and no promises.
+ *
+ * Create the stream with the `sharedRing` option, post `stream.sharedRing`
+ * to a worker, and wrap it there:
+ *
+ * @example
+ * ```typescript
+ * // worker.mts
+ * const ring = new SharedRingWriter(workerData.ring);
+ * const block = new Float32Array(128 * ring.channels);
+ * for (;;) {
+ *   ring.waitForSpace(128);
+ *   render(block);
+ *   ring.write(block);
+ * }
+ * ```
+ */
+export class SharedRingWriter {
+  #header: Int32Array;
+  #samples: Float32Array | Float64Array;
+  #capacity: number;
+  #channels: number;
+
+  constructor(buffer: SharedArrayBuffer) {
+    this.#header = new Int32Array(buffer, 0, HEADER_BYTES / 4);
+    this.#capacity = this.#header[CAPACITY];
+    this.#channels = this.#header[CHANNELS];
+
+    const ctor =
+      this.#header[SAMPLE_BYTES] === 4 ? Float32Array : Float64Array;
+    this.#samples = new ctor(
+      buffer,
+      HEADER_BYTES,
+      this.#capacity * this.#channels
+    );
+  }
+
+  /** Interleaved channel count of the ring. */
+  get channels(): number {
+    return this.#channels;
+  }
+
+  /** Ring capacity in frames. */
+  get capacity(): number {
+    return this.#capacity;
+  }
+
+  /** Negotiated sample rate, or 0 until the stream has negotiated a format. */
+  get rate(): number {
+    return Atomics.load(this.#header, RATE);
+  }
+
+  /** Frames written but not yet consumed by PipeWire. */
+  get queuedFrames(): number {
+    const written = Atomics.load(this.#header, WRITE_INDEX);
+    const read = Atomics.load(this.#header, READ_INDEX);
+    return (written - read) >>> 0;
+  }
+
+  /** Frames that can be written without overwriting unplayed audio. */
+  get writableFrames(): number {
+    return this.#capacity - this.queuedFrames;
+  }
+
+  /**
+   * Copies as many whole frames as fit into the ring.
+   *
+   * @param frames - Interleaved samples of the ring's sample format
+   * @returns Number of frames written
+   */
+  write(frames: Float32Array | Float64Array): number {
+    const count = Math.min(
+      Math.floor(frames.length / this.#channels),
+      this.writableFrames
+    );
+    if (count === 0) {
+      return 0;
+    }
+
+    const written = Atomics.load(this.#header, WRITE_INDEX);
+    const offset = (written & (this.#capacity - 1)) * this.#channels;
+    const total = count * this.#channels;
+    const firstPart = Math.min(total, this.#samples.length - offset);
+
+    this.#samples.set(frames.subarray(0, firstPart), offset);
+    if (firstPart < total) {
+      this.#samples.set(frames.subarray(firstPart, total), 0);
+    }
+
+    Atomics.store(this.#header, WRITE_INDEX, (written + count) | 0);
+    return count;
+  }
+
+  /**
+   * Blocks the calling thread until at least `minFrames` can be written.
+   * PipeWire cannot wake an `Atomics.wait()` caller, so this sleeps for the
+   * time the queued audio needs to drain; use it in workers only.
+   *
+   * @param minFrames - Frames of space to wait for (default: 1)
+   */
+  waitForSpace(minFrames = 1) {
+    const wanted = Math.min(minFrames, this.#capacity);
+    while (this.writableFrames < wanted) {
+      const rate = this.rate || 48_000;
+      const missing = wanted - this.writableFrames;
+      Atomics.wait(this.#header, SLEEP_WORD, 0, (missing * 1000) / rate);
+    }
+  }
+}
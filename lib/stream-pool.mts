@@ -0,0 +1,183 @@
+import type {
+  AudioOutputStream,
+  AudioOutputStreamOpts,
+} from "./audio-output-stream.mjs";
+
+/**
+ * Configuration options for `session.createStreamPool()`.
+ *
+ * @property size - Streams kept connected and paused, ready to check out
+ *   (default: 2)
+ * @property stream - Options every pooled stream is created with
+ */
+export interface StreamPoolOpts {
+  size?: number;
+  stream?: AudioOutputStreamOpts;
+}
+
+/**
+ * A set of output streams that are already created, connected and
+ * negotiated, then paused.
+ *
+ * Checking one out only resumes it, so its first samples reach PipeWire
+ * within about one quantum instead of after stream creation and format
+ * negotiation. Use a pool for short sounds that have to start promptly,
+ * such as notifications and UI feedback.
+ *
+ * @example
+ * ```typescript
+ * await using pool = await session.createStreamPool({ size: 4 });
+ *
+ * const stream = await pool.acquire();
+ * await stream.writeFrames(chime);
+ * await pool.release(stream); // Pauses it once the chime has played
+ * ```
+ */
+export interface StreamPool {
+  /**
+   * Check out a stream, resumed and ready to write. When every pooled
+   * stream is checked out, a new one is created and connected.
+   */
+  acquire: () => Promise<AudioOutputStream>;
+
+  /**
+   * Return a stream to the pool. Waits for its buffered audio to finish
+   * playing, then pauses it and undoes what it was used for: its files,
+   * clips, mixer inputs, generators and inserted effects are removed, its
+   * ramps cancelled and its props put back to full volume. Streams beyond
+   * the pool's size are disposed. Rejects for a stream that is not checked
+   * out of this pool, including one already released.
+   */
+  release: (stream: AudioOutputStream) => Promise<void>;
+
+  /**
+   * Streams ready to check out.
+   */
+  get idle(): number;
+
+  /**
+   * Dispose the idle streams. Checked-out streams are disposed when they
+   * are released.
+   */
+  dispose: () => Promise<void>;
+
+  [Symbol.asyncDispose]: () => Promise<void>;
+}
+
+/** @internal A stream the pool can put back the way it was created */
+export interface PooledStream extends AudioOutputStream {
+  reset: () => void;
+}
+
+export class StreamPoolImpl implements StreamPool {
+  static async create(
+    createStream: (opts?: AudioOutputStreamOpts) => Promise<PooledStream>,
+    opts: StreamPoolOpts = {}
+  ): Promise<StreamPool> {
+    const { size = 2, stream: streamOpts } = opts;
+    if (!(size >= 0) || !Number.isInteger(size)) {
+      throw new RangeError("size must be a whole number");
+    }
+
+    const pool = new StreamPoolImpl(createStream, size, streamOpts);
+    const results = await Promise.allSettled(
+      Array.from({ length: size }, () => pool.#connect())
+    );
+    const failed = results.find((result) => result.status === "rejected");
+    if (failed) {
+      await Promise.all(
+        results.map(
+          (result) => result.status === "fulfilled" && result.value.dispose()
+        )
+      );
+      throw failed.reason;
+    }
+    const streams = results.map(
+      (result) => (result as PromiseFulfilledResult<PooledStream>).value
+    );
+    for (const stream of streams) {
+      stream.pause();
+      pool.#idle.push(stream);
+    }
+    return pool;
+  }
+
+  readonly #createStream: (
+    opts?: AudioOutputStreamOpts
+  ) => Promise<PooledStream>;
+  readonly #size: number;
+  readonly #streamOpts?: AudioOutputStreamOpts;
+  readonly #idle: Array<PooledStream> = [];
+  readonly #checkedOut = new Set<PooledStream>();
+  #isDisposed = false;
+
+  private constructor(
+    createStream: (opts?: AudioOutputStreamOpts) => Promise<PooledStream>,
+    size: number,
+    streamOpts?: AudioOutputStreamOpts
+  ) {
+    this.#createStream = createStream;
+    this.#size = size;
+    this.#streamOpts = streamOpts;
+  }
+
+  async #connect() {
+    const stream = await this.#createStream(this.#streamOpts);
+    try {
+      await stream.connect();
+    } catch (error) {
+      await stream.dispose();
+      throw error;
+    }
+    return stream;
+  }
+
+  async acquire() {
+    if (this.#isDisposed) {
+      throw new Error("Stream pool has been disposed");
+    }
+
+    let stream = this.#idle.pop();
+    if (stream) {
+      stream.resume();
+    } else {
+      stream = await this.#connect(); // Slow path: the pool ran dry
+    }
+    this.#checkedOut.add(stream);
+    return stream;
+  }
+
+  async release(released: AudioOutputStream) {
+    const stream = released as PooledStream;
+    if (!this.#checkedOut.delete(stream)) {
+      throw new Error("Stream is not checked out of this pool");
+    }
+
+    await stream.isFinished();
+    if (
+      this.#isDisposed ||
+      !stream.isConnected ||
+      this.#idle.length >= this.#size
+    ) {
+      await stream.dispose();
+      return;
+    }
+    stream.pause();
+    stream.reset();
+    this.#idle.push(stream);
+  }
+
+  get idle(): number {
+    return this.#idle.length;
+  }
+
+  async dispose() {
+    this.#isDisposed = true;
+    const streams = this.#idle.splice(0);
+    await Promise.all(streams.map((stream) => stream.dispose()));
+  }
+
+  [Symbol.asyncDispose]() {
+    return this.dispose();
+  }
+}
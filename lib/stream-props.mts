@@ -0,0 +1,96 @@
+/**
+ * Coalesced props delivery and batched control updates.
+ */
+
+/**
+ * Controls that `setProps()` can change.
+ *
+ * @property volume - Stream volume, linear (1.0 is unity)
+ * @property mute - Mute the stream
+ * @property channelVolumes - One linear volume per channel
+ */
+export interface StreamControls {
+  volume?: number;
+  mute?: boolean;
+  channelVolumes?: ArrayLike<number>;
+}
+
+/** @internal The shape the native `setControls()` takes */
+export interface NativeControls {
+  volume?: number;
+  mute?: boolean;
+  channelVolumes?: Float32Array;
+}
+
+/**
+ * @internal Deliver props changes at most once per `intervalMs`. The native
+ * side only signals that props changed; `deliver` reads them, so changes
+ * between deliveries cost nothing in JavaScript.
+ */
+export function throttleProps(intervalMs: number, deliver: () => void) {
+  let timer: NodeJS.Timeout | undefined;
+  let deliveredAt = -Infinity;
+
+  const run = () => {
+    timer = undefined;
+    deliveredAt = performance.now();
+    deliver();
+  };
+
+  return {
+    notify() {
+      if (timer) {
+        return; // The pending delivery will read the latest props
+      }
+      const wait = deliveredAt + intervalMs - performance.now();
+      if (wait <= 0) {
+        run();
+        return;
+      }
+      timer = setTimeout(run, wait);
+      timer.unref();
+    },
+    cancel() {
+      clearTimeout(timer);
+      timer = undefined;
+    },
+  };
+}
+
+/**
+ * @internal Merge every `set()` made in one turn of the event loop into a
+ * single native call.
+ */
+export class ControlBatch {
+  readonly #apply: (controls: NativeControls) => void;
+  #pending?: NativeControls;
+
+  constructor(apply: (controls: NativeControls) => void) {
+    this.#apply = apply;
+  }
+
+  set(controls: StreamControls) {
+    if (!this.#pending) {
+      this.#pending = {};
+      queueMicrotask(() => this.#flush());
+    }
+    const { volume, mute, channelVolumes } = controls;
+    if (volume !== undefined) {
+      this.#pending.volume = volume;
+    }
+    if (mute !== undefined) {
+      this.#pending.mute = mute;
+    }
+    if (channelVolumes !== undefined) {
+      this.#pending.channelVolumes = Float32Array.from(channelVolumes);
+    }
+  }
+
+  #flush() {
+    const controls = this.#pending;
+    this.#pending = undefined;
+    if (controls) {
+      this.#apply(controls);
+    }
+  }
+}
@@ -0,0 +1,97 @@
+/**
+ * Real-time counters kept by the native stream.
+ */
+
+/** @internal Raw counters as returned by the native `stats` accessor */
+export interface NativeStreamStats {
+  cycles: number;
+  requestedFrames: number;
+  deliveredFrames: number;
+  producedFrames: number;
+  zeroFilledFrames: number;
+  underruns: number;
+  dequeueFailures: number;
+  slowCycles: number;
+  maxDurationNs: number;
+  totalDurationNs: number;
+  durationHistogram: Array<number>;
+  wakeups: number;
+  maxWakeupNs: number;
+  totalWakeupNs: number;
+  queuedFrames: number;
+  bufferSize: number;
+  realtime: boolean;
+}
+
+/**
+ * Playback statistics since the stream was created.
+ * Counters are cumulative; diff two snapshots to get rates over an interval.
+ *
+ * @property cycles - Process callbacks that filled a buffer
+ * @property requestedFrames - Frames PipeWire asked for
+ * @property deliveredFrames - Frames handed back to PipeWire, silence included
+ * @property producedFrames - Delivered frames that came from the application
+ * @property zeroFilledFrames - Silence inserted because audio ran out mid-play
+ * @property underruns - Gaps in playback; a gap counts once audio resumes
+ *   after it, so silence after the last write is not an underrun
+ * @property dequeueFailures - Callbacks where PipeWire had no buffer to fill
+ * @property slowCycles - Callbacks that took longer than the audio they
+ *   delivered lasts
+ * @property maxCallbackMs - Slowest process callback
+ * @property meanCallbackMs - Average process callback duration
+ * @property callbackHistogram - Callback counts by duration: bucket `i`
+ *   holds callbacks of 2^i to 2^(i+1) microseconds (first and last buckets
+ *   are open-ended)
+ * @property maxWakeupMs - Longest delay between the real-time thread freeing
+ *   buffer space and a pending `waitForBuffer()` resolving
+ * @property meanWakeupMs - Average of the same delay
+ * @property fillRatio - `producedFrames / deliveredFrames`; 1 means every
+ *   delivered frame was real audio
+ * @property bufferFill - Fraction of the buffer currently queued
+ * @property realtime - Whether the thread processing this stream's audio got
+ *   the session's `rtPriority`
+ */
+export interface StreamStats {
+  cycles: number;
+  requestedFrames: number;
+  deliveredFrames: number;
+  producedFrames: number;
+  zeroFilledFrames: number;
+  underruns: number;
+  dequeueFailures: number;
+  slowCycles: number;
+  maxCallbackMs: number;
+  meanCallbackMs: number;
+  callbackHistogram: Array<number>;
+  maxWakeupMs: number;
+  meanWakeupMs: number;
+  fillRatio: number;
+  bufferFill: number;
+  realtime: boolean;
+}
+
+/** @internal */
+export function toStreamStats(stats: NativeStreamStats): StreamStats {
+  const timedCycles = stats.durationHistogram.reduce((a, b) => a + b, 0);
+
+  return {
+    cycles: stats.cycles,
+    requestedFrames: stats.requestedFrames,
+    deliveredFrames: stats.deliveredFrames,
+    producedFrames: stats.producedFrames,
+    zeroFilledFrames: stats.zeroFilledFrames,
+    underruns: stats.underruns,
+    dequeueFailures: stats.dequeueFailures,
+    slowCycles: stats.slowCycles,
+    maxCallbackMs: stats.maxDurationNs / 1e6,
+    meanCallbackMs: timedCycles ? stats.totalDurationNs / timedCycles / 1e6 : 0,
+    callbackHistogram: stats.durationHistogram,
+    maxWakeupMs: stats.maxWakeupNs / 1e6,
+    meanWakeupMs: stats.wakeups ? stats.totalWakeupNs / stats.wakeups / 1e6 : 0,
+    fillRatio: stats.deliveredFrames
+      ? stats.producedFrames / stats.deliveredFrames
+      : 1,
+    bufferFill: stats.bufferSize ? stats.queuedFrames / stats.bufferSize : 0,
+    realtime: stats.realtime,
+  };
+}
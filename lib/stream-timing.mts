@@ -0,0 +1,41 @@
+/**
+ * Playback timing sampled from PipeWire on the real-time thread.
+ */
+
+/**
+ * Where playback stands, from `pw_stream_get_time_n()` as the real-time
+ * thread sampled it during the last process cycle, combined with the
+ * stream's own buffer. Times are `CLOCK_MONOTONIC` nanoseconds, the clock
+ * behind `process.hrtime.bigint()` on Linux. Frame counts are on the
+ * `renderRate` timeline, like `renderPosition`.
+ *
+ * @property now - When PipeWire took its time values
+ * @property rate - Graph clock: one tick lasts `num / denom` seconds
+ * @property ticks - Graph clock position at `now`
+ * @property delay - Ticks until the first frame of the last cycle reaches
+ *   the device
+ * @property buffered - Frames held in PipeWire's converter or resampler
+ * @property queued - Frames queued in the stream that PipeWire has not
+ *   consumed yet
+ * @property sampledAt - When this reading was built; `playedFrames` is
+ *   extrapolated to this moment
+ * @property playedFrames - Frames that have reached the device
+ * @property latencyNs - Time from a frame leaving the stream buffer to
+ *   reaching the device
+ * @property queuedFrames - Frames written but not yet rendered
+ * @property nextFramePresentationNs - When the next frame written will
+ *   reach the device, if nothing underruns before then
+ */
+export interface StreamTiming {
+  now: number;
+  rate: { num: number; denom: number };
+  ticks: number;
+  delay: number;
+  buffered: number;
+  queued: number;
+  sampledAt: number;
+  playedFrames: number;
+  latencyNs: number;
+  queuedFrames: number;
+  nextFramePresentationNs: number;
+}
@@ -0,0 +1,296 @@
+/**
+ * Per-cycle tracing of an output stream, exportable in the Chrome
+ * trace-event format.
+ */
+
+import { performance, PerformanceObserver } from "node:perf_hooks";
+
+export interface NativeTrace {
+  readTrace: () => { records: Float64Array; lost: number } | undefined;
+  traceGc: (startNs: number, durationNs: number, kind: number) => void;
+}
+
+/**
+ * How a stream traces itself.
+ *
+ * @property capacity - Records kept, from 256 to 1048576, rounded up to a
+ *   power of two; once full, the oldest are overwritten (default: 4096)
+ * @property gc - Also record garbage collection pauses (default: true)
+ */
+export interface TraceOpts {
+  capacity?: number;
+  gc?: boolean;
+}
+
+/**
+ * One traced moment. Times are `CLOCK_MONOTONIC` nanoseconds, the clock
+ * behind `process.hrtime.bigint()`.
+ *
+ * @property type - `"cycle"` for a process callback on the real-time thread,
+ *   `"write"` for a `write()`, `writePlanar()` or `commit()` call,
+ *   `"wakeup"` for a `waitForBuffer()` the real-time thread resolved, from
+ *   signal to resolution, `"gc"` for a garbage collection pause
+ * @property startNs - When it started
+ * @property durationNs - How long it took
+ * @property requestedFrames - Cycles: frames PipeWire asked for; writes:
+ *   frames offered
+ * @property deliveredFrames - Cycles: frames handed to PipeWire; writes:
+ *   frames accepted; wakeups: frames free to write
+ * @property producedFrames - Cycles: delivered frames that were real audio
+ * @property queuedFrames - Frames queued in the stream afterwards
+ * @property wakeups - Cycles: what the cycle woke JavaScript for; empty when
+ *   it woke nothing
+ * @property underrun - Cycles: audio resumed after a gap
+ * @property slow - Cycles: the callback took longer than the audio it
+ *   delivered lasts
+ * @property gcKind - GC: `"minor"`, `"major"`, `"incremental"` or `"weakcb"`
+ */
+export interface TraceEvent {
+  type: "cycle" | "write" | "wakeup" | "gc";
+  startNs: number;
+  durationNs: number;
+  requestedFrames: number;
+  deliveredFrames: number;
+  producedFrames: number;
+  queuedFrames: number;
+  wakeups: Array<string>;
+  underrun: boolean;
+  slow: boolean;
+  gcKind?: string;
+}
+
+/**
+ * The events a stream's trace holds, oldest first.
+ *
+ * @property events - Traced events in the order they were recorded
+ * @property lost - Events overwritten before they were read
+ */
+export interface StreamTrace {
+  events: Array<TraceEvent>;
+  lost: number;
+}
+
+/**
+ * A trace in the Chrome trace-event JSON format. Write it out with
+ * `JSON.stringify()` and open it in Perfetto or `chrome://tracing`.
+ */
+export interface ChromeTrace {
+  traceEvents: Array<Record<string, unknown>>;
+  displayTimeUnit: "ms";
+  otherData: { lost: number };
+}
+
+// Fields per record from readTrace(); TRACE_RECORD_FIELDS natively
+const RECORD_FIELDS = 9;
+const eventTypes = ["cycle", "write", "wakeup", "gc"] as const;
+// WAKE_* bits (src/wakeup-channel.hpp), lowest first
+const wakeupNames = [
+  "buffer",
+  "data",
+  "mixer",
+  "finished",
+  "disconnected",
+  "bufferAdjusted",
+  "quantumChanged",
+  "levels",
+  "props",
+  "inputEnded",
+];
+// NODE_PERFORMANCE_GC_* kinds
+const gcKinds: Record<number, string> = {
+  1: "minor",
+  4: "major",
+  8: "incremental",
+  16: "weakcb",
+};
+const TRACE_UNDERRUN = 1;
+const TRACE_SLOW = 2;
+const RT_THREAD = 1;
+const JS_THREAD = 2;
+
+/** @internal */
+export function toNativeTrace(trace: boolean | TraceOpts) {
+  if (!trace) {
+    return undefined;
+  }
+  const { capacity = 4096 } = trace === true ? {} : trace;
+  return { capacity };
+}
+
+/** @internal */
+export function decodeTrace(native: {
+  records: Float64Array;
+  lost: number;
+}): StreamTrace {
+  const { records, lost } = native;
+  const events: Array<TraceEvent> = [];
+  for (let i = 0; i < records.length; i += RECORD_FIELDS) {
+    const type = eventTypes[records[i + 2]];
+    const detail = records[i + 7];
+    const flags = records[i + 8];
+    events.push({
+      type,
+      startNs: records[i],
+      durationNs: records[i + 1],
+      requestedFrames: records[i + 3],
+      deliveredFrames: records[i + 4],
+      producedFrames: records[i + 5],
+      queuedFrames: records[i + 6],
+      wakeups:
+        type === "cycle"
+          ? wakeupNames.filter((_, bit) => detail & (1 << bit))
+          : [],
+      underrun: !!(flags & TRACE_UNDERRUN),
+      slow: !!(flags & TRACE_SLOW),
+      gcKind: type === "gc" ? (gcKinds[detail] ?? "unknown") : undefined,
+    });
+  }
+  return { events, lost };
+}
+
+/**
+ * Convert a trace to Chrome trace events: cycles on one thread track and
+ * JavaScript activity on another, with the queue depth as a counter, so a
+ * stalled event loop and the underrun it caused line up on one timeline.
+ *
+ * @internal
+ */
+export function toChromeTrace(trace: StreamTrace, name: string): ChromeTrace {
+  const pid = process.pid;
+  const traceEvents: Array<Record<string, unknown>> = [
+    { name: "process_name", ph: "M", pid, args: { name } },
+    {
+      name: "thread_name",
+      ph: "M",
+      pid,
+      tid: RT_THREAD,
+      args: { name: "PipeWire RT" },
+    },
+    {
+      name: "thread_name",
+      ph: "M",
+      pid,
+      tid: JS_THREAD,
+      args: { name: "JavaScript" },
+    },
+  ];
+
+  for (const event of trace.events) {
+    const ts = event.startNs / 1e3;
+    const dur = event.durationNs / 1e3;
+    switch (event.type) {
+      case "cycle":
+        traceEvents.push({
+          name: "process",
+          cat: "cycle",
+          ph: "X",
+          ts,
+          dur,
+          pid,
+          tid: RT_THREAD,
+          args: {
+            requestedFrames: event.requestedFrames,
+            deliveredFrames: event.deliveredFrames,
+            producedFrames: event.producedFrames,
+            queuedFrames: event.queuedFrames,
+            wakeups: event.wakeups,
+            slow: event.slow,
+          },
+        });
+        traceEvents.push({
+          name: "queuedFrames",
+          ph: "C",
+          ts: ts + dur,
+          pid,
+          args: { frames: event.queuedFrames },
+        });
+        if (event.underrun) {
+          traceEvents.push({
+            name: "underrun",
+            cat: "cycle",
+            ph: "i",
+            s: "t",
+            ts,
+            pid,
+            tid: RT_THREAD,
+          });
+        }
+        break;
+      case "write":
+        traceEvents.push({
+          name: "write",
+          cat: "js",
+          ph: "X",
+          ts,
+          dur,
+          pid,
+          tid: JS_THREAD,
+          args: {
+            offeredFrames: event.requestedFrames,
+            acceptedFrames: event.deliveredFrames,
+            queuedFrames: event.queuedFrames,
+          },
+        });
+        break;
+      case "wakeup":
+        traceEvents.push({
+          name: "waitForBuffer wakeup",
+          cat: "js",
+          ph: "X",
+          ts,
+          dur,
+          pid,
+          tid: JS_THREAD,
+          args: { freeFrames: event.deliveredFrames },
+        });
+        break;
+      case "gc":
+        traceEvents.push({
+          name: `GC (${event.gcKind})`,
+          cat: "gc",
+          ph: "X",
+          ts,
+          dur,
+          pid,
+          tid: JS_THREAD,
+        });
+        break;
+    }
+  }
+
+  return {
+    traceEvents,
+    displayTimeUnit: "ms",
+    otherData: { lost: trace.lost },
+  };
+}
+
+/**
+ * Feeds garbage collection pauses into a stream's trace. perf_hooks times
+ * are milliseconds from `performance.timeOrigin`; both clocks are monotonic,
+ * so one offset maps them onto the native steady clock.
+ *
+ * @internal
+ */
+export class GcTracer {
+  readonly #observer: PerformanceObserver;
+
+  constructor(native: NativeTrace) {
+    const offsetNs = Number(process.hrtime.bigint()) - performance.now() * 1e6;
+    this.#observer = new PerformanceObserver((list) => {
+      for (const entry of list.getEntries()) {
+        const { kind = 0 } = (entry.detail ?? {}) as { kind?: number };
+        native.traceGc(
+          offsetNs + entry.startTime * 1e6,
+          entry.duration * 1e6,
+          kind
+        );
+      }
+    });
+    this.#observer.observe({ entryTypes: ["gc"] });
+  }
+
+  stop() {
+    this.#observer.disconnect();
+  }
+}
@@ -0,0 +1,188 @@
+#!/usr/bin/env npx tsx
+
+/**
+ * Benchmark harness for the audio hot paths.
+ *
+ * Runs the native microbenchmarks (build them with `npm run bench:build`)
+ * and a set of stream benchmarks that play into a private null sink, then
+ * optionally compares the results with a saved baseline and fails on
+ * regressions.
+ *
+ * Usage:
+ *   npm run bench -- [--save results.json] [--baseline results.json]
+ *                    [--tolerance 0.15] [--native-only] [--stream-only]
+ */
+
+import { spawn, execFile } from "child_process";
+import { existsSync } from "fs";
+import { readFile, writeFile } from "fs/promises";
+import { parseArgs, promisify } from "util";
+import { startSession, AudioFormat, BufferStrategy } from "../lib/index.mjs";
+
+type Metrics = Record<string, number>;
+type Results = Record<string, Metrics>;
+
+const NATIVE_BINARY = "./build/Release/hot-paths";
+const SINK_NAME = "pw-client-bench";
+
+// Metrics where any increase over the baseline is a regression
+const ABSOLUTE_METRICS = new Set(["allocationsPerQuantum", "underruns"]);
+
+const { values: args } = parseArgs({
+  options: {
+    save: { type: "string" },
+    baseline: { type: "string" },
+    tolerance: { type: "string", default: "0.15" },
+    "native-only": { type: "boolean", default: false },
+    "stream-only": { type: "boolean", default: false },
+  },
+});
+
+async function runNativeBenchmarks(): Promise<Results> {
+  if (!existsSync(NATIVE_BINARY)) {
+    console.warn(
+      `⚠️  ${NATIVE_BINARY} not found; run \`npm run bench:build\` first`
+    );
+    return {};
+  }
+
+  const { stdout } = await promisify(execFile)(NATIVE_BINARY, ["--json"]);
+  return JSON.parse(stdout) as Results;
+}
+
+/**
+ * Creates a null sink owned by a pw-cli process, so it disappears with the
+ * harness and benchmarks never play through real hardware.
+ */
+async function startNullSink() {
+  const cli = spawn("pw-cli", [], { stdio: ["pipe", "ignore", "inherit"] });
+  cli.stdin.write(
+    `create-node adapter { factory.name=support.null-audio-sink node.name=${SINK_NAME} media.class=Audio/Sink audio.position=[FL FR] }\n`
+  );
+  await new Promise((resolve) => setTimeout(resolve, 500));
+
+  // pw_stream_connect() routes to the node named here
+  process.env.PIPEWIRE_NODE = SINK_NAME;
+  return () => cli.kill();
+}
+
+function sineBlock(frames: number, channels: number) {
+  const block = new Float32Array(frames * channels);
+  for (let i = 0; i < block.length; i++) {
+    block[i] = Math.sin(Math.floor(i / channels) * 0.05) * 0.1;
+  }
+  return block;
+}
+
+async function runStreamBenchmarks(): Promise<Results> {
+  const stopSink = await startNullSink();
+  const results: Results = {};
+
+  try {
+    await using session = await startSession();
+
+    // A ring holding two seconds never fills, so writeFrames() never waits
+    // and the timings are pure call overhead
+    {
+      await using stream = await session.createAudioOutputStream({
+        name: "Benchmark write()",
+        inputFormat: AudioFormat.Float32,
+        buffering: { strategy: BufferStrategy.MaxLatency, milliseconds: 2000 },
+      });
+      await stream.connect();
+
+      for (const frames of [1, 128, 1024]) {
+        const block = sineBlock(frames, stream.channels);
+        const calls = Math.floor((stream.rate * 0.5) / frames);
+        const started = process.hrtime.bigint();
+        for (let i = 0; i < calls; i++) {
+          await stream.writeFrames(block);
+        }
+        const elapsed = Number(process.hrtime.bigint() - started);
+        results[`stream/writeFrames-${frames}`] = {
+          nsPerCall: elapsed / calls,
+          nsPerFrame: elapsed / (calls * frames),
+        };
+        await stream.isFinished();
+      }
+    }
+
+    // A small ring makes every write wait on the RT thread, which exercises
+    // the waitForBuffer() wakeup and the real fillBuffer() path
+    {
+      await using stream = await session.createAudioOutputStream({
+        name: "Benchmark playback",
+        inputFormat: AudioFormat.Float32,
+        buffering: { strategy: BufferStrategy.LowLatency },
+      });
+      await stream.connect();
+
+      const block = sineBlock(stream.rate * 3, stream.channels);
+      await stream.writeFrames(block);
+      await stream.isFinished();
+
+      const stats = stream.stats;
+      const framesPerCycle = stats.deliveredFrames / stats.cycles;
+      results["stream/fillBuffer"] = {
+        nsPerFrame: (stats.meanCallbackMs * 1e6) / framesPerCycle,
+        maxCallbackMs: stats.maxCallbackMs,
+        underruns: stats.underruns,
+      };
+      results["stream/waitForBuffer"] = {
+        meanWakeupMs: stats.meanWakeupMs,
+        maxWakeupMs: stats.maxWakeupMs,
+      };
+    }
+  } finally {
+    stopSink();
+  }
+
+  return results;
+}
+
+function findRegressions(current: Results, baseline: Results) {
+  const tolerance = Number(args.tolerance);
+  const regressions: Array<string> = [];
+
+  for (const [name, metrics] of Object.entries(baseline)) {
+    for (const [metric, expected] of Object.entries(metrics)) {
+      const actual = current[name]?.[metric];
+      if (actual === undefined) {
+        continue;
+      }
+      const limit = ABSOLUTE_METRICS.has(metric)
+        ? expected
+        : expected * (1 + tolerance);
+      if (actual > limit) {
+        regressions.push(
+          `${name} ${metric}: ${actual.toFixed(3)} (baseline ${expected.toFixed(3)})`
+        );
+      }
+    }
+  }
+
+  return regressions;
+}
+
+const results: Results = {
+  ...(args["stream-only"] ? {} : await runNativeBenchmarks()),
+  ...(args["native-only"] ? {} : await runStreamBenchmarks()),
+};
+
+console.table(results);
+
+if (args.save) {
+  await writeFile(args.save, JSON.stringify(results, null, 2) + "\n");
+  console.log(`💾 Saved results to ${args.save}`);
+}
+
+if (args.baseline) {
+  const baseline = JSON.parse(await readFile(args.baseline, "utf8")) as Results;
+  const regressions = findRegressions(results, baseline);
+  if (regressions.length) {
+    console.error(`❌ ${regressions.length} regression(s):`);
+    regressions.forEach((regression) => console.error(`   ${regression}`));
+    process.exit(1);
+  }
+  console.log("✅ No regressions against baseline");
+}
@@ -0,0 +1,57 @@
+#include <algorithm>
+
+#include "adaptive-buffer.hpp"
+
+AdaptiveBuffer::AdaptiveBuffer()
+    : minFrames(0)
+    , maxFrames(0)
+    , stepFrames(1)
+    , stableFrames(0)
+    , cleanFrames(0)
+{
+}
+
+void AdaptiveBuffer::configure(uint32_t minFrames, uint32_t maxFrames, uint32_t stepFrames, uint32_t stableFrames)
+{
+    stepFrames = std::max(1u, stepFrames);
+    maxFrames = std::max(stepFrames, maxFrames);
+    minFrames = std::clamp(minFrames, stepFrames, maxFrames);
+
+    this->minFrames.store(minFrames, std::memory_order_relaxed);
+    this->maxFrames.store(maxFrames, std::memory_order_relaxed);
+    this->stepFrames.store(stepFrames, std::memory_order_relaxed);
+    this->stableFrames.store(stableFrames, std::memory_order_release);
+}
+
+bool AdaptiveBuffer::isEnabled() const
+{
+    return stableFrames.load(std::memory_order_acquire) > 0;
+}
+
+uint32_t AdaptiveBuffer::clamp(uint32_t frames) const
+{
+    return std::clamp(frames, minFrames.load(std::memory_order_relaxed), maxFrames.load(std::memory_order_relaxed));
+}
+
+uint32_t AdaptiveBuffer::update(uint32_t current, bool underran, bool clean, uint32_t frames)
+{
+    auto step = stepFrames.load(std::memory_order_relaxed);
+
+    if (underran) {
+        cleanFrames = 0;
+        auto grown = current + std::max(step, current / 2);
+        return clamp((grown + step - 1) / step * step);
+    }
+
+    // Silence between sounds is neither clean nor an underrun
+    if (!clean) {
+        return current;
+    }
+
+    cleanFrames += frames;
+    if (cleanFrames < stableFrames.load(std::memory_order_relaxed)) {
+        return current;
+    }
+    cleanFrames = 0;
+    return clamp(current > step ? current - step : current);
+}
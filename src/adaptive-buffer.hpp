@@ -0,0 +1,37 @@
+#ifndef PIPEWIRE_ADAPTIVE_BUFFER_HPP
+#define PIPEWIRE_ADAPTIVE_BUFFER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#define ADAPT_GROWN 1 // After an underrun
+#define ADAPT_SHRUNK 2 // After a sustained run of clean cycles
+
+// Sizing policy for BufferStrategy.Adaptive: grow the buffer by half after
+// every underrun, and give back one step of latency each time the stream has
+// played `stableFrames` without one, always staying within [min, max].
+//
+// configure() runs on the PipeWire loop thread when the format changes;
+// update() runs on the RT thread every cycle.
+class AdaptiveBuffer {
+
+public:
+    AdaptiveBuffer();
+
+    void configure(uint32_t minFrames, uint32_t maxFrames, uint32_t stepFrames, uint32_t stableFrames);
+    bool isEnabled() const;
+    uint32_t clamp(uint32_t frames) const;
+
+    // RT thread; returns the new buffer size, which is `current` when unchanged
+    uint32_t update(uint32_t current, bool underran, bool clean, uint32_t frames);
+
+private:
+    std::atomic<uint32_t> minFrames;
+    std::atomic<uint32_t> maxFrames;
+    std::atomic<uint32_t> stepFrames;
+    std::atomic<uint32_t> stableFrames; // 0 while disabled
+
+    uint64_t cleanFrames; // RT thread only
+};
+
+#endif // PIPEWIRE_ADAPTIVE_BUFFER_HPP
@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <cerrno>
 #include <cmath>
+#include <cstring>
 #include <format>
 #include <iostream>
 #include <napi.h>
@@ -9,6 +12,7 @@
 #include <spa/param/props.h>
 #include <spa/pod/builder.h>
 #include <spa/utils/result.h>
+#include <tuple>
 #include <vector>
 
 #include "audio-output-stream.hpp"
@@ -19,24 +23,43 @@
 #define DEFAULT_BUFFER_SIZE 2048
 #define DEFAULT_FORMAT SPA_AUDIO_FORMAT_F64
 #define DEFAULT_BYTE_DEPTH 8
+#define MAX_SAMPLE_RATE 192000
+#define MIX_CHUNK_FRAMES 1024
+#define OFFLINE_CHUNK_FRAMES 8192 // Frames an offline render converts and writes at a time
+#define MAX_METER_UPDATES 1000 // Level readings per second
+#define DEFAULT_TRACE_RECORDS 4096
+#define TRACE_RECORD_FIELDS 9 // Numbers per record in what readTrace() returns
+#define ADAPT_STABLE_SECONDS 10 // Clean playback before adaptive buffering gives latency back
 
 using namespace std;
 using namespace std::numbers;
 
-Napi::FunctionReference AudioOutputStream::constructor;
 pw_properties* getStreamProps(const Napi::Object& options);
 void onStateChange(void* userData, pw_stream_state old, pw_stream_state state, const char* error);
 void onParamChange(void* userData, uint32_t id, const struct spa_pod* param);
+void onIoChange(void* userData, uint32_t id, void* area, uint32_t size);
 void onProcess(void* userData);
-Napi::Object parseProps(const Napi::Env env, const struct spa_pod_object* props);
-Napi::Value podToJsValue(const Napi::Env env, const struct spa_pod* pod);
+bool getSampleView(const Napi::Value& value, spa_audio_format rawFormat, SampleView& view);
+bool parseWaveform(const Napi::Value& value, uint32_t& waveform);
+
+struct AutomationRequest {
+    bool pan;
+    float target;
+    uint32_t frames;
+    uint64_t startFrame;
+    uint32_t curve;
+};
+bool parseAutomation(const Napi::CallbackInfo& info, size_t first, AutomationRequest& request);
+bool parseEffectType(const Napi::Value& value, uint32_t& type);
+bool parseBiquadShape(const Napi::Value& value, float& shape);
+bool parseEffectParams(uint32_t type, const Napi::Object& options, float* params);
 
 static const pw_stream_events stream_events = {
     .version = PW_VERSION_STREAM_EVENTS,
     .destroy = NULL,
     .state_changed = onStateChange,
     .control_info = NULL,
-    .io_changed = NULL,
+    .io_changed = onIoChange,
     .param_changed = onParamChange,
     .add_buffer = NULL,
     .remove_buffer = NULL,
@@ -65,6 +88,32 @@ Napi::Function AudioOutputStream::init(Napi::Env env)
                 &AudioOutputStream::getFramesPerQuantum,
                 NULL,
                 napi_enumerable),
+            InstanceAccessor(
+                "renderPosition",
+                &AudioOutputStream::getRenderPosition,
+                NULL,
+                napi_enumerable),
+            InstanceAccessor(
+                "timing",
+                &AudioOutputStream::getTiming,
+                NULL,
+                napi_enumerable),
+            InstanceAccessor(
+                "props",
+                &AudioOutputStream::getProps,
+                NULL,
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::setControls>(
+                "setControls",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::setActive>(
+                "setActive",
+                napi_enumerable),
+            InstanceAccessor(
+                "levels",
+                &AudioOutputStream::getLevels,
+                NULL,
+                napi_enumerable),
             InstanceAccessor(
                 "bufferSize",
                 &AudioOutputStream::getBufferSize,
@@ -73,9 +122,111 @@ Napi::Function AudioOutputStream::init(Napi::Env env)
             InstanceMethod<&AudioOutputStream::write>(
                 "write",
                 napi_enumerable),
+            InstanceMethod<&AudioOutputStream::writePlanar>(
+                "writePlanar",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::acquireBuffer>(
+                "acquireBuffer",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::commit>(
+                "commit",
+                napi_enumerable),
             InstanceMethod<&AudioOutputStream::waitForBuffer>(
                 "waitForBuffer",
                 napi_enumerable),
+            InstanceMethod<&AudioOutputStream::read>(
+                "read",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::waitForData>(
+                "waitForData",
+                napi_enumerable),
+            InstanceAccessor(
+                "readableFrames",
+                &AudioOutputStream::getReadableFrames,
+                NULL,
+                napi_enumerable),
+            InstanceAccessor(
+                "droppedFrames",
+                &AudioOutputStream::getDroppedFrames,
+                NULL,
+                napi_enumerable),
+            InstanceAccessor(
+                "stats",
+                &AudioOutputStream::getStats,
+                NULL,
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::readTrace>(
+                "readTrace",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::traceGc>(
+                "traceGc",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::addMixerInput>(
+                "addMixerInput",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::removeMixerInput>(
+                "removeMixerInput",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::setMixerInputLevels>(
+                "setMixerInputLevels",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::writeMixerInput>(
+                "writeMixerInput",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::getMixerInputFrames>(
+                "getMixerInputFrames",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::waitForMixerSpace>(
+                "waitForMixerSpace",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::addGenerator>(
+                "addGenerator",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::setGeneratorParams>(
+                "setGeneratorParams",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::playFile>(
+                "playFile",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::getFileState>(
+                "getFileState",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::setFileLooping>(
+                "setFileLooping",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::scheduleClip>(
+                "scheduleClip",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::hasMixerInputEnded>(
+                "hasMixerInputEnded",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::triggerSample>(
+                "triggerSample",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::renderOffline>(
+                "renderOffline",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::automate>(
+                "automate",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::automateMixerInput>(
+                "automateMixerInput",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::resetAutomation>(
+                "resetAutomation",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::insertEffect>(
+                "insertEffect",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::setEffectParams>(
+                "setEffectParams",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::setEffectBypass>(
+                "setEffectBypass",
+                napi_enumerable),
+            InstanceMethod<&AudioOutputStream::removeEffect>(
+                "removeEffect",
+                napi_enumerable),
             InstanceMethod<&AudioOutputStream::isFinished>(
                 "isFinished",
                 napi_enumerable),
@@ -84,34 +235,42 @@ Napi::Function AudioOutputStream::init(Napi::Env env)
                 napi_enumerable),
         });
 
-    constructor = Napi::Persistent(ctor);
-    constructor.SuppressDestruct();
-
     return ctor;
 }
 
 AudioOutputStream::AudioOutputStream(const Napi::CallbackInfo& info)
     : Napi::ObjectWrap<AudioOutputStream>(info)
     , session(NULL)
+    , loop(NULL)
     , stream(NULL)
+    , direction(PW_DIRECTION_OUTPUT)
     , format(DEFAULT_FORMAT)
     , bytesPerSample(DEFAULT_BYTE_DEPTH)
     , rate(DEFAULT_RATE)
     , channels(DEFAULT_CHANNELS)
+    , inputFormat(DEFAULT_FORMAT)
+    , inputBytesPerSample(DEFAULT_BYTE_DEPTH)
+    , dither(false)
     , frameBufferSize(DEFAULT_BUFFER_SIZE) // Will be configured in create()
-    , queuedFrameCount(0)
     , requestedBufferSizeBytes(0) // 0 means no specific byte count requested
     , requestedBufferedQuanta(4) // Default multiplier
     , requestedLatencyMs(0.0) // 0.0 means no specific latency requested
+    , adaptiveMinLatencyMs(0.0)
+    , adaptiveMaxLatencyMs(0.0)
+    , adjustedFromFrames(0)
+    , adjustReason(0)
     , framesPerQuantum(256) // Default quantum, will be set from session during create()
-    , currentBufferOffset(0)
+    , graphRate(0)
+    , ioPosition(nullptr)
+    , ioRateMatch(nullptr)
+    , droppedFrames(0)
     , stateChangedCallback(NULL)
     , paramChangedCallback(NULL)
     , latencyCallback(NULL)
-    , propsCallback(NULL)
-    , readyDeferral(NULL)
-    , finishedDeferral(NULL)
-    , disconnectDeferral(NULL)
+    , readySignalledAt(0)
+    , wantedSpace(0)
+    , defaultSpaceWanted(false)
+    , wantedFrames(0)
 {
     Napi::Env env = info.Env();
     if (!info.IsConstructCall()) {
@@ -119,19 +278,106 @@ AudioOutputStream::AudioOutputStream(const Napi::CallbackInfo& info)
     }
 }
 
-Napi::Promise AudioOutputStream::create(PipeWireSession* session, const Napi::Object& options)
+std::optional<Napi::Error> AudioOutputStream::prepare(PipeWireSession* session, const Napi::Object& options)
 {
+    // JS thread: everything about creation that can fail, so a batch can
+    // reject before any stream reaches PipeWire
     this->session = session;
     auto env = options.Env();
 
-    format = (spa_audio_format)options.Get("format").As<Napi::Number>().Uint32Value();
-    bytesPerSample = options.Get("bytesPerSample").As<Napi::Number>().Uint32Value();
+    inputFormat = (spa_audio_format)options.Get("inputFormat").As<Napi::Number>().Uint32Value();
+    if (!SampleConverter::isInputFormat(inputFormat)) {
+        return Napi::TypeError::New(env, "inputFormat must be Float32 or Float64");
+    }
+    inputBytesPerSample = SampleConverter::sampleSize(inputFormat);
+    dither = options.Get("dither").ToBoolean().Value();
+    auto directionOption = options.Get("direction");
+    if (directionOption.IsString() && directionOption.As<Napi::String>().Utf8Value() == "input") {
+        direction = PW_DIRECTION_INPUT;
+    }
     rate = options.Get("rate").As<Napi::Number>().Uint32Value();
     channels = options.Get("channels").As<Napi::Number>().Uint32Value();
+    if (options.Get("renderRate").IsNumber()) {
+        if (isCapture()) {
+            return Napi::TypeError::New(env, "renderRate is only supported on output streams");
+        }
+        renderRate = options.Get("renderRate").As<Napi::Number>().Uint32Value();
+        if (renderRate < 1 || renderRate > MAX_SAMPLE_RATE) {
+            return Napi::RangeError::New(env, "renderRate must be between 1 and 192000");
+        }
+    }
+    auto qualityOption = options.Get("resampleQuality");
+    if (qualityOption.IsString()) {
+        auto quality = qualityOption.As<Napi::String>().Utf8Value();
+        if (quality == "fast") {
+            resampleQuality = RESAMPLE_FAST;
+        } else if (quality == "best") {
+            resampleQuality = RESAMPLE_BEST;
+        } else if (quality != "balanced") {
+            return Napi::TypeError::New(env, "resampleQuality must be fast, balanced or best");
+        }
+    }
+    if (options.Get("metering").IsObject()) {
+        if (isCapture()) {
+            return Napi::TypeError::New(env, "metering is only supported on output streams");
+        }
+        auto metering = options.Get("metering").As<Napi::Object>();
+        if (!metering.Get("updatesPerSecond").IsNumber()) {
+            return Napi::TypeError::New(env, "metering.updatesPerSecond must be a number");
+        }
+        meterUpdatesPerSecond = metering.Get("updatesPerSecond").As<Napi::Number>().DoubleValue();
+        meterTruePeak = metering.Get("truePeak").ToBoolean().Value();
+        if (!(meterUpdatesPerSecond > 0.0 && meterUpdatesPerSecond <= MAX_METER_UPDATES)) {
+            return Napi::RangeError::New(env, "metering.updatesPerSecond must be above 0 and at most 1000");
+        }
+    }
+
+    if (options.Get("trace").IsObject()) {
+        auto traceOptions = options.Get("trace").As<Napi::Object>();
+        auto capacity = traceOptions.Get("capacity").IsNumber()
+            ? traceOptions.Get("capacity").As<Napi::Number>().DoubleValue()
+            : (double)DEFAULT_TRACE_RECORDS;
+        if (!(capacity >= TRACE_MIN_RECORDS && capacity <= TRACE_MAX_RECORDS)) {
+            return Napi::RangeError::New(env, "trace.capacity must be between 256 and 1048576");
+        }
+        trace.configure((uint32_t)capacity);
+    }
+
+    // Until negotiation completes, assume the graph takes the input as-is
+    format = inputFormat;
+    bytesPerSample = inputBytesPerSample;
+    configureConverter();
+    configureMeter();
+
+    auto sharedRingOption = options.Get("sharedRing");
+    if (sharedRingOption.IsTypedArray() && isCapture()) {
+        return Napi::TypeError::New(env, "sharedRing is only supported on output streams");
+    }
+    if (sharedRingOption.IsTypedArray()) {
+        auto view = sharedRingOption.As<Napi::TypedArray>();
+        auto error = view.TypedArrayType() == napi_uint8_array
+            ? attachSharedRing(sharedRingOption.As<Napi::Uint8Array>())
+            : "sharedRing must be passed as a Uint8Array view";
+        if (error) {
+            return Napi::TypeError::New(env, error);
+        }
+    }
 
-    auto name = options.Get("name").As<Napi::String>().Utf8Value();
-    auto properties = getStreamProps(options);
-    props = Napi::ObjectReference::New(Napi::Object::New(env), 1);
+    if (options.Get("watermarks").IsObject()) {
+        auto watermarks = options.Get("watermarks").As<Napi::Object>();
+        if (watermarks.Get("high").IsNumber()) {
+            highWatermark = watermarks.Get("high").As<Napi::Number>().DoubleValue();
+        }
+        if (!(highWatermark > 0.0 && highWatermark <= 1.0)) {
+            return Napi::RangeError::New(env, "watermarks.high must be above 0 and at most 1");
+        }
+        if (watermarks.Get("low").IsNumber()) {
+            lowWatermark = watermarks.Get("low").As<Napi::Number>().DoubleValue();
+            if (!(lowWatermark >= 0.0 && lowWatermark < highWatermark)) {
+                return Napi::RangeError::New(env, "watermarks.low must be at least 0 and below watermarks.high");
+            }
+        }
+    }
 
     // Extract buffer configuration values for async processing
     if (options.Get("buffering").IsObject()) {
@@ -145,17 +391,41 @@ Napi::Promise AudioOutputStream::create(PipeWireSession* session, const Napi::Ob
                 requestedBufferedQuanta = 1;
         } else if (buffering.Get("requestedMs").IsNumber()) {
             requestedLatencyMs = buffering.Get("requestedMs").As<Napi::Number>().DoubleValue();
+        } else if (buffering.Get("adaptive").IsObject()) {
+            auto adaptive = buffering.Get("adaptive").As<Napi::Object>();
+            if (!adaptive.Get("minMs").IsNumber() || !adaptive.Get("maxMs").IsNumber()) {
+                return Napi::TypeError::New(env, "Adaptive buffering needs minMs and maxMs as numbers");
+            }
+            adaptiveMinLatencyMs = adaptive.Get("minMs").As<Napi::Number>().DoubleValue();
+            adaptiveMaxLatencyMs = adaptive.Get("maxMs").As<Napi::Number>().DoubleValue();
+            if (!(adaptiveMinLatencyMs > 0.0 && adaptiveMinLatencyMs <= adaptiveMaxLatencyMs)) {
+                return Napi::RangeError::New(env, "Adaptive buffering needs 0 < minimum latency <= maximum latency");
+            }
         }
     }
 
+    pendingName = options.Get("name").As<Napi::String>().Utf8Value();
+    pendingProperties = getStreamProps(options);
     initCallbacks(options);
+    loop = session->acquireLoop();
+    return std::nullopt;
+}
+
+Napi::Promise AudioOutputStream::create(PipeWireSession* session, const Napi::Object& options)
+{
+    auto env = options.Env();
+    if (auto error = prepare(session, options)) {
+        return rejected(*error);
+    }
 
     Ref();
     return async(
         env,
-        [this, session, name, properties]() {
-            framesPerQuantum = session->getFramesPerQuantum();
-            initStream(name, properties);
+        [this, session]() {
+            open(session->getFramesPerQuantum());
+            loop->withThreadLock([this]() {
+                initStream();
+            });
         },
         [this]() {
             Unref();
@@ -163,6 +433,18 @@ Napi::Promise AudioOutputStream::create(PipeWireSession* session, const Napi::Ob
         });
 }
 
+SessionLoop* AudioOutputStream::getSessionLoop()
+{
+    return loop;
+}
+
+void AudioOutputStream::open(uint32_t quantum)
+{
+    // Worker thread, before the stream exists
+    framesPerQuantum = quantum;
+    allocateRing();
+}
+
 void AudioOutputStream::initCallbacks(const Napi::Object& options)
 {
     auto env = options.Env();
@@ -172,11 +454,6 @@ void AudioOutputStream::initCallbacks(const Napi::Object& options)
         options.Get("onStateChange").As<Napi::Function>(),
         "PipeWireStream::stateChangedCallback", 0, 1);
 
-    propsCallback = Napi::ThreadSafeFunction::New(
-        env,
-        options.Get("onPropsChange").As<Napi::Function>(),
-        "PipeWireStream::propsCallback", 0, 1);
-
     formatChangeCallback = Napi::ThreadSafeFunction::New(
         env,
         options.Get("onFormatChange").As<Napi::Function>(),
@@ -191,32 +468,261 @@ void AudioOutputStream::initCallbacks(const Napi::Object& options)
         env,
         options.Get("onUnknownParamChange").As<Napi::Function>(),
         "PipeWireStream::paramChangedCallback", 0, 1);
+
+    wakeups.open(env, "PipeWireStream::wakeups", [this](Napi::Env env, uint32_t events) {
+        onWakeup(env, events);
+    });
+
+    if (adaptiveMaxLatencyMs > 0.0 && options.Get("onBufferAdjusted").IsFunction()) {
+        bufferAdjustedCallback = Napi::Persistent(options.Get("onBufferAdjusted").As<Napi::Function>());
+        wakeups.subscribe(WAKE_BUFFER_ADJUSTED);
+    }
+
+    if (options.Get("onQuantumChange").IsFunction()) {
+        quantumChangeCallback = Napi::Persistent(options.Get("onQuantumChange").As<Napi::Function>());
+        wakeups.subscribe(WAKE_QUANTUM_CHANGED);
+    }
+
+    if (options.Get("onPropsChange").IsFunction()) {
+        propsChangeCallback = Napi::Persistent(options.Get("onPropsChange").As<Napi::Function>());
+        wakeups.subscribe(WAKE_PROPS);
+    }
+
+    if (meterUpdatesPerSecond > 0.0 && options.Get("onLevels").IsFunction()) {
+        levelsCallback = Napi::Persistent(options.Get("onLevels").As<Napi::Function>());
+        wakeups.subscribe(WAKE_LEVELS);
+    }
+
+    // Subscribed even without a callback: ended voices hand their sample
+    // references back to this thread, so an unloaded sample is freed
+    if (options.Get("onInputEnded").IsFunction()) {
+        inputEndedCallback = Napi::Persistent(options.Get("onInputEnded").As<Napi::Function>());
+    }
+    wakeups.subscribe(WAKE_INPUT_ENDED);
 }
 
-void AudioOutputStream::initStream(std::string name, pw_properties* properties)
+void AudioOutputStream::onWakeup(Napi::Env env, uint32_t events)
 {
-    session->withThreadLock([this, name, properties]() {
-        stream = pw_stream_new_simple(
-            session->getLoop(),
-            name.c_str(),
-            properties,
-            &stream_events,
-            this);
-    });
+    // JS thread: every event raised since the last wakeup arrives at once.
+    // A wait whose condition no longer holds stays armed for the next one.
+    if (events & WAKE_BUFFER) {
+        auto availableFrames = getAvailableFrames();
+        if (!bufferWaiters.empty() && availableFrames >= getWakeFrames()) {
+            auto signalledAt = readySignalledAt.exchange(0, std::memory_order_relaxed);
+            if (signalledAt) {
+                auto latencyNs = steadyNanos() - signalledAt;
+                stats.recordWakeup(latencyNs);
+                trace.record({
+                    .startNs = signalledAt,
+                    .durationNs = (uint64_t)latencyNs,
+                    .kind = TRACE_WAKEUP,
+                    .delivered = availableFrames,
+                    .queued = getQueuedFrames(),
+                });
+            }
+        }
+
+        // Only the callers whose own minFrames is met; the rest keep waiting
+        std::vector<BufferWaiter> ready;
+        for (size_t i = 0; i < bufferWaiters.size();) {
+            if (availableFrames >= getWakeFrames(bufferWaiters[i].minFrames)) {
+                ready.push_back(std::move(bufferWaiters[i]));
+                bufferWaiters.erase(bufferWaiters.begin() + i);
+            } else {
+                i++;
+            }
+        }
+        publishWakeFrames();
+        if (bufferWaiters.empty()) {
+            wakeups.disarm(env, WAKE_BUFFER);
+        }
+        for (auto& waiter : ready) {
+            waiter.deferral.Resolve(Napi::Number::New(env, availableFrames));
+        }
+    }
+
+    if (events & WAKE_DATA) {
+        auto readableFrames = getQueuedFrames();
+        if (readableFrames >= wantedFrames.load(std::memory_order_relaxed)) {
+            wakeups.disarm(env, WAKE_DATA);
+            settle(dataDeferral, Napi::Number::New(env, readableFrames));
+        }
+    }
+
+    if (events & WAKE_MIXER) {
+        wakeups.disarm(env, WAKE_MIXER);
+        settle(mixerDeferral, env.Undefined());
+    }
+
+    if (events & WAKE_FINISHED) {
+        wakeups.disarm(env, WAKE_FINISHED);
+        settle(finishedDeferral, env.Undefined());
+    }
+
+    if (events & WAKE_DISCONNECTED) {
+        wakeups.disarm(env, WAKE_DISCONNECTED);
+        settle(disconnectDeferral, env.Undefined());
+    }
+
+    if (events & WAKE_BUFFER_ADJUSTED) {
+        auto fromFrames = adjustedFromFrames.exchange(0, std::memory_order_acq_rel);
+        if (fromFrames && !bufferAdjustedCallback.IsEmpty()) {
+            auto adjustment = Napi::Object::New(env);
+            adjustment.Set("oldSize", (double)fromFrames * getBytesPerFrame());
+            adjustment.Set("newSize", (double)frameBufferSize * getBytesPerFrame());
+            adjustment.Set("reason", adjustReason.load(std::memory_order_relaxed) == ADAPT_GROWN ? "underrun" : "stable");
+            bufferAdjustedCallback.Call({ adjustment });
+        }
+    }
+
+    if ((events & WAKE_QUANTUM_CHANGED) && !quantumChangeCallback.IsEmpty()) {
+        auto quantum = Napi::Object::New(env);
+        quantum.Set("framesPerQuantum", (double)framesPerQuantum.load(std::memory_order_relaxed));
+        quantum.Set("rate", (double)graphRate.load(std::memory_order_relaxed));
+        quantumChangeCallback.Call({ quantum });
+    }
+
+    if ((events & WAKE_PROPS) && !propsChangeCallback.IsEmpty()) {
+        // Only a notification: JS reads the props, merged natively, when it
+        // actually delivers them
+        propsChangeCallback.Call({});
+    }
+
+    if ((events & WAKE_LEVELS) && !levelsCallback.IsEmpty()) {
+        // However many windows finished since the last wakeup, only the
+        // latest is delivered
+        levelsCallback.Call({ toLevels(env) });
+    }
+
+    if (events & WAKE_INPUT_ENDED) {
+        mixer.releaseEndedVoices();
+    }
+    if ((events & WAKE_INPUT_ENDED) && !inputEndedCallback.IsEmpty()) {
+        // JS asks each of its files whether it was one that ended
+        inputEndedCallback.Call({});
+    }
+}
+
+void AudioOutputStream::settle(std::optional<Napi::Promise::Deferred>& deferral, Napi::Value value)
+{
+    if (deferral) {
+        auto settled = std::move(*deferral);
+        deferral.reset();
+        settled.Resolve(value);
+    }
+}
+
+void AudioOutputStream::initStream()
+{
+    // Loop lock held; the stream takes ownership of the properties
+    stream = pw_stream_new_simple(
+        loop->getLoop(),
+        pendingName.c_str(),
+        pendingProperties,
+        &stream_events,
+        this);
+    pendingProperties = NULL;
+}
+
+void AudioOutputStream::configureConverter()
+{
+    if (isCapture()) {
+        converter.configure(format, inputFormat, false);
+    } else {
+        converter.configure(inputFormat, format, dither);
+        busInput.configure(inputFormat, SPA_AUDIO_FORMAT_F32, false);
+        busOutput.configure(SPA_AUDIO_FORMAT_F32, format, dither);
+        mixer.setRate(getSourceRate());
+        if (renderRate && renderRate != rate) {
+            resampler.configure(renderRate, rate, channels, resampleQuality, MIX_CHUNK_FRAMES);
+        } else {
+            resampler.disable();
+        }
+    }
+}
+
+void AudioOutputStream::configureMeter()
+{
+    if (!isCapture() && meterUpdatesPerSecond > 0.0) {
+        meter.configure(channels, rate, meterUpdatesPerSecond, meterTruePeak);
+    }
+}
+
+void AudioOutputStream::allocateRing()
+{
+    if (!isCapture()) {
+        bus.assign((size_t)MIX_CHUNK_FRAMES * channels, 0.0f);
+        planarScratch.assign((size_t)MIX_CHUNK_FRAMES * channels * sizeof(double), 0);
+    }
+
+    if (sharedRing.isAttached()) {
+        return; // The worker-owned ring replaces the internal one
+    }
+
+    // Format negotiation happens after this point, so reserve frames for the
+    // narrowest sample format and the highest rate we offer by default;
+    // setBufferSize() clamps the negotiated size to what was reserved.
+    size_t maxFrames;
+    if (requestedBufferSizeBytes > 0) {
+        maxFrames = requestedBufferSizeBytes / channels;
+    } else if (requestedLatencyMs > 0.0) {
+        maxFrames = static_cast<size_t>(requestedLatencyMs * MAX_SAMPLE_RATE / 1000.0);
+    } else if (adaptiveMaxLatencyMs > 0.0) {
+        maxFrames = static_cast<size_t>(adaptiveMaxLatencyMs * MAX_SAMPLE_RATE / 1000.0);
+    } else {
+        maxFrames = (size_t)requestedBufferedQuanta * framesPerQuantum;
+    }
+
+    maxFrames = std::max(maxFrames, (size_t)framesPerQuantum);
+    ring.allocate(maxFrames * getInputBytesPerFrame());
+}
+
+const char* AudioOutputStream::attachSharedRing(Napi::Uint8Array view)
+{
+    auto error = sharedRing.attach(view.Data(), view.ByteLength(), channels, inputBytesPerSample);
+    if (!error) {
+        // Keep the SharedArrayBuffer alive for as long as the RT thread may read it
+        sharedRingRef = Napi::Persistent(view);
+        frameBufferSize = sharedRing.capacity();
+    }
+    return error;
 }
 
 void AudioOutputStream::setBufferSize()
 {
+    if (sharedRing.isAttached()) {
+        frameBufferSize = sharedRing.capacity();
+        return;
+    }
+
+    // Sizes are in ring frames, which are at the render rate when resampling
+    auto sourceRate = getSourceRate();
+    uint32_t cycleFrames = framesPerQuantum; // The RT thread may update it meanwhile
+    if (sourceRate != rate && rate) {
+        cycleFrames = std::max(1u, (uint32_t)((uint64_t)cycleFrames * sourceRate / rate));
+    }
+    auto maxFrames = static_cast<uint32_t>(ring.capacity() / getInputBytesPerFrame());
+    if (adaptiveMaxLatencyMs > 0.0) {
+        // Start at the minimum latency; a renegotiation keeps what was learned
+        auto wasEnabled = adaptiveBuffer.isEnabled();
+        auto minFrames = static_cast<uint32_t>(adaptiveMinLatencyMs * sourceRate / 1000.0);
+        minFrames = (minFrames + cycleFrames - 1) / cycleFrames * cycleFrames;
+        auto adaptiveMaxFrames = std::min(static_cast<uint32_t>(adaptiveMaxLatencyMs * sourceRate / 1000.0), maxFrames);
+        adaptiveBuffer.configure(minFrames, adaptiveMaxFrames, cycleFrames, sourceRate * ADAPT_STABLE_SECONDS);
+        frameBufferSize = adaptiveBuffer.clamp(wasEnabled ? frameBufferSize.load() : 0);
+        return;
+    }
+
     uint32_t quanta;
     if (requestedBufferSizeBytes > 0) {
         // Convert bytes to quanta
         uint32_t bytesPerFrame = bytesPerSample * channels;
         uint32_t requestedFrames = requestedBufferSizeBytes / bytesPerFrame;
-        quanta = requestedFrames / framesPerQuantum;
+        quanta = requestedFrames / cycleFrames;
     } else if (requestedLatencyMs > 0.0) {
         // Convert milliseconds to quanta
-        uint32_t requestedFrames = static_cast<uint32_t>(requestedLatencyMs * rate / 1000.0);
-        quanta = requestedFrames / framesPerQuantum;
+        uint32_t requestedFrames = static_cast<uint32_t>(requestedLatencyMs * sourceRate / 1000.0);
+        quanta = requestedFrames / cycleFrames;
     } else {
         // Use quantum-based sizing directly
         quanta = requestedBufferedQuanta;
@@ -225,7 +731,67 @@ void AudioOutputStream::setBufferSize()
     if (quanta < 1) {
         quanta = 1; // Ensure at least one quantum
     }
-    frameBufferSize = quanta * framesPerQuantum;
+
+    frameBufferSize = std::min(quanta * cycleFrames, maxFrames);
+}
+
+uint32_t AudioOutputStream::getQueuedFrames()
+{
+    if (sharedRing.isAttached()) {
+        return sharedRing.readableFrames();
+    }
+    return ring.readable() / getInputBytesPerFrame();
+}
+
+uint32_t AudioOutputStream::getAvailableFrames()
+{
+    auto limit = getHighWatermarkFrames();
+    auto queued = getQueuedFrames();
+    return limit > queued ? limit - queued : 0;
+}
+
+uint32_t AudioOutputStream::getHighWatermarkFrames()
+{
+    return std::max(1u, (uint32_t)(frameBufferSize * highWatermark));
+}
+
+uint32_t AudioOutputStream::getWakeFrames()
+{
+    // The RT thread wakes JS as soon as any pending caller can resolve
+    auto wanted = wantedSpace.load(std::memory_order_relaxed);
+    auto frames = wanted ? getWakeFrames(wanted) : UINT32_MAX;
+    if (!wanted || defaultSpaceWanted.load(std::memory_order_relaxed)) {
+        frames = std::min(frames, getWakeFrames(0));
+    }
+    return frames;
+}
+
+uint32_t AudioOutputStream::getWakeFrames(uint32_t wanted)
+{
+    // Space a caller wants before waitForBuffer() resolves: its minFrames,
+    // else the gap between the watermarks, else one quantum
+    auto limit = getHighWatermarkFrames();
+    if (!wanted) {
+        wanted = lowWatermark >= 0.0
+            ? limit - std::min(limit, (uint32_t)(frameBufferSize * lowWatermark))
+            : framesPerQuantum.load(std::memory_order_relaxed);
+    }
+    return std::clamp(wanted, 1u, limit);
+}
+
+void AudioOutputStream::publishWakeFrames()
+{
+    uint32_t smallest = 0;
+    auto defaultWanted = false;
+    for (auto& waiter : bufferWaiters) {
+        if (!waiter.minFrames) {
+            defaultWanted = true;
+        } else if (!smallest || waiter.minFrames < smallest) {
+            smallest = waiter.minFrames;
+        }
+    }
+    defaultSpaceWanted.store(defaultWanted, std::memory_order_relaxed);
+    wantedSpace.store(smallest, std::memory_order_relaxed);
 }
 
 std::vector<spa_audio_format> AudioOutputStream::parsePreferredFormats(const Napi::Object& options)
@@ -284,27 +850,67 @@ void AudioOutputStream::buildFormatParams(struct spa_pod_builder& podBuilder,
     spa_pod_builder_pop(&podBuilder, &formatFrame);
 }
 
-void AudioOutputStream::connectStream(const std::vector<spa_audio_format>& preferredFormats,
+bool AudioOutputStream::buildCachedFormatParam(struct spa_pod_builder& podBuilder,
+    const std::vector<spa_audio_format>& preferredFormats,
     const std::vector<uint32_t>& preferredRates)
 {
-    session->withThreadLock([this, preferredFormats, preferredRates]() {
+    // Only while the cached format still satisfies this connect's preferences
+    if (!cachedFormat || cachedFormat->channels != channels
+        || std::find(preferredFormats.begin(), preferredFormats.end(), cachedFormat->format) == preferredFormats.end()
+        || std::find(preferredRates.begin(), preferredRates.end(), cachedFormat->rate) == preferredRates.end()) {
+        return false;
+    }
+
+    auto info = *cachedFormat;
+    spa_format_audio_raw_build(&podBuilder, SPA_PARAM_EnumFormat, &info);
+    return true;
+}
+
+void AudioOutputStream::connectLocked(const ConnectRequest& request)
+{
+    // Loop lock held
+    auto& preferredFormats = request.preferredFormats;
+    auto& preferredRates = request.preferredRates;
+    {
         uint8_t buffer[4096]; // Larger buffer for multiple formats
         struct spa_pod_builder podBuilder = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
 
+        // The cached format goes first; the full list stays as the fallback
+        // for a graph that changed since
+        const struct spa_pod* connectParams[2];
+        uint32_t paramCount = 0;
+        auto offset = podBuilder.state.offset;
+        if (buildCachedFormatParam(podBuilder, preferredFormats, preferredRates)) {
+            connectParams[paramCount++] = (spa_pod*)SPA_PTROFF(buffer, offset, void);
+        }
+        offset = podBuilder.state.offset;
         buildFormatParams(podBuilder, preferredFormats, preferredRates);
-
-        const struct spa_pod* connectParams[1] = {
-            (struct spa_pod*)buffer
-        };
+        connectParams[paramCount++] = (spa_pod*)SPA_PTROFF(buffer, offset, void);
 
         pw_stream_connect(
             stream,
-            PW_DIRECTION_OUTPUT,
+            direction,
             PW_ID_ANY,
             (pw_stream_flags)(PW_STREAM_FLAG_AUTOCONNECT | PW_STREAM_FLAG_MAP_BUFFERS | PW_STREAM_FLAG_RT_PROCESS),
             connectParams,
-            1);
-    });
+            paramCount);
+    }
+}
+
+std::optional<Napi::Error> AudioOutputStream::prepareConnect(const Napi::Object& options, ConnectRequest& request)
+{
+    auto env = options.Env();
+    if (renderingOffline.load(std::memory_order_acquire)) {
+        return Napi::Error::New(env, "Cannot connect during an offline render");
+    }
+
+    try {
+        request.preferredFormats = parsePreferredFormats(options);
+        request.preferredRates = parsePreferredRates(options);
+    } catch (const std::exception& e) {
+        return Napi::TypeError::New(env, e.what());
+    }
+    return std::nullopt;
 }
 
 Napi::Value AudioOutputStream::connect(const Napi::CallbackInfo& info)
@@ -313,26 +919,24 @@ Napi::Value AudioOutputStream::connect(const Napi::CallbackInfo& info)
 
     if (info.Length() == 0 || !info[0].IsObject()) {
         Napi::TypeError::New(env, "connect() requires options object with preferredFormats").ThrowAsJavaScriptException();
+        return env.Undefined();
     }
 
-    auto options = info[0].As<Napi::Object>();
-
-    try {
-        auto preferredFormats = parsePreferredFormats(options);
-        auto preferredRates = parsePreferredRates(options);
+    ConnectRequest request;
+    if (auto error = prepareConnect(info[0].As<Napi::Object>(), request)) {
+        return rejected(*error);
+    }
 
-        return async(
-            env,
-            [this, preferredFormats, preferredRates]() {
-                connectStream(preferredFormats, preferredRates);
-            },
-            [env]() {
-                return env.Undefined();
+    return async(
+        env,
+        [this, request]() {
+            loop->withThreadLock([this, &request]() {
+                connectLocked(request);
             });
-    } catch (const std::exception& e) {
-        Napi::TypeError::New(env, e.what()).ThrowAsJavaScriptException();
-        return env.Undefined();
-    }
+        },
+        [env]() {
+            return env.Undefined();
+        });
 }
 
 Napi::Value AudioOutputStream::disconnect(const Napi::CallbackInfo& info)
@@ -347,24 +951,14 @@ Napi::Value AudioOutputStream::disconnect(const Napi::CallbackInfo& info)
 
     // Create the disconnect promise on the main thread
     if (!disconnectDeferral) {
-        disconnectDeferral = new Napi::Promise::Deferred(env);
-        disconnectSignal = Napi::ThreadSafeFunction::New(
-            env,
-            Napi::Function::New(env, [this](const Napi::CallbackInfo& info) {
-                auto env = info.Env();
-                if (disconnectDeferral) {
-                    disconnectDeferral->Resolve(env.Undefined());
-                    delete disconnectDeferral;
-                    disconnectDeferral = NULL;
-                }
-            }),
-            "PipeWireStream::disconnectSignal", 0, 1, disconnectDeferral);
+        disconnectDeferral.emplace(env);
+        wakeups.arm(env, WAKE_DISCONNECTED);
     }
 
     return async(
         env,
         [this]() {
-            session->withThreadLock([this]() {
+            loop->withThreadLock([this]() {
                 if (stream) {
                     auto state = pw_stream_get_state(stream, nullptr);
                     if (state == PW_STREAM_STATE_STREAMING || state == PW_STREAM_STATE_PAUSED || state == PW_STREAM_STATE_CONNECTING) {
@@ -390,6 +984,11 @@ uint32_t AudioOutputStream::getRate()
     return rate;
 }
 
+uint32_t AudioOutputStream::getSourceRate()
+{
+    return renderRate ? renderRate : rate;
+}
+
 uint32_t AudioOutputStream::getChannels()
 {
     return channels;
@@ -400,434 +999,2028 @@ uint32_t AudioOutputStream::getBytesPerFrame()
     return bytesPerSample * channels;
 }
 
-Napi::Value AudioOutputStream::getWritableFrames(const Napi::CallbackInfo& info)
+uint32_t AudioOutputStream::getInputBytesPerFrame()
 {
-    auto availableFrames = (long)frameBufferSize - queuedFrameCount;
-    return Napi::Number::New(info.Env(), std::max((long)0, availableFrames));
+    return inputBytesPerSample * channels;
 }
 
-Napi::Value AudioOutputStream::getFramesPerQuantum(const Napi::CallbackInfo& info)
+bool AudioOutputStream::isCapture()
 {
-    return Napi::Number::New(info.Env(), framesPerQuantum);
+    return direction == PW_DIRECTION_INPUT;
 }
 
-Napi::Value AudioOutputStream::getBufferSize(const Napi::CallbackInfo& info)
+bool AudioOutputStream::isPlanar()
 {
-    uint32_t bufferSizeBytes = this->frameBufferSize * this->getBytesPerFrame();
-    return Napi::Number::New(info.Env(), bufferSizeBytes);
+    return SampleConverter::isPlanar(format);
 }
 
-void AudioOutputStream::onStateChange(pw_stream_state state, const char* error)
+StreamStats& AudioOutputStream::getStreamStats()
 {
-    std::string errorMessage = error ? error : "";
+    return stats;
+}
 
-    // Check if we're waiting for a disconnect and the stream is now unconnected
-    if (state == PW_STREAM_STATE_UNCONNECTED && disconnectDeferral) {
-        disconnectSignal.NonBlockingCall();
-        disconnectSignal.Release();
-        disconnectSignal = nullptr;
-    }
+Napi::Value AudioOutputStream::getWritableFrames(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), getAvailableFrames());
+}
 
-    stateChangedCallback.NonBlockingCall(
-        [state, errorMessage](const Napi::Env env, Napi::Function jsCallback) {
+Napi::Value AudioOutputStream::getReadableFrames(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), isCapture() ? getQueuedFrames() : 0);
+}
+
+Napi::Value AudioOutputStream::getDroppedFrames(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), (double)droppedFrames.load(std::memory_order_relaxed));
+}
+
+Napi::Value AudioOutputStream::getStats(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    auto snapshot = stats.snapshot();
+
+    auto histogram = Napi::Array::New(env, STATS_DURATION_BUCKETS);
+    for (uint32_t i = 0; i < STATS_DURATION_BUCKETS; i++) {
+        histogram.Set(i, (double)snapshot.durationHistogram[i]);
+    }
+
+    auto result = Napi::Object::New(env);
+    result.Set("cycles", (double)snapshot.cycles);
+    result.Set("requestedFrames", (double)snapshot.requestedFrames);
+    result.Set("deliveredFrames", (double)snapshot.deliveredFrames);
+    result.Set("producedFrames", (double)snapshot.producedFrames);
+    result.Set("zeroFilledFrames", (double)snapshot.zeroFilledFrames);
+    result.Set("underruns", (double)snapshot.underruns);
+    result.Set("dequeueFailures", (double)snapshot.dequeueFailures);
+    result.Set("slowCycles", (double)snapshot.slowCycles);
+    result.Set("maxDurationNs", (double)snapshot.maxDurationNs);
+    result.Set("totalDurationNs", (double)snapshot.totalDurationNs);
+    result.Set("durationHistogram", histogram);
+    result.Set("wakeups", (double)snapshot.wakeups);
+    result.Set("maxWakeupNs", (double)snapshot.maxWakeupNs);
+    result.Set("totalWakeupNs", (double)snapshot.totalWakeupNs);
+    result.Set("queuedFrames", (double)getQueuedFrames());
+    result.Set("bufferSize", (double)frameBufferSize.load(std::memory_order_relaxed));
+    result.Set("realtime", realtime.load(std::memory_order_relaxed));
+    return result;
+}
+
+Napi::Value AudioOutputStream::readTrace(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    if (!trace.isEnabled()) {
+        return env.Undefined();
+    }
+
+    // Flattened into one Float64Array: a trace can hold a million records,
+    // far too many to hand over as objects
+    std::vector<TraceRecord> records;
+    auto lost = trace.read(records);
+    auto fields = Napi::Float64Array::New(env, records.size() * TRACE_RECORD_FIELDS);
+    auto out = fields.Data();
+    for (auto& record : records) {
+        *out++ = (double)record.startNs;
+        *out++ = (double)record.durationNs;
+        *out++ = record.kind;
+        *out++ = record.requested;
+        *out++ = record.delivered;
+        *out++ = record.produced;
+        *out++ = record.queued;
+        *out++ = record.detail;
+        *out++ = record.flags;
+    }
+
+    auto result = Napi::Object::New(env);
+    result.Set("records", fields);
+    result.Set("lost", (double)lost);
+    return result;
+}
+
+Napi::Value AudioOutputStream::traceGc(const Napi::CallbackInfo& info)
+{
+    // JS observes GC through perf_hooks and converts the times to steady_clock
+    auto env = info.Env();
+    if (!info[0].IsNumber() || !info[1].IsNumber()) {
+        Napi::TypeError::New(env, "traceGc() needs a start time and a duration in nanoseconds")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    trace.record({
+        .startNs = info[0].As<Napi::Number>().Int64Value(),
+        .durationNs = (uint64_t)std::max<int64_t>(0, info[1].As<Napi::Number>().Int64Value()),
+        .kind = TRACE_GC,
+        .queued = getQueuedFrames(),
+        .detail = info[2].IsNumber() ? info[2].As<Napi::Number>().Uint32Value() : 0,
+    });
+    return env.Undefined();
+}
+
+void AudioOutputStream::traceWrite(int64_t startedNs, uint32_t offered, uint32_t accepted)
+{
+    trace.record({
+        .startNs = startedNs,
+        .durationNs = (uint64_t)(steadyNanos() - startedNs),
+        .kind = TRACE_WRITE,
+        .requested = offered,
+        .delivered = accepted,
+        .queued = getQueuedFrames(),
+    });
+}
+
+void AudioOutputStream::traceCycle(
+    int64_t startedNs,
+    uint64_t durationNs,
+    uint32_t requested,
+    uint32_t delivered,
+    uint32_t produced,
+    uint32_t flags)
+{
+    // RT thread, after the buffer went back to PipeWire
+    if (!trace.isEnabled()) {
+        return;
+    }
+    trace.record({
+        .startNs = startedNs,
+        .durationNs = durationNs,
+        .kind = TRACE_CYCLE,
+        .requested = requested,
+        .delivered = delivered,
+        .produced = produced,
+        .queued = getQueuedFrames(),
+        .detail = raisedEvents,
+        .flags = flags,
+    });
+    raisedEvents = 0;
+}
+
+pw_loop* AudioOutputStream::getDataLoop()
+{
+    // PW_STREAM_FLAG_RT_PROCESS runs process on the data loop of the
+    // stream's own context, a thread the session never gets to see
+    auto core = pw_stream_get_core(stream);
+    return core ? pw_data_loop_get_loop(pw_context_get_data_loop(pw_core_get_context(core))) : NULL;
+}
+
+// Runs on the data thread, which has no other way to name itself
+static int getDataThread(spa_loop*, bool, uint32_t, const void*, size_t, void* data)
+{
+    *(pthread_t*)data = pthread_self();
+    return 0;
+}
+
+void AudioOutputStream::configureDataThread()
+{
+    // Only the thread's handle is fetched on the data loop; pinning and the
+    // RTKit round trip then run here, so no process cycle ever waits on them
+    auto dataLoop = getDataLoop();
+    if (dataThreadConfigured || !dataLoop || (loop->cpu < 0 && loop->rtPriority <= 0)) {
+        return;
+    }
+    dataThreadConfigured = true;
+    pthread_t thread;
+    if (pw_loop_invoke(dataLoop, getDataThread, 0, NULL, 0, true, &thread) >= 0) {
+        realtime.store(loop->configureDataThread(thread), std::memory_order_relaxed);
+    }
+}
+
+Napi::Value AudioOutputStream::getLevels(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    return meter.isEnabled() ? toLevels(env) : env.Undefined();
+}
+
+Napi::Value AudioOutputStream::toLevels(Napi::Env env)
+{
+    LevelReading reading;
+    meter.read(reading);
+
+    auto peak = Napi::Array::New(env, reading.channels);
+    auto rms = Napi::Array::New(env, reading.channels);
+    for (uint32_t ch = 0; ch < reading.channels; ch++) {
+        peak.Set(ch, (double)reading.peak[ch]);
+        rms.Set(ch, (double)reading.rms[ch]);
+    }
+
+    auto result = Napi::Object::New(env);
+    result.Set("peak", peak);
+    result.Set("rms", rms);
+    if (meter.hasTruePeak()) {
+        auto truePeak = Napi::Array::New(env, reading.channels);
+        for (uint32_t ch = 0; ch < reading.channels; ch++) {
+            truePeak.Set(ch, (double)reading.truePeak[ch]);
+        }
+        result.Set("truePeak", truePeak);
+    }
+    result.Set("windows", (double)reading.windows);
+    return result;
+}
+
+Napi::Value AudioOutputStream::getFramesPerQuantum(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), framesPerQuantum.load(std::memory_order_relaxed));
+}
+
+Napi::Value AudioOutputStream::getRenderPosition(const Napi::CallbackInfo& info)
+{
+    return Napi::Number::New(info.Env(), (double)renderPosition.load(std::memory_order_relaxed));
+}
+
+bool AudioOutputStream::readTiming(PlaybackTiming& timing)
+{
+    // The ring and render position must belong to the sampled cycle; if a
+    // cycle ran while they were read, read all three again
+    auto& sample = timing.sample;
+    for (;;) {
+        if (isCapture() || !clock.read(sample)) {
+            return false;
+        }
+        timing.ringFrames = getQueuedFrames();
+        timing.rendered = renderPosition.load(std::memory_order_relaxed);
+        ClockSample check;
+        if (clock.read(check) && check.cycle == sample.cycle) {
+            break;
+        }
+    }
+
+    auto outputRate = getRate();
+    timing.sourceRate = getSourceRate();
+    if (!sample.rateDenom || !outputRate || !timing.sourceRate) {
+        return false;
+    }
+
+    // The device is reached after PipeWire's own delay, then whatever sits in
+    // its converter and in buffers we queued but it has not consumed yet
+    auto delayNs = (double)sample.delay * 1e9 * sample.rateNum / sample.rateDenom;
+    timing.latencyNs = delayNs + ((double)sample.buffered + (double)sample.queued) * 1e9 / outputRate;
+    timing.startNs = (double)sample.nowNs + timing.latencyNs;
+    return true;
+}
+
+Napi::Value AudioOutputStream::getTiming(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    PlaybackTiming timing;
+    if (!readTiming(timing)) {
+        return env.Undefined();
+    }
+
+    // Extrapolated from the cycle sample
+    auto& sample = timing.sample;
+    auto nowNs = (double)steadyNanos();
+    auto played = std::clamp(timing.frameAt(nowNs), 0.0, (double)timing.rendered);
+    auto nextFrameNs = timing.timeOf((double)timing.rendered + timing.ringFrames);
+
+    auto rate = Napi::Object::New(env);
+    rate.Set("num", sample.rateNum);
+    rate.Set("denom", sample.rateDenom);
+
+    auto result = Napi::Object::New(env);
+    result.Set("now", (double)sample.nowNs);
+    result.Set("rate", rate);
+    result.Set("ticks", (double)sample.ticks);
+    result.Set("delay", (double)sample.delay);
+    result.Set("buffered", (double)sample.buffered);
+    result.Set("queued", (double)sample.queued);
+    result.Set("sampledAt", nowNs);
+    result.Set("playedFrames", std::floor(played));
+    result.Set("latencyNs", timing.latencyNs);
+    result.Set("queuedFrames", timing.ringFrames);
+    result.Set("nextFramePresentationNs", nextFrameNs);
+    return result;
+}
+
+Napi::Value AudioOutputStream::getBufferSize(const Napi::CallbackInfo& info)
+{
+    uint32_t bufferSizeBytes = this->frameBufferSize * this->getBytesPerFrame();
+    return Napi::Number::New(info.Env(), bufferSizeBytes);
+}
+
+void AudioOutputStream::onStateChange(pw_stream_state state, const char* error)
+{
+    std::string errorMessage = error ? error : "";
+
+    // Wakes a pending disconnect(), if any
+    if (state == PW_STREAM_STATE_UNCONNECTED) {
+        wakeups.notify(WAKE_DISCONNECTED);
+    }
+    // By PAUSED the node exists and its data loop is running, but no cycle
+    // has been processed yet
+    if (state == PW_STREAM_STATE_PAUSED || state == PW_STREAM_STATE_STREAMING) {
+        configureDataThread();
+    }
+
+    stateChangedCallback.NonBlockingCall(
+        [state, errorMessage](const Napi::Env env, Napi::Function jsCallback) {
             auto jsState = Napi::Number::New(env, (int)state);
             auto jsError = Napi::String::New(env, errorMessage);
             jsCallback.Call({ jsState, jsError });
         });
 }
 
-void AudioOutputStream::onPropsChange(const spa_pod* param)
+void AudioOutputStream::onPropsChange(const spa_pod* param)
+{
+    // Runs on the loop thread. Changes merge into one snapshot and raise a
+    // single coalescing wakeup however many arrive before JS runs
+    streamProps.update(param);
+    wakeups.notify(WAKE_PROPS);
+}
+
+Napi::Value AudioOutputStream::getProps(const Napi::CallbackInfo& info)
+{
+    return streamProps.toObject(info.Env());
+}
+
+Napi::Value AudioOutputStream::setControls(const Napi::CallbackInfo& info)
+{
+    // setControls({ volume?, mute?, channelVolumes? }): everything in one
+    // pw_stream_set_control() call, so one Props update reaches the graph
+    auto env = info.Env();
+    if (!info[0].IsObject()) {
+        Napi::TypeError::New(env, "setControls needs an object").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    auto controls = info[0].As<Napi::Object>();
+
+    float volume = 0.0f;
+    float mute = 0.0f;
+    float channelVolumes[SPA_AUDIO_MAX_CHANNELS];
+    uint32_t numVolumes = 0;
+    if (controls.Get("channelVolumes").IsTypedArray()) {
+        auto volumes = controls.Get("channelVolumes").As<Napi::Float32Array>();
+        if (volumes.TypedArrayType() != napi_float32_array || volumes.ElementLength() != channels
+            || channels > SPA_AUDIO_MAX_CHANNELS) {
+            Napi::RangeError::New(env, std::format("channelVolumes must be a Float32Array of {} volumes", channels))
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        numVolumes = channels;
+        std::copy(volumes.Data(), volumes.Data() + numVolumes, channelVolumes);
+    }
+
+    // Up to three (id, count, values) triples; a zero id ends the list early
+    uint32_t ids[3] = {};
+    uint32_t counts[3] = {};
+    float* values[3] = {};
+    uint32_t used = 0;
+    if (controls.Get("volume").IsNumber()) {
+        volume = controls.Get("volume").As<Napi::Number>().FloatValue();
+        ids[used] = SPA_PROP_volume;
+        counts[used] = 1;
+        values[used++] = &volume;
+    }
+    if (controls.Get("mute").IsBoolean()) {
+        mute = controls.Get("mute").As<Napi::Boolean>().Value() ? 1.0f : 0.0f;
+        ids[used] = SPA_PROP_mute;
+        counts[used] = 1;
+        values[used++] = &mute;
+    }
+    if (numVolumes) {
+        ids[used] = SPA_PROP_channelVolumes;
+        counts[used] = numVolumes;
+        values[used++] = channelVolumes;
+    }
+    if (!used || !stream) {
+        return env.Undefined();
+    }
+
+    int result;
+    loop->withThreadLock([&]() {
+        result = pw_stream_set_control(stream,
+            ids[0], counts[0], values[0],
+            ids[1], counts[1], values[1],
+            ids[2], counts[2], values[2],
+            0);
+    });
+    if (result < 0) {
+        Napi::Error::New(env, std::format("Failed to set stream controls: {}", spa_strerror(result)))
+            .ThrowAsJavaScriptException();
+    }
+    return env.Undefined();
+}
+
+Napi::Value AudioOutputStream::setActive(const Napi::CallbackInfo& info)
+{
+    // setActive(active): pause or resume a connected stream, keeping its
+    // negotiated format and buffers
+    auto env = info.Env();
+    auto active = info[0].ToBoolean().Value();
+    if (!stream) {
+        return env.Undefined();
+    }
+
+    int result;
+    loop->withThreadLock([&]() {
+        result = pw_stream_set_active(stream, active);
+    });
+    if (result < 0) {
+        Napi::Error::New(env, std::format("Failed to {} stream: {}", active ? "resume" : "pause", spa_strerror(result)))
+            .ThrowAsJavaScriptException();
+    }
+    return env.Undefined();
+}
+
+// Runs on the data loop, which onFormatChange() blocks on meanwhile
+static int applyNegotiatedFormat(spa_loop*, bool, uint32_t, const void* data, size_t, void* userData)
+{
+    ((AudioOutputStream*)userData)->applyFormat(*(const NegotiatedFormat*)data);
+    return 0;
+}
+
+void AudioOutputStream::onFormatChange(const spa_pod* param)
+{
+    spa_audio_info_raw audioInfo;
+    spa_format_audio_raw_parse(param, &audioInfo);
+
+    auto newRate = audioInfo.rate;
+    auto newChannels = audioInfo.channels;
+    auto newFormat = audioInfo.format;
+
+    // The ring, the bus and the planar scratch are strided for the channel
+    // count the stream was created with, and JS writers are framing samples
+    // for it too. We only ever offer that count, so anything else is refused
+    // rather than reallocated under the data loop; the error reaches JS
+    // through onStateChange.
+    if (newChannels != channels) {
+        pw_log_error("negotiated %u channels; stream was created with %u", newChannels, channels);
+        pw_stream_set_error(stream, -EINVAL, "negotiated %u channels; stream was created with %u",
+            newChannels, channels);
+        return;
+    }
+    cachedFormat = audioInfo;
+
+    auto newBytesPerSample = SampleConverter::sampleSize(newFormat);
+
+    if (isCapture() ? !SampleConverter::isInputFormat(newFormat) : !SampleConverter::isSupported(newFormat)) {
+        pw_log_warn("negotiated format %u cannot be converted; %s will be silent", newFormat,
+            isCapture() ? "capture" : "output");
+    }
+
+    if (newRate != rate || newFormat != format || newBytesPerSample != bytesPerSample) {
+        // process reads all of this mid-cycle: the converter tables, the
+        // resampler's history, the meter's windows and the buffer size. A
+        // blocking invoke applies it on the data loop, between two cycles.
+        NegotiatedFormat negotiated = { newRate, newFormat, newBytesPerSample };
+        auto dataLoop = getDataLoop();
+        if (dataLoop) {
+            pw_loop_invoke(dataLoop, applyNegotiatedFormat, 0, &negotiated, sizeof(negotiated), true, this);
+        } else {
+            applyFormat(negotiated);
+        }
+
+        formatChangeCallback.NonBlockingCall([this](const Napi::Env env, Napi::Function jsCallback) {
+            auto formatObj = Napi::Object::New(env);
+            formatObj.Set("rate", Napi::Number::New(env, rate));
+            formatObj.Set("channels", Napi::Number::New(env, channels));
+            formatObj.Set("format", Napi::Number::New(env, format));
+            jsCallback.Call({ formatObj });
+        });
+    }
+}
+
+void AudioOutputStream::applyFormat(const NegotiatedFormat& negotiated)
+{
+    rate = negotiated.rate;
+    format = negotiated.format;
+    bytesPerSample = negotiated.bytesPerSample;
+    configureConverter();
+    configureMeter();
+    setBufferSize();
+    if (sharedRing.isAttached()) {
+        sharedRing.publishRate(getSourceRate());
+    }
+}
+
+void AudioOutputStream::onLatencyChange(const spa_pod* param)
+{
+    spa_latency_info latency;
+    spa_latency_parse(param, &latency);
+    latencyCallback.NonBlockingCall([latency](const Napi::Env env, Napi::Function jsCallback) {
+        auto minimums = Napi::Object::New(env);
+        minimums.Set("nanoseconds", Napi::BigInt::New(env, latency.min_ns));
+        minimums.Set("quantum", Napi::Number::New(env, latency.min_quantum));
+        minimums.Set("rate", Napi::Number::New(env, latency.min_rate));
+
+        auto maximums = Napi::Object::New(env);
+        maximums.Set("nanoseconds", Napi::BigInt::New(env, latency.max_ns));
+        maximums.Set("quantum", Napi::Number::New(env, latency.max_quantum));
+        maximums.Set("rate", Napi::Number::New(env, latency.max_rate));
+
+        auto latencyObj = Napi::Object::New(env);
+        latencyObj.Set("direction", latency.direction == SPA_DIRECTION_INPUT ? "input" : "output");
+        latencyObj.Set("min", minimums);
+        latencyObj.Set("max", maximums);
+
+        jsCallback.Call({ latencyObj });
+    });
+}
+
+void AudioOutputStream::onUnknownParamChange(uint32_t param)
+{
+    paramChangedCallback.NonBlockingCall([param](const Napi::Env env, Napi::Function jsCallback) {
+        jsCallback.Call({ Napi::Number::New(env, param) });
+    });
+}
+
+bool parseWaveform(const Napi::Value& value, uint32_t& waveform)
+{
+    static const std::pair<const char*, uint32_t> names[] = {
+        { "sine", WAVEFORM_SINE },
+        { "square", WAVEFORM_SQUARE },
+        { "sawtooth", WAVEFORM_SAWTOOTH },
+        { "triangle", WAVEFORM_TRIANGLE },
+        { "white-noise", WAVEFORM_WHITE_NOISE },
+        { "pink-noise", WAVEFORM_PINK_NOISE },
+    };
+
+    if (!value.IsString()) {
+        return false;
+    }
+    auto name = value.As<Napi::String>().Utf8Value();
+    for (auto& [candidate, id] : names) {
+        if (name == candidate) {
+            waveform = id;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Option names for each effect's parameters, by EFFECT_* type and index
+static const char* const effectParamNames[][EFFECT_MAX_PARAMS] = {
+    { "shape", "frequency", "q", "gainDb", "sections" },
+    { "thresholdDb", "lookaheadMs", "releaseMs", NULL, NULL },
+    { "delayMs", "feedback", "mix", "channelMask", NULL },
+    { "midGain", "sideGain", NULL, NULL, NULL },
+};
+
+static const float effectDefaults[][EFFECT_MAX_PARAMS] = {
+    { BIQUAD_LOWPASS, 1000.0f, 0.7071f, 0.0f, 1.0f },
+    { -1.0f, 5.0f, 50.0f, 0.0f, 0.0f },
+    { 250.0f, 0.0f, 0.5f, (float)((1u << EFFECT_MAX_CHANNELS) - 1), 0.0f },
+    { 1.0f, 1.0f, 0.0f, 0.0f, 0.0f },
+};
+
+bool parseEffectType(const Napi::Value& value, uint32_t& type)
+{
+    static const std::pair<const char*, uint32_t> names[] = {
+        { "biquad", EFFECT_BIQUAD },
+        { "limiter", EFFECT_LIMITER },
+        { "delay", EFFECT_DELAY },
+        { "mid-side", EFFECT_MID_SIDE },
+    };
+
+    if (!value.IsString()) {
+        return false;
+    }
+    auto name = value.As<Napi::String>().Utf8Value();
+    for (auto& [candidate, id] : names) {
+        if (name == candidate) {
+            type = id;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseBiquadShape(const Napi::Value& value, float& shape)
+{
+    static const std::pair<const char*, uint32_t> names[] = {
+        { "lowpass", BIQUAD_LOWPASS },
+        { "highpass", BIQUAD_HIGHPASS },
+        { "bandpass", BIQUAD_BANDPASS },
+        { "notch", BIQUAD_NOTCH },
+        { "peaking", BIQUAD_PEAKING },
+        { "lowshelf", BIQUAD_LOWSHELF },
+        { "highshelf", BIQUAD_HIGHSHELF },
+        { "allpass", BIQUAD_ALLPASS },
+    };
+
+    if (!value.IsString()) {
+        return false;
+    }
+    auto name = value.As<Napi::String>().Utf8Value();
+    for (auto& [candidate, id] : names) {
+        if (name == candidate) {
+            shape = (float)id;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseEffectParams(uint32_t type, const Napi::Object& options, float* params)
+{
+    // Only the parameters present are written; false for an unknown shape
+    for (uint32_t i = 0; i < EFFECT_MAX_PARAMS && effectParamNames[type][i]; i++) {
+        auto value = options.Get(effectParamNames[type][i]);
+        if (type == EFFECT_BIQUAD && i == BIQUAD_SHAPE) {
+            if (!value.IsUndefined() && !parseBiquadShape(value, params[i])) {
+                return false;
+            }
+        } else if (value.IsNumber()) {
+            params[i] = value.As<Napi::Number>().FloatValue();
+        }
+    }
+    return true;
+}
+
+bool parseAutomation(const Napi::CallbackInfo& info, size_t first, AutomationRequest& request)
+{
+    // (lane, target, frames, startFrame, curve) starting at info[first]
+    if (!info[first].IsString() || !info[first + 4].IsString()) {
+        return false;
+    }
+    auto lane = info[first].As<Napi::String>().Utf8Value();
+    auto curve = info[first + 4].As<Napi::String>().Utf8Value();
+    if ((lane != "gain" && lane != "pan") || (curve != "linear" && curve != "exponential")) {
+        return false;
+    }
+
+    request.pan = lane == "pan";
+    request.target = info[first + 1].As<Napi::Number>().FloatValue();
+    request.frames = info[first + 2].As<Napi::Number>().Uint32Value();
+    request.startFrame = (uint64_t)std::max(0.0, info[first + 3].As<Napi::Number>().DoubleValue());
+    request.curve = curve == "exponential" ? RAMP_EXPONENTIAL : RAMP_LINEAR;
+    return true;
+}
+
+bool getSampleView(const Napi::Value& value, spa_audio_format rawFormat, SampleView& view)
+{
+    if (value.IsArrayBuffer()) {
+        auto buffer = value.As<Napi::ArrayBuffer>();
+        view = { (const uint8_t*)buffer.Data(), buffer.ByteLength(), rawFormat };
+        return true;
+    }
+
+    if (!value.IsTypedArray()) {
+        return false;
+    }
+
+    // napi_get_typedarray_info also resolves views over a SharedArrayBuffer
+    napi_typedarray_type type;
+    size_t length;
+    void* data;
+    if (napi_get_typedarray_info(value.Env(), value, &type, &length, &data, NULL, NULL) != napi_ok) {
+        return false;
+    }
+
+    spa_audio_format format;
+    switch (type) {
+    case napi_float32_array:
+        format = SPA_AUDIO_FORMAT_F32;
+        break;
+    case napi_float64_array:
+        format = SPA_AUDIO_FORMAT_F64;
+        break;
+    case napi_uint8_array:
+        // Buffers carry raw bytes already in the stream's input format
+        format = rawFormat;
+        break;
+    default:
+        return false;
+    }
+
+    auto elementSize = type == napi_uint8_array ? 1 : SampleConverter::sampleSize(format);
+    view = { (const uint8_t*)data, length * elementSize, format };
+    return true;
+}
+
+Napi::Value AudioOutputStream::write(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    auto started = trace.isEnabled() ? steadyNanos() : 0;
+    if (auto error = checkWritable()) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    SampleView view;
+    if (!getSampleView(info[0], inputFormat, view)) {
+        Napi::TypeError::New(env, "First argument must be an ArrayBuffer, Float32Array, Float64Array or Buffer")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto viewSampleSize = SampleConverter::sampleSize(view.format);
+    auto viewFrameSize = viewSampleSize * channels;
+    if (view.size % viewFrameSize != 0) {
+        Napi::TypeError::New(
+            env,
+            std::format(
+                "Buffer size {} must align to frame size {} ({} x {})",
+                view.size,
+                viewFrameSize,
+                viewSampleSize,
+                channels))
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    // Copy as many whole frames as currently fit; the caller retries the rest
+    auto frameSize = getInputBytesPerFrame();
+    auto limit = (size_t)getHighWatermarkFrames() * frameSize;
+    auto frames = view.format == inputFormat
+        ? ring.write(view.data, view.size, limit) / frameSize
+        : writeConverted(view, limit);
+    acquiredAt = nullptr; // The space an acquired buffer pointed at may be taken now
+
+    if (started) {
+        traceWrite(started, view.size / viewFrameSize, frames);
+    }
+    return Napi::Number::New(env, frames);
+}
+
+Napi::Value AudioOutputStream::writePlanar(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    auto started = trace.isEnabled() ? steadyNanos() : 0;
+    if (auto error = checkWritable()) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    if (!info[0].IsArray() || info[0].As<Napi::Array>().Length() != channels || channels > SPA_AUDIO_MAX_CHANNELS) {
+        Napi::TypeError::New(env, std::format("First argument must be an array of {} channel planes", channels))
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    // Every plane must hold the stream's input format so they interleave
+    // straight into the ring
+    auto planeArray = info[0].As<Napi::Array>();
+    const uint8_t* planes[SPA_AUDIO_MAX_CHANNELS];
+    size_t planeSize = 0;
+    for (uint32_t channel = 0; channel < channels; channel++) {
+        SampleView view;
+        if (!getSampleView(planeArray.Get(channel), inputFormat, view) || view.format != inputFormat) {
+            Napi::TypeError::New(
+                env,
+                std::format("Planes must be {}s", inputFormat == SPA_AUDIO_FORMAT_F32 ? "Float32Array" : "Float64Array"))
+                .ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        if (channel && view.size != planeSize) {
+            Napi::RangeError::New(env, "Planes must all be the same length").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        planes[channel] = view.data;
+        planeSize = view.size;
+    }
+
+    // Frames already written by earlier calls are skipped
+    size_t totalFrames = planeSize / inputBytesPerSample;
+    size_t offset = info[1].IsNumber() ? info[1].As<Napi::Number>().Uint32Value() : 0;
+    offset = std::min(offset, totalFrames);
+    for (uint32_t channel = 0; channel < channels; channel++) {
+        planes[channel] += offset * inputBytesPerSample;
+    }
+
+    auto frameSize = getInputBytesPerFrame();
+    RingSpans spans;
+    auto reserved = ring.reserve((totalFrames - offset) * frameSize, (size_t)getHighWatermarkFrames() * frameSize, spans);
+    for (auto& span : spans.parts) {
+        auto frames = span.size / frameSize;
+        interleave(planes, span.data, channels, inputBytesPerSample, frames);
+        for (uint32_t channel = 0; channel < channels; channel++) {
+            planes[channel] += frames * inputBytesPerSample;
+        }
+    }
+    ring.commit(reserved);
+    acquiredAt = nullptr;
+
+    if (started) {
+        traceWrite(started, totalFrames - offset, reserved / frameSize);
+    }
+    return Napi::Number::New(env, reserved / frameSize);
+}
+
+const char* AudioOutputStream::checkWritable()
+{
+    if (isCapture()) {
+        return "Capture streams are read, not written";
+    }
+    if (sharedRing.isAttached()) {
+        return "Stream reads from its sharedRing; write through SharedRingWriter instead";
+    }
+    return nullptr;
+}
+
+Napi::ArrayBuffer AudioOutputStream::getAcquiredArrayBuffer(Napi::Env env)
+{
+    // Covers the acquired span and nothing else, so no view JS can build on
+    // it reaches the rest of the ring. While JS holds it, the buffer keeps
+    // this stream (and the ring storage) alive.
+    Ref();
+    return Napi::ArrayBuffer::New(
+        env, acquiredAt, acquiredBytes,
+        [](Napi::Env, void*, AudioOutputStream* stream) { stream->Unref(); },
+        this);
+}
+
+Napi::Value AudioOutputStream::acquireBuffer(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    if (auto error = checkWritable()) {
+        Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    // Reserve contiguous space only, so the caller gets one plain view; near
+    // the end of the ring it is shorter than asked for and the next call
+    // continues from the start
+    auto frameSize = getInputBytesPerFrame();
+    auto wanted = info[0].IsNumber() ? info[0].As<Napi::Number>().Uint32Value() : getAvailableFrames();
+    RingSpans spans;
+    ring.reserve((size_t)wanted * frameSize, (size_t)getHighWatermarkFrames() * frameSize, spans);
+    acquiredAt = spans.parts[0].data;
+    acquiredBytes = spans.parts[0].size / frameSize * frameSize;
+
+    if (!acquiredBytes) {
+        // The ring is full: nothing to render into, and nothing to commit
+        acquiredAt = nullptr;
+        return inputFormat == SPA_AUDIO_FORMAT_F32 ? (Napi::Value)Napi::Float32Array::New(env, 0)
+                                                   : (Napi::Value)Napi::Float64Array::New(env, 0);
+    }
+
+    auto buffer = getAcquiredArrayBuffer(env);
+    if (inputFormat == SPA_AUDIO_FORMAT_F32) {
+        return Napi::Float32Array::New(env, acquiredBytes / sizeof(float), buffer, 0);
+    }
+    return Napi::Float64Array::New(env, acquiredBytes / sizeof(double), buffer, 0);
+}
+
+Napi::Value AudioOutputStream::commit(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    if (!info[0].IsTypedArray()) {
+        Napi::TypeError::New(env, "First argument must be a buffer from acquireBuffer()").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    // The view must start where the acquired span does and end inside it;
+    // frames are committed from the span's start
+    auto view = info[0].As<Napi::TypedArray>();
+    auto viewData = (uint8_t*)view.ArrayBuffer().Data() + view.ByteOffset();
+    if (!acquiredAt || viewData != acquiredAt || view.ByteLength() > acquiredBytes) {
+        Napi::Error::New(env, "Buffer is not the one most recently returned by acquireBuffer()")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto frameSize = getInputBytesPerFrame();
+    auto frames = info[1].IsNumber() ? info[1].As<Napi::Number>().Uint32Value() : view.ByteLength() / frameSize;
+    if ((size_t)frames * frameSize > acquiredBytes) {
+        Napi::RangeError::New(
+            env,
+            std::format("Cannot commit {} frames; only {} were acquired", frames, acquiredBytes / frameSize))
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto started = trace.isEnabled() ? steadyNanos() : 0;
+    ring.commit((size_t)frames * frameSize);
+    acquiredAt = nullptr;
+    acquiredBytes = 0;
+    if (started) {
+        traceWrite(started, frames, frames);
+    }
+    return Napi::Number::New(env, frames);
+}
+
+size_t AudioOutputStream::writeConverted(const SampleView& view, size_t limit)
+{
+    // Float arrays of the other width are widened/narrowed while copying
+    auto viewSampleSize = SampleConverter::sampleSize(view.format);
+    auto wanted = view.size / viewSampleSize * inputBytesPerSample;
+
+    RingSpans spans;
+    auto reserved = ring.reserve(wanted, limit, spans);
+    writeConverter.configure(view.format, inputFormat, false);
+
+    auto source = view.data;
+    for (auto& span : spans.parts) {
+        auto samples = span.size / inputBytesPerSample;
+        writeConverter.convert(source, span.data, samples);
+        source += samples * viewSampleSize;
+    }
+
+    ring.commit(reserved);
+    return reserved / getInputBytesPerFrame();
+}
+
+Napi::Value AudioOutputStream::waitForBuffer(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    auto options = info[0].IsObject() ? info[0].As<Napi::Object>() : Napi::Object::New(env);
+    auto minFrames = options.Get("minFrames").IsNumber() ? options.Get("minFrames").As<Napi::Number>().Uint32Value() : 0;
+
+    auto availableFrames = getAvailableFrames();
+    if (availableFrames >= getWakeFrames(minFrames)) {
+        return resolved(Napi::Number::New(env, availableFrames));
+    }
+
+    // Each caller keeps its own minFrames, so a later call asking for more
+    // or less never moves an earlier caller's threshold
+    auto waiter = std::find_if(bufferWaiters.begin(), bufferWaiters.end(), [minFrames](auto& entry) {
+        return entry.minFrames == minFrames;
+    });
+    if (waiter == bufferWaiters.end()) {
+        bufferWaiters.push_back({ minFrames, Napi::Promise::Deferred::New(env) });
+        waiter = bufferWaiters.end() - 1;
+        publishWakeFrames();
+    }
+
+    // The RT thread raises WAKE_BUFFER only while it is armed
+    wakeups.arm(env, WAKE_BUFFER);
+    return waiter->deferral.Promise();
+}
+
+Napi::Value AudioOutputStream::read(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    if (!isCapture()) {
+        Napi::Error::New(env, "Only capture streams can be read").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    SampleView view;
+    if (!getSampleView(info[0], inputFormat, view) || view.format != inputFormat) {
+        Napi::TypeError::New(env, "First argument must be an ArrayBuffer or a typed array of the stream's sample format")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    // The view is only written, never retained
+    auto frameSize = getInputBytesPerFrame();
+    auto size = view.size / frameSize * frameSize;
+    auto frames = ring.read((uint8_t*)view.data, size) / frameSize;
+    return Napi::Number::New(env, frames);
+}
+
+Napi::Value AudioOutputStream::waitForData(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    uint32_t minFrames = info[0].IsNumber() ? info[0].As<Napi::Number>().Uint32Value() : 1;
+    minFrames = std::clamp(minFrames, 1u, std::max(1u, (uint32_t)(ring.capacity() / getInputBytesPerFrame())));
+
+    auto readableFrames = getQueuedFrames();
+    if (readableFrames >= minFrames) {
+        return resolved(Napi::Number::New(env, readableFrames));
+    }
+
+    // The RT thread raises WAKE_DATA only once wantedFrames have been
+    // captured, so a batch costs one wakeup
+    wantedFrames.store(minFrames, std::memory_order_relaxed);
+    if (!dataDeferral) {
+        dataDeferral.emplace(env);
+        wakeups.arm(env, WAKE_DATA);
+    }
+
+    return dataDeferral->Promise();
+}
+
+Napi::Value AudioOutputStream::addMixerInput(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    if (isCapture()) {
+        Napi::Error::New(env, "Capture streams have no mixer").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto options = info[0].IsObject() ? info[0].As<Napi::Object>() : Napi::Object::New(env);
+    auto inputChannels = options.Get("channels").IsNumber() ? options.Get("channels").As<Napi::Number>().Uint32Value() : 1;
+    auto frames = options.Get("frames").IsNumber()
+        ? options.Get("frames").As<Napi::Number>().Uint32Value()
+        : std::max<uint32_t>(frameBufferSize, framesPerQuantum);
+    auto gain = options.Get("gain").IsNumber() ? options.Get("gain").As<Napi::Number>().FloatValue() : 1.0f;
+    auto pan = options.Get("pan").IsNumber() ? options.Get("pan").As<Napi::Number>().FloatValue() : 0.0f;
+
+    if (inputChannels != 1 && inputChannels != channels) {
+        Napi::RangeError::New(env, "Mixer inputs must be mono or match the stream's channel count")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto id = mixer.addInput(inputChannels, std::max<uint32_t>(frames, 1), gain, std::clamp(pan, -1.0f, 1.0f));
+    if (id < 0) {
+        Napi::RangeError::New(env, std::format("A stream mixes at most {} inputs", MIXER_MAX_INPUTS))
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return Napi::Number::New(env, id);
+}
+
+Napi::Value AudioOutputStream::removeMixerInput(const Napi::CallbackInfo& info)
+{
+    auto id = info[0].As<Napi::Number>().Uint32Value();
+    return Napi::Boolean::New(info.Env(), mixer.removeInput(id));
+}
+
+Napi::Value AudioOutputStream::setMixerInputLevels(const Napi::CallbackInfo& info)
+{
+    auto id = info[0].As<Napi::Number>().Uint32Value();
+    auto gain = info[1].As<Napi::Number>().FloatValue();
+    auto pan = info[2].As<Napi::Number>().FloatValue();
+    return Napi::Boolean::New(info.Env(), mixer.setLevels(id, gain, pan));
+}
+
+Napi::Value AudioOutputStream::writeMixerInput(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    auto id = info[0].As<Napi::Number>().Uint32Value();
+    SampleView view;
+    if (!getSampleView(info[1], SPA_AUDIO_FORMAT_F32, view) || view.format != SPA_AUDIO_FORMAT_F32) {
+        Napi::TypeError::New(env, "Mixer inputs take a Float32Array").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto frames = mixer.write(id, (const float*)view.data, view.size / sizeof(float));
+    return Napi::Number::New(env, frames);
+}
+
+Napi::Value AudioOutputStream::getMixerInputFrames(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    auto id = info[0].As<Napi::Number>().Uint32Value();
+    auto result = Napi::Object::New(env);
+    result.Set("writable", Napi::Number::New(env, mixer.writableFrames(id)));
+    result.Set("queued", Napi::Number::New(env, mixer.queuedFrames(id)));
+    return result;
+}
+
+Napi::Value AudioOutputStream::waitForMixerSpace(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+
+    // One wait serves every input: any cycle that mixed has freed space
+    if (!mixerDeferral) {
+        mixerDeferral.emplace(env);
+        wakeups.arm(env, WAKE_MIXER);
+    }
+
+    return mixerDeferral->Promise();
+}
+
+Napi::Value AudioOutputStream::addGenerator(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    if (isCapture()) {
+        Napi::Error::New(env, "Capture streams have no mixer").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto options = info[0].IsObject() ? info[0].As<Napi::Object>() : Napi::Object::New(env);
+    uint32_t waveform = WAVEFORM_SINE;
+    if (!options.Get("waveform").IsUndefined() && !parseWaveform(options.Get("waveform"), waveform)) {
+        Napi::TypeError::New(env, "Unknown waveform").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    auto frequency = options.Get("frequency").IsNumber() ? options.Get("frequency").As<Napi::Number>().FloatValue() : 440.0f;
+    auto amplitude = options.Get("amplitude").IsNumber() ? options.Get("amplitude").As<Napi::Number>().FloatValue() : 1.0f;
+    auto phase = options.Get("phase").IsNumber() ? options.Get("phase").As<Napi::Number>().FloatValue() : 0.0f;
+    auto gain = options.Get("gain").IsNumber() ? options.Get("gain").As<Napi::Number>().FloatValue() : 1.0f;
+    auto pan = options.Get("pan").IsNumber() ? options.Get("pan").As<Napi::Number>().FloatValue() : 0.0f;
+
+    auto id = mixer.addGenerator(waveform, frequency, amplitude, phase, gain, std::clamp(pan, -1.0f, 1.0f));
+    if (id < 0) {
+        Napi::RangeError::New(env, std::format("A stream mixes at most {} inputs", MIXER_MAX_INPUTS))
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return Napi::Number::New(env, id);
+}
+
+Napi::Value AudioOutputStream::playFile(const Napi::CallbackInfo& info)
+{
+    // playFile(path, { offset?, loop?, gain?, pan?, raw?: { format, channels, rate? } })
+    // resolves to { id, channels, rate, frames } once the file is mapped
+    auto env = info.Env();
+    if (isCapture()) {
+        return rejected(Napi::Error::New(env, "Capture streams have no mixer"));
+    }
+    if (!info[0].IsString()) {
+        return rejected(Napi::TypeError::New(env, "playFile() needs a path"));
+    }
+
+    auto path = info[0].As<Napi::String>().Utf8Value();
+    auto options = info[1].IsObject() ? info[1].As<Napi::Object>() : Napi::Object::New(env);
+    auto offset = options.Get("offset").IsNumber() ? options.Get("offset").As<Napi::Number>().DoubleValue() : 0.0;
+    if (!(offset >= 0.0)) {
+        return rejected(Napi::RangeError::New(env, "offset must be a frame count of at least 0"));
+    }
+    auto loop = options.Get("loop").ToBoolean().Value();
+    auto gain = options.Get("gain").IsNumber() ? options.Get("gain").As<Napi::Number>().FloatValue() : 1.0f;
+    auto pan = options.Get("pan").IsNumber() ? options.Get("pan").As<Napi::Number>().FloatValue() : 0.0f;
+
+    std::optional<RawFileFormat> raw;
+    if (options.Get("raw").IsObject()) {
+        auto rawOptions = options.Get("raw").As<Napi::Object>();
+        raw = RawFileFormat {
+            (spa_audio_format)rawOptions.Get("format").ToNumber().Uint32Value(),
+            rawOptions.Get("channels").ToNumber().Uint32Value(),
+            rawOptions.Get("rate").IsNumber() ? rawOptions.Get("rate").As<Napi::Number>().Uint32Value() : getSourceRate(),
+        };
+        if (!FileSource::isReadable(raw->format)) {
+            return rejected(Napi::TypeError::New(env, "Raw files must be U8, S16, S24, S24_32, S32, F32 or F64"));
+        }
+    }
+
+    // Opening maps and reads in the file, so it runs off the JS thread
+    auto file = std::make_shared<FileSource>();
+    auto error = std::make_shared<std::string>();
+    Ref();
+    return async(
+        env,
+        [file, path, raw, error]() {
+            file->open(path, raw ? &*raw : NULL, *error);
+        },
+        [this, env, file, path, error, offset, loop, gain, pan]() -> Napi::Value {
+            Unref();
+            if (!error->empty()) {
+                return rejected(Napi::Error::New(env, *error));
+            }
+            if (file->getRate() != getSourceRate()) {
+                return rejected(Napi::RangeError::New(env,
+                    std::format("{} is {} Hz but the stream renders at {} Hz; create the stream with renderRate: {}",
+                        path, file->getRate(), getSourceRate(), file->getRate())));
+            }
+            if (offset >= (double)file->getFrames()) {
+                return rejected(Napi::RangeError::New(env, std::format("offset is past the end of {}", path)));
+            }
+
+            file->start((uint64_t)offset, loop);
+            auto channels = file->getChannels();
+            auto id = mixer.addFile(file, gain, std::clamp(pan, -1.0f, 1.0f));
+            if (id < 0) {
+                return rejected(Napi::RangeError::New(env, std::format("A stream mixes at most {} inputs", MIXER_MAX_INPUTS)));
+            }
+
+            auto result = Napi::Object::New(env);
+            result.Set("id", id);
+            result.Set("channels", channels);
+            result.Set("rate", file->getRate());
+            result.Set("frames", (double)file->getFrames());
+            return result;
+        });
+}
+
+Napi::Value AudioOutputStream::getFileState(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    auto file = mixer.file(info[0].As<Napi::Number>().Uint32Value());
+    if (!file) {
+        return env.Undefined();
+    }
+    auto state = Napi::Object::New(env);
+    state.Set("position", (double)file->getPosition());
+    state.Set("ended", file->hasEnded());
+    return state;
+}
+
+Napi::Value AudioOutputStream::setFileLooping(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    auto file = mixer.file(info[0].As<Napi::Number>().Uint32Value());
+    if (file) {
+        file->setLooping(info[1].ToBoolean().Value());
+    }
+    return Napi::Boolean::New(env, file != NULL);
+}
+
+Napi::Value AudioOutputStream::scheduleClip(const Napi::CallbackInfo& info)
+{
+    // scheduleClip(samples, { channels?, atFrame?, atTimeNs?, gain?, pan? })
+    // returns { id, startFrame }
+    auto env = info.Env();
+    if (isCapture()) {
+        Napi::Error::New(env, "Capture streams have no mixer").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    SampleView view;
+    if (!getSampleView(info[0], SPA_AUDIO_FORMAT_F32, view) || view.format != SPA_AUDIO_FORMAT_F32) {
+        Napi::TypeError::New(env, "Clips take a Float32Array").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto options = info[1].IsObject() ? info[1].As<Napi::Object>() : Napi::Object::New(env);
+    auto clipChannels = options.Get("channels").IsNumber() ? options.Get("channels").As<Napi::Number>().Uint32Value() : 1;
+    auto gain = options.Get("gain").IsNumber() ? options.Get("gain").As<Napi::Number>().FloatValue() : 1.0f;
+    auto pan = options.Get("pan").IsNumber() ? options.Get("pan").As<Napi::Number>().FloatValue() : 0.0f;
+    if (clipChannels != 1 && clipChannels != channels) {
+        Napi::RangeError::New(env, "Clips must be mono or match the stream's channel count")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    auto frames = view.size / sizeof(float) / clipChannels;
+    if (!frames) {
+        Napi::RangeError::New(env, "Clips need at least one frame").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto atFrame = options.Get("atFrame").IsNumber() ? options.Get("atFrame").As<Napi::Number>().DoubleValue() : NAN;
+    auto atTimeNs = options.Get("atTimeNs").IsNumber() ? options.Get("atTimeNs").As<Napi::Number>().DoubleValue() : NAN;
+    if (std::isnan(atFrame) && std::isnan(atTimeNs)) {
+        Napi::TypeError::New(env, "schedule() needs atFrame or atTimeNs").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    double startFrame;
+    if (!resolveStartFrame(env, atFrame, atTimeNs, startFrame)) {
+        return env.Undefined();
+    }
+
+    auto id = mixer.addClip((const float*)view.data, frames, clipChannels, (uint64_t)startFrame, gain, std::clamp(pan, -1.0f, 1.0f));
+    if (id < 0) {
+        Napi::RangeError::New(env, std::format("A stream mixes at most {} inputs", MIXER_MAX_INPUTS))
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto result = Napi::Object::New(env);
+    result.Set("id", id);
+    result.Set("startFrame", startFrame);
+    return result;
+}
+
+Napi::Value AudioOutputStream::hasMixerInputEnded(const Napi::CallbackInfo& info)
+{
+    return Napi::Boolean::New(info.Env(), mixer.hasEnded(info[0].As<Napi::Number>().Uint32Value()));
+}
+
+bool AudioOutputStream::resolveStartFrame(const Napi::Env& env, double atFrame, double atTimeNs, double& startFrame)
+{
+    // A frame already rendered plays as soon as the input is mixed
+    if (!std::isnan(atFrame)) {
+        startFrame = std::max(atFrame, 0.0);
+        return true;
+    }
+    if (std::isnan(atTimeNs)) {
+        startFrame = 0;
+        return true;
+    }
+    PlaybackTiming timing;
+    if (!readTiming(timing)) {
+        Napi::Error::New(env, "No playback timing yet; schedule by atFrame until the stream has played a cycle")
+            .ThrowAsJavaScriptException();
+        return false;
+    }
+    startFrame = std::max(std::round(timing.frameAt(atTimeNs)), 0.0);
+    return true;
+}
+
+Napi::Value AudioOutputStream::triggerSample(const Napi::CallbackInfo& info)
+{
+    // triggerSample(id, gain, pan, atFrame, atTimeNs, polyphony) returns the
+    // start frame. Positional, NaN for "now", so no options object is built
+    // or read; the id is still copied into a std::string for the lookup,
+    // which only reaches the heap for ids too long for its inline buffer.
+    auto env = info.Env();
+    if (isCapture()) {
+        Napi::Error::New(env, "Capture streams have no mixer").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    auto id = info[0].As<Napi::String>().Utf8Value();
+    auto sample = session->findSample(id);
+    if (!sample) {
+        Napi::Error::New(env, std::format("No sample loaded as \"{}\"", id)).ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (sample->channels != 1 && sample->channels != channels) {
+        Napi::RangeError::New(env, std::format("Sample \"{}\" has {} channels; streams play mono samples or their own channel count", id, sample->channels))
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    if (sample->rate && sample->rate != getSourceRate()) {
+        Napi::RangeError::New(env, std::format("Sample \"{}\" is at {} Hz but the stream renders at {} Hz", id, sample->rate, getSourceRate()))
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto gain = info[1].As<Napi::Number>().FloatValue();
+    auto pan = info[2].As<Napi::Number>().FloatValue();
+    auto polyphony = info[5].As<Napi::Number>().Uint32Value();
+    double startFrame;
+    if (!resolveStartFrame(env, info[3].As<Napi::Number>().DoubleValue(), info[4].As<Napi::Number>().DoubleValue(), startFrame)) {
+        return env.Undefined();
+    }
+
+    auto voice = mixer.addVoice(std::move(sample), (uint64_t)startFrame, gain, std::clamp(pan, -1.0f, 1.0f), std::clamp<uint32_t>(polyphony, 1, MIXER_MAX_INPUTS));
+    if (voice < 0) {
+        Napi::RangeError::New(env, std::format("A stream mixes at most {} inputs", MIXER_MAX_INPUTS))
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return Napi::Number::New(env, startFrame);
+}
+
+Napi::Value AudioOutputStream::renderOffline(const Napi::CallbackInfo& info)
+{
+    // renderOffline(path, { frames, format?, rate?, wav? }) resolves to
+    // { frames, bytes } once the file is complete
+    auto env = info.Env();
+    if (isCapture()) {
+        return rejected(Napi::Error::New(env, "Capture streams cannot render offline"));
+    }
+    if (!info[0].IsString() || !info[1].IsObject()) {
+        return rejected(Napi::TypeError::New(env, "renderOffline() needs a path and options"));
+    }
+    if (destroyed || pw_stream_get_state(stream, nullptr) != PW_STREAM_STATE_UNCONNECTED) {
+        return rejected(Napi::Error::New(env, "Disconnect the stream before rendering offline"));
+    }
+    if (renderingOffline.exchange(true, std::memory_order_acq_rel)) {
+        return rejected(Napi::Error::New(env, "An offline render is already running"));
+    }
+
+    auto path = info[0].As<Napi::String>().Utf8Value();
+    auto options = info[1].As<Napi::Object>();
+    auto frames = options.Get("frames").ToNumber().DoubleValue();
+    auto wav = !options.Get("wav").IsBoolean() || options.Get("wav").As<Napi::Boolean>().Value();
+    auto outputFormat = options.Get("format").IsNumber()
+        ? (spa_audio_format)options.Get("format").As<Napi::Number>().Uint32Value()
+        : SPA_AUDIO_FORMAT_F32;
+    auto outputRate = options.Get("rate").IsNumber() ? options.Get("rate").As<Napi::Number>().Uint32Value()
+                                                     : getSourceRate();
+    const char* invalid = NULL;
+    if (!(frames >= 1.0) || frames > (double)UINT64_MAX) {
+        invalid = "frames must be at least 1";
+    } else if (!outputRate || outputRate > MAX_SAMPLE_RATE) {
+        invalid = "rate is out of range";
+    } else if (!FileSink::isWritable(outputFormat, wav)) {
+        invalid = wav ? "WAV renders must be U8, S16, S32, F32 or F64" : "Raw renders must be U8, S16, S24_32, S32, F32 or F64";
+    }
+    if (invalid) {
+        renderingOffline.store(false, std::memory_order_release);
+        return rejected(Napi::RangeError::New(env, invalid));
+    }
+
+    // The worker stands in for the RT thread: the same ring, mixer,
+    // automation and effects, but converters and a resampler of its own, set
+    // up for the file. Sources stay at the rate they were written at, and
+    // the resampler converts to the file's rate when the two differ. The
+    // stream's negotiated rate and format are never touched, so getters and
+    // rate checks on the JS thread still see them during the render.
+    auto sourceRate = getSourceRate();
+    auto render = std::make_shared<OfflineRender>();
+    render->rate = outputRate;
+    render->format = outputFormat;
+    render->converter.configure(inputFormat, outputFormat, dither);
+    render->busInput.configure(inputFormat, SPA_AUDIO_FORMAT_F32, false);
+    render->busOutput.configure(SPA_AUDIO_FORMAT_F32, outputFormat, dither);
+    if (sourceRate != outputRate) {
+        render->resampler.configure(sourceRate, outputRate, channels, resampleQuality, MIX_CHUNK_FRAMES);
+    }
+    offlineCancelled.store(false, std::memory_order_relaxed);
+    offlineWorking.store(true, std::memory_order_release);
+
+    auto sink = std::make_shared<FileSink>();
+    auto error = std::make_shared<std::string>();
+    Ref();
+    return async(
+        env,
+        [this, sink, render, error, path, wav, frames]() {
+            if (sink->open(path, render->format, channels, render->rate, wav, *error)
+                && renderToSink(*sink, (uint64_t)frames, *render, *error)) {
+                sink->close(*error);
+            }
+            offlineWorking.store(false, std::memory_order_release);
+            offlineWorking.notify_all();
+        },
+        [this, env, sink, error, frames]() -> Napi::Value {
+            renderingOffline.store(false, std::memory_order_release);
+            Unref();
+            if (!error->empty()) {
+                return rejected(Napi::Error::New(env, *error));
+            }
+
+            auto result = Napi::Object::New(env);
+            result.Set("frames", std::floor(frames));
+            result.Set("bytes", (double)sink->getBytes());
+            return result;
+        });
+}
+
+bool AudioOutputStream::renderToSink(FileSink& sink, uint64_t frames, OfflineRender& render, std::string& error)
 {
-    // Copy the props to a new object since we're using the data in another thread
-    auto copy = spa_pod_copy(param);
-    auto properties = (struct spa_pod_object*)copy;
+    // Renders as fast as the CPU allows; wakeups still fire, so JS can keep
+    // feeding mixer inputs, but nothing waits for it
+    RenderPath path = {
+        .converter = render.converter,
+        .busInput = render.busInput,
+        .busOutput = render.busOutput,
+        .resampler = render.resampler,
+        .bytesPerFrame = SampleConverter::sampleSize(render.format) * channels,
+    };
+    std::vector<uint8_t> chunk((size_t)OFFLINE_CHUNK_FRAMES * path.bytesPerFrame);
+    for (uint64_t done = 0; done < frames;) {
+        if (offlineCancelled.load(std::memory_order_relaxed)) {
+            error = "Stream destroyed during an offline render";
+            return false;
+        }
+        auto count = (uint32_t)std::min<uint64_t>(frames - done, OFFLINE_CHUNK_FRAMES);
+        raiseWakeups(renderFrames(chunk.data(), count, path));
+        if (!sink.write(chunk.data(), (size_t)count * path.bytesPerFrame, error)) {
+            return false;
+        }
+        done += count;
+    }
+    return true;
+}
 
-    propsCallback.NonBlockingCall([this, properties](const Napi::Env env, Napi::Function jsCallback) {
-        setProps(env, properties);
-        jsCallback.Call({ props.Value() });
-    });
+Napi::Value AudioOutputStream::setGeneratorParams(const Napi::CallbackInfo& info)
+{
+    // Each parameter is its own atomic; the RT thread picks up whatever has
+    // changed at the start of its next cycle
+    auto env = info.Env();
+    auto oscillator = mixer.generator(info[0].As<Napi::Number>().Uint32Value());
+    if (!oscillator || !info[1].IsObject()) {
+        return Napi::Boolean::New(env, false);
+    }
+
+    auto params = info[1].As<Napi::Object>();
+    uint32_t waveform;
+    if (!params.Get("waveform").IsUndefined()) {
+        if (!parseWaveform(params.Get("waveform"), waveform)) {
+            Napi::TypeError::New(env, "Unknown waveform").ThrowAsJavaScriptException();
+            return env.Undefined();
+        }
+        oscillator->setWaveform(waveform);
+    }
+    if (params.Get("frequency").IsNumber()) {
+        oscillator->setFrequency(params.Get("frequency").As<Napi::Number>().FloatValue());
+    }
+    if (params.Get("amplitude").IsNumber()) {
+        oscillator->setAmplitude(params.Get("amplitude").As<Napi::Number>().FloatValue());
+    }
+    if (params.Get("phase").IsNumber()) {
+        oscillator->setPhase(params.Get("phase").As<Napi::Number>().FloatValue());
+    }
+    return Napi::Boolean::New(env, true);
 }
 
-void AudioOutputStream::setProp(const char* key, spa_pod* value)
+Napi::Value AudioOutputStream::automate(const Napi::CallbackInfo& info)
 {
-    props.Value()[key] = podToJsValue(props.Env(), value);
+    // automate(lane, target, frames, startFrame, curve); false when the lane's queue is full
+    auto env = info.Env();
+    AutomationRequest request;
+    if (!parseAutomation(info, 0, request)) {
+        Napi::TypeError::New(env, "Automation needs a gain or pan lane and a linear or exponential curve")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto& lane = request.pan ? masterPan : masterGain;
+    auto target = request.pan ? std::clamp(request.target, -1.0f, 1.0f) : request.target;
+    return Napi::Boolean::New(env, lane.schedule(target, request.frames, request.startFrame, request.curve));
 }
 
-void AudioOutputStream::setChannelProp(uint32_t index, const char* key, Napi::Value value)
+Napi::Value AudioOutputStream::resetAutomation(const Napi::CallbackInfo& info)
 {
-    auto env = props.Env();
-    auto propsObj = props.Value();
+    // Jumps cancel whatever was scheduled, so a pooled stream goes back
+    // without a ramp still waiting to start
+    masterGain.set(1.0f);
+    masterPan.set(0.0f);
+    return info.Env().Undefined();
+}
 
-    Napi::Array channels;
-    if (propsObj.Has("channels")) {
-        channels = props.Get("channels").As<Napi::Array>();
-    } else {
-        channels = Napi::Array::New(env);
-        propsObj.Set("channels", channels);
+EffectChain* AudioOutputStream::effectChain(const Napi::Value& target, uint32_t& chainChannels)
+{
+    auto id = target.As<Napi::Number>().Int32Value();
+    if (id < 0) {
+        chainChannels = channels;
+        return &effects;
     }
+    return mixer.effects((uint32_t)id, chainChannels);
+}
 
-    Napi::Object channel;
-    if (index >= channels.Length()) {
-        channel = Napi::Object::New(env);
-        channels.Set(index, channel);
-    } else {
-        channel = channels.Get(index).As<Napi::Object>();
-    }
-
-    channel[key] = value;
-}
-
-Napi::Value podToJsValue(const Napi::Env env, const struct spa_pod* pod)
-{
-    if (spa_pod_is_int(pod)) {
-        int32_t value;
-        spa_pod_get_int(pod, &value);
-        return Napi::Number::New(env, value);
-    } else if (spa_pod_is_float(pod)) {
-        float value;
-        spa_pod_get_float(pod, &value);
-        return Napi::Number::New(env, value);
-    } else if (spa_pod_is_bool(pod)) {
-        bool value;
-        spa_pod_get_bool(pod, &value);
-        return Napi::Boolean::New(env, value);
-    } else if (spa_pod_is_string(pod)) {
-        const char* str;
-        spa_pod_get_string(pod, &str);
-        return Napi::String::New(env, str);
-    } else {
-        // Handle other types as needed
-        // Unhandled POD type - silently ignore
+Napi::Value AudioOutputStream::insertEffect(const Napi::CallbackInfo& info)
+{
+    // insertEffect(target, { type, index?, maxDelayMs?, ...params }); a
+    // target of -1 is the stream's own bus, anything else a mixer input
+    auto env = info.Env();
+    if (isCapture()) {
+        Napi::Error::New(env, "Capture streams have no effects").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    uint32_t chainChannels = 0;
+    auto chain = effectChain(info[0], chainChannels);
+    if (!chain) {
+        Napi::Error::New(env, "No such mixer input").ThrowAsJavaScriptException();
         return env.Undefined();
     }
+    if (chainChannels > EFFECT_MAX_CHANNELS) {
+        Napi::RangeError::New(env, std::format("Effects process at most {} channels", EFFECT_MAX_CHANNELS))
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto options = info[1].IsObject() ? info[1].As<Napi::Object>() : Napi::Object::New(env);
+    uint32_t type;
+    if (!parseEffectType(options.Get("type"), type)) {
+        Napi::TypeError::New(env, "Unknown effect type").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    float params[EFFECT_MAX_PARAMS];
+    std::copy_n(effectDefaults[type], EFFECT_MAX_PARAMS, params);
+    if (!parseEffectParams(type, options, params)) {
+        Napi::TypeError::New(env, "Unknown filter shape").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    // Delay memory is sized here so the RT thread never allocates. Without
+    // a fixed render rate, the effect may be inserted before negotiation or
+    // run on a graph that changes rate, so it is sized for the highest rate
+    // a stream can run at, as the ring is.
+    double capacityMs = 0.0;
+    if (type == EFFECT_LIMITER) {
+        capacityMs = EFFECT_LIMITER_MAX_LOOKAHEAD_MS;
+    } else if (type == EFFECT_DELAY) {
+        auto maxDelayMs = options.Get("maxDelayMs").IsNumber() ? options.Get("maxDelayMs").As<Napi::Number>().DoubleValue() : 1000.0;
+        capacityMs = std::min(std::max(maxDelayMs, (double)params[DELAY_MS]), EFFECT_DELAY_MAX_MS);
+    }
+    auto sizingRate = renderRate ? renderRate : MAX_SAMPLE_RATE;
+    auto capacityFrames = std::max<size_t>(1, (size_t)std::ceil(capacityMs * sizingRate / 1000.0));
+    auto index = options.Get("index").IsNumber() ? options.Get("index").As<Napi::Number>().Uint32Value() : EFFECT_CHAIN_MAX_STAGES;
+
+    auto id = chain->insert(type, params, index, capacityFrames, chainChannels);
+    if (id < 0) {
+        Napi::RangeError::New(env, std::format("A chain holds at most {} effects", EFFECT_CHAIN_MAX_STAGES))
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return Napi::Number::New(env, id);
 }
 
-void AudioOutputStream::setProps(Napi::Env env, const spa_pod_object* properties)
+Napi::Value AudioOutputStream::setEffectParams(const Napi::CallbackInfo& info)
 {
-    struct spa_pod_prop* prop;
-    SPA_POD_OBJECT_FOREACH(properties, prop)
-    {
-        auto key = (spa_prop)prop->key;
-        auto value = &prop->value;
-        switch (key) {
-        case SPA_PROP_volume:
-            setProp("volume", value);
-            break;
-        case SPA_PROP_mute:
-            setProp("mute", value);
-            break;
-        case SPA_PROP_monitorMute:
-            setProp("monitorMute", value);
-            break;
-        case SPA_PROP_softMute:
-            setProp("softMute", value);
-            break;
-        case SPA_PROP_channelVolumes: {
-            uint32_t numVolumes;
-            auto volumes = (float*)spa_pod_get_array(&prop->value, &numVolumes);
-            for (uint32_t i = 0; i < numVolumes; i++) {
-                setChannelProp(i, "volume", Napi::Number::New(env, volumes[i]));
-            }
-        } break;
-        case SPA_PROP_channelMap: {
-            uint32_t numChannels;
-            auto channelIds = (spa_audio_channel*)spa_pod_get_array(&prop->value, &numChannels);
-            for (uint32_t i = 0; i < numChannels; i++) {
-                setChannelProp(i, "id", Napi::Number::New(env, channelIds[i]));
-            }
-        } break;
-        case SPA_PROP_monitorVolumes: {
-            uint32_t numMonitorVolumes;
-            auto monitorVolumes = (float*)spa_pod_get_array(&prop->value, &numMonitorVolumes);
-            for (uint32_t i = 0; i < numMonitorVolumes; i++) {
-                setChannelProp(i, "monitorVolume", Napi::Number::New(env, monitorVolumes[i]));
-            }
-        } break;
-        case SPA_PROP_softVolumes: {
-            uint32_t numVolumes;
-            auto volumes = (float*)spa_pod_get_array(&prop->value, &numVolumes);
-            for (uint32_t i = 0; i < numVolumes; i++) {
-                setChannelProp(i, "softVolume", Napi::Number::New(env, volumes[i]));
-            }
-        } break;
-        case SPA_PROP_params: {
-            auto paramsObj = Napi::Object::New(env);
-            spa_pod_parser parser;
-            spa_pod_frame frame;
-            spa_pod_parser_pod(&parser, &prop->value);
-            spa_pod_parser_push_struct(&parser, &frame);
-            while (true) {
-                const char* name;
-                if (spa_pod_parser_get_string(&parser, &name) < 0) {
-                    break;
-                }
-
-                spa_pod* param;
-                if (spa_pod_parser_get_pod(&parser, &param) < 0) {
-                    break;
-                }
+    // setEffectParams(target, id, params); parameters left out keep their
+    // values, and the RT thread recomputes the stage on its next cycle
+    auto env = info.Env();
+    uint32_t chainChannels;
+    auto chain = effectChain(info[0], chainChannels);
+    auto id = info[1].As<Napi::Number>().Uint32Value();
+    auto type = chain ? chain->typeOf(id) : -1;
+    if (type < 0 || !info[2].IsObject()) {
+        return Napi::Boolean::New(env, false);
+    }
 
-                paramsObj[name] = podToJsValue(env, param);
-            }
-            props.Set("params", paramsObj);
-        } break;
-        default:
-            // Unhandled prop - silently ignore
-            break;
-        }
+    float params[EFFECT_MAX_PARAMS];
+    std::fill_n(params, EFFECT_MAX_PARAMS, NAN);
+    if (!parseEffectParams((uint32_t)type, info[2].As<Napi::Object>(), params)) {
+        Napi::TypeError::New(env, "Unknown filter shape").ThrowAsJavaScriptException();
+        return env.Undefined();
     }
+    return Napi::Boolean::New(env, chain->setParams(id, params));
 }
 
-void AudioOutputStream::onFormatChange(const spa_pod* param)
+Napi::Value AudioOutputStream::setEffectBypass(const Napi::CallbackInfo& info)
 {
-    spa_audio_info_raw audioInfo;
-    spa_format_audio_raw_parse(param, &audioInfo);
+    // setEffectBypass(target, id, bypassed)
+    auto env = info.Env();
+    uint32_t chainChannels;
+    auto chain = effectChain(info[0], chainChannels);
+    auto id = info[1].As<Napi::Number>().Uint32Value();
+    return Napi::Boolean::New(env, chain && chain->setBypassed(id, info[2].ToBoolean().Value()));
+}
 
-    auto newRate = audioInfo.rate;
-    auto newChannels = audioInfo.channels;
-    auto newFormat = audioInfo.format;
+Napi::Value AudioOutputStream::removeEffect(const Napi::CallbackInfo& info)
+{
+    // removeEffect(target, id)
+    auto env = info.Env();
+    uint32_t chainChannels;
+    auto chain = effectChain(info[0], chainChannels);
+    auto id = info[1].As<Napi::Number>().Uint32Value();
+    return Napi::Boolean::New(env, chain && chain->remove(id));
+}
 
-    uint32_t newBytesPerSample;
-    switch (newFormat) {
-    case SPA_AUDIO_FORMAT_F64:
-        newBytesPerSample = 8;
-        break;
-    case SPA_AUDIO_FORMAT_S16:
-    case SPA_AUDIO_FORMAT_U16:
-        newBytesPerSample = 2;
-        break;
-    case SPA_AUDIO_FORMAT_F32:
-    case SPA_AUDIO_FORMAT_S32:
-    case SPA_AUDIO_FORMAT_U32:
-    case SPA_AUDIO_FORMAT_S24_32:
-    default:
-        newBytesPerSample = 4;
-        break;
+Napi::Value AudioOutputStream::automateMixerInput(const Napi::CallbackInfo& info)
+{
+    // automateMixerInput(id, lane, target, frames, startFrame, curve)
+    auto env = info.Env();
+    auto id = info[0].As<Napi::Number>().Uint32Value();
+    AutomationRequest request;
+    if (!parseAutomation(info, 1, request)) {
+        Napi::TypeError::New(env, "Automation needs a gain or pan lane and a linear or exponential curve")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
     }
+    return Napi::Boolean::New(env,
+        mixer.automate(id, request.pan, request.target, request.frames, request.startFrame, request.curve));
+}
 
-    if (newRate != rate || newChannels != channels || newFormat != format || newBytesPerSample != bytesPerSample) {
-        rate = newRate;
-        channels = newChannels;
-        format = newFormat;
-        bytesPerSample = newBytesPerSample;
-        setBufferSize();
+Napi::Value AudioOutputStream::isFinished(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    if (getQueuedFrames() == 0 && mixer.isDrained()) {
+        return resolved(env.Undefined());
+    }
 
-        formatChangeCallback.NonBlockingCall([this](const Napi::Env env, Napi::Function jsCallback) {
-            auto formatObj = Napi::Object::New(env);
-            formatObj.Set("rate", Napi::Number::New(env, rate));
-            formatObj.Set("channels", Napi::Number::New(env, channels));
-            formatObj.Set("format", Napi::Number::New(env, format));
-            jsCallback.Call({ formatObj });
-        });
+    if (!finishedDeferral) {
+        finishedDeferral.emplace(env);
+        wakeups.arm(env, WAKE_FINISHED);
     }
+
+    return finishedDeferral->Promise();
 }
 
-void AudioOutputStream::onLatencyChange(const spa_pod* param)
+uint32_t AudioOutputStream::readSource(uint8_t* dest, uint32_t frames, SampleConverter& target, uint32_t destStride)
 {
-    spa_latency_info latency;
-    spa_latency_parse(param, &latency);
-    latencyCallback.NonBlockingCall([latency](const Napi::Env env, Napi::Function jsCallback) {
-        auto minimums = Napi::Object::New(env);
-        minimums.Set("nanoseconds", Napi::BigInt::New(env, latency.min_ns));
-        minimums.Set("quantum", Napi::Number::New(env, latency.min_quantum));
-        minimums.Set("rate", Napi::Number::New(env, latency.min_rate));
+    // Drains the write() ring (or the shared ring) through target into dest
+    auto inputStride = getInputBytesPerFrame();
+
+    RingSpans spans;
+    auto shared = sharedRing.isAttached();
+    auto wanted = (size_t)frames * inputStride;
+    auto totalRead = shared ? sharedRing.peek(wanted, spans) : ring.peek(wanted, spans);
+    for (auto& span : spans.parts) {
+        target.convert(span.data, dest, span.size / inputBytesPerSample);
+        dest += span.size / inputStride * destStride;
+    }
 
-        auto maximums = Napi::Object::New(env);
-        maximums.Set("nanoseconds", Napi::BigInt::New(env, latency.max_ns));
-        maximums.Set("quantum", Napi::Number::New(env, latency.max_quantum));
-        maximums.Set("rate", Napi::Number::New(env, latency.max_rate));
+    if (shared) {
+        sharedRing.skip(totalRead);
+    } else {
+        ring.skip(totalRead);
+    }
+    return totalRead / inputStride;
+}
 
-        auto latencyObj = Napi::Object::New(env);
-        latencyObj.Set("direction", latency.direction == SPA_DIRECTION_INPUT ? "input" : "output");
-        latencyObj.Set("min", minimums);
-        latencyObj.Set("max", maximums);
+uint32_t AudioOutputStream::mixBuffer(uint8_t* destBuffer, uint32_t frames, const RenderPath& path)
+{
+    // Sources are summed on a Float32 bus in chunks, then converted once
+    auto outputStride = path.bytesPerFrame;
+    auto chunkFrames = (uint32_t)(bus.size() / channels);
+    auto busStride = channels * (uint32_t)sizeof(float);
+    uint32_t producedFrames = 0;
+
+    for (uint32_t done = 0; done < frames; done += chunkFrames) {
+        auto count = std::min(frames - done, chunkFrames);
+        auto busData = bus.data();
+        auto position = renderPosition.load(std::memory_order_relaxed);
+
+        auto fromRing = readSource((uint8_t*)busData, count, path.busInput, busStride);
+        std::fill(busData + (size_t)fromRing * channels, busData + (size_t)count * channels, 0.0f);
+        auto fromMixer = mixer.mixInto(busData, count, channels, position);
+        applyAutomation(busData, count, position);
+        if (effects.hasStages()) {
+            effects.process(busData, count, channels, getSourceRate());
+        }
+        renderPosition.store(position + count, std::memory_order_relaxed);
+        producedFrames = std::max(producedFrames, done + std::max(fromRing, fromMixer));
+        if (meter.isEnabled() && meter.process(busData, count)) {
+            raisedEvents |= wakeups.notify(WAKE_LEVELS);
+        }
 
-        jsCallback.Call({ latencyObj });
-    });
+        path.busOutput.convert((const uint8_t*)busData, destBuffer + (size_t)done * outputStride, (size_t)count * channels);
+    }
+    return producedFrames;
 }
 
-void AudioOutputStream::onUnknownParamChange(uint32_t param)
+uint32_t AudioOutputStream::resampleFrames(uint8_t* destBuffer, uint32_t frames, const RenderPath& path)
 {
-    paramChangedCallback.NonBlockingCall([param](const Napi::Env env, Napi::Function jsCallback) {
-        jsCallback.Call({ Napi::Number::New(env, param) });
-    });
+    // The ring and the mixer are summed at the render rate in the resampler's
+    // input buffer, then each chunk is resampled onto the bus and converted
+    auto outputStride = path.bytesPerFrame;
+    auto chunkFrames = std::min((uint32_t)(bus.size() / channels), (uint32_t)MIX_CHUNK_FRAMES);
+    auto inputStride = channels * (uint32_t)sizeof(float);
+    auto mixing = mixer.hasInputs();
+    uint32_t producedFrames = 0;
+
+    for (uint32_t done = 0; done < frames; done += chunkFrames) {
+        auto count = std::min(frames - done, chunkFrames);
+        auto needed = path.resampler.inputFramesFor(count);
+        auto input = path.resampler.inputBuffer();
+        auto position = renderPosition.load(std::memory_order_relaxed);
+
+        auto fromSource = readSource((uint8_t*)input, needed, path.busInput, inputStride);
+        std::fill(input + (size_t)fromSource * channels, input + (size_t)needed * channels, 0.0f);
+        if (mixing) {
+            fromSource = std::max(fromSource, mixer.mixInto(input, needed, channels, position));
+        }
+        applyAutomation(input, needed, position);
+        if (effects.hasStages()) {
+            effects.process(input, needed, channels, getSourceRate());
+        }
+        renderPosition.store(position + needed, std::memory_order_relaxed);
+        path.resampler.commitInput(needed);
+        path.resampler.process(bus.data(), count);
+        if (meter.isEnabled() && meter.process(bus.data(), count)) {
+            raisedEvents |= wakeups.notify(WAKE_LEVELS);
+        }
+
+        // Count output frames in proportion to the input that was real audio
+        if (fromSource) {
+            producedFrames = done + (fromSource >= needed ? count : (uint32_t)((uint64_t)count * fromSource / needed));
+        }
+        path.busOutput.convert((const uint8_t*)bus.data(), destBuffer + (size_t)done * outputStride, (size_t)count * channels);
+    }
+    return producedFrames;
 }
 
-Napi::Value AudioOutputStream::write(const Napi::CallbackInfo& info)
+bool AudioOutputStream::isAutomated()
 {
-    auto env = info.Env();
-    if (!info[0].IsArrayBuffer()) {
-        Napi::TypeError::New(env, "First argument must be an ArrayBuffer").ThrowAsJavaScriptException();
-    }
+    // Both lanes are checked every cycle so each picks up set() promptly
+    auto gainMoved = !masterGain.isAt(1.0f);
+    auto panMoved = !masterPan.isAt(0.0f) && channels == 2;
+    return gainMoved || panMoved;
+}
 
-    auto buffer = info[0].As<Napi::ArrayBuffer>();
-    auto size = buffer.ByteLength();
+void AudioOutputStream::applyAutomation(float* frames, uint32_t count, uint64_t position)
+{
+    // Gain scales every channel; pan is a balance, and only on stereo streams
+    for (uint32_t done = 0; done < count; done += AUTOMATION_BLOCK_FRAMES) {
+        auto blockFrames = std::min<uint32_t>(count - done, AUTOMATION_BLOCK_FRAMES);
+        auto block = frames + (size_t)done * channels;
+
+        float gain, pan;
+        auto steadyGain = masterGain.process(position + done, blockFrames, automationGains, gain);
+        auto steadyPan = masterPan.process(position + done, blockFrames, automationPans, pan);
+        if (steadyGain && steadyPan && gain == 1.0f && (pan == 0.0f || channels != 2)) {
+            continue;
+        }
 
-    auto frameSize = getBytesPerFrame();
-    if (size % frameSize != 0) {
-        Napi::TypeError::New(
-            env,
-            std::format(
-                "Buffer size {} must align to frame size {} ({} x {})",
-                size,
-                frameSize,
-                bytesPerSample,
-                channels))
-            .ThrowAsJavaScriptException();
+        if (steadyGain) {
+            std::fill(automationGains, automationGains + blockFrames, gain);
+        }
+        if (channels != 2) {
+            scaleFrames(block, automationGains, blockFrames, channels);
+            continue;
+        }
+        if (steadyPan) {
+            std::fill(automationPans, automationPans + blockFrames, pan);
+        }
+        // Left gains replace the gain values and right gains the pans, in place
+        for (uint32_t i = 0; i < blockFrames; i++) {
+            auto level = automationGains[i];
+            auto balance = automationPans[i];
+            automationGains[i] = level * std::min(1.0f, 1.0f - balance);
+            automationPans[i] = level * std::min(1.0f, 1.0f + balance);
+        }
+        scaleStereo(block, automationGains, automationPans, blockFrames);
     }
+}
 
-    js_buffer newBuffer = {
-        .buffer = (uint8_t*)buffer.Data(),
-        .size = size,
+RenderPath AudioOutputStream::getRenderPath()
+{
+    return {
+        .converter = converter,
+        .busInput = busInput,
+        .busOutput = busOutput,
+        .resampler = resampler,
+        .bytesPerFrame = getBytesPerFrame(),
     };
+}
+
+uint32_t AudioOutputStream::renderFrames(uint8_t* destBuffer, uint32_t frames, const RenderPath& path)
+{
+    if (path.resampler.isActive() && bus.size() >= channels) {
+        return resampleFrames(destBuffer, frames, path);
+    }
+    if ((mixer.hasInputs() || isAutomated() || effects.hasStages() || meter.isEnabled()) && bus.size() >= channels) {
+        return mixBuffer(destBuffer, frames, path);
+    }
 
-    this->bufferRefs.push(Napi::Persistent(buffer));
-    this->buffers.push(newBuffer);
-    this->queuedFrameCount += size / frameSize;
+    // Fast path: convert straight from the ring into the output buffer
+    auto producedFrames = readSource(destBuffer, frames, path.converter, path.bytesPerFrame);
+    renderPosition.store(renderPosition.load(std::memory_order_relaxed) + frames, std::memory_order_relaxed);
 
-    return env.Undefined();
+    // We ran out of source data; fill the rest with silence
+    if (producedFrames < frames) {
+        path.converter.silence(destBuffer + (size_t)producedFrames * path.bytesPerFrame, (frames - producedFrames) * channels);
+    }
+    return producedFrames;
 }
 
-Napi::Value AudioOutputStream::waitForBuffer(const Napi::CallbackInfo& info)
+uint32_t AudioOutputStream::fillBuffer(uint8_t* destBuffer, uint32_t frames)
 {
-    auto env = info.Env();
-    auto availableFrames = (long)frameBufferSize - queuedFrameCount;
+    // Runs on the RT thread: no allocation, no locks, no N-API objects
+    auto renderStart = renderPosition.load(std::memory_order_relaxed);
+    auto producedFrames = renderFrames(destBuffer, frames, getRenderPath());
+    sampleClock(renderStart);
+    raiseWakeups(producedFrames);
+    return producedFrames;
+}
 
-    if (availableFrames > 0) {
-        return resolved(Napi::Number::New(env, availableFrames));
+uint32_t AudioOutputStream::fillPlanes(spa_data* datas, uint32_t frames)
+{
+    // Runs on the RT thread. Each chunk is rendered interleaved into scratch,
+    // then split into the per-channel planes
+    auto frameSize = getBytesPerFrame();
+    auto chunkFrames = (uint32_t)(planarScratch.size() / frameSize);
+    uint8_t* planes[SPA_AUDIO_MAX_CHANNELS];
+    uint32_t producedFrames = 0;
+    auto renderStart = renderPosition.load(std::memory_order_relaxed);
+    auto path = getRenderPath();
+
+    if (!chunkFrames) {
+        // Negotiated more channels than the scratch was sized for
+        for (uint32_t channel = 0; channel < channels; channel++) {
+            memset(datas[channel].data, 0, (size_t)frames * bytesPerSample);
+        }
+        frames = 0;
     }
 
-    if (!readyDeferral) {
-        // Release any existing readySignal before creating a new one
-        if (readySignal) {
-            readySignal.Release();
-            readySignal = nullptr;
+    for (uint32_t done = 0; done < frames; done += chunkFrames) {
+        auto count = std::min(frames - done, chunkFrames);
+        auto fromSource = renderFrames(planarScratch.data(), count, path);
+        if (fromSource) {
+            producedFrames = done + fromSource;
         }
 
-        readyDeferral = new Napi::Promise::Deferred(env);
-        readySignal = Napi::ThreadSafeFunction::New(
-            env,
-            Napi::Function::New(env, [this](const Napi::CallbackInfo& info) {
-                auto env = info.Env();
-                auto availableFrames = (long)frameBufferSize - queuedFrameCount;
-                if (availableFrames > 0) {
-                    readyDeferral->Resolve(Napi::Number::New(env, availableFrames));
-                    delete readyDeferral;
-                    readyDeferral = NULL;
-                }
-            }),
-            "PipeWireStream::readySignal", 0, 1, readyDeferral);
+        for (uint32_t channel = 0; channel < channels; channel++) {
+            planes[channel] = (uint8_t*)datas[channel].data + (size_t)done * bytesPerSample;
+        }
+        deinterleave(planarScratch.data(), planes, channels, bytesPerSample, count);
     }
 
-    return readyDeferral->Promise();
+    sampleClock(renderStart);
+    raiseWakeups(producedFrames);
+    return producedFrames;
 }
 
-Napi::Value AudioOutputStream::isFinished(const Napi::CallbackInfo& info)
+void AudioOutputStream::sampleClock(uint64_t renderStart)
 {
-    auto env = info.Env();
-    if (this->queuedFrameCount == 0) {
-        return resolved(env.Undefined());
+    // PipeWire updates its time values before calling process, so these
+    // describe the cycle that was just rendered
+    pw_time time;
+    if (pw_stream_get_time_n(stream, &time, sizeof(time)) < 0) {
+        return;
     }
+    clock.publish({
+        .nowNs = time.now,
+        .rateNum = time.rate.num,
+        .rateDenom = time.rate.denom,
+        .ticks = time.ticks,
+        .delay = time.delay,
+        .buffered = time.buffered,
+        .queued = time.queued,
+        .renderStart = renderStart,
+    });
+}
 
-    if (!this->finishedDeferral) {
-        this->finishedDeferral = new Napi::Promise::Deferred(env);
-        this->finishedSignal = Napi::ThreadSafeFunction::New(
-            env,
-            Napi::Function::New(env, [this](const Napi::CallbackInfo& info) {
-                auto env = info.Env();
-                this->finishedDeferral->Resolve(env.Undefined());
-                delete this->finishedDeferral;
-                this->finishedDeferral = NULL;
-            }),
-            "PipeWireStream::finishedSignal", 0, 1, this->finishedDeferral);
+void AudioOutputStream::raiseWakeups(uint32_t producedFrames)
+{
+    // Raised events coalesce into a single JS wakeup until it is handled
+    auto mixing = mixer.hasInputs() && bus.size() >= channels;
+    uint32_t events = 0;
+    if (wakeups.isArmed(WAKE_BUFFER) && getAvailableFrames() >= getWakeFrames()) {
+        // Time from the first unanswered wakeup
+        int64_t unset = 0;
+        readySignalledAt.compare_exchange_strong(unset, steadyNanos(), std::memory_order_relaxed);
+        events |= WAKE_BUFFER;
+    }
+    if (mixing) {
+        events |= WAKE_MIXER;
+    }
+    // Not only while mixing: the last voice to end leaves no inputs behind
+    if (mixer.takeEndedInputs()) {
+        events |= WAKE_INPUT_ENDED;
+    }
+    if (!producedFrames) {
+        events |= WAKE_FINISHED;
+    }
+    raisedEvents |= wakeups.notify(events);
+}
+
+void AudioOutputStream::adaptBufferSize(bool underran, bool clean, uint32_t frames)
+{
+    // Runs on the RT thread after each cycle
+    if (!adaptiveBuffer.isEnabled()) {
+        return;
+    }
+
+    uint32_t current = frameBufferSize;
+    auto next = adaptiveBuffer.update(current, underran, clean, frames);
+    if (next == current) {
+        return;
     }
 
-    return this->finishedDeferral->Promise();
+    // Several adjustments before JS runs are reported as one
+    uint32_t unset = 0;
+    adjustedFromFrames.compare_exchange_strong(unset, current, std::memory_order_acq_rel);
+    adjustReason.store(next > current ? ADAPT_GROWN : ADAPT_SHRUNK, std::memory_order_relaxed);
+    frameBufferSize = next;
+    wakeups.notify(WAKE_BUFFER_ADJUSTED);
 }
 
-void AudioOutputStream::fillBuffer(uint8_t* destBuffer, uint size)
+void AudioOutputStream::trackQuantum(uint32_t requested)
 {
-    auto remainingBytes = size;
-    uint destOffset = 0;
-    uint totalWritten = 0;
-    auto stride = getBytesPerFrame();
-    while (remainingBytes > 0 && buffers.size()) {
-        auto sourceJsBuffer = buffers.front();
-        auto sourceTotalBytes = sourceJsBuffer.size;
-        auto sourceRemaining = sourceTotalBytes - currentBufferOffset;
-        auto amtToCopy = remainingBytes > sourceRemaining ? sourceRemaining : remainingBytes;
-        memcpy(
-            destBuffer + destOffset,
-            sourceJsBuffer.buffer + currentBufferOffset,
-            amtToCopy);
-        totalWritten += amtToCopy;
-        remainingBytes -= amtToCopy;
-        currentBufferOffset += amtToCopy;
-        destOffset += amtToCopy;
-        queuedFrameCount -= amtToCopy / stride;
-        if (currentBufferOffset >= sourceTotalBytes) {
-            buffers.pop();
-            bufferRefs.pop();
-            currentBufferOffset = 0;
+    // Runs on the RT thread at the start of each cycle. A rate-matched stream
+    // is asked for its own number of frames, which differs from the graph's
+    uint32_t quantum = 0;
+    uint32_t clockRate = graphRate.load(std::memory_order_relaxed);
+    auto rateMatch = ioRateMatch.load(std::memory_order_acquire);
+    if (rateMatch && (rateMatch->flags & SPA_IO_RATE_MATCH_FLAG_ACTIVE)) {
+        quantum = rateMatch->size;
+    }
+    if (auto position = ioPosition.load(std::memory_order_acquire)) {
+        if (!quantum) {
+            quantum = static_cast<uint32_t>(position->clock.duration);
+        }
+        if (position->clock.rate.denom) {
+            clockRate = position->clock.rate.denom;
         }
     }
-
-    // We ran out of source data; zero-fill the rest
-    if (remainingBytes) {
-        memset(destBuffer + destOffset, 0, remainingBytes);
+    if (!quantum) {
+        quantum = requested;
     }
 
-    if (queuedFrameCount < frameBufferSize && readyDeferral) {
-        this->readySignal.NonBlockingCall();
-        // Don't release here - let _destroy() handle it to avoid double-free
+    if (!quantum
+        || (quantum == framesPerQuantum.load(std::memory_order_relaxed)
+            && clockRate == graphRate.load(std::memory_order_relaxed))) {
+        return;
     }
+    framesPerQuantum.store(quantum, std::memory_order_relaxed);
+    graphRate.store(clockRate, std::memory_order_relaxed);
+    wakeups.notify(WAKE_QUANTUM_CHANGED);
+}
 
-    if (!totalWritten && finishedDeferral) {
-        this->finishedSignal.NonBlockingCall();
-        // Don't release here - let _destroy() handle it to avoid double-free
+void AudioOutputStream::onIoChange(uint32_t id, void* area, uint32_t size)
+{
+    // Runs on the loop thread; a null area means the IO is going away
+    switch (id) {
+    case SPA_IO_Position:
+        ioPosition.store(area && size >= sizeof(spa_io_position) ? (spa_io_position*)area : nullptr,
+            std::memory_order_release);
+        break;
+    case SPA_IO_RateMatch:
+        ioRateMatch.store(area && size >= sizeof(spa_io_rate_match) ? (spa_io_rate_match*)area : nullptr,
+            std::memory_order_release);
+        break;
     }
 }
 
-Napi::Value AudioOutputStream::destroy(const Napi::CallbackInfo& info)
+void AudioOutputStream::captureBuffer(const uint8_t* sourceBuffer, uint32_t frames)
 {
-    auto env = info.Env();
+    // Runs on the RT thread: no allocation, no locks, no N-API objects
+    auto captureStride = getBytesPerFrame();
+    auto ringStride = getInputBytesPerFrame();
+
+    RingSpans spans = {};
+    size_t reserved = 0;
+    if (SampleConverter::isInputFormat(format)) {
+        reserved = ring.reserve((size_t)frames * ringStride, ring.capacity(), spans);
+    }
 
-    // Reject any pending promises first
-    if (this->readyDeferral) {
-        this->readyDeferral->Reject(Napi::Error::New(env, "Stream destroyed").Value());
-        delete this->readyDeferral;
-        this->readyDeferral = NULL;
+    auto source = sourceBuffer;
+    for (auto& span : spans.parts) {
+        converter.convert(source, span.data, span.size / inputBytesPerSample);
+        source += span.size / ringStride * captureStride;
     }
+    ring.commit(reserved);
 
-    if (this->finishedDeferral) {
-        this->finishedDeferral->Reject(Napi::Error::New(env, "Stream destroyed").Value());
-        delete this->finishedDeferral;
-        this->finishedDeferral = NULL;
+    // JS fell behind; the newest audio is dropped rather than blocking the graph
+    auto capturedFrames = reserved / ringStride;
+    if (capturedFrames < frames) {
+        droppedFrames.fetch_add(frames - capturedFrames, std::memory_order_relaxed);
     }
 
-    if (this->disconnectDeferral) {
-        this->disconnectDeferral->Reject(Napi::Error::New(env, "Stream destroyed").Value());
-        delete this->disconnectDeferral;
-        this->disconnectDeferral = NULL;
+    if (wakeups.isArmed(WAKE_DATA) && getQueuedFrames() >= wantedFrames.load(std::memory_order_relaxed)) {
+        wakeups.notify(WAKE_DATA);
     }
+}
+
+Napi::Value AudioOutputStream::destroy(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
 
-    // Unref the props object
-    if (props) {
-        props.Unref();
+    // Reject any pending promises first
+    wakeups.disarm(env, WAKE_BUFFER | WAKE_DATA | WAKE_MIXER | WAKE_FINISHED | WAKE_DISCONNECTED);
+    for (auto deferral : { &dataDeferral, &mixerDeferral, &finishedDeferral, &disconnectDeferral }) {
+        if (*deferral) {
+            (*deferral)->Reject(Napi::Error::New(env, "Stream destroyed").Value());
+            deferral->reset();
+        }
     }
+    for (auto& waiter : bufferWaiters) {
+        waiter.deferral.Reject(Napi::Error::New(env, "Stream destroyed").Value());
+    }
+    bufferWaiters.clear();
+    publishWakeFrames();
+
+    bufferAdjustedCallback.Reset();
+    propsChangeCallback.Reset();
+    quantumChangeCallback.Reset();
+    levelsCallback.Reset();
+    inputEndedCallback.Reset();
+    offlineCancelled.store(true, std::memory_order_relaxed);
 
     return async(
         env,
         [this]() {
-            session->withThreadLock([this]() {
-                if (stream) {
-                    auto state = pw_stream_get_state(stream, nullptr);
-                    // Only disconnect if not already unconnected
-                    if (state != PW_STREAM_STATE_UNCONNECTED && state != PW_STREAM_STATE_ERROR) {
-                        pw_stream_disconnect(stream);
+            if (loop) {
+                loop->withThreadLock([this]() {
+                    if (stream) {
+                        auto state = pw_stream_get_state(stream, nullptr);
+                        // Only disconnect if not already unconnected
+                        if (state != PW_STREAM_STATE_UNCONNECTED && state != PW_STREAM_STATE_ERROR) {
+                            pw_stream_disconnect(stream);
+                        }
                     }
-                }
-            });
+                });
+            }
+            // A cancelled offline render stops within one chunk; it raises
+            // wakeups, so the channel must outlive it
+            offlineWorking.wait(true, std::memory_order_acquire);
             _destroy(); // This now handles callback cleanup too
         },
         [env]() {
@@ -850,10 +3043,6 @@ void AudioOutputStream::_destroy()
         paramChangedCallback.Release();
         paramChangedCallback = nullptr;
     }
-    if (propsCallback) {
-        propsCallback.Release();
-        propsCallback = nullptr;
-    }
     if (latencyCallback) {
         latencyCallback.Release();
         latencyCallback = nullptr;
@@ -862,31 +3051,30 @@ void AudioOutputStream::_destroy()
         formatChangeCallback.Release();
         formatChangeCallback = nullptr;
     }
-    if (readySignal) {
-        readySignal.Release();
-        readySignal = nullptr;
-    }
-    if (finishedSignal) {
-        finishedSignal.Release();
-        finishedSignal = nullptr;
-    }
-    if (disconnectSignal) {
-        disconnectSignal.Release();
-        disconnectSignal = nullptr;
-    }
 
-    if (session) {
-        session->withThreadLock([this]() {
+    if (loop) {
+        loop->withThreadLock([this]() {
             if (stream) {
                 pw_stream_destroy(stream);
                 stream = NULL;
             }
         });
+        session->releaseLoop(loop);
+        loop = NULL;
     } else if (stream) {
         // Session is null but stream still exists - clean up directly
         pw_stream_destroy(stream);
         stream = NULL;
     }
+
+    if (pendingProperties) {
+        // Prepared but never created
+        pw_properties_free(pendingProperties);
+        pendingProperties = NULL;
+    }
+
+    // Only now is the RT thread guaranteed to be done raising wakeups
+    wakeups.close();
 }
 
 AudioOutputStream::~AudioOutputStream()
@@ -942,13 +3130,22 @@ void onParamChange(void* userData, uint32_t id, const struct spa_pod* param)
     }
 }
 
+void onIoChange(void* userData, uint32_t id, void* area, uint32_t size)
+{
+    auto stream = (AudioOutputStream*)userData;
+    stream->onIoChange(id, area, size);
+}
+
 void onProcess(void* userData)
 {
     auto stream = (AudioOutputStream*)userData;
     auto pwStream = stream->getStream();
+    auto& stats = stream->getStreamStats();
+    auto started = steadyNanos();
 
     auto pwBuffer = pw_stream_dequeue_buffer(pwStream);
     if (!pwBuffer) {
+        stats.recordDequeueFailure();
         pw_log_warn("out of buffers: %m");
         return;
     }
@@ -956,23 +3153,90 @@ void onProcess(void* userData)
     auto spaData = pwBuffer->buffer->datas[0];
     auto memoryPtr = (double*)spaData.data;
     if (!memoryPtr) {
+        pwBuffer->size = 0;
+        pw_stream_queue_buffer(pwStream, pwBuffer);
         return;
     }
 
+    auto requested = pwBuffer->requested; // The buffer is PipeWire's again once queued
+    stream->trackQuantum(requested);
+
     auto stride = stream->getBytesPerFrame();
-    auto numFrames = spaData.maxsize / stride;
-    if (pwBuffer->requested < numFrames) {
-        numFrames = pwBuffer->requested;
-    }
-    auto byteCount = numFrames * stride;
+    uint32_t numFrames;
+    uint32_t producedFrames;
+    bool underran = false;
+    if (stream->isPlanar() && !stream->isCapture()) {
+        // One spa_data per channel, each holding one sample per frame
+        auto buffer = pwBuffer->buffer;
+        auto channels = stream->getChannels();
+        auto sampleSize = stride / std::max(1u, channels);
+        numFrames = UINT32_MAX;
+        for (uint32_t channel = 0; channel < channels; channel++) {
+            numFrames = channel < buffer->n_datas && buffer->datas[channel].data
+                ? std::min(numFrames, buffer->datas[channel].maxsize / sampleSize)
+                : 0;
+        }
+        if (!channels || channels > SPA_AUDIO_MAX_CHANNELS || !numFrames) {
+            pwBuffer->size = 0;
+            pw_stream_queue_buffer(pwStream, pwBuffer);
+            return;
+        }
+        if (pwBuffer->requested && pwBuffer->requested < numFrames) {
+            numFrames = pwBuffer->requested;
+        }
 
-    stream->fillBuffer((uint8_t*)spaData.data, byteCount);
+        producedFrames = stream->fillPlanes(buffer->datas, numFrames);
+        underran = stats.recordCycle(pwBuffer->requested, numFrames, producedFrames);
+        stream->adaptBufferSize(underran, producedFrames == numFrames, numFrames);
 
-    spaData.chunk->offset = 0;
-    spaData.chunk->stride = stride;
-    spaData.chunk->size = byteCount;
+        for (uint32_t channel = 0; channel < channels; channel++) {
+            auto chunk = buffer->datas[channel].chunk;
+            chunk->offset = 0;
+            chunk->stride = sampleSize;
+            chunk->size = numFrames * sampleSize;
+        }
+
+        pwBuffer->size = numFrames; // Summed into pw_time.queued
+        pw_stream_queue_buffer(pwStream, pwBuffer);
+    } else if (stream->isCapture()) {
+        auto offset = std::min(spaData.chunk->offset, spaData.maxsize);
+        auto size = std::min(spaData.chunk->size, spaData.maxsize - offset);
+        numFrames = size / stride;
+        producedFrames = numFrames;
+        stream->captureBuffer((const uint8_t*)spaData.data + offset, numFrames);
+        pw_stream_queue_buffer(pwStream, pwBuffer);
+    } else {
+        // requested is 0 when the driver doesn't say; fill the whole buffer then
+        numFrames = spaData.maxsize / stride;
+        if (pwBuffer->requested && pwBuffer->requested < numFrames) {
+            numFrames = pwBuffer->requested;
+        }
+        auto byteCount = numFrames * stride;
+
+        producedFrames = stream->fillBuffer((uint8_t*)spaData.data, numFrames);
+        underran = stats.recordCycle(pwBuffer->requested, numFrames, producedFrames);
+        stream->adaptBufferSize(underran, producedFrames == numFrames, numFrames);
+
+        spaData.chunk->offset = 0;
+        spaData.chunk->stride = stride;
+        spaData.chunk->size = byteCount;
+
+        pwBuffer->size = numFrames; // Summed into pw_time.queued
+        pw_stream_queue_buffer(pwStream, pwBuffer);
+    }
 
-    pw_stream_queue_buffer(pwStream, pwBuffer);
+    // The callback overran if it took longer than the audio it moved lasts
+    auto rate = stream->getRate();
+    auto budgetNs = rate ? (uint64_t)numFrames * 1000000000 / rate : 0;
+    auto durationNs = (uint64_t)(steadyNanos() - started);
+    stats.recordDuration(durationNs, budgetNs);
+    stream->traceCycle(
+        started,
+        durationNs,
+        requested,
+        numFrames,
+        producedFrames,
+        (underran ? TRACE_UNDERRUN : 0) | (budgetNs && durationNs > budgetNs ? TRACE_SLOW : 0));
 }
 
 std::vector<uint32_t> AudioOutputStream::parsePreferredRates(const Napi::Object& options)
@@ -1,25 +1,85 @@
 #ifndef PIPEWIRE_STREAM_HPP
 #define PIPEWIRE_STREAM_HPP
 
+#include <atomic>
 #include <napi.h>
+#include <optional>
 #include <pipewire/pipewire.h>
 #include <pipewire/thread-loop.h>
-#include <queue>
+#include <spa/node/io.h>
 #include <spa/param/audio/raw.h>
 #include <spa/param/latency.h>
 #include <vector>
 
+#include "adaptive-buffer.hpp"
+#include "automation.hpp"
+#include "effect-chain.hpp"
+#include "file-sink.hpp"
+#include "level-meter.hpp"
+#include "mixer.hpp"
+#include "planar.hpp"
+#include "resampler.hpp"
+#include "ring-buffer.hpp"
+#include "sample-convert.hpp"
 #include "session.hpp"
+#include "shared-ring.hpp"
+#include "stream-clock.hpp"
+#include "stream-props.hpp"
+#include "stream-stats.hpp"
+#include "trace-ring.hpp"
+#include "wakeup-channel.hpp"
 
-struct js_buffer {
-    uint8_t* buffer;
+// Bytes handed to write(), tagged with the sample format they hold
+struct SampleView {
+    const uint8_t* data;
     size_t size;
+    spa_audio_format format;
+};
+
+// What connect() negotiates with, parsed on the JS thread so the connect
+// itself can run under a loop lock on a worker
+struct ConnectRequest {
+    std::vector<spa_audio_format> preferredFormats;
+    std::vector<uint32_t> preferredRates;
+};
+
+// A pending waitForBuffer(); callers asking for the same minFrames share one
+struct BufferWaiter {
+    uint32_t minFrames; // 0 for the watermark or quantum default
+    Napi::Promise::Deferred deferral;
+};
+
+// A format PipeWire settled on, handed from the loop thread to the data loop
+struct NegotiatedFormat {
+    uint32_t rate;
+    spa_audio_format format;
+    uint32_t bytesPerSample;
+};
+
+// What rendering converts through. The RT thread uses the stream's
+// negotiated converters; an offline render passes its own.
+struct RenderPath {
+    SampleConverter& converter; // Ring -> output format, when nothing is mixed
+    SampleConverter& busInput; // Ring -> Float32 bus
+    SampleConverter& busOutput; // Bus -> output format
+    Resampler& resampler; // Render rate -> output rate
+    uint32_t bytesPerFrame; // In the output format
+};
+
+// An offline render's output, set up on the JS thread and kept apart from
+// the format the graph negotiated
+struct OfflineRender {
+    uint32_t rate;
+    spa_audio_format format;
+    SampleConverter converter;
+    SampleConverter busInput;
+    SampleConverter busOutput;
+    Resampler resampler;
 };
 
 class AudioOutputStream : public Napi::ObjectWrap<AudioOutputStream> {
 
 public:
-    static Napi::FunctionReference constructor;
     static Napi::Function init(Napi::Env env);
 
     AudioOutputStream(const Napi::CallbackInfo& info);
@@ -30,75 +90,280 @@ public:
     Napi::Value disconnect(const Napi::CallbackInfo& info);
     Napi::Value getWritableFrames(const Napi::CallbackInfo& info);
     Napi::Value getFramesPerQuantum(const Napi::CallbackInfo& info);
+    Napi::Value getRenderPosition(const Napi::CallbackInfo& info);
+    Napi::Value getTiming(const Napi::CallbackInfo& info);
     Napi::Value getBufferSize(const Napi::CallbackInfo& info);
     Napi::Value waitForBuffer(const Napi::CallbackInfo& info);
     Napi::Value isFinished(const Napi::CallbackInfo& info);
     Napi::Value write(const Napi::CallbackInfo& info);
+    Napi::Value writePlanar(const Napi::CallbackInfo& info);
+    Napi::Value acquireBuffer(const Napi::CallbackInfo& info);
+    Napi::Value commit(const Napi::CallbackInfo& info);
+    Napi::Value read(const Napi::CallbackInfo& info);
+    Napi::Value waitForData(const Napi::CallbackInfo& info);
+    Napi::Value getReadableFrames(const Napi::CallbackInfo& info);
+    Napi::Value getDroppedFrames(const Napi::CallbackInfo& info);
+    Napi::Value getStats(const Napi::CallbackInfo& info);
+    Napi::Value readTrace(const Napi::CallbackInfo& info);
+    Napi::Value traceGc(const Napi::CallbackInfo& info);
+    Napi::Value getLevels(const Napi::CallbackInfo& info);
+    Napi::Value getProps(const Napi::CallbackInfo& info);
+    Napi::Value setControls(const Napi::CallbackInfo& info);
+    Napi::Value setActive(const Napi::CallbackInfo& info);
+    Napi::Value addMixerInput(const Napi::CallbackInfo& info);
+    Napi::Value removeMixerInput(const Napi::CallbackInfo& info);
+    Napi::Value setMixerInputLevels(const Napi::CallbackInfo& info);
+    Napi::Value writeMixerInput(const Napi::CallbackInfo& info);
+    Napi::Value getMixerInputFrames(const Napi::CallbackInfo& info);
+    Napi::Value waitForMixerSpace(const Napi::CallbackInfo& info);
+    Napi::Value addGenerator(const Napi::CallbackInfo& info);
+    Napi::Value setGeneratorParams(const Napi::CallbackInfo& info);
+    Napi::Value playFile(const Napi::CallbackInfo& info);
+    Napi::Value getFileState(const Napi::CallbackInfo& info);
+    Napi::Value setFileLooping(const Napi::CallbackInfo& info);
+    Napi::Value scheduleClip(const Napi::CallbackInfo& info);
+    Napi::Value hasMixerInputEnded(const Napi::CallbackInfo& info);
+    Napi::Value triggerSample(const Napi::CallbackInfo& info);
+    Napi::Value renderOffline(const Napi::CallbackInfo& info);
+    Napi::Value automate(const Napi::CallbackInfo& info);
+    Napi::Value automateMixerInput(const Napi::CallbackInfo& info);
+    Napi::Value resetAutomation(const Napi::CallbackInfo& info);
+    Napi::Value insertEffect(const Napi::CallbackInfo& info);
+    Napi::Value setEffectParams(const Napi::CallbackInfo& info);
+    Napi::Value setEffectBypass(const Napi::CallbackInfo& info);
+    Napi::Value removeEffect(const Napi::CallbackInfo& info);
     Napi::Value destroy(const Napi::CallbackInfo& info);
 
     Napi::Promise create(PipeWireSession* session, const Napi::Object& options);
+    // JS thread; validates the options and places the stream on a loop, or
+    // returns the error create() would reject with
+    std::optional<Napi::Error> prepare(PipeWireSession* session, const Napi::Object& options);
+    void open(uint32_t framesPerQuantum); // Worker thread, after prepare()
+    void initStream(); // Loop lock held, after open()
+    SessionLoop* getSessionLoop();
+    std::optional<Napi::Error> prepareConnect(const Napi::Object& options, ConnectRequest& request);
+    void connectLocked(const ConnectRequest& request); // Loop lock held
+    void _destroy();
     void initCallbacks(Napi::Env& env, const Napi::Object& options);
     pw_stream* getStream();
     uint32_t getRate();
+    uint32_t getSourceRate(); // Rate of the frames in the ring
     uint32_t getChannels();
     uint32_t getBytesPerFrame();
+    uint32_t getInputBytesPerFrame();
 
     void onStateChange(pw_stream_state state, const char* error);
     void onPropsChange(const spa_pod* param);
     void onFormatChange(const spa_pod* param);
+    void applyFormat(const NegotiatedFormat& negotiated); // Data thread, between cycles
     void onLatencyChange(const spa_pod* param);
     void onUnknownParamChange(uint32_t param);
+    void onIoChange(uint32_t id, void* area, uint32_t size);
 
-    void fillBuffer(uint8_t* buffer, uint count);
+    bool isCapture();
+    bool isPlanar();
+    StreamStats& getStreamStats();
+    uint32_t fillBuffer(uint8_t* buffer, uint32_t frames); // Returns frames taken from JS
+    uint32_t fillPlanes(spa_data* datas, uint32_t frames); // One spa_data per channel
+    void adaptBufferSize(bool underran, bool clean, uint32_t frames);
+    void trackQuantum(uint32_t requested);
+    void captureBuffer(const uint8_t* buffer, uint32_t frames);
+    void traceCycle(int64_t startedNs, uint64_t durationNs, uint32_t requested, uint32_t delivered, uint32_t produced, uint32_t flags);
 
 private:
     PipeWireSession* session;
+    SessionLoop* loop; // The session loop this stream was placed on
     pw_stream* stream;
+    pw_direction direction;
     spa_audio_format format;
     uint32_t bytesPerSample;
     uint32_t rate;
     uint32_t channels;
 
-    uint frameBufferSize;
-    uint queuedFrameCount;
+    // Samples arrive from JS as Float32 or Float64 and are converted to the
+    // negotiated format on the RT thread; capture streams convert the other way
+    spa_audio_format inputFormat;
+    uint32_t inputBytesPerSample;
+    bool dither;
+    SampleConverter converter;
+    SampleConverter writeConverter; // JS thread only
+
+    std::atomic<uint32_t> frameBufferSize;
 
     // Buffer sizing - track both requested bytes and quantum-based sizing
     uint32_t requestedBufferSizeBytes; // User-requested buffer size in bytes (0 if not specified)
     uint32_t requestedBufferedQuanta; // Quantum multiplier for buffer calculation
     double requestedLatencyMs; // User-requested latency in milliseconds (0.0 if not specified)
 
-    uint32_t framesPerQuantum;
-    std::queue<Napi::Reference<Napi::ArrayBuffer>> bufferRefs;
-    std::queue<js_buffer> buffers;
-    uint currentBufferOffset;
+    // BufferStrategy.Adaptive: frameBufferSize moves between these latencies
+    // on the RT thread; 0.0 when the buffer is static
+    double adaptiveMinLatencyMs;
+    double adaptiveMaxLatencyMs;
+    AdaptiveBuffer adaptiveBuffer;
+    std::atomic<uint32_t> adjustedFromFrames; // Size before the first unreported adjustment
+    std::atomic<uint32_t> adjustReason;
+    Napi::FunctionReference bufferAdjustedCallback;
+
+    // Frames per graph cycle and the graph rate. Seeded from the session's
+    // clock.quantum, then tracked from the IO areas on every cycle, so JS
+    // reads them without the loop lock.
+    std::atomic<uint32_t> framesPerQuantum;
+    std::atomic<uint32_t> graphRate;
+    std::atomic<spa_io_position*> ioPosition; // Set on the loop thread by io_changed
+    std::atomic<spa_io_rate_match*> ioRateMatch;
+    Napi::FunctionReference quantumChangeCallback;
+
+    // Fractions of the buffer: write() fills up to the high watermark, and a
+    // waiting writer is woken once the queue has drained to the low one.
+    // A negative low watermark means "wake as soon as a quantum is free".
+    double lowWatermark = -1.0;
+    double highWatermark = 1.0;
+
+    // Written by write() on the JS thread, drained by fillBuffer() on the RT thread.
+    // Capture streams swap the roles: captureBuffer() writes, read() drains.
+    RingBuffer ring;
+    std::atomic<uint64_t> droppedFrames; // Captured frames lost to a full ring
+
+    // acquireBuffer() hands out views of the ring itself, each backed by an
+    // external ArrayBuffer over just the acquired span; commit() then
+    // publishes them without a copy
+    uint8_t* acquiredAt = nullptr;
+    size_t acquiredBytes = 0;
+
+    // Mixer inputs are summed with the ring on a Float32 bus before the
+    // final conversion; the bus is only used while the mixer has inputs
+    Mixer mixer;
+    std::vector<float> bus;
+    SampleConverter busInput; // Ring input format -> bus
+    SampleConverter busOutput; // Bus -> negotiated format
+
+    // Planar formats are rendered interleaved here, then split into planes
+    std::vector<uint8_t> planarScratch;
+
+    // Frames rendered so far at the render rate: the timeline automation is
+    // scheduled on. Only the RT thread advances it.
+    std::atomic<uint64_t> renderPosition { 0 };
+
+    // PipeWire's time values as of the last playback cycle
+    StreamClock clock;
+
+    // Stream-wide gain and balance ramps. While either is away from unity
+    // the fast path is skipped so they can be applied on the bus.
+    AutomationLane masterGain { 1.0f };
+    AutomationLane masterPan { 0.0f };
+    float automationGains[AUTOMATION_BLOCK_FRAMES]; // RT thread only
+    float automationPans[AUTOMATION_BLOCK_FRAMES];
+
+    // Effects run on the bus after automation and before metering, at the
+    // render rate; while any are inserted the fast path is skipped too
+    EffectChain effects;
+
+    // With a fixed render rate, JS always writes at renderRate and the RT
+    // thread resamples (ring and mixer together) to the negotiated rate.
+    // 0 when JS renders at whatever rate is negotiated.
+    uint32_t renderRate = 0;
+    uint32_t resampleQuality = RESAMPLE_BALANCED;
+    Resampler resampler;
+
+    // Peak/RMS meters over the bus just before the final conversion; a
+    // metered stream always renders through the bus. 0 updates per second
+    // when metering is off
+    double meterUpdatesPerSecond = 0.0;
+    bool meterTruePeak = false;
+    LevelMeter meter;
+    Napi::FunctionReference levelsCallback;
+    Napi::FunctionReference inputEndedCallback;
+
+    // Replaces the ring when a JS worker renders into a SharedArrayBuffer
+    SharedRing sharedRing;
+    Napi::Reference<Napi::Uint8Array> sharedRingRef;
+
+    StreamStats stats; // Updated by the RT thread on every process callback
+
+    // Opt-in log of individual cycles, writes and wakeups
+    TraceRing trace;
+    uint32_t raisedEvents = 0; // RT thread only: what the last cycle woke JS for
+    bool dataThreadConfigured = false; // Loop thread only: loop settings applied
+    std::atomic<bool> realtime = false; // Whether the data thread got the loop's rtPriority
 
     Napi::ThreadSafeFunction stateChangedCallback;
     Napi::ThreadSafeFunction paramChangedCallback;
     Napi::ThreadSafeFunction formatChangeCallback;
     Napi::ThreadSafeFunction latencyCallback;
 
-    Napi::ObjectReference props;
-    Napi::ThreadSafeFunction propsCallback;
+    // The last format PipeWire settled on; loop thread. A reconnect offers it
+    // first, so an unchanged graph accepts it without another round of
+    // negotiation.
+    std::optional<spa_audio_info_raw> cachedFormat;
 
-    Napi::Promise::Deferred* readyDeferral;
-    Napi::ThreadSafeFunction readySignal;
+    // Merged on the loop thread, materialized for JS only when read
+    StreamProps streamProps;
+    Napi::FunctionReference propsChangeCallback;
 
-    Napi::Promise::Deferred* finishedDeferral;
-    Napi::ThreadSafeFunction finishedSignal;
+    // Every wait shares one coalescing wakeup; a promise per kind of wait is
+    // handed to all callers until the RT thread satisfies it, except that
+    // buffer waits get one per minFrames
+    WakeupChannel wakeups;
+    std::vector<BufferWaiter> bufferWaiters; // JS thread only; each resolves at its own minFrames
+    std::atomic<int64_t> readySignalledAt; // steady_clock ns of the first unanswered wakeup
+    // What the least demanding pending waitForBuffer() asked for: the
+    // smallest explicit minFrames (0 when none did) and whether any caller
+    // wants the default
+    std::atomic<uint32_t> wantedSpace;
+    std::atomic<bool> defaultSpaceWanted;
+    std::optional<Napi::Promise::Deferred> dataDeferral;
+    std::atomic<uint32_t> wantedFrames;
+    std::optional<Napi::Promise::Deferred> mixerDeferral;
+    std::optional<Napi::Promise::Deferred> finishedDeferral;
+    std::optional<Napi::Promise::Deferred> disconnectDeferral;
 
-    Napi::Promise::Deferred* disconnectDeferral;
-    Napi::ThreadSafeFunction disconnectSignal;
+    // An offline render drives the render path from a worker thread in place
+    // of the RT thread, so it only runs while the stream is unconnected
+    std::atomic<bool> renderingOffline { false }; // Until the JS completion runs
+    std::atomic<bool> offlineWorking { false }; // Until the worker stops rendering
+    std::atomic<bool> offlineCancelled { false };
 
     bool destroyed = false;
+    std::string pendingName; // Held from prepare() until initStream()
+    pw_properties* pendingProperties = NULL;
 
     void initCallbacks(const Napi::Object& options);
-    void initStream(std::string name, pw_properties* properties);
+    void onWakeup(Napi::Env env, uint32_t events);
+    void settle(std::optional<Napi::Promise::Deferred>& deferral, Napi::Value value);
 
+    pw_loop* getDataLoop(); // Loop thread; where process runs, NULL before connect()
+    void configureDataThread(); // Loop thread, once the data loop runs
+    void configureConverter();
+    void configureMeter();
+    void allocateRing(); // Size the ring for the largest buffer negotiation can produce
+    const char* attachSharedRing(Napi::Uint8Array view);
     void setBufferSize(); // Calculate buffer size after format negotiation
-
-    void setProps(Napi::Env env, const spa_pod_object* properties);
-    void setProp(const char* key, spa_pod* value);
-    void setChannelProp(uint32_t channel, const char* key, Napi::Value value);
+    uint32_t readSource(uint8_t* dest, uint32_t frames, SampleConverter& target, uint32_t destStride);
+    uint32_t mixBuffer(uint8_t* dest, uint32_t frames, const RenderPath& path);
+    uint32_t resampleFrames(uint8_t* dest, uint32_t frames, const RenderPath& path);
+    bool isAutomated();
+    void applyAutomation(float* frames, uint32_t count, uint64_t position);
+    uint32_t renderFrames(uint8_t* dest, uint32_t frames, const RenderPath& path);
+    RenderPath getRenderPath(); // RT thread; the negotiated format's
+    void raiseWakeups(uint32_t producedFrames);
+    void sampleClock(uint64_t renderStart);
+    bool readTiming(PlaybackTiming& timing); // False before the first playback cycle
+    // atFrame or atTimeNs (NaN when absent) on the render timeline; throws
+    // and returns false when a time cannot be converted yet
+    bool resolveStartFrame(const Napi::Env& env, double atFrame, double atTimeNs, double& startFrame);
+    bool renderToSink(FileSink& sink, uint64_t frames, OfflineRender& render, std::string& error); // Worker thread
+    Napi::Value toLevels(Napi::Env env);
+    EffectChain* effectChain(const Napi::Value& target, uint32_t& chainChannels); // The bus for -1, else a mixer input's
+    void traceWrite(int64_t startedNs, uint32_t offered, uint32_t accepted);
+    uint32_t getQueuedFrames();
+    uint32_t getAvailableFrames(); // Writable frames below the high watermark
+    uint32_t getHighWatermarkFrames();
+    uint32_t getWakeFrames(); // For the least demanding pending waitForBuffer()
+    uint32_t getWakeFrames(uint32_t minFrames); // For one caller's minFrames
+    void publishWakeFrames(); // JS thread, after bufferWaiters changes
+    size_t writeConverted(const SampleView& view, size_t limit);
+    const char* checkWritable();
+    Napi::ArrayBuffer getAcquiredArrayBuffer(Napi::Env env);
 
     // Helper methods for connect()
     std::vector<spa_audio_format> parsePreferredFormats(const Napi::Object& options);
@@ -106,10 +371,9 @@ private:
     void buildFormatParams(struct spa_pod_builder& podBuilder,
         const std::vector<spa_audio_format>& preferredFormats,
         const std::vector<uint32_t>& preferredRates);
-    void connectStream(const std::vector<spa_audio_format>& preferredFormats,
+    bool buildCachedFormatParam(struct spa_pod_builder& podBuilder,
+        const std::vector<spa_audio_format>& preferredFormats,
         const std::vector<uint32_t>& preferredRates);
-
-    void _destroy();
 };
 
 #endif // PIPEWIRE_STREAM_HPP
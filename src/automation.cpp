@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#endif
+
+#include "automation.hpp"
+
+#define EXPONENTIAL_FLOOR 0.0001f // -80dB; exponential ramps cannot reach 0
+
+AutomationLane::AutomationLane(float value)
+    : generation(0)
+    , jumpValue(value)
+    , queue {}
+    , head(0)
+    , tail(0)
+    , seenGeneration(0)
+    , current(value)
+    , ramping(false)
+    , curve(RAMP_LINEAR)
+    , endFrame(0)
+    , target(value)
+    , step(0.0f)
+{
+}
+
+void AutomationLane::reset(float value)
+{
+    jumpValue.store(value, std::memory_order_relaxed);
+    head.store(tail.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    seenGeneration = generation.load(std::memory_order_relaxed);
+    current = value;
+    ramping = false;
+}
+
+void AutomationLane::set(float value)
+{
+    jumpValue.store(value, std::memory_order_relaxed);
+    generation.fetch_add(1, std::memory_order_release);
+}
+
+bool AutomationLane::schedule(float target, uint32_t frames, uint64_t startFrame, uint32_t curve)
+{
+    auto writeAt = tail.load(std::memory_order_relaxed);
+    if (writeAt - head.load(std::memory_order_acquire) >= AUTOMATION_QUEUE_SIZE) {
+        return false;
+    }
+
+    queue[writeAt % AUTOMATION_QUEUE_SIZE] = {
+        .startFrame = startFrame,
+        .frames = frames,
+        .target = target,
+        .curve = curve,
+        .generation = generation.load(std::memory_order_relaxed),
+    };
+    tail.store(writeAt + 1, std::memory_order_release);
+    return true;
+}
+
+void AutomationLane::applyGeneration()
+{
+    auto latest = generation.load(std::memory_order_acquire);
+    if (latest != seenGeneration) {
+        seenGeneration = latest;
+        current = jumpValue.load(std::memory_order_relaxed);
+        ramping = false;
+    }
+}
+
+const AutomationEvent* AutomationLane::peek()
+{
+    // Skips events that a later set() cancelled
+    auto readAt = head.load(std::memory_order_relaxed);
+    auto end = tail.load(std::memory_order_acquire);
+    for (; readAt != end; readAt++) {
+        auto& event = queue[readAt % AUTOMATION_QUEUE_SIZE];
+        if (event.generation == seenGeneration) {
+            head.store(readAt, std::memory_order_release);
+            return &event;
+        }
+    }
+    head.store(readAt, std::memory_order_release);
+    return nullptr;
+}
+
+void AutomationLane::begin(const AutomationEvent& event, uint64_t position)
+{
+    // A ramp that started before this block still ends on schedule, except
+    // that start frame 0 means "as soon as the lane gets to it"
+    curve = event.curve;
+    target = event.target;
+    endFrame = (event.startFrame ? event.startFrame : position) + event.frames;
+    head.fetch_add(1, std::memory_order_release);
+
+    if (endFrame <= position) {
+        current = target;
+        ramping = false;
+        return;
+    }
+
+    auto frames = (float)(endFrame - position);
+    if (curve == RAMP_EXPONENTIAL) {
+        current = std::max(current, EXPONENTIAL_FLOOR);
+        step = std::pow(std::max(target, EXPONENTIAL_FLOOR) / current, 1.0f / frames);
+    } else {
+        step = (target - current) / frames;
+    }
+    ramping = true;
+}
+
+bool AutomationLane::process(uint64_t position, uint32_t frames, float* values, float& value)
+{
+    applyGeneration();
+
+    if (!ramping) {
+        auto next = peek();
+        if (!next || next->startFrame >= position + frames) {
+            value = current;
+            return true;
+        }
+    }
+
+    uint32_t done = 0;
+    while (done < frames) {
+        auto at = position + done;
+        if (!ramping) {
+            auto next = peek();
+            if (next && next->startFrame <= at) {
+                begin(*next, at);
+                continue;
+            }
+            // Hold until the next event starts or the block ends
+            auto until = next ? (uint32_t)std::min<uint64_t>(frames, next->startFrame - position) : frames;
+            std::fill(values + done, values + until, current);
+            done = until;
+            continue;
+        }
+
+        auto count = (uint32_t)std::min<uint64_t>(frames - done, endFrame - at);
+        if (curve == RAMP_EXPONENTIAL) {
+            for (uint32_t i = 0; i < count; i++) {
+                current *= step;
+                values[done + i] = current;
+            }
+        } else {
+            // Independent per frame, so this vectorizes
+            auto start = current;
+            for (uint32_t i = 0; i < count; i++) {
+                values[done + i] = start + step * (float)(i + 1);
+            }
+            current = start + step * (float)count;
+        }
+        done += count;
+
+        if (at + count >= endFrame) {
+            // Land exactly on the target, whatever rounding accumulated
+            current = target;
+            values[done - 1] = target;
+            ramping = false;
+        }
+    }
+    return false;
+}
+
+bool AutomationLane::isAt(float value)
+{
+    applyGeneration();
+    return !ramping && current == value && !peek();
+}
+
+void scaleStereo(float* bus, const float* left, const float* right, size_t frames)
+{
+    size_t i = 0;
+#if HAVE_X86_SIMD
+    for (; i + 4 <= frames; i += 4) {
+        auto l = _mm_loadu_ps(left + i);
+        auto r = _mm_loadu_ps(right + i);
+        auto low = _mm_unpacklo_ps(l, r); // l0 r0 l1 r1
+        auto high = _mm_unpackhi_ps(l, r); // l2 r2 l3 r3
+        _mm_storeu_ps(bus + i * 2, _mm_mul_ps(_mm_loadu_ps(bus + i * 2), low));
+        _mm_storeu_ps(bus + i * 2 + 4, _mm_mul_ps(_mm_loadu_ps(bus + i * 2 + 4), high));
+    }
+#elif HAVE_NEON
+    for (; i + 4 <= frames; i += 4) {
+        auto samples = vld2q_f32(bus + i * 2);
+        samples.val[0] = vmulq_f32(samples.val[0], vld1q_f32(left + i));
+        samples.val[1] = vmulq_f32(samples.val[1], vld1q_f32(right + i));
+        vst2q_f32(bus + i * 2, samples);
+    }
+#endif
+    for (; i < frames; i++) {
+        bus[i * 2] *= left[i];
+        bus[i * 2 + 1] *= right[i];
+    }
+}
+
+void scaleFrames(float* bus, const float* gains, size_t frames, uint32_t channels)
+{
+    if (channels == 2) {
+        scaleStereo(bus, gains, gains, frames);
+        return;
+    }
+    if (channels == 1) {
+        size_t i = 0;
+#if HAVE_X86_SIMD
+        for (; i + 4 <= frames; i += 4) {
+            _mm_storeu_ps(bus + i, _mm_mul_ps(_mm_loadu_ps(bus + i), _mm_loadu_ps(gains + i)));
+        }
+#elif HAVE_NEON
+        for (; i + 4 <= frames; i += 4) {
+            vst1q_f32(bus + i, vmulq_f32(vld1q_f32(bus + i), vld1q_f32(gains + i)));
+        }
+#endif
+        for (; i < frames; i++) {
+            bus[i] *= gains[i];
+        }
+        return;
+    }
+    for (size_t i = 0; i < frames; i++) {
+        for (uint32_t ch = 0; ch < channels; ch++) {
+            bus[i * channels + ch] *= gains[i];
+        }
+    }
+}
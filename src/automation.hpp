@@ -0,0 +1,73 @@
+#ifndef PIPEWIRE_AUTOMATION_HPP
+#define PIPEWIRE_AUTOMATION_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#define AUTOMATION_QUEUE_SIZE 32 // Ramps a lane can hold before they start
+#define AUTOMATION_BLOCK_FRAMES 256 // Frames of per-frame values rendered at once
+
+#define RAMP_LINEAR 0
+#define RAMP_EXPONENTIAL 1
+
+struct AutomationEvent {
+    uint64_t startFrame; // On the stream's render timeline; 0 starts when reached
+    uint32_t frames; // 0 jumps straight to the target
+    float target;
+    uint32_t curve;
+    uint32_t generation; // Events from before the last set() are dropped
+};
+
+// One automated parameter (a gain or a pan) shared between JS and the RT
+// thread.
+//
+// JS schedules ramps into a single-producer, single-consumer queue; the RT
+// thread starts each one at its frame and renders the value frame by frame,
+// so a fade costs one message however long it is. set() jumps straight to a
+// value and cancels everything scheduled before it. Ramps run in the order
+// they were scheduled, each starting from wherever the previous one ended.
+class AutomationLane {
+
+public:
+    explicit AutomationLane(float value);
+
+    // JS thread
+    void reset(float value); // Only while the RT thread is not processing the lane
+    void set(float value);
+    bool schedule(float target, uint32_t frames, uint64_t startFrame, uint32_t curve); // false when full
+
+    // RT thread. Returns true and sets `value` when the lane holds still for
+    // the whole block; otherwise writes one value per frame into `values`.
+    // frames must not exceed AUTOMATION_BLOCK_FRAMES.
+    bool process(uint64_t position, uint32_t frames, float* values, float& value);
+    bool isAt(float value); // Still at value, with nothing scheduled
+
+private:
+    std::atomic<uint32_t> generation;
+    std::atomic<float> jumpValue;
+    AutomationEvent queue[AUTOMATION_QUEUE_SIZE];
+    std::atomic<uint32_t> head; // Next event the RT thread takes
+    std::atomic<uint32_t> tail; // Next slot JS fills
+
+    // RT thread only
+    uint32_t seenGeneration;
+    float current;
+    bool ramping;
+    uint32_t curve;
+    uint64_t endFrame;
+    float target;
+    float step; // Added (linear) or multiplied (exponential) per frame
+
+    void applyGeneration();
+    const AutomationEvent* peek();
+    void begin(const AutomationEvent& event, uint64_t position);
+};
+
+// bus[i * 2] *= left[i], bus[i * 2 + 1] *= right[i]
+void scaleStereo(float* bus, const float* left, const float* right, size_t frames);
+
+// Every channel of frame i scaled by gains[i]
+void scaleFrames(float* bus, const float* gains, size_t frames, uint32_t channels);
+
+#endif // PIPEWIRE_AUTOMATION_HPP
@@ -0,0 +1,597 @@
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#endif
+
+#include "automation.hpp"
+#include "effect-chain.hpp"
+
+#define DELAY_GLIDE 0.001f // Fraction of the way to a new delay time per frame
+
+void BiquadCascade::reset()
+{
+    b0 = 1.0f;
+    b1 = b2 = a1 = a2 = 0.0f;
+    sections = 1;
+    std::fill(&state[0][0][0], &state[0][0][0] + EFFECT_MAX_SECTIONS * EFFECT_MAX_CHANNELS * 2, 0.0f);
+}
+
+void BiquadCascade::configure(const float* params, uint32_t rate)
+{
+    // Coefficients from the Audio EQ Cookbook (R. Bristow-Johnson)
+    auto shape = (uint32_t)params[BIQUAD_SHAPE];
+    auto frequency = std::clamp((double)params[BIQUAD_FREQUENCY], 1.0, rate * 0.49);
+    auto q = std::max((double)params[BIQUAD_Q], 0.01);
+    auto amplitude = std::pow(10.0, params[BIQUAD_GAIN_DB] / 40.0);
+    auto w0 = 2.0 * M_PI * frequency / rate;
+    auto cosw = std::cos(w0);
+    auto alpha = std::sin(w0) / (2.0 * q);
+    auto shelf = 2.0 * std::sqrt(amplitude) * alpha;
+
+    double nb0, nb1, nb2, na0, na1, na2;
+    na1 = -2.0 * cosw;
+    na0 = 1.0 + alpha;
+    na2 = 1.0 - alpha;
+    switch (shape) {
+    case BIQUAD_HIGHPASS:
+        nb0 = nb2 = (1.0 + cosw) / 2.0;
+        nb1 = -(1.0 + cosw);
+        break;
+    case BIQUAD_BANDPASS:
+        nb0 = alpha;
+        nb1 = 0.0;
+        nb2 = -alpha;
+        break;
+    case BIQUAD_NOTCH:
+        nb0 = nb2 = 1.0;
+        nb1 = -2.0 * cosw;
+        break;
+    case BIQUAD_PEAKING:
+        nb0 = 1.0 + alpha * amplitude;
+        nb1 = -2.0 * cosw;
+        nb2 = 1.0 - alpha * amplitude;
+        na0 = 1.0 + alpha / amplitude;
+        na2 = 1.0 - alpha / amplitude;
+        break;
+    case BIQUAD_LOWSHELF:
+        nb0 = amplitude * ((amplitude + 1.0) - (amplitude - 1.0) * cosw + shelf);
+        nb1 = 2.0 * amplitude * ((amplitude - 1.0) - (amplitude + 1.0) * cosw);
+        nb2 = amplitude * ((amplitude + 1.0) - (amplitude - 1.0) * cosw - shelf);
+        na0 = (amplitude + 1.0) + (amplitude - 1.0) * cosw + shelf;
+        na1 = -2.0 * ((amplitude - 1.0) + (amplitude + 1.0) * cosw);
+        na2 = (amplitude + 1.0) + (amplitude - 1.0) * cosw - shelf;
+        break;
+    case BIQUAD_HIGHSHELF:
+        nb0 = amplitude * ((amplitude + 1.0) + (amplitude - 1.0) * cosw + shelf);
+        nb1 = -2.0 * amplitude * ((amplitude - 1.0) + (amplitude + 1.0) * cosw);
+        nb2 = amplitude * ((amplitude + 1.0) + (amplitude - 1.0) * cosw - shelf);
+        na0 = (amplitude + 1.0) - (amplitude - 1.0) * cosw + shelf;
+        na1 = 2.0 * ((amplitude - 1.0) - (amplitude + 1.0) * cosw);
+        na2 = (amplitude + 1.0) - (amplitude - 1.0) * cosw - shelf;
+        break;
+    case BIQUAD_ALLPASS:
+        nb0 = 1.0 - alpha;
+        nb1 = -2.0 * cosw;
+        nb2 = 1.0 + alpha;
+        break;
+    default: // BIQUAD_LOWPASS
+        nb0 = nb2 = (1.0 - cosw) / 2.0;
+        nb1 = 1.0 - cosw;
+        break;
+    }
+
+    b0 = (float)(nb0 / na0);
+    b1 = (float)(nb1 / na0);
+    b2 = (float)(nb2 / na0);
+    a1 = (float)(na1 / na0);
+    a2 = (float)(na2 / na0);
+    sections = std::clamp<uint32_t>((uint32_t)params[BIQUAD_SECTIONS], 1, EFFECT_MAX_SECTIONS);
+}
+
+void BiquadCascade::process(float* frames, uint32_t count, uint32_t channels)
+{
+    // Each section runs over the whole block with its state in registers;
+    // the recursion is serial in time, so channels are the only parallelism
+    auto filtered = std::min<uint32_t>(channels, EFFECT_MAX_CHANNELS);
+    for (uint32_t section = 0; section < sections; section++) {
+        if (filtered == 2) {
+            // Both channels in one pass, so the two recursions overlap
+            auto l1 = state[section][0][0], l2 = state[section][0][1];
+            auto r1 = state[section][1][0], r2 = state[section][1][1];
+            auto sample = frames;
+            for (uint32_t i = 0; i < count; i++, sample += channels) {
+                auto xl = sample[0];
+                auto xr = sample[1];
+                auto yl = b0 * xl + l1;
+                auto yr = b0 * xr + r1;
+                l1 = b1 * xl - a1 * yl + l2;
+                r1 = b1 * xr - a1 * yr + r2;
+                l2 = b2 * xl - a2 * yl;
+                r2 = b2 * xr - a2 * yr;
+                sample[0] = yl;
+                sample[1] = yr;
+            }
+            state[section][0][0] = std::fabs(l1) < 1e-20f ? 0.0f : l1;
+            state[section][0][1] = std::fabs(l2) < 1e-20f ? 0.0f : l2;
+            state[section][1][0] = std::fabs(r1) < 1e-20f ? 0.0f : r1;
+            state[section][1][1] = std::fabs(r2) < 1e-20f ? 0.0f : r2;
+            continue;
+        }
+        for (uint32_t ch = 0; ch < filtered; ch++) {
+            auto s1 = state[section][ch][0];
+            auto s2 = state[section][ch][1];
+            auto sample = frames + ch;
+            for (uint32_t i = 0; i < count; i++, sample += channels) {
+                auto x = *sample;
+                auto y = b0 * x + s1;
+                s1 = b1 * x - a1 * y + s2;
+                s2 = b2 * x - a2 * y;
+                *sample = y;
+            }
+            // Let decaying state reach zero rather than turn denormal
+            state[section][ch][0] = std::fabs(s1) < 1e-20f ? 0.0f : s1;
+            state[section][ch][1] = std::fabs(s2) < 1e-20f ? 0.0f : s2;
+        }
+    }
+}
+
+void LookaheadLimiter::allocate(size_t capacityFrames, uint32_t channels)
+{
+    this->channels = std::min<uint32_t>(channels, EFFECT_MAX_CHANNELS);
+    capacity = capacityFrames + 1;
+    delayed.assign(capacity * this->channels, 0.0f);
+    envelope.assign(capacity, 1.0f);
+    holdValues.assign(capacity, 1.0f);
+    holdFrames.assign(capacity, 0);
+    threshold = 1.0f;
+    lookahead = 1;
+    release = 0.0f;
+    reset();
+}
+
+void LookaheadLimiter::reset()
+{
+    std::fill(delayed.begin(), delayed.end(), 0.0f);
+    std::fill(envelope.begin(), envelope.end(), 1.0f);
+    frame = 0;
+    holdHead = 0;
+    holdSize = 0;
+    smoothed = 1.0f;
+    envelopeSum = (double)lookahead;
+}
+
+void LookaheadLimiter::configure(const float* params, uint32_t rate)
+{
+    threshold = std::min(1.0f, std::pow(10.0f, params[LIMITER_THRESHOLD_DB] / 20.0f));
+    auto releaseFrames = std::max(1.0, params[LIMITER_RELEASE_MS] * rate / 1000.0);
+    release = (float)std::exp(-1.0 / releaseFrames);
+
+    auto frames = (size_t)std::lround(std::max(0.0, params[LIMITER_LOOKAHEAD_MS] * rate / 1000.0));
+    frames = std::clamp<size_t>(frames, 1, capacity - 1);
+    if (frames != lookahead) {
+        lookahead = frames;
+        resetWindow();
+    }
+}
+
+void LookaheadLimiter::resetWindow()
+{
+    // Re-sum the envelope over the new window; frames from before the
+    // start still hold unity gain
+    envelopeSum = 0.0;
+    for (size_t back = 1; back <= lookahead; back++) {
+        envelopeSum += envelope[(frame + capacity * 2 - back) % capacity];
+    }
+}
+
+void LookaheadLimiter::process(float* frames, uint32_t count, uint32_t channels)
+{
+    auto limited = std::min(channels, this->channels);
+    auto delay = lookahead - 1; // The window closes on the peak this late
+    auto average = 1.0 / (double)lookahead;
+    auto wrap = [this](size_t index) {
+        return index >= capacity ? index - capacity : index;
+    };
+
+    // Ring positions advance together: this frame, the frame leaving the
+    // average and the frame leaving the delay line
+    auto slot = (size_t)(frame % capacity);
+    auto leaving = wrap(slot + capacity - lookahead);
+    auto out = wrap(slot + capacity - delay);
+    for (uint32_t done = 0; done < count; done += EFFECT_BLOCK_FRAMES) {
+        auto blockFrames = std::min<uint32_t>(count - done, EFFECT_BLOCK_FRAMES);
+        auto block = frames + (size_t)done * channels;
+
+        for (uint32_t i = 0; i < blockFrames; i++) {
+            auto sample = block + (size_t)i * channels;
+            float peak = 0.0f;
+            for (uint32_t ch = 0; ch < limited; ch++) {
+                peak = std::max(peak, std::fabs(sample[ch]));
+            }
+            auto wanted = peak > threshold ? threshold / peak : 1.0f;
+
+            // Running minimum of the wanted gain over the lookahead
+            while (holdSize && holdValues[wrap(holdHead + holdSize - 1)] >= wanted) {
+                holdSize--;
+            }
+            auto tail = wrap(holdHead + holdSize);
+            holdValues[tail] = wanted;
+            holdFrames[tail] = frame;
+            holdSize++;
+            while (holdFrames[holdHead] + lookahead <= frame) {
+                holdHead = wrap(holdHead + 1);
+                holdSize--;
+            }
+            auto held = holdValues[holdHead];
+
+            // Attack at once, recover exponentially, then average over the
+            // window so the gain reaches its floor smoothly
+            smoothed = held < smoothed ? held : held + (smoothed - held) * release;
+            envelopeSum += smoothed - envelope[leaving];
+            envelope[slot] = smoothed;
+            gains[i] = (float)(envelopeSum * average);
+
+            auto stored = delayed.data() + slot * this->channels;
+            auto released = delayed.data() + out * this->channels;
+            for (uint32_t ch = 0; ch < limited; ch++) {
+                stored[ch] = sample[ch];
+                sample[ch] = released[ch];
+            }
+            frame++;
+            slot = wrap(slot + 1);
+            leaving = wrap(leaving + 1);
+            out = wrap(out + 1);
+        }
+
+        if (limited == channels) {
+            scaleFrames(block, gains, blockFrames, channels);
+            continue;
+        }
+        for (uint32_t i = 0; i < blockFrames; i++) {
+            for (uint32_t ch = 0; ch < limited; ch++) {
+                block[(size_t)i * channels + ch] *= gains[i];
+            }
+        }
+    }
+}
+
+void DelayLine::allocate(size_t capacityFrames, uint32_t channels)
+{
+    this->channels = std::min<uint32_t>(channels, EFFECT_MAX_CHANNELS);
+    capacity = capacityFrames + 2;
+    buffer.assign(capacity * this->channels, 0.0f);
+    reset();
+}
+
+void DelayLine::reset()
+{
+    std::fill(buffer.begin(), buffer.end(), 0.0f);
+    writeIndex = 0;
+    delayFrames = 1.0f;
+    currentDelay = -1.0f; // Jump to the first delay time configured
+    feedback = 0.0f;
+    mix = 0.0f;
+    channelMask = 0;
+}
+
+void DelayLine::configure(const float* params, uint32_t rate)
+{
+    delayFrames = std::clamp((float)(params[DELAY_MS] * rate / 1000.0), 1.0f, (float)(capacity - 2));
+    feedback = std::clamp(params[DELAY_FEEDBACK], -0.99f, 0.99f);
+    mix = std::clamp(params[DELAY_MIX], 0.0f, 1.0f);
+    channelMask = (uint32_t)params[DELAY_CHANNEL_MASK];
+    if (currentDelay < 0.0f) {
+        currentDelay = delayFrames;
+    }
+}
+
+void DelayLine::process(float* frames, uint32_t count, uint32_t channels)
+{
+    auto delayed = std::min(channels, this->channels);
+    auto wrap = [this](size_t index) {
+        return index >= capacity ? index - capacity : index;
+    };
+    for (uint32_t i = 0; i < count; i++) {
+        if (currentDelay != delayFrames) {
+            currentDelay += (delayFrames - currentDelay) * DELAY_GLIDE;
+            if (std::fabs(delayFrames - currentDelay) < 1e-3f) {
+                currentDelay = delayFrames;
+            }
+        }
+
+        // Linear interpolation between the two frames around the read point
+        auto whole = (size_t)currentDelay;
+        auto fraction = currentDelay - (float)whole;
+        auto newer = wrap(writeIndex + capacity - whole); // whole frames back
+        auto older = wrap(writeIndex + capacity - whole - 1); // one further back
+        auto first = buffer.data() + newer * this->channels;
+        auto second = buffer.data() + older * this->channels;
+        auto written = buffer.data() + writeIndex * this->channels;
+        auto sample = frames + (size_t)i * channels;
+
+        for (uint32_t ch = 0; ch < delayed; ch++) {
+            if (!(channelMask & (1u << ch))) {
+                continue;
+            }
+            auto wet = first[ch] + (second[ch] - first[ch]) * fraction;
+            written[ch] = sample[ch] + wet * feedback;
+            sample[ch] += (wet - sample[ch]) * mix;
+        }
+        writeIndex = wrap(writeIndex + 1);
+    }
+}
+
+void midSide(float* frames, size_t count, float midGain, float sideGain)
+{
+    size_t i = 0;
+#if HAVE_X86_SIMD
+    auto half = _mm_set1_ps(0.5f);
+    auto mids = _mm_set1_ps(midGain);
+    auto sides = _mm_set1_ps(sideGain);
+    for (; i + 2 <= count; i += 2) {
+        auto lr = _mm_loadu_ps(frames + i * 2); // l0 r0 l1 r1
+        auto rl = _mm_shuffle_ps(lr, lr, _MM_SHUFFLE(2, 3, 0, 1)); // r0 l0 r1 l1
+        auto mid = _mm_mul_ps(_mm_add_ps(lr, rl), half); // m0 m0 m1 m1
+        auto side = _mm_mul_ps(_mm_sub_ps(lr, rl), half); // s0 -s0 s1 -s1
+        _mm_storeu_ps(frames + i * 2, _mm_add_ps(_mm_mul_ps(mid, mids), _mm_mul_ps(side, sides)));
+    }
+#elif HAVE_NEON
+    auto mids = vdupq_n_f32(midGain * 0.5f);
+    auto sides = vdupq_n_f32(sideGain * 0.5f);
+    for (; i + 2 <= count; i += 2) {
+        auto lr = vld1q_f32(frames + i * 2); // l0 r0 l1 r1
+        auto rl = vrev64q_f32(lr); // r0 l0 r1 l1
+        auto out = vmlaq_f32(vmulq_f32(vaddq_f32(lr, rl), mids), vsubq_f32(lr, rl), sides);
+        vst1q_f32(frames + i * 2, out);
+    }
+#endif
+    for (; i < count; i++) {
+        auto mid = (frames[i * 2] + frames[i * 2 + 1]) * 0.5f;
+        auto side = (frames[i * 2] - frames[i * 2 + 1]) * 0.5f;
+        frames[i * 2] = mid * midGain + side * sideGain;
+        frames[i * 2 + 1] = mid * midGain - side * sideGain;
+    }
+}
+
+EffectChain::EffectChain()
+    : orderSequence(0)
+    , orderCount(0)
+    , order {}
+    , jsOrder {}
+    , jsCount(0)
+    , activeOrder {}
+    , activeCount(0)
+    , seenOrder(0)
+{
+}
+
+void EffectChain::reset()
+{
+    for (auto& stage : stages) {
+        stage.state.store(EFFECT_STAGE_FREE, std::memory_order_relaxed);
+    }
+    jsCount = 0;
+    publishOrder();
+    activeCount = 0;
+    seenOrder = orderSequence.load(std::memory_order_relaxed);
+}
+
+int EffectChain::insert(uint32_t type, const float* params, uint32_t index, size_t capacityFrames, uint32_t channels)
+{
+    if (jsCount == EFFECT_CHAIN_MAX_STAGES) {
+        return -1;
+    }
+    int id = -1;
+    for (uint32_t i = 0; i < EFFECT_CHAIN_MAX_STAGES; i++) {
+        if (stages[i].state.load(std::memory_order_acquire) == EFFECT_STAGE_FREE) {
+            id = (int)i;
+            break;
+        }
+    }
+    if (id < 0) {
+        return -1; // Removed stages the RT thread has not handed back yet
+    }
+
+    // The stage is FREE, so the RT thread is not touching any of it
+    auto& stage = stages[id];
+    stage.type = type;
+    stage.bypassed.store(false, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < EFFECT_MAX_PARAMS; i++) {
+        stage.params[i].store(params[i], std::memory_order_relaxed);
+    }
+    stage.configured = false;
+    switch (type) {
+    case EFFECT_BIQUAD:
+        stage.biquads.reset();
+        break;
+    case EFFECT_LIMITER:
+        stage.limiter.allocate(capacityFrames, channels);
+        break;
+    case EFFECT_DELAY:
+        stage.delay.allocate(capacityFrames, channels);
+        break;
+    }
+    stage.state.store(EFFECT_STAGE_ACTIVE, std::memory_order_release);
+
+    index = std::min(index, jsCount);
+    std::copy_backward(jsOrder + index, jsOrder + jsCount, jsOrder + jsCount + 1);
+    jsOrder[index] = (uint8_t)id;
+    jsCount++;
+    publishOrder();
+    return id;
+}
+
+bool EffectChain::remove(uint32_t id)
+{
+    if (!hasStage(id)) {
+        return false;
+    }
+    // Marked first, so the RT thread sees it once it adopts the order without it
+    stages[id].state.store(EFFECT_STAGE_REMOVING, std::memory_order_release);
+    auto end = std::remove(jsOrder, jsOrder + jsCount, (uint8_t)id);
+    jsCount = (uint32_t)(end - jsOrder);
+    publishOrder();
+    return true;
+}
+
+bool EffectChain::setParams(uint32_t id, const float* params)
+{
+    if (!hasStage(id)) {
+        return false;
+    }
+    auto& stage = stages[id];
+    auto start = stage.sequence.load(std::memory_order_relaxed);
+    stage.sequence.store(start + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (uint32_t i = 0; i < EFFECT_MAX_PARAMS; i++) {
+        if (!std::isnan(params[i])) {
+            stage.params[i].store(params[i], std::memory_order_relaxed);
+        }
+    }
+    stage.sequence.store(start + 2, std::memory_order_release);
+    return true;
+}
+
+bool EffectChain::setBypassed(uint32_t id, bool bypassed)
+{
+    if (!hasStage(id)) {
+        return false;
+    }
+    stages[id].bypassed.store(bypassed, std::memory_order_relaxed);
+    return true;
+}
+
+bool EffectChain::hasStage(uint32_t id)
+{
+    return id < EFFECT_CHAIN_MAX_STAGES
+        && stages[id].state.load(std::memory_order_relaxed) == EFFECT_STAGE_ACTIVE;
+}
+
+int EffectChain::typeOf(uint32_t id)
+{
+    return hasStage(id) ? (int)stages[id].type : -1;
+}
+
+bool EffectChain::hasStages() const
+{
+    // A chain just emptied still runs once, to adopt the empty order and
+    // free what was removed
+    return orderCount.load(std::memory_order_relaxed) > 0 || activeCount > 0;
+}
+
+void EffectChain::publishOrder()
+{
+    auto start = orderSequence.load(std::memory_order_relaxed);
+    orderSequence.store(start + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    orderCount.store(jsCount, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < jsCount; i++) {
+        order[i].store(jsOrder[i], std::memory_order_relaxed);
+    }
+    orderSequence.store(start + 2, std::memory_order_release);
+}
+
+void EffectChain::adoptOrder()
+{
+    // Keeps the current order if JS is mid-publish; the next cycle retries
+    auto sequence = orderSequence.load(std::memory_order_acquire);
+    if (sequence == seenOrder || (sequence & 1)) {
+        return;
+    }
+    uint8_t next[EFFECT_CHAIN_MAX_STAGES];
+    auto count = std::min<uint32_t>(orderCount.load(std::memory_order_relaxed), EFFECT_CHAIN_MAX_STAGES);
+    for (uint32_t i = 0; i < count; i++) {
+        next[i] = order[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (orderSequence.load(std::memory_order_relaxed) != sequence) {
+        return;
+    }
+
+    std::copy(next, next + count, activeOrder);
+    activeCount = count;
+    seenOrder = sequence;
+    freeRemoved();
+}
+
+void EffectChain::freeRemoved()
+{
+    for (uint32_t id = 0; id < EFFECT_CHAIN_MAX_STAGES; id++) {
+        auto& stage = stages[id];
+        if (stage.state.load(std::memory_order_acquire) != EFFECT_STAGE_REMOVING
+            || std::find(activeOrder, activeOrder + activeCount, id) != activeOrder + activeCount) {
+            continue;
+        }
+        stage.state.store(EFFECT_STAGE_FREE, std::memory_order_release);
+    }
+}
+
+void EffectChain::process(float* frames, uint32_t count, uint32_t channels, uint32_t rate)
+{
+    adoptOrder();
+    for (uint32_t i = 0; i < activeCount; i++) {
+        auto& stage = stages[activeOrder[i]];
+        if (!stage.bypassed.load(std::memory_order_relaxed)) {
+            runStage(stage, frames, count, channels, rate);
+        }
+    }
+}
+
+void EffectChain::runStage(EffectStage& stage, float* frames, uint32_t count, uint32_t channels, uint32_t rate)
+{
+    // Parameters are re-read only when they or the rate have changed
+    auto sequence = stage.sequence.load(std::memory_order_acquire);
+    if ((!stage.configured || sequence != stage.seenSequence || rate != stage.seenRate) && !(sequence & 1)) {
+        float params[EFFECT_MAX_PARAMS];
+        for (uint32_t i = 0; i < EFFECT_MAX_PARAMS; i++) {
+            params[i] = stage.params[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (stage.sequence.load(std::memory_order_relaxed) == sequence) {
+            switch (stage.type) {
+            case EFFECT_BIQUAD:
+                stage.biquads.configure(params, rate);
+                break;
+            case EFFECT_LIMITER:
+                stage.limiter.configure(params, rate);
+                break;
+            case EFFECT_DELAY:
+                stage.delay.configure(params, rate);
+                break;
+            case EFFECT_MID_SIDE:
+                stage.midGain = params[MID_SIDE_MID_GAIN];
+                stage.sideGain = params[MID_SIDE_SIDE_GAIN];
+                break;
+            }
+            stage.seenSequence = sequence;
+            stage.seenRate = rate;
+            stage.configured = true;
+        }
+    }
+    if (!stage.configured) {
+        return; // Passes through until its first parameters are readable
+    }
+
+    switch (stage.type) {
+    case EFFECT_BIQUAD:
+        stage.biquads.process(frames, count, channels);
+        break;
+    case EFFECT_LIMITER:
+        stage.limiter.process(frames, count, channels);
+        break;
+    case EFFECT_DELAY:
+        stage.delay.process(frames, count, channels);
+        break;
+    case EFFECT_MID_SIDE:
+        if (channels == 2) {
+            midSide(frames, count, stage.midGain, stage.sideGain);
+        }
+        break;
+    }
+}
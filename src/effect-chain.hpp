@@ -0,0 +1,205 @@
+#ifndef PIPEWIRE_EFFECT_CHAIN_HPP
+#define PIPEWIRE_EFFECT_CHAIN_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define EFFECT_CHAIN_MAX_STAGES 8
+#define EFFECT_MAX_CHANNELS 8
+#define EFFECT_MAX_PARAMS 5
+#define EFFECT_MAX_SECTIONS 4 // Biquads cascaded in one stage
+#define EFFECT_BLOCK_FRAMES 256 // Frames of limiter gains computed at once
+#define EFFECT_LIMITER_MAX_LOOKAHEAD_MS 20.0
+#define EFFECT_DELAY_MAX_MS 10000.0
+
+#define EFFECT_BIQUAD 0
+#define EFFECT_LIMITER 1
+#define EFFECT_DELAY 2
+#define EFFECT_MID_SIDE 3
+
+#define BIQUAD_LOWPASS 0
+#define BIQUAD_HIGHPASS 1
+#define BIQUAD_BANDPASS 2
+#define BIQUAD_NOTCH 3
+#define BIQUAD_PEAKING 4
+#define BIQUAD_LOWSHELF 5
+#define BIQUAD_HIGHSHELF 6
+#define BIQUAD_ALLPASS 7
+
+// Parameters, by index, for each effect type
+#define BIQUAD_SHAPE 0
+#define BIQUAD_FREQUENCY 1 // Hz
+#define BIQUAD_Q 2
+#define BIQUAD_GAIN_DB 3 // Peaking and shelving shapes only
+#define BIQUAD_SECTIONS 4 // Identical sections in series, 1 to EFFECT_MAX_SECTIONS
+
+#define LIMITER_THRESHOLD_DB 0
+#define LIMITER_LOOKAHEAD_MS 1
+#define LIMITER_RELEASE_MS 2
+
+#define DELAY_MS 0
+#define DELAY_FEEDBACK 1
+#define DELAY_MIX 2 // 0 dry to 1 wet
+#define DELAY_CHANNEL_MASK 3 // Bit n delays channel n
+
+#define MID_SIDE_MID_GAIN 0
+#define MID_SIDE_SIDE_GAIN 1
+
+#define EFFECT_STAGE_FREE 0
+#define EFFECT_STAGE_ACTIVE 1
+#define EFFECT_STAGE_REMOVING 2 // Set by JS; the RT thread frees the stage
+
+// Up to EFFECT_MAX_SECTIONS identical biquads in series, in transposed
+// direct form II with one state pair per channel
+class BiquadCascade {
+
+public:
+    void reset();
+    void configure(const float* params, uint32_t rate);
+    void process(float* frames, uint32_t count, uint32_t channels);
+
+private:
+    float b0, b1, b2, a1, a2; // Normalized so a0 is 1
+    uint32_t sections;
+    float state[EFFECT_MAX_SECTIONS][EFFECT_MAX_CHANNELS][2];
+};
+
+// A brickwall limiter that sees LIMITER_LOOKAHEAD_MS ahead. The gain each
+// frame needs is held for the lookahead as a running minimum and averaged
+// over the same window, so the gain has already settled when a peak comes
+// out of the delay line and never overshoots it. Delays the signal by the
+// lookahead.
+class LookaheadLimiter {
+
+public:
+    // JS thread, while the stage is FREE
+    void allocate(size_t capacityFrames, uint32_t channels);
+
+    // RT thread
+    void reset();
+    void configure(const float* params, uint32_t rate);
+    void process(float* frames, uint32_t count, uint32_t channels);
+
+private:
+    uint32_t channels;
+    size_t capacity; // Frames each ring holds; bounds the lookahead
+    std::vector<float> delayed; // Interleaved samples, capacity frames
+    std::vector<float> envelope; // Smoothed gain per frame, for the average
+    std::vector<float> holdValues; // Running-minimum deque, oldest first
+    std::vector<uint64_t> holdFrames;
+
+    // RT thread only
+    float threshold;
+    size_t lookahead; // In frames, at least 1
+    float release; // Per-frame recovery coefficient
+    uint64_t frame;
+    size_t holdHead;
+    size_t holdSize;
+    float smoothed;
+    double envelopeSum; // Sum of the last `lookahead` envelope values
+    float gains[EFFECT_BLOCK_FRAMES];
+
+    void resetWindow();
+};
+
+// A feedback delay with a fractional, interpolated read position that
+// glides to a new delay time instead of jumping, so changes do not click
+class DelayLine {
+
+public:
+    // JS thread, while the stage is FREE
+    void allocate(size_t capacityFrames, uint32_t channels);
+
+    // RT thread
+    void reset();
+    void configure(const float* params, uint32_t rate);
+    void process(float* frames, uint32_t count, uint32_t channels);
+
+private:
+    uint32_t channels;
+    size_t capacity;
+    std::vector<float> buffer; // Interleaved, capacity frames
+
+    // RT thread only
+    size_t writeIndex;
+    float delayFrames; // Target read distance
+    float currentDelay; // Glides towards delayFrames
+    float feedback;
+    float mix;
+    uint32_t channelMask;
+};
+
+// One slot in an effect chain. Parameters are published under a sequence
+// counter (a seqlock) so the RT thread never sees half of an update.
+struct EffectStage {
+    std::atomic<uint32_t> state { EFFECT_STAGE_FREE };
+    uint32_t type = EFFECT_BIQUAD; // Fixed while the stage is in use
+    std::atomic<bool> bypassed { false };
+    std::atomic<uint32_t> sequence { 0 }; // Odd while parameters are being written
+    std::atomic<float> params[EFFECT_MAX_PARAMS];
+    BiquadCascade biquads;
+    LookaheadLimiter limiter;
+    DelayLine delay;
+
+    // RT thread only
+    uint32_t seenSequence = 0;
+    uint32_t seenRate = 0;
+    bool configured = false;
+    float midGain = 1.0f;
+    float sideGain = 1.0f;
+};
+
+// An ordered chain of DSP stages run in place on a Float32 bus.
+//
+// Like the mixer's inputs, stages live in fixed slots: JS configures a FREE
+// stage and any delay memory it needs before activating it, and a removed
+// stage is handed back to FREE by the RT thread once it is out of the order
+// the RT thread runs. The order itself is published under a seqlock, and the
+// RT thread adopts a new one at the start of a cycle.
+class EffectChain {
+
+public:
+    EffectChain();
+
+    // JS thread
+    void reset(); // Only while the RT thread is not processing the chain
+    // Inserts at `index` in the order (clamped to the end); returns the
+    // stage id, or -1 when every stage is in use. capacityFrames bounds the
+    // delay or lookahead the stage can hold.
+    int insert(uint32_t type, const float* params, uint32_t index, size_t capacityFrames, uint32_t channels);
+    bool remove(uint32_t id);
+    bool setParams(uint32_t id, const float* params); // NaN leaves a parameter unchanged
+    bool setBypassed(uint32_t id, bool bypassed);
+    bool hasStage(uint32_t id);
+    int typeOf(uint32_t id); // -1 unless id is an active stage
+    bool hasStages() const;
+
+    // RT thread; channels beyond EFFECT_MAX_CHANNELS pass through
+    void process(float* frames, uint32_t count, uint32_t channels, uint32_t rate);
+
+private:
+    EffectStage stages[EFFECT_CHAIN_MAX_STAGES];
+    std::atomic<uint32_t> orderSequence;
+    std::atomic<uint32_t> orderCount;
+    std::atomic<uint8_t> order[EFFECT_CHAIN_MAX_STAGES];
+    // JS thread only
+    uint8_t jsOrder[EFFECT_CHAIN_MAX_STAGES];
+    uint32_t jsCount;
+    // RT thread only
+    uint8_t activeOrder[EFFECT_CHAIN_MAX_STAGES];
+    uint32_t activeCount;
+    uint32_t seenOrder;
+
+    void publishOrder();
+    void adoptOrder();
+    void freeRemoved();
+    void runStage(EffectStage& stage, float* frames, uint32_t count, uint32_t channels, uint32_t rate);
+};
+
+// In place on interleaved stereo: L' = M * midGain + S * sideGain and
+// R' = M * midGain - S * sideGain, with M = (L + R) / 2 and S = (L - R) / 2
+void midSide(float* frames, size_t count, float midGain, float sideGain);
+
+#endif // PIPEWIRE_EFFECT_CHAIN_HPP
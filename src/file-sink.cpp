@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "file-sink.hpp"
+#include "sample-convert.hpp"
+
+#define WAVE_FORMAT_PCM 0x0001
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+
+namespace {
+
+void putU16(uint8_t* bytes, uint16_t value)
+{
+    bytes[0] = (uint8_t)value;
+    bytes[1] = (uint8_t)(value >> 8);
+}
+
+void putU32(uint8_t* bytes, uint32_t value)
+{
+    putU16(bytes, (uint16_t)value);
+    putU16(bytes + 2, (uint16_t)(value >> 16));
+}
+
+// RIFF sizes are 32-bit; past 4 GiB they saturate, which readers (ours
+// included) take as "to the end of the file"
+uint32_t riffSize(uint64_t size)
+{
+    return (uint32_t)std::min<uint64_t>(size, UINT32_MAX);
+}
+
+} // namespace
+
+FileSink::FileSink()
+    : file(NULL)
+    , wav(false)
+    , dataBytes(0)
+    , dataOffset(0)
+{
+}
+
+FileSink::~FileSink()
+{
+    if (file) {
+        fclose(file);
+    }
+}
+
+bool FileSink::isWritable(spa_audio_format format, bool wav)
+{
+    switch (format) {
+    case SPA_AUDIO_FORMAT_S24_32:
+        // WAV left-justifies 24-bit samples in a 32-bit container; S24_32
+        // keeps them in the low bits, so it only goes to raw files
+        return !wav;
+    case SPA_AUDIO_FORMAT_U8:
+    case SPA_AUDIO_FORMAT_S16:
+    case SPA_AUDIO_FORMAT_S32:
+    case SPA_AUDIO_FORMAT_F32:
+    case SPA_AUDIO_FORMAT_F64:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool FileSink::open(const std::string& path, spa_audio_format format, uint32_t channels, uint32_t rate, bool wav, std::string& error)
+{
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        error = "Cannot create " + path + ": " + strerror(errno);
+        return false;
+    }
+    this->wav = wav;
+    dataBytes = 0;
+    if (wav && !writeWavHeader(format, channels, rate)) {
+        error = "Cannot write " + path + ": " + strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool FileSink::writeWavHeader(spa_audio_format format, uint32_t channels, uint32_t rate)
+{
+    auto sampleBytes = SampleConverter::sampleSize(format);
+    auto blockAlign = sampleBytes * channels;
+    auto floating = format == SPA_AUDIO_FORMAT_F32 || format == SPA_AUDIO_FORMAT_F64;
+    uint32_t fmtSize = floating ? 18 : 16; // Float formats carry an empty extension
+
+    uint8_t header[12 + 8 + 18 + 8] = {};
+    memcpy(header, "RIFF", 4);
+    memcpy(header + 8, "WAVE", 4);
+    memcpy(header + 12, "fmt ", 4);
+    putU32(header + 16, fmtSize);
+
+    auto fmt = header + 20;
+    putU16(fmt, floating ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM);
+    putU16(fmt + 2, (uint16_t)channels);
+    putU32(fmt + 4, rate);
+    putU32(fmt + 8, rate * blockAlign);
+    putU16(fmt + 12, (uint16_t)blockAlign);
+    putU16(fmt + 14, (uint16_t)(sampleBytes * 8));
+
+    auto data = fmt + fmtSize;
+    memcpy(data, "data", 4);
+    dataOffset = (uint32_t)(data + 8 - header);
+    return fwrite(header, 1, dataOffset, file) == dataOffset;
+}
+
+bool FileSink::write(const uint8_t* data, size_t size, std::string& error)
+{
+    if (fwrite(data, 1, size, file) != size) {
+        error = std::string("Cannot write offline render: ") + strerror(errno);
+        return false;
+    }
+    dataBytes += size;
+    return true;
+}
+
+bool FileSink::close(std::string& error)
+{
+    auto ok = true;
+    if (wav) {
+        uint8_t size[4];
+        putU32(size, riffSize(dataOffset - 8 + dataBytes));
+        ok = fseek(file, 4, SEEK_SET) == 0 && fwrite(size, 1, 4, file) == 4;
+        putU32(size, riffSize(dataBytes));
+        ok = ok && fseek(file, dataOffset - 4, SEEK_SET) == 0 && fwrite(size, 1, 4, file) == 4;
+    }
+    ok = fclose(file) == 0 && ok;
+    file = NULL;
+    if (!ok) {
+        error = std::string("Cannot finish offline render: ") + strerror(errno);
+    }
+    return ok;
+}
+
+uint64_t FileSink::getBytes() const
+{
+    return dataBytes;
+}
@@ -0,0 +1,43 @@
+#ifndef PIPEWIRE_FILE_SINK_HPP
+#define PIPEWIRE_FILE_SINK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <spa/param/audio/raw.h>
+#include <string>
+
+// Interleaved PCM written to a WAV or headerless file by an offline render.
+//
+// A WAV header is written up front with the sizes left at zero, and
+// close() patches them once the length is known, so a render never holds
+// more than one chunk of audio in memory. Samples are written as the
+// converter produced them: U8, S16, S32, F32 or F64, little-endian, plus
+// S24_32 for raw files.
+class FileSink {
+
+public:
+    FileSink();
+    ~FileSink();
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    // Not RT safe; all return false with error set
+    bool open(const std::string& path, spa_audio_format format, uint32_t channels, uint32_t rate, bool wav, std::string& error);
+    bool write(const uint8_t* data, size_t size, std::string& error);
+    bool close(std::string& error); // Fills in the WAV sizes
+
+    uint64_t getBytes() const; // Sample bytes written so far
+
+    static bool isWritable(spa_audio_format format, bool wav);
+
+private:
+    FILE* file;
+    bool wav;
+    uint64_t dataBytes;
+    uint32_t dataOffset; // Where the samples start; 0 for raw files
+
+    bool writeWavHeader(spa_audio_format format, uint32_t channels, uint32_t rate);
+};
+
+#endif // PIPEWIRE_FILE_SINK_HPP
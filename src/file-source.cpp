@@ -0,0 +1,390 @@
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#endif
+
+#include "file-source.hpp"
+
+#define WAVE_FORMAT_PCM 0x0001
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+
+#define S16_UNIT (1.0f / 32768.0f)
+#define S24_UNIT (1.0f / 8388608.0f)
+#define S32_UNIT (1.0f / 2147483648.0f)
+
+namespace {
+
+uint16_t readU16(const uint8_t* bytes)
+{
+    return (uint16_t)(bytes[0] | bytes[1] << 8);
+}
+
+uint32_t readU32(const uint8_t* bytes)
+{
+    return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+void fromU8(const uint8_t* source, float* dest, size_t samples)
+{
+    for (size_t i = 0; i < samples; i++) {
+        dest[i] = ((int32_t)source[i] - 128) * (1.0f / 128.0f);
+    }
+}
+
+void fromS16(const uint8_t* source, float* dest, size_t samples)
+{
+    auto in = (const int16_t*)source;
+    size_t i = 0;
+#if HAVE_X86_SIMD
+    auto scale = _mm_set1_ps(S16_UNIT);
+    for (; i + 8 <= samples; i += 8) {
+        auto value = _mm_loadu_si128((const __m128i*)(in + i));
+        // Duplicating each sample into both halves and shifting sign-extends it
+        auto low = _mm_srai_epi32(_mm_unpacklo_epi16(value, value), 16);
+        auto high = _mm_srai_epi32(_mm_unpackhi_epi16(value, value), 16);
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(dest + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+#elif HAVE_NEON
+    for (; i + 8 <= samples; i += 8) {
+        auto value = vld1q_s16(in + i);
+        vst1q_f32(dest + i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(value))), S16_UNIT));
+        vst1q_f32(dest + i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(value))), S16_UNIT));
+    }
+#endif
+    for (; i < samples; i++) {
+        dest[i] = in[i] * S16_UNIT;
+    }
+}
+
+void fromS24(const uint8_t* source, float* dest, size_t samples)
+{
+    // Packed three bytes per sample; shifting up to bit 31 and back sign-extends
+    for (size_t i = 0; i < samples; i++) {
+        auto bytes = source + i * 3;
+        auto value = (int32_t)((uint32_t)bytes[0] << 8 | (uint32_t)bytes[1] << 16 | (uint32_t)bytes[2] << 24) >> 8;
+        dest[i] = value * S24_UNIT;
+    }
+}
+
+void fromS24_32(const uint8_t* source, float* dest, size_t samples)
+{
+    auto in = (const int32_t*)source;
+    for (size_t i = 0; i < samples; i++) {
+        dest[i] = ((int32_t)((uint32_t)in[i] << 8) >> 8) * S24_UNIT;
+    }
+}
+
+void fromS32(const uint8_t* source, float* dest, size_t samples)
+{
+    auto in = (const int32_t*)source;
+    size_t i = 0;
+#if HAVE_X86_SIMD
+    auto scale = _mm_set1_ps(S32_UNIT);
+    for (; i + 4 <= samples; i += 4) {
+        auto value = _mm_loadu_si128((const __m128i*)(in + i));
+        _mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(value), scale));
+    }
+#elif HAVE_NEON
+    for (; i + 4 <= samples; i += 4) {
+        vst1q_f32(dest + i, vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(in + i)), S32_UNIT));
+    }
+#endif
+    for (; i < samples; i++) {
+        dest[i] = in[i] * S32_UNIT;
+    }
+}
+
+void fromF32(const uint8_t* source, float* dest, size_t samples)
+{
+    memcpy(dest, source, samples * sizeof(float));
+}
+
+void fromF64(const uint8_t* source, float* dest, size_t samples)
+{
+    auto in = (const double*)source;
+    for (size_t i = 0; i < samples; i++) {
+        dest[i] = (float)in[i];
+    }
+}
+
+struct FileFormatInfo {
+    spa_audio_format format;
+    uint32_t bytes;
+    void (*decoder)(const uint8_t*, float*, size_t);
+};
+
+bool describe(spa_audio_format format, FileFormatInfo& info)
+{
+    switch (format) {
+    case SPA_AUDIO_FORMAT_U8:
+        info = { format, 1, fromU8 };
+        return true;
+    case SPA_AUDIO_FORMAT_S16:
+        info = { format, 2, fromS16 };
+        return true;
+    case SPA_AUDIO_FORMAT_S24:
+        info = { format, 3, fromS24 };
+        return true;
+    case SPA_AUDIO_FORMAT_S24_32:
+        info = { format, 4, fromS24_32 };
+        return true;
+    case SPA_AUDIO_FORMAT_S32:
+        info = { format, 4, fromS32 };
+        return true;
+    case SPA_AUDIO_FORMAT_F32:
+        info = { format, 4, fromF32 };
+        return true;
+    case SPA_AUDIO_FORMAT_F64:
+        info = { format, 8, fromF64 };
+        return true;
+    default:
+        return false;
+    }
+}
+
+spa_audio_format wavFormat(uint16_t tag, uint16_t bits)
+{
+    if (tag == WAVE_FORMAT_PCM) {
+        switch (bits) {
+        case 8:
+            return SPA_AUDIO_FORMAT_U8;
+        case 16:
+            return SPA_AUDIO_FORMAT_S16;
+        case 24:
+            return SPA_AUDIO_FORMAT_S24;
+        case 32:
+            return SPA_AUDIO_FORMAT_S32;
+        }
+    } else if (tag == WAVE_FORMAT_IEEE_FLOAT) {
+        switch (bits) {
+        case 32:
+            return SPA_AUDIO_FORMAT_F32;
+        case 64:
+            return SPA_AUDIO_FORMAT_F64;
+        }
+    }
+    return SPA_AUDIO_FORMAT_UNKNOWN;
+}
+
+} // namespace
+
+FileSource::FileSource()
+    : mapping(NULL)
+    , mappingSize(0)
+    , data(NULL)
+    , frames(0)
+    , frameBytes(0)
+    , channels(0)
+    , rate(0)
+    , format(SPA_AUDIO_FORMAT_UNKNOWN)
+    , decoder(NULL)
+    , looping(false)
+    , position(0)
+    , ended(false)
+    , cursor(0)
+{
+}
+
+FileSource::~FileSource()
+{
+    unmap();
+}
+
+bool FileSource::isReadable(spa_audio_format format)
+{
+    FileFormatInfo info;
+    return describe(format, info);
+}
+
+bool FileSource::open(const std::string& path, const RawFileFormat* raw, std::string& error)
+{
+    unmap();
+
+    auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = std::string("Cannot open ") + path + ": " + strerror(errno);
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) < 0 || info.st_size == 0) {
+        error = "Cannot play an empty file: " + path;
+        ::close(fd);
+        return false;
+    }
+
+    // Populating here, off the RT thread, reads the file in before it plays
+    mappingSize = (size_t)info.st_size;
+    mapping = mmap(NULL, mappingSize, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    ::close(fd); // The mapping keeps the file alive
+    if (mapping == MAP_FAILED) {
+        mapping = NULL;
+        error = std::string("Cannot map ") + path + ": " + strerror(errno);
+        return false;
+    }
+    madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+
+    size_t dataSize;
+    if (raw) {
+        format = raw->format;
+        channels = raw->channels;
+        rate = raw->rate;
+        data = (const uint8_t*)mapping;
+        dataSize = mappingSize;
+    } else if (!parseWav(dataSize, error)) {
+        unmap();
+        return false;
+    }
+
+    FileFormatInfo described;
+    if (!describe(format, described)) {
+        error = "Unsupported sample format in " + path;
+        unmap();
+        return false;
+    }
+    if (!channels || channels > FILE_SOURCE_MAX_CHANNELS || !rate) {
+        error = "Unsupported channel count or rate in " + path;
+        unmap();
+        return false;
+    }
+
+    decoder = described.decoder;
+    frameBytes = described.bytes * channels;
+    frames = dataSize / frameBytes;
+    if (!frames) {
+        error = "No audio in " + path;
+        unmap();
+        return false;
+    }
+    return true;
+}
+
+bool FileSource::parseWav(size_t& dataSize, std::string& error)
+{
+    auto bytes = (const uint8_t*)mapping;
+    if (mappingSize < 12 || memcmp(bytes, "RIFF", 4) || memcmp(bytes + 8, "WAVE", 4)) {
+        error = "Not a WAV file";
+        return false;
+    }
+
+    bool haveFormat = false;
+    for (size_t at = 12; at + 8 <= mappingSize;) {
+        auto id = bytes + at;
+        auto size = (size_t)readU32(bytes + at + 4);
+        auto body = at + 8;
+
+        if (!memcmp(id, "fmt ", 4) && size >= 16 && body + size <= mappingSize) {
+            auto tag = readU16(bytes + body);
+            channels = readU16(bytes + body + 2);
+            rate = readU32(bytes + body + 4);
+            auto bits = readU16(bytes + body + 14);
+            if (tag == WAVE_FORMAT_EXTENSIBLE && size >= 40) {
+                tag = readU16(bytes + body + 24); // First two bytes of the sub-format GUID
+            }
+            format = wavFormat(tag, bits);
+            haveFormat = true;
+        } else if (!memcmp(id, "data", 4)) {
+            if (!haveFormat) {
+                error = "WAV data chunk comes before its format";
+                return false;
+            }
+            // Streamed WAVs leave the size 0 or 0xFFFFFFFF; play to the end
+            auto available = mappingSize - body;
+            data = bytes + body;
+            dataSize = size && size <= available ? size : available;
+            return true;
+        }
+        at = body + size + (size & 1); // Chunks are padded to even sizes
+    }
+
+    error = "WAV file has no data chunk";
+    return false;
+}
+
+void FileSource::unmap()
+{
+    if (mapping) {
+        munmap(mapping, mappingSize);
+        mapping = NULL;
+    }
+    data = NULL;
+    frames = 0;
+}
+
+void FileSource::start(uint64_t offsetFrames, bool loop)
+{
+    cursor = std::min(offsetFrames, frames);
+    position.store(cursor, std::memory_order_relaxed);
+    looping.store(loop, std::memory_order_relaxed);
+    ended.store(false, std::memory_order_relaxed);
+}
+
+uint32_t FileSource::getChannels() const
+{
+    return channels;
+}
+
+uint32_t FileSource::getRate() const
+{
+    return rate;
+}
+
+uint64_t FileSource::getFrames() const
+{
+    return frames;
+}
+
+spa_audio_format FileSource::getFormat() const
+{
+    return format;
+}
+
+void FileSource::setLooping(bool loop)
+{
+    looping.store(loop, std::memory_order_relaxed);
+}
+
+uint64_t FileSource::getPosition() const
+{
+    return position.load(std::memory_order_relaxed);
+}
+
+bool FileSource::hasEnded() const
+{
+    return ended.load(std::memory_order_acquire);
+}
+
+uint32_t FileSource::render(float* dest, uint32_t count)
+{
+    if (ended.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+
+    uint32_t done = 0;
+    while (done < count) {
+        if (cursor >= frames) {
+            if (!looping.load(std::memory_order_relaxed)) {
+                ended.store(true, std::memory_order_release);
+                break;
+            }
+            cursor = 0;
+        }
+        auto take = (uint32_t)std::min<uint64_t>(count - done, frames - cursor);
+        decoder(data + cursor * frameBytes, dest + (size_t)done * channels, (size_t)take * channels);
+        done += take;
+        cursor += take;
+    }
+    position.store(cursor, std::memory_order_relaxed);
+    return done;
+}
@@ -0,0 +1,77 @@
+#ifndef PIPEWIRE_FILE_SOURCE_HPP
+#define PIPEWIRE_FILE_SOURCE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <spa/param/audio/raw.h>
+#include <string>
+
+#define FILE_SOURCE_MAX_CHANNELS 32
+
+// How to read a headerless PCM file
+struct RawFileFormat {
+    spa_audio_format format;
+    uint32_t channels;
+    uint32_t rate;
+};
+
+// A WAV or raw PCM file mapped into memory and decoded to Float32 on the RT
+// thread as the mixer plays it.
+//
+// open() maps the whole file with MAP_POPULATE, so the pages are read in on
+// the (worker) thread that opens it and the RT thread finds them resident
+// rather than faulting to disk. Only the header is parsed; samples stay in
+// the page cache, not on the JS heap. Decoding covers U8, S16, packed S24,
+// S24_32, S32, F32 and F64, little-endian.
+class FileSource {
+
+public:
+    FileSource();
+    ~FileSource();
+    FileSource(const FileSource&) = delete;
+    FileSource& operator=(const FileSource&) = delete;
+
+    // Not RT safe. raw is NULL for a WAV file; returns false with error set
+    bool open(const std::string& path, const RawFileFormat* raw, std::string& error);
+    void start(uint64_t offsetFrames, bool loop); // Before the mixer sees it
+
+    uint32_t getChannels() const;
+    uint32_t getRate() const;
+    uint64_t getFrames() const;
+    spa_audio_format getFormat() const;
+
+    // Any thread
+    void setLooping(bool loop);
+    uint64_t getPosition() const;
+    bool hasEnded() const;
+
+    // RT thread; writes up to `frames` interleaved frames at the file's
+    // channel count and returns how many it wrote (fewer only at the end)
+    uint32_t render(float* dest, uint32_t frames);
+
+    static bool isReadable(spa_audio_format format);
+
+private:
+    using Decoder = void (*)(const uint8_t* source, float* dest, size_t samples);
+
+    void* mapping;
+    size_t mappingSize;
+    const uint8_t* data; // First sample frame
+    uint64_t frames;
+    uint32_t frameBytes;
+    uint32_t channels;
+    uint32_t rate;
+    spa_audio_format format;
+    Decoder decoder;
+
+    std::atomic<bool> looping;
+    std::atomic<uint64_t> position; // Published after each render()
+    std::atomic<bool> ended;
+    uint64_t cursor; // RT thread only
+
+    bool parseWav(size_t& dataSize, std::string& error);
+    void unmap();
+};
+
+#endif // PIPEWIRE_FILE_SOURCE_HPP
@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#endif
+
+#include "level-meter.hpp"
+
+namespace {
+
+// Largest absolute value of the four interpolated points between the last
+// two samples: one multiply-add per tap for all phases at once
+float interpolatedPeak(const float* window, const float (*taps)[TRUE_PEAK_PHASES])
+{
+#if HAVE_X86_SIMD
+    auto sum = _mm_setzero_ps();
+    for (uint32_t i = 0; i < TRUE_PEAK_TAPS; i++) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(window[i]), _mm_loadu_ps(taps[i])));
+    }
+    sum = _mm_andnot_ps(_mm_set1_ps(-0.0f), sum);
+    sum = _mm_max_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_max_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+#elif HAVE_NEON
+    auto sum = vdupq_n_f32(0.0f);
+    for (uint32_t i = 0; i < TRUE_PEAK_TAPS; i++) {
+        sum = vmlaq_n_f32(sum, vld1q_f32(taps[i]), window[i]);
+    }
+    return vmaxvq_f32(vabsq_f32(sum));
+#else
+    float sum[TRUE_PEAK_PHASES] = {};
+    for (uint32_t i = 0; i < TRUE_PEAK_TAPS; i++) {
+        for (uint32_t p = 0; p < TRUE_PEAK_PHASES; p++) {
+            sum[p] += window[i] * taps[i][p];
+        }
+    }
+    float peak = 0.0f;
+    for (auto value : sum) {
+        peak = std::max(peak, std::abs(value));
+    }
+    return peak;
+#endif
+}
+
+} // namespace
+
+LevelMeter::LevelMeter()
+    : enabled(false)
+    , truePeak(false)
+    , channels(0)
+    , windowFrames(0)
+    , sequence(0)
+    , windows(0)
+    , windowFill(0)
+    , peakSum {}
+    , squareSum {}
+    , truePeakSum {}
+    , history {}
+    , historyPosition(0)
+    , phaseTaps {}
+{
+    for (uint32_t ch = 0; ch < METER_MAX_CHANNELS; ch++) {
+        peaks[ch].store(0.0f, std::memory_order_relaxed);
+        levels[ch].store(0.0f, std::memory_order_relaxed);
+        truePeaks[ch].store(0.0f, std::memory_order_relaxed);
+    }
+}
+
+void LevelMeter::configure(uint32_t channels, uint32_t rate, double updatesPerSecond, bool truePeak)
+{
+    if (!channels || channels > METER_MAX_CHANNELS || !rate || updatesPerSecond <= 0.0) {
+        disable();
+        return;
+    }
+
+    this->channels = channels;
+    this->truePeak = truePeak;
+    windowFrames = std::max<uint32_t>(1, (uint32_t)std::lround(rate / updatesPerSecond));
+    windowFill = 0;
+    std::fill(std::begin(peakSum), std::end(peakSum), 0.0f);
+    std::fill(std::begin(squareSum), std::end(squareSum), 0.0);
+    std::fill(std::begin(truePeakSum), std::end(truePeakSum), 0.0f);
+    std::fill(&history[0][0], &history[0][0] + sizeof(history) / sizeof(float), 0.0f);
+    historyPosition = 0;
+
+    // Phase p of a 4x interpolator: a Blackman-windowed sinc cut off at the
+    // original Nyquist frequency, with unity gain at DC
+    const auto length = TRUE_PEAK_PHASES * TRUE_PEAK_TAPS;
+    const auto center = (length - 1) / 2.0;
+    for (uint32_t p = 0; p < TRUE_PEAK_PHASES; p++) {
+        for (uint32_t k = 0; k < TRUE_PEAK_TAPS; k++) {
+            auto n = p + k * TRUE_PEAK_PHASES;
+            auto x = (n - center) / TRUE_PEAK_PHASES;
+            auto sinc = x == 0.0 ? 1.0 : std::sin(std::numbers::pi * x) / (std::numbers::pi * x);
+            auto w = 2.0 * std::numbers::pi * (n + 0.5) / length;
+            auto window = 0.42 - 0.5 * std::cos(w) + 0.08 * std::cos(2.0 * w);
+            // Tap k weighs the sample k frames back; stored oldest first
+            phaseTaps[TRUE_PEAK_TAPS - 1 - k][p] = (float)(sinc * window);
+        }
+        float sum = 0.0f;
+        for (uint32_t k = 0; k < TRUE_PEAK_TAPS; k++) {
+            sum += phaseTaps[k][p];
+        }
+        for (uint32_t k = 0; k < TRUE_PEAK_TAPS; k++) {
+            phaseTaps[k][p] /= sum;
+        }
+    }
+    enabled = true;
+}
+
+void LevelMeter::disable()
+{
+    enabled = false;
+}
+
+bool LevelMeter::isEnabled() const
+{
+    return enabled;
+}
+
+bool LevelMeter::hasTruePeak() const
+{
+    return enabled && truePeak;
+}
+
+bool LevelMeter::process(const float* frames, uint32_t count)
+{
+    auto published = false;
+    for (uint32_t done = 0; done < count;) {
+        auto take = std::min(count - done, windowFrames - windowFill);
+        accumulate(frames + (size_t)done * channels, take);
+        if (truePeak) {
+            accumulateTruePeak(frames + (size_t)done * channels, take);
+        }
+        done += take;
+        windowFill += take;
+
+        if (windowFill == windowFrames) {
+            publish();
+            published = true;
+        }
+    }
+    return published;
+}
+
+void LevelMeter::accumulate(const float* frames, uint32_t count)
+{
+    auto samples = (size_t)count * channels;
+    size_t i = 0;
+
+    // With 1, 2 or 4 channels, lane n of a 4-wide vector always holds
+    // channel n % channels
+    if (4 % channels == 0) {
+        float peakLanes[4] = {};
+        float squareLanes[4] = {};
+#if HAVE_X86_SIMD
+        auto signMask = _mm_set1_ps(-0.0f);
+        auto peak = _mm_setzero_ps();
+        auto squares = _mm_setzero_ps();
+        for (; i + 4 <= samples; i += 4) {
+            auto value = _mm_loadu_ps(frames + i);
+            peak = _mm_max_ps(peak, _mm_andnot_ps(signMask, value));
+            squares = _mm_add_ps(squares, _mm_mul_ps(value, value));
+        }
+        _mm_storeu_ps(peakLanes, peak);
+        _mm_storeu_ps(squareLanes, squares);
+#elif HAVE_NEON
+        auto peak = vdupq_n_f32(0.0f);
+        auto squares = vdupq_n_f32(0.0f);
+        for (; i + 4 <= samples; i += 4) {
+            auto value = vld1q_f32(frames + i);
+            peak = vmaxq_f32(peak, vabsq_f32(value));
+            squares = vmlaq_f32(squares, value, value);
+        }
+        vst1q_f32(peakLanes, peak);
+        vst1q_f32(squareLanes, squares);
+#endif
+        for (uint32_t lane = 0; lane < 4; lane++) {
+            auto ch = lane % channels;
+            peakSum[ch] = std::max(peakSum[ch], peakLanes[lane]);
+            squareSum[ch] += squareLanes[lane];
+        }
+    }
+
+    // i is a multiple of the channel count here
+    for (; i < samples; i++) {
+        auto ch = i % channels;
+        auto value = frames[i];
+        peakSum[ch] = std::max(peakSum[ch], std::abs(value));
+        squareSum[ch] += (double)value * value;
+    }
+}
+
+void LevelMeter::accumulateTruePeak(const float* frames, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        auto slot = historyPosition;
+        historyPosition = (historyPosition + 1) % TRUE_PEAK_TAPS;
+
+        for (uint32_t ch = 0; ch < channels; ch++) {
+            auto lane = history[ch];
+            auto value = frames[(size_t)i * channels + ch];
+            lane[slot] = value;
+            lane[slot + TRUE_PEAK_TAPS] = value;
+
+            // The last TRUE_PEAK_TAPS samples, oldest first
+            auto window = lane + historyPosition;
+            truePeakSum[ch] = std::max(truePeakSum[ch], interpolatedPeak(window, phaseTaps));
+        }
+    }
+}
+
+void LevelMeter::publish()
+{
+    // Writers never wait; a reader that saw an odd or changed sequence retries
+    auto start = sequence.load(std::memory_order_relaxed);
+    sequence.store(start + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (uint32_t ch = 0; ch < channels; ch++) {
+        peaks[ch].store(peakSum[ch], std::memory_order_relaxed);
+        levels[ch].store((float)std::sqrt(squareSum[ch] / windowFrames), std::memory_order_relaxed);
+        // Never below the sample peak, which the interpolator can undershoot
+        truePeaks[ch].store(std::max(truePeakSum[ch], peakSum[ch]), std::memory_order_relaxed);
+        peakSum[ch] = 0.0f;
+        squareSum[ch] = 0.0;
+        truePeakSum[ch] = 0.0f;
+    }
+    windows.store(windows.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    sequence.store(start + 2, std::memory_order_release);
+    windowFill = 0;
+}
+
+void LevelMeter::read(LevelReading& reading) const
+{
+    reading.channels = enabled ? channels : 0;
+    for (;;) {
+        auto before = sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        reading.windows = windows.load(std::memory_order_relaxed);
+        for (uint32_t ch = 0; ch < reading.channels; ch++) {
+            reading.peak[ch] = peaks[ch].load(std::memory_order_relaxed);
+            reading.rms[ch] = levels[ch].load(std::memory_order_relaxed);
+            reading.truePeak[ch] = truePeaks[ch].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef PIPEWIRE_LEVEL_METER_HPP
+#define PIPEWIRE_LEVEL_METER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#define METER_MAX_CHANNELS 64
+#define TRUE_PEAK_PHASES 4 // Oversampling factor for true-peak detection
+#define TRUE_PEAK_TAPS 12 // Per phase
+
+struct LevelReading {
+    uint32_t channels;
+    uint64_t windows; // Readings published so far
+    float peak[METER_MAX_CHANNELS]; // Largest absolute sample
+    float rms[METER_MAX_CHANNELS];
+    float truePeak[METER_MAX_CHANNELS]; // Only filled when true peak is metered
+};
+
+// Per-channel peak, RMS and (optionally) true-peak meters over the
+// interleaved Float32 audio a stream is about to hand to PipeWire.
+//
+// The RT thread accumulates each channel over a fixed window of frames and
+// publishes the finished window all at once, so JS reads consistent levels
+// at the update rate however often it looks. Publishing goes through a
+// sequence counter (a seqlock); readers retry instead of blocking the RT
+// thread. True peak oversamples 4x with a short windowed-sinc filter, as
+// ITU-R BS.1770 describes, and costs 48 multiply-adds (12 vector ones) per sample
+// and channel, so it is opt-in.
+class LevelMeter {
+
+public:
+    LevelMeter();
+
+    // Only while the RT thread is not metering: before connect(), or on the
+    // data loop between two cycles
+    void configure(uint32_t channels, uint32_t rate, double updatesPerSecond, bool truePeak);
+    void disable();
+    bool isEnabled() const;
+
+    // RT thread; returns true when a window finished and was published
+    bool process(const float* frames, uint32_t count);
+
+    // JS thread
+    void read(LevelReading& reading) const;
+    bool hasTruePeak() const;
+
+private:
+    bool enabled;
+    bool truePeak;
+    uint32_t channels;
+    uint32_t windowFrames;
+
+    std::atomic<uint32_t> sequence; // Odd while a window is being published
+    std::atomic<uint64_t> windows;
+    std::atomic<float> peaks[METER_MAX_CHANNELS];
+    std::atomic<float> levels[METER_MAX_CHANNELS];
+    std::atomic<float> truePeaks[METER_MAX_CHANNELS];
+
+    // RT thread only
+    uint32_t windowFill;
+    float peakSum[METER_MAX_CHANNELS];
+    double squareSum[METER_MAX_CHANNELS];
+    float truePeakSum[METER_MAX_CHANNELS];
+    float history[METER_MAX_CHANNELS][TRUE_PEAK_TAPS * 2]; // Each sample stored twice, so a window is contiguous
+    uint32_t historyPosition;
+
+    float phaseTaps[TRUE_PEAK_TAPS][TRUE_PEAK_PHASES]; // Oldest sample first, all phases of a tap together
+
+    void accumulate(const float* frames, uint32_t count);
+    void accumulateTruePeak(const float* frames, uint32_t count);
+    void publish();
+};
+
+#endif // PIPEWIRE_LEVEL_METER_HPP
@@ -0,0 +1,797 @@
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#endif
+
+#include "mixer.hpp"
+
+#define PAN_KNOT_FRAMES 16 // Frames between exact evaluations of a moving pan law
+#define PAN_KNOT_TOLERANCE 0.0005f // How far from a straight line a knot's pans may bend
+
+namespace {
+
+// bus[i] += source[i] * gains[i % 2]; the stereo and uniform-gain case
+void addInterleavedStereo(float* bus, const float* source, size_t frames, float left, float right)
+{
+    size_t i = 0;
+#if HAVE_X86_SIMD
+    auto gains = _mm_setr_ps(left, right, left, right);
+    for (; i + 2 <= frames; i += 2) {
+        auto mixed = _mm_add_ps(_mm_loadu_ps(bus + i * 2), _mm_mul_ps(_mm_loadu_ps(source + i * 2), gains));
+        _mm_storeu_ps(bus + i * 2, mixed);
+    }
+#elif HAVE_NEON
+    float pattern[4] = { left, right, left, right };
+    auto gains = vld1q_f32(pattern);
+    for (; i + 2 <= frames; i += 2) {
+        vst1q_f32(bus + i * 2, vmlaq_f32(vld1q_f32(bus + i * 2), vld1q_f32(source + i * 2), gains));
+    }
+#endif
+    for (; i < frames; i++) {
+        bus[i * 2] += source[i * 2] * left;
+        bus[i * 2 + 1] += source[i * 2 + 1] * right;
+    }
+}
+
+// Mono source spread onto a stereo bus with separate left/right gains
+void addMonoToStereo(float* bus, const float* source, size_t frames, float left, float right)
+{
+    size_t i = 0;
+#if HAVE_X86_SIMD
+    auto gains = _mm_setr_ps(left, right, left, right);
+    for (; i + 4 <= frames; i += 4) {
+        auto samples = _mm_loadu_ps(source + i);
+        auto low = _mm_unpacklo_ps(samples, samples); // s0 s0 s1 s1
+        auto high = _mm_unpackhi_ps(samples, samples); // s2 s2 s3 s3
+        _mm_storeu_ps(bus + i * 2, _mm_add_ps(_mm_loadu_ps(bus + i * 2), _mm_mul_ps(low, gains)));
+        _mm_storeu_ps(bus + i * 2 + 4, _mm_add_ps(_mm_loadu_ps(bus + i * 2 + 4), _mm_mul_ps(high, gains)));
+    }
+#elif HAVE_NEON
+    float pattern[2] = { left, right };
+    auto gains = vld1_f32(pattern);
+    for (; i + 4 <= frames; i += 4) {
+        auto samples = vld1q_f32(source + i);
+        auto out = vld2q_f32(bus + i * 2); // Deinterleaved left/right lanes
+        out.val[0] = vmlaq_lane_f32(out.val[0], samples, gains, 0);
+        out.val[1] = vmlaq_lane_f32(out.val[1], samples, gains, 1);
+        vst2q_f32(bus + i * 2, out);
+    }
+#endif
+    for (; i < frames; i++) {
+        bus[i * 2] += source[i] * left;
+        bus[i * 2 + 1] += source[i] * right;
+    }
+}
+
+// Mono source onto a stereo bus with per-frame left/right gains
+void addMonoToStereoRamped(float* bus, const float* source, size_t frames, const float* left, const float* right)
+{
+    size_t i = 0;
+#if HAVE_X86_SIMD
+    for (; i + 4 <= frames; i += 4) {
+        auto samples = _mm_loadu_ps(source + i);
+        auto toLeft = _mm_mul_ps(samples, _mm_loadu_ps(left + i));
+        auto toRight = _mm_mul_ps(samples, _mm_loadu_ps(right + i));
+        _mm_storeu_ps(bus + i * 2, _mm_add_ps(_mm_loadu_ps(bus + i * 2), _mm_unpacklo_ps(toLeft, toRight)));
+        _mm_storeu_ps(bus + i * 2 + 4, _mm_add_ps(_mm_loadu_ps(bus + i * 2 + 4), _mm_unpackhi_ps(toLeft, toRight)));
+    }
+#elif HAVE_NEON
+    for (; i + 4 <= frames; i += 4) {
+        auto samples = vld1q_f32(source + i);
+        auto out = vld2q_f32(bus + i * 2);
+        out.val[0] = vmlaq_f32(out.val[0], samples, vld1q_f32(left + i));
+        out.val[1] = vmlaq_f32(out.val[1], samples, vld1q_f32(right + i));
+        vst2q_f32(bus + i * 2, out);
+    }
+#endif
+    for (; i < frames; i++) {
+        bus[i * 2] += source[i] * left[i];
+        bus[i * 2 + 1] += source[i] * right[i];
+    }
+}
+
+// Interleaved stereo source with per-frame left/right gains
+void addInterleavedStereoRamped(float* bus, const float* source, size_t frames, const float* left, const float* right)
+{
+    size_t i = 0;
+#if HAVE_X86_SIMD
+    for (; i + 4 <= frames; i += 4) {
+        auto l = _mm_loadu_ps(left + i);
+        auto r = _mm_loadu_ps(right + i);
+        auto low = _mm_mul_ps(_mm_loadu_ps(source + i * 2), _mm_unpacklo_ps(l, r));
+        auto high = _mm_mul_ps(_mm_loadu_ps(source + i * 2 + 4), _mm_unpackhi_ps(l, r));
+        _mm_storeu_ps(bus + i * 2, _mm_add_ps(_mm_loadu_ps(bus + i * 2), low));
+        _mm_storeu_ps(bus + i * 2 + 4, _mm_add_ps(_mm_loadu_ps(bus + i * 2 + 4), high));
+    }
+#elif HAVE_NEON
+    for (; i + 4 <= frames; i += 4) {
+        auto samples = vld2q_f32(source + i * 2);
+        auto out = vld2q_f32(bus + i * 2);
+        out.val[0] = vmlaq_f32(out.val[0], samples.val[0], vld1q_f32(left + i));
+        out.val[1] = vmlaq_f32(out.val[1], samples.val[1], vld1q_f32(right + i));
+        vst2q_f32(bus + i * 2, out);
+    }
+#endif
+    for (; i < frames; i++) {
+        bus[i * 2] += source[i * 2] * left[i];
+        bus[i * 2 + 1] += source[i * 2 + 1] * right[i];
+    }
+}
+
+void addScaled(float* bus, const float* source, size_t samples, float gain)
+{
+    size_t i = 0;
+#if HAVE_X86_SIMD
+    auto gains = _mm_set1_ps(gain);
+    for (; i + 4 <= samples; i += 4) {
+        _mm_storeu_ps(bus + i, _mm_add_ps(_mm_loadu_ps(bus + i), _mm_mul_ps(_mm_loadu_ps(source + i), gains)));
+    }
+#elif HAVE_NEON
+    for (; i + 4 <= samples; i += 4) {
+        vst1q_f32(bus + i, vmlaq_n_f32(vld1q_f32(bus + i), vld1q_f32(source + i), gain));
+    }
+#endif
+    for (; i < samples; i++) {
+        bus[i] += source[i] * gain;
+    }
+}
+
+} // namespace
+
+Mixer::Mixer()
+    : inputCount(0)
+    , rate(48000)
+    , inputsEnded(false)
+    , voicesTriggered(0)
+{
+}
+
+int Mixer::addInput(uint32_t channels, size_t frames, float gain, float pan)
+{
+    auto input = claimInput();
+    if (!input) {
+        return -1;
+    }
+
+    // The RT thread ignores FREE slots, so the ring can be (re)allocated here
+    input->ring.allocate(frames * channels * sizeof(float));
+    input->file.reset();
+    input->sample.reset();
+    input->nextSample.reset();
+    input->voice = false;
+    input->generated = false;
+    input->clip = false;
+    input->channels = channels;
+    activate(*input, gain, pan);
+    return input - inputs;
+}
+
+int Mixer::addGenerator(uint32_t waveform, float frequency, float amplitude, float phase, float gain, float pan)
+{
+    auto input = claimInput();
+    if (!input) {
+        return -1;
+    }
+
+    input->ring.allocate(0);
+    input->file.reset();
+    input->sample.reset();
+    input->nextSample.reset();
+    input->voice = false;
+    input->oscillator.reset(waveform, frequency, amplitude, phase);
+    input->generated = true;
+    input->clip = false;
+    input->channels = 1;
+    activate(*input, gain, pan);
+    return input - inputs;
+}
+
+Oscillator* Mixer::generator(uint32_t id)
+{
+    auto input = activeInput(id);
+    return input && input->generated ? &input->oscillator : NULL;
+}
+
+EffectChain* Mixer::effects(uint32_t id, uint32_t& channels)
+{
+    auto input = activeInput(id);
+    if (!input) {
+        return NULL;
+    }
+    channels = input->channels;
+    return &input->effects;
+}
+
+int Mixer::addFile(std::shared_ptr<FileSource> file, float gain, float pan)
+{
+    auto input = claimInput();
+    if (!input) {
+        return -1;
+    }
+
+    input->ring.allocate(0);
+    input->sample.reset();
+    input->nextSample.reset();
+    input->voice = false;
+    input->generated = false;
+    input->clip = false;
+    input->channels = file->getChannels();
+    input->file = std::move(file);
+    activate(*input, gain, pan);
+    return input - inputs;
+}
+
+FileSource* Mixer::file(uint32_t id)
+{
+    auto input = activeInput(id);
+    return input ? input->file.get() : NULL;
+}
+
+int Mixer::addClip(const float* samples, size_t frames, uint32_t channels, uint64_t startFrame, float gain, float pan)
+{
+    auto input = claimInput();
+    if (!input) {
+        return -1;
+    }
+
+    // Filled before the slot goes live, so the RT thread sees the whole clip
+    auto size = frames * channels * sizeof(float);
+    input->ring.allocate(size);
+    input->ring.write((const uint8_t*)samples, size, size);
+    input->file.reset();
+    input->sample.reset();
+    input->nextSample.reset();
+    input->voice = false;
+    input->generated = false;
+    input->clip = true;
+    input->channels = channels;
+    activate(*input, gain, pan, startFrame);
+    return input - inputs;
+}
+
+int Mixer::addVoice(std::shared_ptr<const CachedSample> sample, uint64_t startFrame, float gain, float pan, uint32_t polyphony)
+{
+    // Voices already being stolen are on their way out and do not count.
+    // Voices awaiting a handoff count as the voice they are about to become.
+    uint32_t playing = 0;
+    MixerInput* oldest = NULL;
+    MixerInput* cut = NULL; // Oldest voice that can be cut, fading ones first
+    for (auto& input : inputs) {
+        auto state = input.state.load(std::memory_order_acquire);
+        if ((state != MIXER_INPUT_ACTIVE && state != MIXER_INPUT_HANDOFF) || !input.voice) {
+            continue;
+        }
+        auto stealing = input.stealing.load(std::memory_order_relaxed);
+        if (state == MIXER_INPUT_ACTIVE
+            && (!cut || stealing > cut->stealing.load(std::memory_order_relaxed)
+                || (stealing == cut->stealing.load(std::memory_order_relaxed) && input.voiceSequence < cut->voiceSequence))) {
+            cut = &input;
+        }
+        if (stealing) {
+            continue;
+        }
+        playing++;
+        if (!oldest || input.voiceSequence < oldest->voiceSequence) {
+            oldest = &input;
+        }
+    }
+
+    auto input = claimInput();
+    if (!input && cut) {
+        // The next fields are only read once the state says HANDOFF. If the
+        // RT thread freed the voice meanwhile, the slot is simply free.
+        cut->nextSample = sample;
+        cut->nextStartFrame = startFrame;
+        cut->nextGain = gain;
+        cut->nextPan = pan;
+        uint32_t expected = MIXER_INPUT_ACTIVE;
+        if (cut->state.compare_exchange_strong(expected, MIXER_INPUT_HANDOFF, std::memory_order_release)) {
+            // Cleared only once the handoff is certain, so a voice still
+            // fading out is never heard again at full level. restartVoice()
+            // clears it too, in case the RT thread gets there first.
+            cut->stealing.store(false, std::memory_order_relaxed);
+            if (cut == oldest) {
+                playing--;
+                oldest = NULL;
+            }
+            cut->voiceSequence = ++voicesTriggered;
+        } else {
+            cut->nextSample.reset();
+            input = claimInput();
+            cut = NULL;
+        }
+    } else {
+        cut = NULL;
+    }
+    if (!input && !cut) {
+        return -1;
+    }
+
+    if (playing >= polyphony) {
+        // The handed-off slot now holds the newest voice, so look again
+        // when it was the oldest
+        if (!oldest) {
+            for (auto& other : inputs) {
+                auto state = other.state.load(std::memory_order_acquire);
+                if (&other != cut && (state == MIXER_INPUT_ACTIVE || state == MIXER_INPUT_HANDOFF) && other.voice
+                    && !other.stealing.load(std::memory_order_relaxed)
+                    && (!oldest || other.voiceSequence < oldest->voiceSequence)) {
+                    oldest = &other;
+                }
+            }
+        }
+        if (oldest) {
+            oldest->stealing.store(true, std::memory_order_release);
+        }
+    }
+    if (cut) {
+        return cut - inputs;
+    }
+
+    input->ring.allocate(0);
+    input->file.reset();
+    input->nextSample.reset();
+    input->generated = false;
+    input->clip = false;
+    input->channels = sample->channels;
+    input->sample = std::move(sample);
+    input->voice = true;
+    input->voiceSequence = ++voicesTriggered;
+    input->stealing.store(false, std::memory_order_relaxed);
+    input->cursor = 0;
+    input->fadeLeft = MIXER_STEAL_FRAMES;
+    activate(*input, gain, pan, startFrame);
+    return input - inputs;
+}
+
+bool Mixer::hasEnded(uint32_t id)
+{
+    auto input = activeInput(id);
+    return input && input->ended.load(std::memory_order_acquire);
+}
+
+void Mixer::setRate(uint32_t rate)
+{
+    this->rate.store(rate, std::memory_order_relaxed);
+}
+
+MixerInput* Mixer::claimInput()
+{
+    for (auto& input : inputs) {
+        if (input.state.load(std::memory_order_acquire) == MIXER_INPUT_FREE) {
+            return &input;
+        }
+    }
+    return NULL;
+}
+
+void Mixer::activate(MixerInput& input, float gain, float pan, uint64_t startFrame)
+{
+    input.gain.reset(gain);
+    input.pan.reset(pan);
+    input.startFrame = startFrame;
+    input.ended.store(false, std::memory_order_relaxed);
+    input.effects.reset();
+    inputCount.fetch_add(1, std::memory_order_relaxed);
+    input.state.store(MIXER_INPUT_ACTIVE, std::memory_order_release);
+}
+
+bool Mixer::removeInput(uint32_t id)
+{
+    // A voice can free itself, or be restarted, between the lookup and the
+    // store; only a slot still ACTIVE is the input JS means
+    if (id >= MIXER_MAX_INPUTS) {
+        return false;
+    }
+    uint32_t expected = MIXER_INPUT_ACTIVE;
+    return inputs[id].state.compare_exchange_strong(expected, MIXER_INPUT_REMOVING, std::memory_order_acq_rel);
+}
+
+bool Mixer::setLevels(uint32_t id, float gain, float pan)
+{
+    auto input = activeInput(id);
+    if (!input) {
+        return false;
+    }
+    // Setting a level cancels that level's scheduled ramps
+    if (!std::isnan(gain)) {
+        input->gain.set(gain);
+    }
+    if (!std::isnan(pan)) {
+        input->pan.set(std::clamp(pan, -1.0f, 1.0f));
+    }
+    return true;
+}
+
+bool Mixer::automate(uint32_t id, bool pan, float target, uint32_t frames, uint64_t startFrame, uint32_t curve)
+{
+    auto input = activeInput(id);
+    if (!input) {
+        return false;
+    }
+    if (pan) {
+        return input->pan.schedule(std::clamp(target, -1.0f, 1.0f), frames, startFrame, curve);
+    }
+    return input->gain.schedule(target, frames, startFrame, curve);
+}
+
+size_t Mixer::write(uint32_t id, const float* samples, size_t sampleCount)
+{
+    auto input = activeInput(id);
+    if (!input || input->generated || input->file || input->clip) {
+        return 0;
+    }
+
+    // Whole frames only; the caller retries the rest
+    auto frameSize = input->channels * sizeof(float);
+    auto size = sampleCount / input->channels * frameSize;
+    return input->ring.write((const uint8_t*)samples, size, input->ring.capacity()) / frameSize;
+}
+
+size_t Mixer::writableFrames(uint32_t id)
+{
+    auto input = activeInput(id);
+    if (!input || input->generated) {
+        return 0;
+    }
+    return input->ring.writable(input->ring.capacity()) / (input->channels * sizeof(float));
+}
+
+size_t Mixer::queuedFrames(uint32_t id)
+{
+    auto input = activeInput(id);
+    if (!input || input->generated) {
+        return 0;
+    }
+    return input->ring.readable() / (input->channels * sizeof(float));
+}
+
+bool Mixer::hasInputs() const
+{
+    return inputCount.load(std::memory_order_relaxed) > 0;
+}
+
+bool Mixer::isDrained()
+{
+    for (uint32_t id = 0; id < MIXER_MAX_INPUTS; id++) {
+        auto source = file(id);
+        auto voiceState = inputs[id].state.load(std::memory_order_acquire);
+        auto voice = inputs[id].voice && (voiceState == MIXER_INPUT_ACTIVE || voiceState == MIXER_INPUT_HANDOFF);
+        if (queuedFrames(id) > 0 || (source && !source->hasEnded()) || voice) {
+            return false;
+        }
+    }
+    return true;
+}
+
+MixerInput* Mixer::activeInput(uint32_t id)
+{
+    if (id >= MIXER_MAX_INPUTS || inputs[id].state.load(std::memory_order_acquire) != MIXER_INPUT_ACTIVE) {
+        return NULL;
+    }
+    return &inputs[id];
+}
+
+uint32_t Mixer::mixInto(float* bus, uint32_t frames, uint32_t channels, uint64_t position)
+{
+    uint32_t mixedFrames = 0;
+    for (auto& input : inputs) {
+        auto state = input.state.load(std::memory_order_acquire);
+        if (state == MIXER_INPUT_REMOVING) {
+            input.state.store(MIXER_INPUT_FREE, std::memory_order_release);
+            inputCount.fetch_sub(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (state == MIXER_INPUT_HANDOFF) {
+            restartVoice(input);
+        } else if (state != MIXER_INPUT_ACTIVE) {
+            continue;
+        }
+
+        // An input scheduled for later is silent until its frame comes up,
+        // then starts at that offset into the block. The wait counts as
+        // supplied audio, so gaps in a sequence are not underruns.
+        if (input.startFrame >= position + frames) {
+            if (input.sample && input.stealing.load(std::memory_order_acquire)) {
+                releaseVoice(input); // Stolen before it was heard
+                continue;
+            }
+            mixedFrames = frames;
+            continue;
+        }
+        auto lead = input.startFrame > position ? (uint32_t)(input.startFrame - position) : 0;
+        auto leadBus = bus + (size_t)lead * channels;
+        auto count = frames - lead;
+        auto at = position + lead;
+
+        if (input.generated) {
+            mixGenerator(input, leadBus, count, channels, at);
+            mixedFrames = frames;
+            continue;
+        }
+        if (input.sample) {
+            auto fromVoice = mixVoice(input, leadBus, count, channels, at);
+            mixedFrames = std::max(mixedFrames, fromVoice ? lead + fromVoice : 0);
+            continue;
+        }
+        if (input.file) {
+            auto fromFile = mixFile(input, leadBus, count, channels, at);
+            mixedFrames = std::max(mixedFrames, fromFile ? lead + fromFile : 0);
+            continue;
+        }
+
+        auto frameSize = input.channels * sizeof(float);
+        RingSpans spans;
+        auto available = input.ring.peek((size_t)count * frameSize, spans);
+        uint32_t offset = 0;
+        for (auto& span : spans.parts) {
+            auto spanFrames = (uint32_t)(span.size / frameSize);
+            mixSpan(input, (const float*)span.data, leadBus + (size_t)offset * channels, spanFrames, channels, at + offset);
+            offset += spanFrames;
+        }
+        input.ring.skip(available);
+        if (available) {
+            mixedFrames = std::max(mixedFrames, lead + (uint32_t)(available / frameSize));
+        }
+        if (input.clip && !input.ring.readable() && !input.ended.load(std::memory_order_relaxed)) {
+            input.ended.store(true, std::memory_order_release);
+            inputsEnded = true;
+        }
+    }
+    return mixedFrames;
+}
+
+void Mixer::mixGenerator(MixerInput& input, float* bus, uint32_t frames, uint32_t channels, uint64_t position)
+{
+    auto sampleRate = rate.load(std::memory_order_relaxed);
+    for (uint32_t done = 0; done < frames; done += MIXER_SCRATCH_FRAMES) {
+        auto count = std::min<uint32_t>(frames - done, MIXER_SCRATCH_FRAMES);
+        input.oscillator.render(scratch, count, sampleRate);
+        mixSpan(input, scratch, bus + (size_t)done * channels, count, channels, position + done);
+    }
+}
+
+uint32_t Mixer::mixFile(MixerInput& input, float* bus, uint32_t frames, uint32_t channels, uint64_t position)
+{
+    auto& source = *input.file;
+    if (source.hasEnded()) {
+        return 0;
+    }
+
+    auto chunk = MIXER_FILE_SCRATCH_SAMPLES / input.channels;
+    uint32_t done = 0;
+    while (done < frames) {
+        auto wanted = std::min(frames - done, chunk);
+        auto count = source.render(fileScratch, wanted);
+        mixSpan(input, fileScratch, bus + (size_t)done * channels, count, channels, position + done);
+        done += count;
+        if (count < wanted) {
+            input.ended.store(true, std::memory_order_release);
+            inputsEnded = true;
+            break;
+        }
+    }
+    return done;
+}
+
+uint32_t Mixer::mixVoice(MixerInput& input, float* bus, uint32_t frames, uint32_t channels, uint64_t position)
+{
+    // Mixed straight from the cached samples; only a fade-out needs a copy
+    auto& sample = *input.sample;
+    auto count = (uint32_t)std::min<size_t>(frames, sample.frames - input.cursor);
+    auto source = sample.samples.data() + input.cursor * input.channels;
+    auto stolen = input.stealing.load(std::memory_order_acquire);
+    if (!stolen) {
+        mixSpan(input, source, bus, count, channels, position);
+    } else {
+        count = std::min(count, input.fadeLeft);
+        auto chunk = MIXER_FILE_SCRATCH_SAMPLES / input.channels;
+        for (uint32_t done = 0; done < count; done += chunk) {
+            auto part = std::min(count - done, chunk);
+            for (uint32_t i = 0; i < part; i++) {
+                auto fade = (float)(input.fadeLeft - done - i) / MIXER_STEAL_FRAMES;
+                for (uint32_t ch = 0; ch < input.channels; ch++) {
+                    fileScratch[i * input.channels + ch] = source[(size_t)(done + i) * input.channels + ch] * fade;
+                }
+            }
+            mixSpan(input, fileScratch, bus + (size_t)done * channels, part, channels, position + done);
+        }
+        input.fadeLeft -= count;
+    }
+
+    input.cursor += count;
+    if (input.cursor == sample.frames || (stolen && !input.fadeLeft)) {
+        releaseVoice(input);
+    }
+    return count;
+}
+
+void Mixer::releaseVoice(MixerInput& input)
+{
+    // No JavaScript tracks a voice, so it frees its own slot. The sample
+    // reference may be the last one, and freeing it is not RT-safe, so JS
+    // drops it in releaseEndedVoices() when it hears the input ended. A
+    // voice JS has just handed a new sample to starts again instead.
+    uint32_t expected = MIXER_INPUT_ACTIVE;
+    if (!input.state.compare_exchange_strong(expected, MIXER_INPUT_FREE, std::memory_order_acq_rel)) {
+        restartVoice(input);
+        return;
+    }
+    inputCount.fetch_sub(1, std::memory_order_relaxed);
+    inputsEnded = true;
+}
+
+void Mixer::restartVoice(MixerInput& input)
+{
+    // A swap, so the old sample is released on the JS thread along with
+    // nextSample. JS does not touch the slot during a handoff, so the
+    // lanes, effects and flags left by the previous sample are reset here.
+    std::swap(input.sample, input.nextSample);
+    input.channels = input.sample->channels;
+    input.startFrame = input.nextStartFrame;
+    input.cursor = 0;
+    input.fadeLeft = MIXER_STEAL_FRAMES;
+    input.gain.reset(input.nextGain);
+    input.pan.reset(input.nextPan);
+    input.effects.reset();
+    input.ended.store(false, std::memory_order_relaxed);
+    input.stealing.store(false, std::memory_order_relaxed);
+    input.state.store(MIXER_INPUT_ACTIVE, std::memory_order_release);
+    inputsEnded = true;
+}
+
+void Mixer::releaseEndedVoices()
+{
+    // JS owns FREE slots, and the nextSample of ACTIVE ones, since only JS
+    // starts a handoff
+    for (auto& input : inputs) {
+        auto state = input.state.load(std::memory_order_acquire);
+        if (state == MIXER_INPUT_FREE) {
+            input.sample.reset();
+            input.nextSample.reset();
+        } else if (state == MIXER_INPUT_ACTIVE) {
+            input.nextSample.reset();
+        }
+    }
+}
+
+bool Mixer::takeEndedInputs()
+{
+    auto ended = inputsEnded;
+    inputsEnded = false;
+    return ended;
+}
+
+void Mixer::mixSpan(MixerInput& input, const float* source, float* bus, uint32_t frames, uint32_t channels, uint64_t position)
+{
+    // Levels are rendered a block at a time; a block where neither is
+    // ramping takes the constant-gain kernels
+    for (uint32_t done = 0; done < frames; done += AUTOMATION_BLOCK_FRAMES) {
+        auto count = std::min<uint32_t>(frames - done, AUTOMATION_BLOCK_FRAMES);
+        auto blockSource = source + (size_t)done * input.channels;
+        auto blockBus = bus + (size_t)done * channels;
+        if (input.effects.hasStages() && input.channels <= EFFECT_MAX_CHANNELS) {
+            std::copy_n(blockSource, (size_t)count * input.channels, effectScratch);
+            input.effects.process(effectScratch, count, input.channels, rate.load(std::memory_order_relaxed));
+            blockSource = effectScratch;
+        }
+
+        float gain, pan;
+        auto steadyGain = input.gain.process(position + done, count, gainValues, gain);
+        auto steadyPan = input.pan.process(position + done, count, panValues, pan);
+        if (steadyGain && steadyPan) {
+            mixSteady(input, blockSource, blockBus, count, channels, gain, pan);
+            continue;
+        }
+
+        if (steadyGain) {
+            std::fill(gainValues, gainValues + count, gain);
+        }
+        if (steadyPan) {
+            std::fill(panValues, panValues + count, pan);
+        }
+        mixAutomated(input, blockSource, blockBus, count, channels, steadyPan);
+    }
+}
+
+void Mixer::mixSteady(const MixerInput& input, const float* source, float* bus, uint32_t frames, uint32_t channels, float gain, float pan)
+{
+    if (channels == 2 && input.channels == 1) {
+        // Constant-power pan law: -3dB per side at centre
+        auto angle = (pan + 1.0f) * (float)std::numbers::pi / 4.0f;
+        addMonoToStereo(bus, source, frames, gain * std::cos(angle), gain * std::sin(angle));
+    } else if (channels == 2 && input.channels == 2) {
+        // Stereo sources get balance rather than panning
+        addInterleavedStereo(bus, source, frames, gain * std::min(1.0f, 1.0f - pan), gain * std::min(1.0f, 1.0f + pan));
+    } else if (input.channels == channels) {
+        addScaled(bus, source, (size_t)frames * channels, gain);
+    } else if (input.channels == 1) {
+        for (uint32_t ch = 0; ch < channels; ch++) {
+            for (uint32_t i = 0; i < frames; i++) {
+                bus[i * channels + ch] += source[i] * gain;
+            }
+        }
+    } else {
+        // Negotiation changed the layout; mix the channels both sides have
+        auto shared = std::min(input.channels, channels);
+        for (uint32_t i = 0; i < frames; i++) {
+            for (uint32_t ch = 0; ch < shared; ch++) {
+                bus[i * channels + ch] += source[i * input.channels + ch] * gain;
+            }
+        }
+    }
+}
+
+void Mixer::mixAutomated(const MixerInput& input, const float* source, float* bus, uint32_t frames, uint32_t channels, bool steadyPan)
+{
+    // Same layouts and pan laws as mixSteady(), with gainValues and
+    // panValues holding one level per frame
+    if (channels == 2 && input.channels == 1) {
+        auto angle = (panValues[0] + 1.0f) * (float)std::numbers::pi / 4.0f;
+        auto left = std::cos(angle);
+        auto right = std::sin(angle);
+        if (steadyPan) {
+            for (uint32_t i = 0; i < frames; i++) {
+                leftGains[i] = gainValues[i] * left;
+                rightGains[i] = gainValues[i] * right;
+            }
+        } else {
+            // A moving pan evaluates the pan law every PAN_KNOT_FRAMES and
+            // interpolates between; ramps are smooth enough for that to be inaudible
+            for (uint32_t knot = 0; knot < frames; knot += PAN_KNOT_FRAMES) {
+                auto end = std::min(frames, knot + PAN_KNOT_FRAMES);
+                auto middle = (knot + end - 1) / 2;
+                auto straight = (panValues[knot] + panValues[end - 1]) * 0.5f;
+                if (std::abs(straight - panValues[middle]) > PAN_KNOT_TOLERANCE) {
+                    // A ramp starts or ends inside this knot; evaluate it exactly
+                    for (uint32_t i = knot; i < end; i++) {
+                        angle = (panValues[i] + 1.0f) * (float)std::numbers::pi / 4.0f;
+                        leftGains[i] = gainValues[i] * std::cos(angle);
+                        rightGains[i] = gainValues[i] * std::sin(angle);
+                    }
+                    left = std::cos(angle);
+                    right = std::sin(angle);
+                    continue;
+                }
+                angle = (panValues[end - 1] + 1.0f) * (float)std::numbers::pi / 4.0f;
+                auto endLeft = std::cos(angle);
+                auto endRight = std::sin(angle);
+                auto span = (float)std::max(1u, end - knot - 1);
+                auto leftStep = (endLeft - left) / span;
+                auto rightStep = (endRight - right) / span;
+                for (uint32_t i = knot; i < end; i++) {
+                    auto offset = (float)(i - knot);
+                    leftGains[i] = gainValues[i] * (left + leftStep * offset);
+                    rightGains[i] = gainValues[i] * (right + rightStep * offset);
+                }
+                left = endLeft;
+                right = endRight;
+            }
+        }
+        addMonoToStereoRamped(bus, source, frames, leftGains, rightGains);
+    } else if (channels == 2 && input.channels == 2) {
+        for (uint32_t i = 0; i < frames; i++) {
+            leftGains[i] = gainValues[i] * std::min(1.0f, 1.0f - panValues[i]);
+            rightGains[i] = gainValues[i] * std::min(1.0f, 1.0f + panValues[i]);
+        }
+        addInterleavedStereoRamped(bus, source, frames, leftGains, rightGains);
+    } else {
+        auto sourceChannels = input.channels;
+        for (uint32_t i = 0; i < frames; i++) {
+            for (uint32_t ch = 0; ch < channels; ch++) {
+                if (sourceChannels == 1) {
+                    bus[i * channels + ch] += source[i] * gainValues[i];
+                } else if (ch < sourceChannels) {
+                    bus[i * channels + ch] += source[i * sourceChannels + ch] * gainValues[i];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,134 @@
+#ifndef PIPEWIRE_MIXER_HPP
+#define PIPEWIRE_MIXER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "automation.hpp"
+#include "effect-chain.hpp"
+#include "file-source.hpp"
+#include "oscillator.hpp"
+#include "ring-buffer.hpp"
+#include "sample-cache.hpp"
+
+#define MIXER_MAX_INPUTS 64
+#define MIXER_SCRATCH_FRAMES 256 // Generators render this many frames at a time
+#define MIXER_FILE_SCRATCH_SAMPLES 2048 // Files decode this many samples at a time
+#define MIXER_STEAL_FRAMES 128 // Fade-out of a voice stolen for a new one
+
+#define MIXER_INPUT_FREE 0
+#define MIXER_INPUT_ACTIVE 1
+#define MIXER_INPUT_REMOVING 2 // Set by JS; the RT thread frees the slot
+#define MIXER_INPUT_HANDOFF 3 // Set by JS on a voice; the RT thread restarts it as the next one
+
+// One source feeding the mixer: Float32 samples, either mono (panned onto
+// the bus) or interleaved at the bus channel count. A generator input has no
+// ring; its mono samples are synthesized by the oscillator as it is mixed.
+// A file input decodes its samples straight from a mapped file. A clip is
+// a ring filled once before it goes live, heard from startFrame and ended
+// when it runs dry. A voice plays a cached sample in place, shared with
+// every other voice of it, and frees its own slot when it finishes or has
+// faded out after being stolen. Any input can run its samples through its
+// own effect chain before they are mixed.
+struct MixerInput {
+    RingBuffer ring;
+    Oscillator oscillator;
+    std::shared_ptr<FileSource> file; // Released by JS once the slot is FREE
+    std::shared_ptr<const CachedSample> sample; // Released by JS once the voice ends
+    std::atomic<bool> stealing { false }; // Set by JS; the RT thread fades the voice out
+    // A voice cut short to make room when every slot is taken is handed
+    // these by JS and restarted with them by the RT thread
+    std::shared_ptr<const CachedSample> nextSample;
+    uint64_t nextStartFrame = 0;
+    float nextGain = 1.0f;
+    float nextPan = 0.0f;
+    bool generated = false;
+    bool clip = false;
+    uint32_t channels = 1;
+    uint64_t startFrame = 0; // Render frame the input is first heard at
+    std::atomic<bool> ended { false }; // Set by the RT thread when a clip or file runs out
+    AutomationLane gain { 1.0f };
+    AutomationLane pan { 0.0f };
+    EffectChain effects;
+    std::atomic<uint32_t> state { MIXER_INPUT_FREE };
+
+    // JS thread only
+    bool voice = false;
+    uint64_t voiceSequence = 0; // Trigger order, for stealing the oldest voice
+
+    // RT thread only
+    size_t cursor = 0; // Next frame of a voice's sample
+    uint32_t fadeLeft = 0; // Frames left of a stolen voice's fade-out
+};
+
+// Sums up to MIXER_MAX_INPUTS rings into a Float32 bus on the RT thread.
+//
+// Slots are fixed so the RT thread never sees storage being allocated: JS
+// only allocates into FREE slots, and a removed slot is handed back to FREE
+// by the RT thread once it has stopped reading it.
+class Mixer {
+
+public:
+    Mixer();
+
+    // JS thread
+    int addInput(uint32_t channels, size_t frames, float gain, float pan);
+    int addGenerator(uint32_t waveform, float frequency, float amplitude, float phase, float gain, float pan);
+    Oscillator* generator(uint32_t id); // NULL unless id is an active generator
+    int addFile(std::shared_ptr<FileSource> file, float gain, float pan);
+    FileSource* file(uint32_t id); // NULL unless id is an active file
+    EffectChain* effects(uint32_t id, uint32_t& channels); // NULL unless id is an active input
+    int addClip(const float* samples, size_t frames, uint32_t channels, uint64_t startFrame, float gain, float pan);
+    // Starts a voice of a cached sample. With `polyphony` voices already
+    // playing, the oldest is faded out to make room; when no slot is free,
+    // a voice (one already fading, if any) is cut off and its slot reused.
+    // Returns -1 only when the slots are full of other inputs.
+    int addVoice(std::shared_ptr<const CachedSample> sample, uint64_t startFrame, float gain, float pan, uint32_t polyphony);
+    bool hasEnded(uint32_t id); // Whether an active clip or file has run out
+    void releaseEndedVoices(); // Drops samples of voices that finished or were replaced
+    void setRate(uint32_t rate); // Sample rate generators render at
+    bool removeInput(uint32_t id);
+    bool setLevels(uint32_t id, float gain, float pan); // NaN leaves a level unchanged
+    bool automate(uint32_t id, bool pan, float target, uint32_t frames, uint64_t startFrame, uint32_t curve);
+    size_t write(uint32_t id, const float* samples, size_t sampleCount); // Returns frames
+    size_t writableFrames(uint32_t id);
+    size_t queuedFrames(uint32_t id);
+    bool hasInputs() const;
+    bool isDrained();
+
+    // RT thread; adds into bus and returns the most frames any input supplied.
+    // position is the first frame's place on the stream's render timeline.
+    uint32_t mixInto(float* bus, uint32_t frames, uint32_t channels, uint64_t position);
+    bool takeEndedInputs(); // Whether a clip, file or voice ended since the last call
+
+private:
+    MixerInput inputs[MIXER_MAX_INPUTS];
+    std::atomic<uint32_t> inputCount;
+    std::atomic<uint32_t> rate;
+    // RT thread only
+    float scratch[MIXER_SCRATCH_FRAMES];
+    float fileScratch[MIXER_FILE_SCRATCH_SAMPLES];
+    float effectScratch[AUTOMATION_BLOCK_FRAMES * EFFECT_MAX_CHANNELS];
+    bool inputsEnded;
+    uint64_t voicesTriggered; // JS thread only
+    float gainValues[AUTOMATION_BLOCK_FRAMES];
+    float panValues[AUTOMATION_BLOCK_FRAMES];
+    float leftGains[AUTOMATION_BLOCK_FRAMES];
+    float rightGains[AUTOMATION_BLOCK_FRAMES];
+
+    MixerInput* claimInput(); // A FREE slot, or NULL when all are taken
+    void activate(MixerInput& input, float gain, float pan, uint64_t startFrame = 0);
+    MixerInput* activeInput(uint32_t id);
+    void mixGenerator(MixerInput& input, float* bus, uint32_t frames, uint32_t channels, uint64_t position);
+    uint32_t mixFile(MixerInput& input, float* bus, uint32_t frames, uint32_t channels, uint64_t position);
+    uint32_t mixVoice(MixerInput& input, float* bus, uint32_t frames, uint32_t channels, uint64_t position);
+    void releaseVoice(MixerInput& input);
+    void restartVoice(MixerInput& input);
+    void mixSpan(MixerInput& input, const float* source, float* bus, uint32_t frames, uint32_t channels, uint64_t position);
+    void mixSteady(const MixerInput& input, const float* source, float* bus, uint32_t frames, uint32_t channels, float gain, float pan);
+    void mixAutomated(const MixerInput& input, const float* source, float* bus, uint32_t frames, uint32_t channels, bool steadyPan);
+};
+
+#endif // PIPEWIRE_MIXER_HPP
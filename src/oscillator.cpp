@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <memory>
+#include <numbers>
+#include <vector>
+
+#include "oscillator.hpp"
+
+#define TABLE_BITS 11
+#define TABLE_SIZE (1u << TABLE_BITS)
+#define TABLE_LEVELS 10 // Level n holds the first 2^n harmonics
+#define FRACTION_BITS (32 - TABLE_BITS)
+
+namespace {
+
+struct Wavetables {
+    float sine[TABLE_SIZE + 1]; // One guard sample for interpolation
+    float shapes[3][TABLE_LEVELS][TABLE_SIZE + 1]; // Square, sawtooth, triangle
+};
+
+// Fourier series weight of a sine harmonic in each shape; 0 when absent
+double harmonicWeight(uint32_t waveform, uint32_t harmonic)
+{
+    auto odd = harmonic % 2 == 1;
+    switch (waveform) {
+    case WAVEFORM_SQUARE:
+        return odd ? 1.0 / harmonic : 0.0;
+    case WAVEFORM_SAWTOOTH:
+        return (odd ? 1.0 : -1.0) / harmonic;
+    case WAVEFORM_TRIANGLE:
+        return odd ? ((harmonic / 2) % 2 ? -1.0 : 1.0) / ((double)harmonic * harmonic) : 0.0;
+    default:
+        return 0.0;
+    }
+}
+
+std::unique_ptr<Wavetables> buildWavetables()
+{
+    auto tables = std::make_unique<Wavetables>();
+
+    std::vector<double> sine(TABLE_SIZE);
+    for (uint32_t i = 0; i < TABLE_SIZE; i++) {
+        sine[i] = std::sin(2.0 * std::numbers::pi * i / TABLE_SIZE);
+        tables->sine[i] = (float)sine[i];
+    }
+    tables->sine[TABLE_SIZE] = tables->sine[0];
+
+    // Each level adds the next octave of harmonics to the one below it, so
+    // the whole set costs one pass per harmonic
+    for (uint32_t waveform = WAVEFORM_SQUARE; waveform <= WAVEFORM_TRIANGLE; waveform++) {
+        std::vector<double> sum(TABLE_SIZE, 0.0);
+        uint32_t harmonic = 1;
+        for (uint32_t level = 0; level < TABLE_LEVELS; level++) {
+            for (; harmonic <= (1u << level); harmonic++) {
+                auto weight = harmonicWeight(waveform, harmonic);
+                if (weight == 0.0) {
+                    continue;
+                }
+                for (uint32_t i = 0; i < TABLE_SIZE; i++) {
+                    sum[i] += weight * sine[(harmonic * i) & (TABLE_SIZE - 1)];
+                }
+            }
+
+            // Normalize to unit peak, Gibbs overshoot included
+            double peak = 0.0;
+            for (auto value : sum) {
+                peak = std::max(peak, std::abs(value));
+            }
+            auto table = tables->shapes[waveform - WAVEFORM_SQUARE][level];
+            for (uint32_t i = 0; i < TABLE_SIZE; i++) {
+                table[i] = (float)(sum[i] / peak);
+            }
+            table[TABLE_SIZE] = table[0];
+        }
+    }
+    return tables;
+}
+
+const Wavetables& wavetables()
+{
+    static const auto tables = buildWavetables();
+    return *tables;
+}
+
+} // namespace
+
+Oscillator::Oscillator()
+    : waveform(WAVEFORM_SINE)
+    , frequency(440.0f)
+    , amplitude(1.0f)
+    , pendingPhase(-1)
+    , phase(0)
+    , currentAmplitude(0.0f)
+    , noiseState(0x9E3779B9u)
+    , pink {}
+{
+}
+
+bool Oscillator::isWaveform(uint32_t waveform)
+{
+    return waveform <= WAVEFORM_PINK_NOISE;
+}
+
+void Oscillator::reset(uint32_t waveform, float frequency, float amplitude, float phase)
+{
+    wavetables();
+
+    // Only called while the RT thread is not rendering this oscillator
+    this->waveform.store(waveform, std::memory_order_relaxed);
+    this->frequency.store(frequency, std::memory_order_relaxed);
+    this->amplitude.store(amplitude, std::memory_order_relaxed);
+    pendingPhase.store(-1, std::memory_order_relaxed);
+    this->phase = (uint32_t)((phase - std::floor(phase)) * 4294967296.0);
+    currentAmplitude = amplitude;
+    std::fill(std::begin(pink), std::end(pink), 0.0f);
+}
+
+void Oscillator::setWaveform(uint32_t waveform)
+{
+    this->waveform.store(waveform, std::memory_order_relaxed);
+}
+
+void Oscillator::setFrequency(float frequency)
+{
+    this->frequency.store(frequency, std::memory_order_relaxed);
+}
+
+void Oscillator::setAmplitude(float amplitude)
+{
+    this->amplitude.store(amplitude, std::memory_order_relaxed);
+}
+
+void Oscillator::setPhase(float phase)
+{
+    auto cycles = phase - std::floor(phase);
+    pendingPhase.store((int64_t)(cycles * 4294967296.0) & 0xFFFFFFFF, std::memory_order_release);
+}
+
+void Oscillator::render(float* dest, uint32_t frames, uint32_t rate)
+{
+    if (!frames) {
+        return;
+    }
+
+    auto shape = waveform.load(std::memory_order_relaxed);
+    auto requestedPhase = pendingPhase.exchange(-1, std::memory_order_acq_rel);
+    if (requestedPhase >= 0) {
+        phase = (uint32_t)requestedPhase;
+    }
+
+    if (shape == WAVEFORM_WHITE_NOISE || shape == WAVEFORM_PINK_NOISE) {
+        renderNoise(dest, frames, shape == WAVEFORM_PINK_NOISE);
+    } else {
+        // Cycles per frame, at most Nyquist
+        auto cycles = rate ? std::clamp((double)frequency.load(std::memory_order_relaxed) / rate, 0.0, 0.5) : 0.0;
+        auto increment = (uint32_t)(cycles * 4294967295.0);
+
+        const float* table = wavetables().sine;
+        if (shape != WAVEFORM_SINE && isWaveform(shape)) {
+            // The richest table whose top harmonic stays below Nyquist
+            auto harmonics = increment ? (uint32_t)std::min(0.5 / cycles, (double)(1u << 31)) : (1u << 31);
+            auto level = std::min<uint32_t>(std::bit_width(harmonics) - 1, TABLE_LEVELS - 1);
+            table = wavetables().shapes[shape - WAVEFORM_SQUARE][level];
+        }
+
+        const float scale = 1.0f / (1u << FRACTION_BITS);
+        for (uint32_t i = 0; i < frames; i++) {
+            auto index = phase >> FRACTION_BITS;
+            auto fraction = (float)(phase & ((1u << FRACTION_BITS) - 1)) * scale;
+            dest[i] = table[index] + (table[index + 1] - table[index]) * fraction;
+            phase += increment;
+        }
+    }
+
+    // Ramp to the new amplitude over the block instead of stepping
+    auto target = amplitude.load(std::memory_order_relaxed);
+    if (target == currentAmplitude) {
+        for (uint32_t i = 0; i < frames; i++) {
+            dest[i] *= target;
+        }
+    } else {
+        auto step = (target - currentAmplitude) / frames;
+        for (uint32_t i = 0; i < frames; i++) {
+            dest[i] *= currentAmplitude + step * (i + 1);
+        }
+        currentAmplitude = target;
+    }
+}
+
+void Oscillator::renderNoise(float* dest, uint32_t frames, bool pinkNoise)
+{
+    const float scale = 1.0f / 2147483648.0f;
+    for (uint32_t i = 0; i < frames; i++) {
+        // xorshift32: fast, and plenty random for audio
+        noiseState ^= noiseState << 13;
+        noiseState ^= noiseState >> 17;
+        noiseState ^= noiseState << 5;
+        auto white = (float)(int32_t)noiseState * scale;
+        if (!pinkNoise) {
+            dest[i] = white;
+            continue;
+        }
+
+        // Paul Kellet's refined -3dB/octave filter
+        pink[0] = 0.99886f * pink[0] + white * 0.0555179f;
+        pink[1] = 0.99332f * pink[1] + white * 0.0750759f;
+        pink[2] = 0.96900f * pink[2] + white * 0.1538520f;
+        pink[3] = 0.86650f * pink[3] + white * 0.3104856f;
+        pink[4] = 0.55000f * pink[4] + white * 0.5329522f;
+        pink[5] = -0.7616f * pink[5] - white * 0.0168980f;
+        auto sum = pink[0] + pink[1] + pink[2] + pink[3] + pink[4] + pink[5] + pink[6] + white * 0.5362f;
+        pink[6] = white * 0.115926f;
+        dest[i] = sum * 0.11f; // Brings the peak back to about unity
+    }
+}
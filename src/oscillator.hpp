@@ -0,0 +1,54 @@
+#ifndef PIPEWIRE_OSCILLATOR_HPP
+#define PIPEWIRE_OSCILLATOR_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#define WAVEFORM_SINE 0
+#define WAVEFORM_SQUARE 1
+#define WAVEFORM_SAWTOOTH 2
+#define WAVEFORM_TRIANGLE 3
+#define WAVEFORM_WHITE_NOISE 4
+#define WAVEFORM_PINK_NOISE 5
+
+// A native mono signal source: band-limited wavetable oscillators and
+// white/pink noise.
+//
+// JS posts parameters through atomics at any time; the RT thread picks them
+// up at the start of each render() call. Amplitude changes are ramped across
+// the block so they do not click. Square, sawtooth and triangle are read from
+// per-octave tables holding only the harmonics below Nyquist for the
+// frequency being played, so they do not alias.
+class Oscillator {
+
+public:
+    Oscillator();
+
+    // JS thread. reset() also builds the shared wavetables on first use
+    void reset(uint32_t waveform, float frequency, float amplitude, float phase);
+    void setWaveform(uint32_t waveform);
+    void setFrequency(float frequency);
+    void setAmplitude(float amplitude);
+    void setPhase(float phase); // In cycles, 0 to 1; applied on the next cycle
+
+    // RT thread; overwrites dest with `frames` mono samples
+    void render(float* dest, uint32_t frames, uint32_t rate);
+
+    static bool isWaveform(uint32_t waveform);
+
+private:
+    std::atomic<uint32_t> waveform;
+    std::atomic<float> frequency;
+    std::atomic<float> amplitude;
+    std::atomic<int64_t> pendingPhase; // Phase to jump to, or -1
+
+    // RT thread only
+    uint32_t phase; // One cycle is 2^32
+    float currentAmplitude;
+    uint32_t noiseState;
+    float pink[7]; // Pink noise filter state
+
+    void renderNoise(float* dest, uint32_t frames, bool pinkNoise);
+};
+
+#endif // PIPEWIRE_OSCILLATOR_HPP
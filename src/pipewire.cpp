@@ -1,33 +1,52 @@
+#include <mutex>
 #include <napi.h>
 #include <pipewire/pipewire.h>
 
 #include "audio-output-stream.hpp"
+#include "pipewire.hpp"
 #include "promises.hpp"
 #include "session.hpp"
 
-class PipeWireAddon : public Napi::Addon<PipeWireAddon> {
+// pw_init()/pw_deinit() are process-wide, but every environment that loads
+// the addon constructs its own PipeWireAddon
+static std::mutex initLock;
+static uint32_t initCount = 0;
 
-public:
-    PipeWireAddon(Napi::Env env, Napi::Object exports)
+PipeWireAddon::PipeWireAddon(Napi::Env env, Napi::Object exports)
+{
     {
-        pw_init(NULL, NULL);
-
-        DefineAddon(
-            exports,
-            { InstanceValue(
-                  "PipeWireSession",
-                  PipeWireSession::init(env),
-                  napi_enumerable),
-                InstanceValue(
-                    "PipeWireStream",
-                    AudioOutputStream::init(env),
-                    napi_enumerable) });
+        std::lock_guard<std::mutex> guard(initLock);
+        if (initCount++ == 0) {
+            pw_init(NULL, NULL);
+        }
     }
 
-    ~PipeWireAddon()
-    {
+    auto streamCtor = AudioOutputStream::init(env);
+    streamConstructor = Napi::Persistent(streamCtor);
+
+    DefineAddon(
+        exports,
+        { InstanceValue(
+              "PipeWireSession",
+              PipeWireSession::init(env),
+              napi_enumerable),
+            InstanceValue(
+                "PipeWireStream",
+                streamCtor,
+                napi_enumerable) });
+}
+
+PipeWireAddon::~PipeWireAddon()
+{
+    std::lock_guard<std::mutex> guard(initLock);
+    if (--initCount == 0) {
         pw_deinit();
     }
-};
+}
+
+PipeWireAddon* PipeWireAddon::forEnv(const Napi::Env& env)
+{
+    return env.GetInstanceData<PipeWireAddon>();
+}
 
 NODE_API_ADDON(PipeWireAddon)
@@ -0,0 +1,21 @@
+#ifndef PIPEWIRE_ADDON_HPP
+#define PIPEWIRE_ADDON_HPP
+
+#include <napi.h>
+
+// Per-environment addon state. Node creates one instance for the main thread
+// and one for every worker_thread that loads the addon, so nothing here may
+// be static.
+class PipeWireAddon : public Napi::Addon<PipeWireAddon> {
+
+public:
+    PipeWireAddon(Napi::Env env, Napi::Object exports);
+    ~PipeWireAddon();
+
+    static PipeWireAddon* forEnv(const Napi::Env& env);
+
+    // Sessions construct streams natively; JS only ever sees the instances
+    Napi::FunctionReference streamConstructor;
+};
+
+#endif // PIPEWIRE_ADDON_HPP
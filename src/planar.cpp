@@ -0,0 +1,138 @@
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#endif
+
+#include <cstring>
+
+#include "planar.hpp"
+
+namespace {
+
+template <typename T>
+void interleaveTyped(const uint8_t* const* planes, uint8_t* dest, uint32_t channels, size_t frames)
+{
+    auto out = (T*)dest;
+    for (uint32_t channel = 0; channel < channels; channel++) {
+        auto in = (const T*)planes[channel];
+        for (size_t i = 0; i < frames; i++) {
+            out[i * channels + channel] = in[i];
+        }
+    }
+}
+
+template <typename T>
+void deinterleaveTyped(const uint8_t* source, uint8_t* const* planes, uint32_t channels, size_t frames)
+{
+    auto in = (const T*)source;
+    for (uint32_t channel = 0; channel < channels; channel++) {
+        auto out = (T*)planes[channel];
+        for (size_t i = 0; i < frames; i++) {
+            out[i] = in[i * channels + channel];
+        }
+    }
+}
+
+// Stereo 32-bit, four frames per step; returns the frames it handled
+
+size_t interleaveStereo32(const uint32_t* left, const uint32_t* right, uint32_t* out, size_t frames)
+{
+    size_t i = 0;
+#if HAVE_X86_SIMD
+    for (; i + 4 <= frames; i += 4) {
+        auto l = _mm_loadu_si128((const __m128i*)(left + i));
+        auto r = _mm_loadu_si128((const __m128i*)(right + i));
+        _mm_storeu_si128((__m128i*)(out + i * 2), _mm_unpacklo_epi32(l, r));
+        _mm_storeu_si128((__m128i*)(out + i * 2 + 4), _mm_unpackhi_epi32(l, r));
+    }
+#elif HAVE_NEON
+    for (; i + 4 <= frames; i += 4) {
+        uint32x4x2_t pair = { { vld1q_u32(left + i), vld1q_u32(right + i) } };
+        vst2q_u32(out + i * 2, pair);
+    }
+#endif
+    return i;
+}
+
+size_t deinterleaveStereo32(const uint32_t* in, uint32_t* left, uint32_t* right, size_t frames)
+{
+    size_t i = 0;
+#if HAVE_X86_SIMD
+    for (; i + 4 <= frames; i += 4) {
+        auto a = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(in + i * 2)));
+        auto b = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)(in + i * 2 + 4)));
+        _mm_storeu_si128((__m128i*)(left + i), _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0))));
+        _mm_storeu_si128((__m128i*)(right + i), _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1))));
+    }
+#elif HAVE_NEON
+    for (; i + 4 <= frames; i += 4) {
+        auto pair = vld2q_u32(in + i * 2);
+        vst1q_u32(left + i, pair.val[0]);
+        vst1q_u32(right + i, pair.val[1]);
+    }
+#endif
+    return i;
+}
+
+} // namespace
+
+void interleave(const uint8_t* const* planes, uint8_t* dest, uint32_t channels, uint32_t sampleSize, size_t frames)
+{
+    if (channels == 1) {
+        memcpy(dest, planes[0], frames * sampleSize);
+        return;
+    }
+    if (channels == 2 && sampleSize == 4) {
+        auto done = interleaveStereo32((const uint32_t*)planes[0], (const uint32_t*)planes[1], (uint32_t*)dest, frames);
+        const uint8_t* rest[2] = { planes[0] + done * 4, planes[1] + done * 4 };
+        interleaveTyped<uint32_t>(rest, dest + done * 8, 2, frames - done);
+        return;
+    }
+
+    switch (sampleSize) {
+    case 1:
+        interleaveTyped<uint8_t>(planes, dest, channels, frames);
+        break;
+    case 2:
+        interleaveTyped<uint16_t>(planes, dest, channels, frames);
+        break;
+    case 4:
+        interleaveTyped<uint32_t>(planes, dest, channels, frames);
+        break;
+    case 8:
+        interleaveTyped<uint64_t>(planes, dest, channels, frames);
+        break;
+    }
+}
+
+void deinterleave(const uint8_t* source, uint8_t* const* planes, uint32_t channels, uint32_t sampleSize, size_t frames)
+{
+    if (channels == 1) {
+        memcpy(planes[0], source, frames * sampleSize);
+        return;
+    }
+    if (channels == 2 && sampleSize == 4) {
+        auto done = deinterleaveStereo32((const uint32_t*)source, (uint32_t*)planes[0], (uint32_t*)planes[1], frames);
+        uint8_t* rest[2] = { planes[0] + done * 4, planes[1] + done * 4 };
+        deinterleaveTyped<uint32_t>(source + done * 8, rest, 2, frames - done);
+        return;
+    }
+
+    switch (sampleSize) {
+    case 1:
+        deinterleaveTyped<uint8_t>(source, planes, channels, frames);
+        break;
+    case 2:
+        deinterleaveTyped<uint16_t>(source, planes, channels, frames);
+        break;
+    case 4:
+        deinterleaveTyped<uint32_t>(source, planes, channels, frames);
+        break;
+    case 8:
+        deinterleaveTyped<uint64_t>(source, planes, channels, frames);
+        break;
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef PIPEWIRE_PLANAR_HPP
+#define PIPEWIRE_PLANAR_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// Moves samples between one interleaved buffer and one plane per channel.
+//
+// Samples are copied as opaque units of sampleSize bytes (1, 2, 4 or 8), so
+// these work for any format once it has been converted. Stereo 32-bit audio,
+// the common Float32 case, has SSE2/NEON kernels; everything else uses typed
+// loops the compiler can vectorize. Safe to call on the RT thread.
+void interleave(const uint8_t* const* planes, uint8_t* dest, uint32_t channels, uint32_t sampleSize, size_t frames);
+void deinterleave(const uint8_t* source, uint8_t* const* planes, uint32_t channels, uint32_t sampleSize, size_t frames);
+
+#endif // PIPEWIRE_PLANAR_HPP
@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include <numeric>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#endif
+
+#include "planar.hpp"
+#include "resampler.hpp"
+
+namespace {
+
+struct QualityLevel {
+    uint32_t taps;
+    uint32_t phases;
+    double beta; // Kaiser window shape: higher means more stopband attenuation
+    double rolloff; // Cutoff as a fraction of the lower Nyquist frequency
+};
+
+const QualityLevel qualityLevels[] = {
+    { 16, 32, 6.0, 0.85 }, // RESAMPLE_FAST
+    { 32, 128, 8.6, 0.91 }, // RESAMPLE_BALANCED
+    { 64, 256, 10.0, 0.95 }, // RESAMPLE_BEST
+};
+
+// Zeroth-order modified Bessel function of the first kind, for the window
+double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+float dot(const float* a, const float* b, uint32_t count)
+{
+    // count is a multiple of 4
+#if HAVE_X86_SIMD
+    auto sum = _mm_setzero_ps();
+    for (uint32_t i = 0; i < count; i += 4) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+#elif HAVE_NEON
+    auto sum = vdupq_n_f32(0.0f);
+    for (uint32_t i = 0; i < count; i += 4) {
+        sum = vmlaq_f32(sum, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    return vaddvq_f32(sum);
+#else
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < count; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+#endif
+}
+
+} // namespace
+
+Resampler::Resampler()
+    : active(false)
+    , channels(0)
+    , taps(0)
+    , phases(0)
+    , inputStep(1)
+    , outputStep(1)
+    , historyFrames(0)
+    , position(0)
+{
+}
+
+void Resampler::configure(uint32_t inputRate, uint32_t outputRate, uint32_t channels, uint32_t quality, uint32_t maxOutputFrames)
+{
+    if (!inputRate || !outputRate || !channels || channels > RESAMPLE_MAX_CHANNELS || inputRate == outputRate) {
+        disable();
+        return;
+    }
+
+    auto& level = qualityLevels[std::min(quality, (uint32_t)RESAMPLE_BEST)];
+    auto divisor = std::gcd(inputRate, outputRate);
+    this->channels = channels;
+    taps = level.taps;
+    phases = level.phases;
+    inputStep = inputRate / divisor;
+    outputStep = outputRate / divisor;
+
+    // Downsampling moves the cutoff below the output Nyquist frequency
+    auto cutoff = level.rolloff * std::min(1.0, (double)outputRate / inputRate);
+    auto half = taps / 2;
+    bank.assign((size_t)(phases + 1) * taps, 0.0f);
+    for (uint32_t phase = 0; phase <= phases; phase++) {
+        auto fraction = (double)phase / phases;
+        auto row = bank.data() + (size_t)phase * taps;
+        double sum = 0.0;
+        for (uint32_t k = 0; k < taps; k++) {
+            // Distance from the output position to input sample k
+            auto t = (double)k - (half - 1) - fraction;
+            auto x = t * cutoff * std::numbers::pi;
+            auto sinc = x == 0.0 ? 1.0 : std::sin(x) / x;
+            auto r = t / half;
+            auto window = std::abs(r) >= 1.0 ? 0.0 : besselI0(level.beta * std::sqrt(1.0 - r * r)) / besselI0(level.beta);
+            row[k] = (float)(sinc * window);
+            sum += row[k];
+        }
+        // Unity gain at DC for every phase
+        for (uint32_t k = 0; k < taps; k++) {
+            row[k] = (float)(row[k] / sum);
+        }
+    }
+    coefficients.assign(taps, 0.0f);
+
+    // The most input one process() call can need, plus the filter's reach
+    auto maxInputFrames = (uint32_t)(((uint64_t)maxOutputFrames * inputStep + outputStep - 1) / outputStep) + taps + 1;
+    history.assign(channels, std::vector<float>((size_t)maxInputFrames + taps, 0.0f));
+    staging.assign((size_t)maxInputFrames * channels, 0.0f);
+
+    // Start with half a filter of silence so the first input frame lines up
+    // with the first output frame
+    historyFrames = half - 1;
+    position = (uint64_t)(half - 1) * outputStep;
+    active = true;
+}
+
+void Resampler::disable()
+{
+    active = false;
+}
+
+bool Resampler::isActive() const
+{
+    return active;
+}
+
+uint32_t Resampler::getLatencyFrames() const
+{
+    return active ? taps / 2 : 0;
+}
+
+uint32_t Resampler::inputFramesFor(uint32_t outputFrames) const
+{
+    if (!outputFrames) {
+        return 0;
+    }
+    // The last output frame reads half a filter past its position
+    auto last = (position + (uint64_t)(outputFrames - 1) * inputStep) / outputStep;
+    auto needed = last + taps / 2 + 1;
+    return needed > historyFrames ? (uint32_t)(needed - historyFrames) : 0;
+}
+
+float* Resampler::inputBuffer()
+{
+    return staging.data();
+}
+
+void Resampler::commitInput(uint32_t frames)
+{
+    uint8_t* planes[RESAMPLE_MAX_CHANNELS];
+    for (uint32_t channel = 0; channel < channels; channel++) {
+        planes[channel] = (uint8_t*)(history[channel].data() + historyFrames);
+    }
+    deinterleave((const uint8_t*)staging.data(), planes, channels, sizeof(float), frames);
+    historyFrames += frames;
+}
+
+void Resampler::process(float* dest, uint32_t outputFrames)
+{
+    auto half = taps / 2;
+
+    for (uint32_t frame = 0; frame < outputFrames; frame++) {
+        auto index = position / outputStep;
+        auto remainder = position % outputStep;
+
+        // Pick the two nearest phases and blend their coefficients
+        auto scaled = remainder * phases;
+        auto phase = scaled / outputStep;
+        auto blend = (float)(scaled % outputStep) / outputStep;
+        auto lower = bank.data() + phase * taps;
+        auto upper = lower + taps;
+        for (uint32_t k = 0; k < taps; k++) {
+            coefficients[k] = lower[k] + blend * (upper[k] - lower[k]);
+        }
+
+        auto first = index - (half - 1);
+        for (uint32_t channel = 0; channel < channels; channel++) {
+            dest[(size_t)frame * channels + channel] = dot(history[channel].data() + first, coefficients.data(), taps);
+        }
+        position += inputStep;
+    }
+
+    // Drop input the next frame no longer reaches
+    auto keepFrom = std::min<uint64_t>(position / outputStep - (half - 1), historyFrames);
+    if (keepFrom) {
+        for (uint32_t channel = 0; channel < channels; channel++) {
+            auto plane = history[channel].data();
+            memmove(plane, plane + keepFrom, (historyFrames - keepFrom) * sizeof(float));
+        }
+        historyFrames -= (uint32_t)keepFrom;
+        position -= keepFrom * outputStep;
+    }
+}
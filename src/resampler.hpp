@@ -0,0 +1,59 @@
+#ifndef PIPEWIRE_RESAMPLER_HPP
+#define PIPEWIRE_RESAMPLER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define RESAMPLE_FAST 0
+#define RESAMPLE_BALANCED 1
+#define RESAMPLE_BEST 2
+
+#define RESAMPLE_MAX_CHANNELS 64
+
+// Polyphase windowed-sinc resampler for interleaved Float32 audio.
+//
+// Converts audio rendered at one rate to another, so JS can render at a
+// fixed rate whatever the graph negotiates. The filter bank is a Kaiser
+// windowed sinc sampled at a fixed number of phases, and coefficients are
+// interpolated linearly between phases. The quality level picks the number
+// of taps and phases. The input-to-output ratio is kept as an exact integer
+// fraction, so the read position never drifts.
+//
+// configure() allocates and runs off the RT thread. Each cycle the RT thread
+// asks how much input the next block of output needs, renders that much into
+// inputBuffer(), commitInput()s it, then process()es the block.
+class Resampler {
+
+public:
+    Resampler();
+
+    // Not RT safe. maxOutputFrames bounds each process() call
+    void configure(uint32_t inputRate, uint32_t outputRate, uint32_t channels, uint32_t quality, uint32_t maxOutputFrames);
+    void disable();
+    bool isActive() const;
+    uint32_t getLatencyFrames() const; // Input frames of delay the filter adds
+
+    // RT thread
+    uint32_t inputFramesFor(uint32_t outputFrames) const;
+    float* inputBuffer(); // Room for inputFramesFor() interleaved frames
+    void commitInput(uint32_t frames);
+    void process(float* dest, uint32_t outputFrames);
+
+private:
+    bool active;
+    uint32_t channels;
+    uint32_t taps; // Per phase; a multiple of 4
+    uint32_t phases;
+    uint64_t inputStep; // Position advance per output frame, in 1/outputStep input frames
+    uint64_t outputStep;
+
+    std::vector<float> bank; // (phases + 1) * taps coefficients
+    std::vector<float> coefficients; // One interpolated phase, reused per output frame
+    std::vector<std::vector<float>> history; // One plane per channel
+    std::vector<float> staging; // Interleaved input waiting for commitInput()
+    uint32_t historyFrames; // Valid frames in each history plane
+    uint64_t position; // Read position in 1/outputStep input frames, relative to history[0]
+};
+
+#endif // PIPEWIRE_RESAMPLER_HPP
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cstring>
+
+#include "ring-buffer.hpp"
+
+RingBuffer::RingBuffer()
+    : writeIndex(0)
+    , readIndex(0)
+{
+}
+
+void RingBuffer::allocate(size_t capacity)
+{
+    storage.assign(capacity, 0);
+    writeIndex.store(0, std::memory_order_relaxed);
+    readIndex.store(0, std::memory_order_relaxed);
+}
+
+size_t RingBuffer::capacity() const
+{
+    return storage.size();
+}
+
+uint8_t* RingBuffer::data()
+{
+    return storage.data();
+}
+
+size_t RingBuffer::readable() const
+{
+    auto written = writeIndex.load(std::memory_order_acquire);
+    auto read = readIndex.load(std::memory_order_acquire);
+    return written - read;
+}
+
+size_t RingBuffer::writable(size_t limit) const
+{
+    auto queued = readable();
+    limit = std::min(limit, capacity());
+    return limit > queued ? limit - queued : 0;
+}
+
+size_t RingBuffer::write(const uint8_t* source, size_t size, size_t limit)
+{
+    RingSpans spans;
+    auto amount = reserve(size, limit, spans);
+    memcpy(spans.parts[0].data, source, spans.parts[0].size);
+    memcpy(spans.parts[1].data, source + spans.parts[0].size, spans.parts[1].size);
+    commit(amount);
+    return amount;
+}
+
+size_t RingBuffer::reserve(size_t size, size_t limit, RingSpans& spans)
+{
+    auto written = writeIndex.load(std::memory_order_relaxed);
+    auto read = readIndex.load(std::memory_order_acquire);
+    limit = std::min(limit, capacity());
+    auto available = limit > written - read ? limit - (written - read) : 0;
+    auto amount = std::min(size, available);
+
+    auto offset = amount ? written % capacity() : 0;
+    auto firstPart = std::min(amount, capacity() - offset);
+    spans.parts[0] = { storage.data() + offset, firstPart };
+    spans.parts[1] = { storage.data(), amount - firstPart };
+    return amount;
+}
+
+void RingBuffer::commit(size_t size)
+{
+    auto written = writeIndex.load(std::memory_order_relaxed);
+    writeIndex.store(written + size, std::memory_order_release);
+}
+
+size_t RingBuffer::read(uint8_t* dest, size_t size)
+{
+    auto read = readIndex.load(std::memory_order_relaxed);
+    auto written = writeIndex.load(std::memory_order_acquire);
+    auto amount = std::min(size, (size_t)(written - read));
+    if (!amount) {
+        return 0;
+    }
+
+    auto offset = read % capacity();
+    auto firstPart = std::min(amount, capacity() - offset);
+    memcpy(dest, storage.data() + offset, firstPart);
+    memcpy(dest + firstPart, storage.data(), amount - firstPart);
+
+    readIndex.store(read + amount, std::memory_order_release);
+    return amount;
+}
+
+size_t RingBuffer::peek(size_t size, RingSpans& spans)
+{
+    auto read = readIndex.load(std::memory_order_relaxed);
+    auto written = writeIndex.load(std::memory_order_acquire);
+    auto amount = std::min(size, (size_t)(written - read));
+
+    auto offset = amount ? read % capacity() : 0;
+    auto firstPart = std::min(amount, capacity() - offset);
+    spans.parts[0] = { storage.data() + offset, firstPart };
+    spans.parts[1] = { storage.data(), amount - firstPart };
+    return amount;
+}
+
+void RingBuffer::skip(size_t size)
+{
+    auto read = readIndex.load(std::memory_order_relaxed);
+    readIndex.store(read + size, std::memory_order_release);
+}
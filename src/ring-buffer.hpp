@@ -0,0 +1,52 @@
+#ifndef PIPEWIRE_RING_BUFFER_HPP
+#define PIPEWIRE_RING_BUFFER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Up to two contiguous regions of the ring, in ring order
+struct RingSpans {
+    struct {
+        uint8_t* data;
+        size_t size;
+    } parts[2];
+};
+
+// Preallocated single-producer/single-consumer byte ring.
+//
+// The producer (JS thread) only ever advances writeIndex and the consumer
+// (PipeWire RT thread) only ever advances readIndex, so neither side needs a
+// lock. Indices grow monotonically and are reduced modulo the capacity when
+// touching storage; the readable byte count is always writeIndex - readIndex.
+class RingBuffer {
+
+public:
+    RingBuffer();
+
+    // Not thread safe; call before either side starts using the ring
+    void allocate(size_t capacity);
+
+    size_t capacity() const;
+    uint8_t* data(); // Raw storage, for exposing the ring to JS
+    size_t readable() const;
+    size_t writable(size_t limit) const;
+
+    // Producer side
+    size_t write(const uint8_t* source, size_t size, size_t limit);
+    size_t reserve(size_t size, size_t limit, RingSpans& spans);
+    void commit(size_t size);
+
+    // Consumer side
+    size_t read(uint8_t* dest, size_t size);
+    size_t peek(size_t size, RingSpans& spans);
+    void skip(size_t size);
+
+private:
+    std::vector<uint8_t> storage;
+    alignas(64) std::atomic<uint64_t> writeIndex;
+    alignas(64) std::atomic<uint64_t> readIndex;
+};
+
+#endif // PIPEWIRE_RING_BUFFER_HPP
@@ -0,0 +1,22 @@
+#include "sample-cache.hpp"
+
+void SampleCache::store(const std::string& id, std::shared_ptr<const CachedSample> sample)
+{
+    samples.insert_or_assign(id, std::move(sample));
+}
+
+std::shared_ptr<const CachedSample> SampleCache::find(const std::string& id) const
+{
+    auto entry = samples.find(id);
+    return entry == samples.end() ? nullptr : entry->second;
+}
+
+bool SampleCache::erase(const std::string& id)
+{
+    return samples.erase(id) > 0;
+}
+
+void SampleCache::clear()
+{
+    samples.clear();
+}
@@ -0,0 +1,39 @@
+#ifndef PIPEWIRE_SAMPLE_CACHE_HPP
+#define PIPEWIRE_SAMPLE_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define SAMPLE_CACHE_MAX_CHANNELS 32
+
+// Decoded PCM loaded once and played by any number of voices on any stream.
+// Never modified after loading, so the RT thread reads it without locks; a
+// voice holds a reference, so unloading never frees samples being mixed.
+struct CachedSample {
+    std::vector<float> samples; // Interleaved Float32, the mixer's bus format
+    uint32_t channels;
+    uint32_t rate; // 0 when the caller did not say
+    size_t frames;
+};
+
+// A session's samples by id. JS thread only: streams look samples up when
+// they trigger them, and the RT thread only sees the references voices hold.
+class SampleCache {
+
+public:
+    // Replaces any sample already stored under id; voices playing the old
+    // one finish with it
+    void store(const std::string& id, std::shared_ptr<const CachedSample> sample);
+    std::shared_ptr<const CachedSample> find(const std::string& id) const;
+    bool erase(const std::string& id);
+    void clear();
+
+private:
+    std::unordered_map<std::string, std::shared_ptr<const CachedSample>> samples;
+};
+
+#endif // PIPEWIRE_SAMPLE_CACHE_HPP
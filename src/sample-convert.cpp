@@ -0,0 +1,514 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_SIMD 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NEON 1
+#endif
+
+#include "sample-convert.hpp"
+
+#define S8_SCALE 127.0f
+#define S16_SCALE 32767.0f
+#define S24_SCALE 8388607.0f
+
+namespace {
+
+inline float clampUnit(float sample)
+{
+    return sample < -1.0f ? -1.0f : (sample > 1.0f ? 1.0f : sample);
+}
+
+inline int32_t quantize(float sample, float scale)
+{
+    return (int32_t)lrintf(clampUnit(sample) * scale);
+}
+
+// Scalar kernels; also used for the tails the vector kernels leave behind
+
+void toF32Scalar(const float* source, uint8_t* dest, size_t samples)
+{
+    memcpy(dest, source, samples * sizeof(float));
+}
+
+void toF64Scalar(const float* source, uint8_t* dest, size_t samples)
+{
+    auto out = (double*)dest;
+    for (size_t i = 0; i < samples; i++) {
+        out[i] = source[i];
+    }
+}
+
+void toS8Scalar(const float* source, uint8_t* dest, size_t samples)
+{
+    auto out = (int8_t*)dest;
+    for (size_t i = 0; i < samples; i++) {
+        out[i] = (int8_t)quantize(source[i], S8_SCALE);
+    }
+}
+
+void toU8Scalar(const float* source, uint8_t* dest, size_t samples)
+{
+    for (size_t i = 0; i < samples; i++) {
+        dest[i] = (uint8_t)(quantize(source[i], S8_SCALE) + 128);
+    }
+}
+
+void toS16Scalar(const float* source, uint8_t* dest, size_t samples)
+{
+    auto out = (int16_t*)dest;
+    for (size_t i = 0; i < samples; i++) {
+        out[i] = (int16_t)quantize(source[i], S16_SCALE);
+    }
+}
+
+void toU16Scalar(const float* source, uint8_t* dest, size_t samples)
+{
+    auto out = (uint16_t*)dest;
+    for (size_t i = 0; i < samples; i++) {
+        out[i] = (uint16_t)(quantize(source[i], S16_SCALE) + 32768);
+    }
+}
+
+void toS24_32Scalar(const float* source, uint8_t* dest, size_t samples)
+{
+    auto out = (int32_t*)dest;
+    for (size_t i = 0; i < samples; i++) {
+        out[i] = quantize(source[i], S24_SCALE);
+    }
+}
+
+void toU24_32Scalar(const float* source, uint8_t* dest, size_t samples)
+{
+    auto out = (uint32_t*)dest;
+    for (size_t i = 0; i < samples; i++) {
+        out[i] = (uint32_t)(quantize(source[i], S24_SCALE) + 0x800000);
+    }
+}
+
+// 32-bit output goes through 24 bits: that is all the precision a float
+// carries, and it keeps +1.0 from overflowing INT32_MAX.
+void toS32Scalar(const float* source, uint8_t* dest, size_t samples)
+{
+    auto out = (int32_t*)dest;
+    for (size_t i = 0; i < samples; i++) {
+        out[i] = quantize(source[i], S24_SCALE) << 8;
+    }
+}
+
+void toU32Scalar(const float* source, uint8_t* dest, size_t samples)
+{
+    auto out = (uint32_t*)dest;
+    for (size_t i = 0; i < samples; i++) {
+        out[i] = ((uint32_t)quantize(source[i], S24_SCALE) << 8) ^ 0x80000000u;
+    }
+}
+
+#if HAVE_X86_SIMD
+
+inline __m128 scaleSse(__m128 samples, __m128 scale)
+{
+    const __m128 lower = _mm_set1_ps(-1.0f);
+    const __m128 upper = _mm_set1_ps(1.0f);
+    return _mm_mul_ps(_mm_min_ps(_mm_max_ps(samples, lower), upper), scale);
+}
+
+void toF64Sse2(const float* source, uint8_t* dest, size_t samples)
+{
+    auto out = (double*)dest;
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        auto in = _mm_loadu_ps(source + i);
+        _mm_storeu_pd(out + i, _mm_cvtps_pd(in));
+        _mm_storeu_pd(out + i + 2, _mm_cvtps_pd(_mm_movehl_ps(in, in)));
+    }
+    toF64Scalar(source + i, (uint8_t*)(out + i), samples - i);
+}
+
+void toU8Sse2(const float* source, uint8_t* dest, size_t samples)
+{
+    const __m128 scale = _mm_set1_ps(S8_SCALE);
+    const __m128i offset = _mm_set1_epi16(128);
+    size_t i = 0;
+    for (; i + 16 <= samples; i += 16) {
+        auto a = _mm_cvtps_epi32(scaleSse(_mm_loadu_ps(source + i), scale));
+        auto b = _mm_cvtps_epi32(scaleSse(_mm_loadu_ps(source + i + 4), scale));
+        auto c = _mm_cvtps_epi32(scaleSse(_mm_loadu_ps(source + i + 8), scale));
+        auto d = _mm_cvtps_epi32(scaleSse(_mm_loadu_ps(source + i + 12), scale));
+        auto low = _mm_add_epi16(_mm_packs_epi32(a, b), offset);
+        auto high = _mm_add_epi16(_mm_packs_epi32(c, d), offset);
+        _mm_storeu_si128((__m128i*)(dest + i), _mm_packus_epi16(low, high));
+    }
+    toU8Scalar(source + i, dest + i, samples - i);
+}
+
+void toS16Sse2(const float* source, uint8_t* dest, size_t samples)
+{
+    const __m128 scale = _mm_set1_ps(S16_SCALE);
+    auto out = (int16_t*)dest;
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        auto a = _mm_cvtps_epi32(scaleSse(_mm_loadu_ps(source + i), scale));
+        auto b = _mm_cvtps_epi32(scaleSse(_mm_loadu_ps(source + i + 4), scale));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(a, b));
+    }
+    toS16Scalar(source + i, (uint8_t*)(out + i), samples - i);
+}
+
+template <int Shift>
+void toS32Sse2(const float* source, uint8_t* dest, size_t samples)
+{
+    const __m128 scale = _mm_set1_ps(S24_SCALE);
+    auto out = (int32_t*)dest;
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        auto value = _mm_cvtps_epi32(scaleSse(_mm_loadu_ps(source + i), scale));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_slli_epi32(value, Shift));
+    }
+    if (Shift) {
+        toS32Scalar(source + i, (uint8_t*)(out + i), samples - i);
+    } else {
+        toS24_32Scalar(source + i, (uint8_t*)(out + i), samples - i);
+    }
+}
+
+__attribute__((target("avx2"))) inline __m256 scaleAvx(__m256 samples, __m256 scale)
+{
+    const __m256 lower = _mm256_set1_ps(-1.0f);
+    const __m256 upper = _mm256_set1_ps(1.0f);
+    return _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(samples, lower), upper), scale);
+}
+
+__attribute__((target("avx2"))) void toS16Avx2(const float* source, uint8_t* dest, size_t samples)
+{
+    const __m256 scale = _mm256_set1_ps(S16_SCALE);
+    auto out = (int16_t*)dest;
+    size_t i = 0;
+    for (; i + 16 <= samples; i += 16) {
+        auto a = _mm256_cvtps_epi32(scaleAvx(_mm256_loadu_ps(source + i), scale));
+        auto b = _mm256_cvtps_epi32(scaleAvx(_mm256_loadu_ps(source + i + 8), scale));
+        // packs works per 128-bit lane; restore sample order afterwards
+        auto packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+        _mm256_storeu_si256((__m256i*)(out + i), packed);
+    }
+    toS16Sse2(source + i, (uint8_t*)(out + i), samples - i);
+}
+
+template <int Shift>
+__attribute__((target("avx2"))) void toS32Avx2(const float* source, uint8_t* dest, size_t samples)
+{
+    const __m256 scale = _mm256_set1_ps(S24_SCALE);
+    auto out = (int32_t*)dest;
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        auto value = _mm256_cvtps_epi32(scaleAvx(_mm256_loadu_ps(source + i), scale));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_slli_epi32(value, Shift));
+    }
+    toS32Sse2<Shift>(source + i, (uint8_t*)(out + i), samples - i);
+}
+
+bool hasAvx2()
+{
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+#endif // HAVE_X86_SIMD
+
+#if HAVE_NEON
+
+inline int32x4_t quantizeNeon(float32x4_t samples, float scale)
+{
+    auto clamped = vminq_f32(vmaxq_f32(samples, vdupq_n_f32(-1.0f)), vdupq_n_f32(1.0f));
+    return vcvtnq_s32_f32(vmulq_n_f32(clamped, scale));
+}
+
+void toS16Neon(const float* source, uint8_t* dest, size_t samples)
+{
+    auto out = (int16_t*)dest;
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        auto a = vqmovn_s32(quantizeNeon(vld1q_f32(source + i), S16_SCALE));
+        auto b = vqmovn_s32(quantizeNeon(vld1q_f32(source + i + 4), S16_SCALE));
+        vst1q_s16(out + i, vcombine_s16(a, b));
+    }
+    toS16Scalar(source + i, (uint8_t*)(out + i), samples - i);
+}
+
+void toU8Neon(const float* source, uint8_t* dest, size_t samples)
+{
+    const int16x8_t offset = vdupq_n_s16(128);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        auto a = vqmovn_s32(quantizeNeon(vld1q_f32(source + i), S8_SCALE));
+        auto b = vqmovn_s32(quantizeNeon(vld1q_f32(source + i + 4), S8_SCALE));
+        vst1_u8(dest + i, vqmovun_s16(vaddq_s16(vcombine_s16(a, b), offset)));
+    }
+    toU8Scalar(source + i, dest + i, samples - i);
+}
+
+template <int Shift>
+void toS32Neon(const float* source, uint8_t* dest, size_t samples)
+{
+    auto out = (int32_t*)dest;
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        auto value = quantizeNeon(vld1q_f32(source + i), S24_SCALE);
+        vst1q_s32(out + i, vshlq_n_s32(value, Shift));
+    }
+    if (Shift) {
+        toS32Scalar(source + i, (uint8_t*)(out + i), samples - i);
+    } else {
+        toS24_32Scalar(source + i, (uint8_t*)(out + i), samples - i);
+    }
+}
+
+void toF64Neon(const float* source, uint8_t* dest, size_t samples)
+{
+    auto out = (double*)dest;
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        auto in = vld1q_f32(source + i);
+        vst1q_f64(out + i, vcvt_f64_f32(vget_low_f32(in)));
+        vst1q_f64(out + i + 2, vcvt_high_f64_f32(in));
+    }
+    toF64Scalar(source + i, (uint8_t*)(out + i), samples - i);
+}
+
+#endif // HAVE_NEON
+
+// Vector kernels share a fixed signature so they can be picked once per format
+using Kernel = void (*)(const float* source, uint8_t* dest, size_t samples);
+
+Kernel selectKernel(spa_audio_format format)
+{
+    switch (format) {
+    case SPA_AUDIO_FORMAT_F32:
+        return toF32Scalar;
+    case SPA_AUDIO_FORMAT_S8:
+        return toS8Scalar;
+    case SPA_AUDIO_FORMAT_U16:
+        return toU16Scalar;
+    case SPA_AUDIO_FORMAT_U24_32:
+        return toU24_32Scalar;
+    case SPA_AUDIO_FORMAT_U32:
+        return toU32Scalar;
+#if HAVE_X86_SIMD
+    case SPA_AUDIO_FORMAT_F64:
+        return toF64Sse2;
+    case SPA_AUDIO_FORMAT_U8:
+        return toU8Sse2;
+    case SPA_AUDIO_FORMAT_S16:
+        return hasAvx2() ? toS16Avx2 : toS16Sse2;
+    case SPA_AUDIO_FORMAT_S24_32:
+        return hasAvx2() ? toS32Avx2<0> : toS32Sse2<0>;
+    case SPA_AUDIO_FORMAT_S32:
+        return hasAvx2() ? toS32Avx2<8> : toS32Sse2<8>;
+#elif HAVE_NEON
+    case SPA_AUDIO_FORMAT_F64:
+        return toF64Neon;
+    case SPA_AUDIO_FORMAT_U8:
+        return toU8Neon;
+    case SPA_AUDIO_FORMAT_S16:
+        return toS16Neon;
+    case SPA_AUDIO_FORMAT_S24_32:
+        return toS32Neon<0>;
+    case SPA_AUDIO_FORMAT_S32:
+        return toS32Neon<8>;
+#else
+    case SPA_AUDIO_FORMAT_F64:
+        return toF64Scalar;
+    case SPA_AUDIO_FORMAT_U8:
+        return toU8Scalar;
+    case SPA_AUDIO_FORMAT_S16:
+        return toS16Scalar;
+    case SPA_AUDIO_FORMAT_S24_32:
+        return toS24_32Scalar;
+    case SPA_AUDIO_FORMAT_S32:
+        return toS32Scalar;
+#endif
+    default:
+        return NULL;
+    }
+}
+
+// One output LSB expressed in full-scale units, for formats worth dithering
+float ditherStep(spa_audio_format format)
+{
+    switch (format) {
+    case SPA_AUDIO_FORMAT_S8:
+    case SPA_AUDIO_FORMAT_U8:
+        return 1.0f / S8_SCALE;
+    case SPA_AUDIO_FORMAT_S16:
+    case SPA_AUDIO_FORMAT_U16:
+        return 1.0f / S16_SCALE;
+    default:
+        return 0.0f;
+    }
+}
+
+inline float nextUniform(uint32_t& seed)
+{
+    // xorshift32: cheap, allocation-free and good enough for dither noise
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return (seed >> 8) * (1.0f / 16777216.0f);
+}
+
+} // namespace
+
+SampleConverter::SampleConverter()
+    : inputFormat(SPA_AUDIO_FORMAT_F64)
+    , outputFormat(SPA_AUDIO_FORMAT_F64)
+    , kernel(NULL)
+    , ditherScale(0.0f)
+    , ditherSeed(0x9E3779B9u)
+{
+}
+
+bool SampleConverter::isInputFormat(spa_audio_format format)
+{
+    return format == SPA_AUDIO_FORMAT_F32 || format == SPA_AUDIO_FORMAT_F64;
+}
+
+bool SampleConverter::isSupported(spa_audio_format format)
+{
+    return selectKernel(interleavedFormat(format)) != NULL;
+}
+
+bool SampleConverter::isPlanar(spa_audio_format format)
+{
+    return interleavedFormat(format) != format;
+}
+
+spa_audio_format SampleConverter::interleavedFormat(spa_audio_format format)
+{
+    switch (format) {
+    case SPA_AUDIO_FORMAT_U8P:
+        return SPA_AUDIO_FORMAT_U8;
+    case SPA_AUDIO_FORMAT_S8P:
+        return SPA_AUDIO_FORMAT_S8;
+    case SPA_AUDIO_FORMAT_S16P:
+        return SPA_AUDIO_FORMAT_S16;
+    case SPA_AUDIO_FORMAT_S24_32P:
+        return SPA_AUDIO_FORMAT_S24_32;
+    case SPA_AUDIO_FORMAT_S32P:
+        return SPA_AUDIO_FORMAT_S32;
+    case SPA_AUDIO_FORMAT_F32P:
+        return SPA_AUDIO_FORMAT_F32;
+    case SPA_AUDIO_FORMAT_F64P:
+        return SPA_AUDIO_FORMAT_F64;
+    default:
+        return format;
+    }
+}
+
+uint32_t SampleConverter::sampleSize(spa_audio_format format)
+{
+    switch (interleavedFormat(format)) {
+    case SPA_AUDIO_FORMAT_F64:
+        return 8;
+    case SPA_AUDIO_FORMAT_S8:
+    case SPA_AUDIO_FORMAT_U8:
+        return 1;
+    case SPA_AUDIO_FORMAT_S16:
+    case SPA_AUDIO_FORMAT_U16:
+        return 2;
+    case SPA_AUDIO_FORMAT_F32:
+    case SPA_AUDIO_FORMAT_S32:
+    case SPA_AUDIO_FORMAT_U32:
+    case SPA_AUDIO_FORMAT_S24_32:
+    case SPA_AUDIO_FORMAT_U24_32:
+    default:
+        return 4;
+    }
+}
+
+void SampleConverter::configure(spa_audio_format input, spa_audio_format output, bool withDither)
+{
+    inputFormat = input;
+    outputFormat = interleavedFormat(output);
+    kernel = selectKernel(outputFormat);
+    ditherScale = withDither ? ditherStep(outputFormat) : 0.0f;
+}
+
+void SampleConverter::convert(const uint8_t* source, uint8_t* dest, size_t samples)
+{
+    if (!kernel) {
+        // Formats we cannot produce play as silence rather than noise
+        silence(dest, samples);
+    } else if (inputFormat == outputFormat) {
+        memcpy(dest, source, samples * sampleSize(outputFormat));
+    } else if (inputFormat == SPA_AUDIO_FORMAT_F64) {
+        convertDoubles((const double*)source, dest, samples);
+    } else {
+        convertFloats((const float*)source, dest, samples);
+    }
+}
+
+void SampleConverter::silence(uint8_t* dest, size_t samples)
+{
+    auto bytes = samples * sampleSize(outputFormat);
+    switch (outputFormat) {
+    case SPA_AUDIO_FORMAT_U8:
+        memset(dest, 0x80, bytes);
+        break;
+    case SPA_AUDIO_FORMAT_U16:
+    case SPA_AUDIO_FORMAT_U24_32:
+    case SPA_AUDIO_FORMAT_U32: {
+        // Zero for unsigned formats is negative full scale; write the midpoint
+        float zero[CONVERT_CHUNK_SAMPLES] = {};
+        auto outSize = sampleSize(outputFormat);
+        for (size_t done = 0; done < samples; done += CONVERT_CHUNK_SAMPLES) {
+            auto count = std::min(samples - done, (size_t)CONVERT_CHUNK_SAMPLES);
+            kernel(zero, dest + done * outSize, count);
+        }
+    } break;
+    default:
+        memset(dest, 0, bytes);
+        break;
+    }
+}
+
+void SampleConverter::convertFloats(const float* source, uint8_t* dest, size_t samples)
+{
+    if (!ditherScale) {
+        kernel(source, dest, samples);
+        return;
+    }
+
+    auto outSize = sampleSize(outputFormat);
+    for (size_t done = 0; done < samples; done += CONVERT_CHUNK_SAMPLES) {
+        auto count = std::min(samples - done, (size_t)CONVERT_CHUNK_SAMPLES);
+        kernel(dither(source + done, count), dest + done * outSize, count);
+    }
+}
+
+void SampleConverter::convertDoubles(const double* source, uint8_t* dest, size_t samples)
+{
+    // Narrow in cache-sized chunks so the float kernels can be reused
+    auto outSize = sampleSize(outputFormat);
+    for (size_t done = 0; done < samples; done += CONVERT_CHUNK_SAMPLES) {
+        auto count = std::min(samples - done, (size_t)CONVERT_CHUNK_SAMPLES);
+        for (size_t i = 0; i < count; i++) {
+            scratch[i] = (float)source[done + i];
+        }
+        auto narrowed = ditherScale ? dither(scratch, count) : scratch;
+        kernel(narrowed, dest + done * outSize, count);
+    }
+}
+
+const float* SampleConverter::dither(const float* source, size_t samples)
+{
+    // Triangular PDF: the difference of two uniform variables spans +/-1 LSB
+    for (size_t i = 0; i < samples; i++) {
+        auto noise = nextUniform(ditherSeed) - nextUniform(ditherSeed);
+        scratch[i] = source[i] + noise * ditherScale;
+    }
+    return scratch;
+}
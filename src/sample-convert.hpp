@@ -0,0 +1,50 @@
+#ifndef PIPEWIRE_SAMPLE_CONVERT_HPP
+#define PIPEWIRE_SAMPLE_CONVERT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <spa/param/audio/raw.h>
+
+#define CONVERT_CHUNK_SAMPLES 256
+
+// Converts Float32/Float64 input samples into the negotiated output format.
+// Planar formats convert as their interleaved twin; splitting the result
+// into planes is left to the caller (see planar.hpp).
+//
+// Kernels are chosen once in configure() (SSE2/AVX2 on x86, NEON on ARM64,
+// scalar elsewhere) so convert() is a single indirect call per span and is
+// safe to run on the RT thread.
+class SampleConverter {
+
+public:
+    SampleConverter();
+
+    static bool isInputFormat(spa_audio_format format);
+    static bool isSupported(spa_audio_format format);
+    static uint32_t sampleSize(spa_audio_format format);
+    static bool isPlanar(spa_audio_format format);
+    static spa_audio_format interleavedFormat(spa_audio_format format); // Planar -> same samples, interleaved
+
+    void configure(spa_audio_format inputFormat, spa_audio_format outputFormat, bool dither);
+    void convert(const uint8_t* source, uint8_t* dest, size_t samples);
+    void silence(uint8_t* dest, size_t samples);
+
+private:
+    using Kernel = void (*)(const float* source, uint8_t* dest, size_t samples);
+
+    spa_audio_format inputFormat;
+    spa_audio_format outputFormat;
+    Kernel kernel;
+
+    // TPDF dither amplitude in output LSBs; 0 disables dithering
+    float ditherScale;
+    uint32_t ditherSeed;
+
+    float scratch[CONVERT_CHUNK_SAMPLES];
+
+    void convertFloats(const float* source, uint8_t* dest, size_t samples);
+    void convertDoubles(const double* source, uint8_t* dest, size_t samples);
+    const float* dither(const float* source, size_t samples);
+};
+
+#endif // PIPEWIRE_SAMPLE_CONVERT_HPP
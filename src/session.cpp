@@ -1,16 +1,23 @@
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <napi.h>
 #include <pipewire/keys.h>
 #include <pipewire/pipewire.h>
+#include <pipewire/thread.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <unordered_map>
 
 #include "audio-output-stream.hpp"
+#include "pipewire.hpp"
 #include "promises.hpp"
 #include "session.hpp"
 
 using namespace std;
 
-Napi::FunctionReference PipeWireSession::constructor;
+bool getSampleView(const Napi::Value& value, spa_audio_format rawFormat, SampleView& view);
 void normalizeStreamProps(const Napi::Object& createOpts);
 void populateMediaProps(const Napi::Object& streamProps, const Napi::Value& maybeMedia);
 
@@ -24,19 +31,50 @@ Napi::Function PipeWireSession::init(const Napi::Env& env)
                 "start", napi_enumerable),
             InstanceMethod<&PipeWireSession::createAudioOutputStream>(
                 "createAudioOutputStream", napi_enumerable),
+            InstanceMethod<&PipeWireSession::createAudioInputStream>(
+                "createAudioInputStream", napi_enumerable),
+            InstanceMethod<&PipeWireSession::createAudioOutputStreams>(
+                "createAudioOutputStreams", napi_enumerable),
+            InstanceMethod<&PipeWireSession::connectStreams>(
+                "connectStreams", napi_enumerable),
+            InstanceMethod<&PipeWireSession::loadSample>(
+                "loadSample", napi_enumerable),
+            InstanceMethod<&PipeWireSession::unloadSample>(
+                "unloadSample", napi_enumerable),
             InstanceMethod<&PipeWireSession::destroy>(
                 "destroy", napi_enumerable),
+            InstanceAccessor(
+                "loops",
+                &PipeWireSession::getLoops,
+                NULL,
+                napi_enumerable),
         });
 
-    constructor = Napi::Persistent(ctor);
-    constructor.SuppressDestruct();
-
     return ctor;
 }
 
+SessionLoop::SessionLoop()
+    : loop(NULL)
+    , streams(0)
+    , cpu(-1)
+    , rtPriority(0)
+{
+}
+
+pw_loop* SessionLoop::getLoop()
+{
+    return pw_thread_loop_get_loop(loop);
+}
+
+void SessionLoop::withThreadLock(std::function<void()> fn)
+{
+    pw_thread_loop_lock(loop);
+    fn();
+    pw_thread_loop_unlock(loop);
+}
+
 PipeWireSession::PipeWireSession(const Napi::CallbackInfo& info)
     : Napi::ObjectWrap<PipeWireSession>(info)
-    , loop(NULL)
     , context(NULL)
     , core(NULL)
     , isStopping(false)
@@ -46,8 +84,12 @@ PipeWireSession::PipeWireSession(const Napi::CallbackInfo& info)
 PipeWireSession::~PipeWireSession()
 {
     // Only clean up if destroy() wasn't called (resources should already be null)
-    if (!isStopping && loop) {
-        pw_thread_loop_stop(loop);
+    if (!isStopping) {
+        for (auto& shard : loops) {
+            if (shard->loop) {
+                pw_thread_loop_stop(shard->loop);
+            }
+        }
     }
 
     if (core) {
@@ -56,21 +98,92 @@ PipeWireSession::~PipeWireSession()
     if (context) {
         pw_context_destroy(context);
     }
-    if (loop) {
-        pw_thread_loop_destroy(loop);
+    for (auto& shard : loops) {
+        if (shard->loop) {
+            pw_thread_loop_destroy(shard->loop);
+        }
     }
 }
 
 pw_loop* PipeWireSession::getLoop()
 {
-    return pw_thread_loop_get_loop(loop);
+    return loops[0]->getLoop();
 }
 
 void PipeWireSession::withThreadLock(std::function<void()> fn)
 {
-    pw_thread_loop_lock(loop);
-    fn();
-    pw_thread_loop_unlock(loop);
+    loops[0]->withThreadLock(fn);
+}
+
+SessionLoop* PipeWireSession::acquireLoop()
+{
+    // Ties go to the lowest index, so a lightly used session stays on one loop
+    SessionLoop* best = loops[0].get();
+    for (auto& shard : loops) {
+        if (shard->streams.load(std::memory_order_relaxed) < best->streams.load(std::memory_order_relaxed)) {
+            best = shard.get();
+        }
+    }
+    best->streams.fetch_add(1, std::memory_order_relaxed);
+    return best;
+}
+
+void PipeWireSession::releaseLoop(SessionLoop* loop)
+{
+    loop->streams.fetch_sub(1, std::memory_order_relaxed);
+}
+
+Napi::Value PipeWireSession::getLoops(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    auto result = Napi::Array::New(env, loops.size());
+    for (uint32_t i = 0; i < loops.size(); i++) {
+        auto entry = Napi::Object::New(env);
+        entry.Set("streams", loops[i]->streams.load(std::memory_order_relaxed));
+        result.Set(i, entry);
+    }
+    return result;
+}
+
+namespace {
+
+void pinToCpu(pthread_t thread, int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(thread, sizeof(set), &set);
+}
+
+// Runs on the loop thread, which has no other way to name itself
+int pinLoopThread(spa_loop*, bool, uint32_t, const void*, size_t, void* data)
+{
+    pinToCpu(pthread_self(), ((SessionLoop*)data)->cpu);
+    return 0;
+}
+
+} // namespace
+
+bool SessionLoop::configureDataThread(pthread_t thread)
+{
+    // Called from the stream's loop thread, never from the data thread
+    // itself: RTKit is a D-Bus round trip, and a process cycle waiting on it
+    // would underrun. Both calls act on another thread by its handle.
+    if (cpu >= 0) {
+        pinToCpu(thread, cpu);
+    }
+    // Goes through RTKit when the stream's context loaded module-rt
+    return rtPriority > 0 && pw_thread_utils_acquire_rt((spa_thread*)thread, rtPriority) >= 0;
+}
+
+void PipeWireSession::pinThread(SessionLoop* shard)
+{
+    // The loop thread only runs control calls, so it is pinned but keeps its
+    // normal priority. Blocks until the loop thread ran it; the loop lock
+    // must not be held.
+    if (shard->cpu >= 0) {
+        pw_loop_invoke(shard->getLoop(), pinLoopThread, 0, NULL, 0, true, shard);
+    }
 }
 
 uint32_t PipeWireSession::getFramesPerQuantum()
@@ -103,19 +216,69 @@ uint32_t PipeWireSession::getFramesPerQuantum()
 Napi::Value PipeWireSession::start(const Napi::CallbackInfo& info)
 {
     auto env = info.Env();
+
+    // start({ loops?, rtPriority?, cpus? })
+    uint32_t loopCount = 1;
+    int rtPriority = 0;
+    std::vector<uint32_t> cpus;
+    if (info[0].IsObject()) {
+        auto opts = info[0].As<Napi::Object>();
+        if (opts.Get("loops").IsNumber()) {
+            auto count = opts.Get("loops").As<Napi::Number>().DoubleValue();
+            if (!(count >= 1 && count <= MAX_SESSION_LOOPS) || count != (uint32_t)count) {
+                return rejected(Napi::RangeError::New(env, "loops must be a whole number from 1 to " + std::to_string(MAX_SESSION_LOOPS)));
+            }
+            loopCount = (uint32_t)count;
+        }
+        if (opts.Get("rtPriority").IsNumber()) {
+            auto priority = opts.Get("rtPriority").As<Napi::Number>().DoubleValue();
+            if (!(priority >= 1 && priority <= 99) || priority != (int)priority) {
+                return rejected(Napi::RangeError::New(env, "rtPriority must be a whole number from 1 to 99"));
+            }
+            rtPriority = (int)priority;
+        }
+        if (opts.Get("cpus").IsArray()) {
+            auto list = opts.Get("cpus").As<Napi::Array>();
+            for (uint32_t i = 0; i < list.Length(); i++) {
+                auto cpu = list.Get(i).ToNumber().DoubleValue();
+                if (!(cpu >= 0 && cpu < CPU_SETSIZE) || cpu != (uint32_t)cpu) {
+                    return rejected(Napi::RangeError::New(env, "cpus must be CPU numbers"));
+                }
+                cpus.push_back((uint32_t)cpu);
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < loopCount; i++) {
+        auto shard = std::make_unique<SessionLoop>();
+        shard->cpu = cpus.empty() ? -1 : (int)cpus[i % cpus.size()];
+        shard->rtPriority = rtPriority;
+        loops.push_back(std::move(shard));
+    }
+
     Ref(); // Keep object alive during async operation
 
     return async(
         env,
         [this]() {
-            spa_dict threadProps = {};
-            loop = pw_thread_loop_new("PipeWireSession", &threadProps);
+            for (uint32_t i = 0; i < loops.size(); i++) {
+                auto name = i ? "PipeWireSession." + std::to_string(i) : std::string("PipeWireSession");
+                spa_dict threadProps = {};
+                loops[i]->loop = pw_thread_loop_new(name.c_str(), &threadProps);
+            }
 
             withThreadLock([this]() {
-                pw_thread_loop_start(loop);
-                context = pw_context_new(pw_thread_loop_get_loop(loop), NULL, 0);
+                pw_thread_loop_start(loops[0]->loop);
+                context = pw_context_new(getLoop(), NULL, 0);
                 core = pw_context_connect(context, NULL, 0);
             });
+            for (uint32_t i = 1; i < loops.size(); i++) {
+                pw_thread_loop_start(loops[i]->loop);
+            }
+
+            for (auto& shard : loops) {
+                pinThread(shard.get());
+            }
         },
         [this, env]() {
             this->Unref(); // Release the reference taken at the start
@@ -127,12 +290,220 @@ Napi::Value PipeWireSession::createAudioOutputStream(const Napi::CallbackInfo& i
 {
     Napi::Object createOpts = info[0].As<Napi::Object>();
 
-    auto jsStream = AudioOutputStream::constructor.New({});
+    auto jsStream = PipeWireAddon::forEnv(info.Env())->streamConstructor.New({});
     auto stream = AudioOutputStream::Unwrap(jsStream);
 
     return stream->create(this, createOpts);
 }
 
+Napi::Value PipeWireSession::createAudioInputStream(const Napi::CallbackInfo& info)
+{
+    // Capture streams share the output stream's negotiation and ring; only
+    // the direction differs
+    Napi::Object createOpts = info[0].As<Napi::Object>();
+    createOpts.Set("direction", "input");
+
+    auto jsStream = PipeWireAddon::forEnv(info.Env())->streamConstructor.New({});
+    auto stream = AudioOutputStream::Unwrap(jsStream);
+
+    return stream->create(this, createOpts);
+}
+
+// Group streams by the loop they were placed on, so each loop is locked once
+static std::vector<std::pair<SessionLoop*, std::vector<AudioOutputStream*>>> byLoop(
+    const std::vector<AudioOutputStream*>& streams)
+{
+    std::vector<std::pair<SessionLoop*, std::vector<AudioOutputStream*>>> groups;
+    for (auto stream : streams) {
+        auto loop = stream->getSessionLoop();
+        auto group = std::find_if(groups.begin(), groups.end(), [loop](auto& entry) {
+            return entry.first == loop;
+        });
+        if (group == groups.end()) {
+            groups.push_back({ loop, {} });
+            group = groups.end() - 1;
+        }
+        group->second.push_back(stream);
+    }
+    return groups;
+}
+
+Napi::Value PipeWireSession::createAudioOutputStreams(const Napi::CallbackInfo& info)
+{
+    // createAudioOutputStreams([opts, ...]): every stream is validated up
+    // front, then one worker builds them all, locking each loop once
+    auto env = info.Env();
+    if (info.Length() == 0 || !info[0].IsArray()) {
+        return rejected(Napi::TypeError::New(env, "createAudioOutputStreams() requires an array of options"));
+    }
+
+    auto optsList = info[0].As<Napi::Array>();
+    std::vector<AudioOutputStream*> streams;
+    for (uint32_t i = 0; i < optsList.Length(); i++) {
+        if (!optsList.Get(i).IsObject()) {
+            for (auto stream : streams) {
+                stream->_destroy();
+            }
+            return rejected(Napi::TypeError::New(env, "Stream options must be objects"));
+        }
+
+        auto jsStream = PipeWireAddon::forEnv(env)->streamConstructor.New({});
+        auto stream = AudioOutputStream::Unwrap(jsStream);
+        if (auto error = stream->prepare(this, optsList.Get(i).As<Napi::Object>())) {
+            // Give back the loops and callbacks the earlier streams took
+            for (auto prepared : streams) {
+                prepared->_destroy();
+            }
+            return rejected(*error);
+        }
+        streams.push_back(stream);
+    }
+
+    // Held until the worker is done, as create() holds a single stream
+    for (auto stream : streams) {
+        stream->Ref();
+    }
+    return async(
+        env,
+        [this, streams]() {
+            auto quantum = getFramesPerQuantum();
+            for (auto stream : streams) {
+                stream->open(quantum);
+            }
+            for (auto& [loop, streamsOnLoop] : byLoop(streams)) {
+                auto& group = streamsOnLoop;
+                loop->withThreadLock([&group]() {
+                    for (auto stream : group) {
+                        stream->initStream();
+                    }
+                });
+            }
+        },
+        [env, streams]() {
+            auto result = Napi::Array::New(env, streams.size());
+            for (uint32_t i = 0; i < streams.size(); i++) {
+                streams[i]->Unref();
+                result.Set(i, streams[i]->Value());
+            }
+            return result;
+        });
+}
+
+Napi::Value PipeWireSession::connectStreams(const Napi::CallbackInfo& info)
+{
+    // connectStreams([{ stream, preferredFormats, preferredRates? }, ...])
+    auto env = info.Env();
+    if (info.Length() == 0 || !info[0].IsArray()) {
+        return rejected(Napi::TypeError::New(env, "connectStreams() requires an array of connect options"));
+    }
+
+    auto ctor = PipeWireAddon::forEnv(env)->streamConstructor.Value();
+    auto entries = info[0].As<Napi::Array>();
+    std::vector<AudioOutputStream*> streams;
+    std::vector<ConnectRequest> requests(entries.Length());
+    for (uint32_t i = 0; i < entries.Length(); i++) {
+        auto entry = entries.Get(i);
+        if (!entry.IsObject() || !entry.As<Napi::Object>().Get("stream").IsObject()
+            || !entry.As<Napi::Object>().Get("stream").As<Napi::Object>().InstanceOf(ctor)) {
+            return rejected(Napi::TypeError::New(env, "Each entry needs the stream to connect"));
+        }
+
+        auto options = entry.As<Napi::Object>();
+        auto stream = AudioOutputStream::Unwrap(options.Get("stream").As<Napi::Object>());
+        if (!stream->getSessionLoop()) {
+            return rejected(Napi::Error::New(env, "Cannot connect a destroyed stream"));
+        }
+        if (auto error = stream->prepareConnect(options, requests[i])) {
+            return rejected(*error);
+        }
+        streams.push_back(stream);
+    }
+
+    for (auto stream : streams) {
+        stream->Ref();
+    }
+    return async(
+        env,
+        [streams, requests]() {
+            std::unordered_map<AudioOutputStream*, const ConnectRequest*> requestOf;
+            for (size_t i = 0; i < streams.size(); i++) {
+                requestOf[streams[i]] = &requests[i];
+            }
+            for (auto& [loop, streamsOnLoop] : byLoop(streams)) {
+                auto& group = streamsOnLoop;
+                loop->withThreadLock([&group, &requestOf]() {
+                    for (auto stream : group) {
+                        stream->connectLocked(*requestOf[stream]);
+                    }
+                });
+            }
+        },
+        [env, streams]() {
+            for (auto stream : streams) {
+                stream->Unref();
+            }
+            return env.Undefined();
+        });
+}
+
+Napi::Value PipeWireSession::loadSample(const Napi::CallbackInfo& info)
+{
+    // loadSample(id, samples, { channels?, rate? })
+    auto env = info.Env();
+    SampleView view;
+    if (!info[0].IsString() || !getSampleView(info[1], SPA_AUDIO_FORMAT_F32, view)
+        || (view.format != SPA_AUDIO_FORMAT_F32 && view.format != SPA_AUDIO_FORMAT_F64)) {
+        Napi::TypeError::New(env, "loadSample() needs an id and a Float32Array or Float64Array")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    auto options = info[2].IsObject() ? info[2].As<Napi::Object>() : Napi::Object::New(env);
+    auto channels = options.Get("channels").IsNumber() ? options.Get("channels").As<Napi::Number>().Uint32Value() : 1;
+    auto rate = options.Get("rate").IsNumber() ? options.Get("rate").As<Napi::Number>().Uint32Value() : 0;
+    if (channels < 1 || channels > SAMPLE_CACHE_MAX_CHANNELS) {
+        Napi::RangeError::New(env, "Samples have 1 to " + std::to_string(SAMPLE_CACHE_MAX_CHANNELS) + " channels")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    auto count = view.size / (view.format == SPA_AUDIO_FORMAT_F64 ? sizeof(double) : sizeof(float));
+    if (count < channels || count % channels) {
+        Napi::RangeError::New(env, "Samples must be whole frames, at least one")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+
+    // Converted to the mixer's Float32 once, here, rather than on every play
+    auto sample = std::make_shared<CachedSample>();
+    sample->channels = channels;
+    sample->rate = rate;
+    sample->frames = count / channels;
+    if (view.format == SPA_AUDIO_FORMAT_F64) {
+        auto source = (const double*)view.data;
+        sample->samples.assign(source, source + count);
+    } else {
+        auto source = (const float*)view.data;
+        sample->samples.assign(source, source + count);
+    }
+    samples.store(info[0].As<Napi::String>().Utf8Value(), std::move(sample));
+    return env.Undefined();
+}
+
+Napi::Value PipeWireSession::unloadSample(const Napi::CallbackInfo& info)
+{
+    auto env = info.Env();
+    if (!info[0].IsString()) {
+        Napi::TypeError::New(env, "unloadSample() needs an id").ThrowAsJavaScriptException();
+        return env.Undefined();
+    }
+    return Napi::Boolean::New(env, samples.erase(info[0].As<Napi::String>().Utf8Value()));
+}
+
+std::shared_ptr<const CachedSample> PipeWireSession::findSample(const std::string& id)
+{
+    return samples.find(id);
+}
+
 Napi::Value PipeWireSession::destroy(const Napi::CallbackInfo& info)
 {
     auto env = info.Env();
@@ -142,10 +513,11 @@ Napi::Value PipeWireSession::destroy(const Napi::CallbackInfo& info)
     }
 
     isStopping = true;
+    samples.clear(); // Playing voices keep their own references
 
     return async(env, [this, env]() {
         // Clean up PipeWire resources in correct order with thread lock
-        if (loop) {
+        if (!loops.empty() && loops[0]->loop) {
             withThreadLock([this]() {
                 // 1. Disconnect the core interface first
                 if (core) {
@@ -160,10 +532,12 @@ Napi::Value PipeWireSession::destroy(const Napi::CallbackInfo& info)
                 }
             });
 
-            // 3. Stop and destroy the thread loop (outside the lock)
-            pw_thread_loop_stop(loop);
-            pw_thread_loop_destroy(loop);
-            loop = NULL;
+            // 3. Stop and destroy the thread loops (outside the lock)
+            for (auto& shard : loops) {
+                pw_thread_loop_stop(shard->loop);
+                pw_thread_loop_destroy(shard->loop);
+                shard->loop = NULL;
+            }
         }
 
         return env.Undefined();
@@ -1,31 +1,79 @@
 #ifndef PIPEWIRE_SESSION_HPP
 #define PIPEWIRE_SESSION_HPP
 
+#include <atomic>
+#include <memory>
 #include <napi.h>
 #include <pipewire/thread-loop.h>
+#include <pthread.h>
+#include <vector>
+
+#include "sample-cache.hpp"
+
+#define MAX_SESSION_LOOPS 64
+
+// One of a session's thread loops. A stream runs its control operations and
+// non-RT callbacks on the loop it was placed on, so streams on different
+// loops never contend for the same lock.
+//
+// Audio does not run here: under PW_STREAM_FLAG_RT_PROCESS each stream
+// processes on the data loop of its own context. Those threads take the
+// loop's cpu and rtPriority from configureDataThread().
+class SessionLoop {
+
+public:
+    SessionLoop();
+
+    void withThreadLock(std::function<void()> fn);
+    pw_loop* getLoop();
+    // Loop thread, once per stream; true when the thread got rtPriority
+    bool configureDataThread(pthread_t thread);
+
+    pw_thread_loop* loop;
+    std::atomic<uint32_t> streams; // Streams placed on this loop
+    int cpu; // The loop thread and its streams' data threads run here; -1 for no pinning
+    int rtPriority; // Requested for its streams' data threads; 0 leaves PipeWire's
+};
 
 class PipeWireSession : public Napi::ObjectWrap<PipeWireSession> {
 
 public:
-    static Napi::FunctionReference constructor;
     static Napi::Function init(const Napi::Env& env);
     PipeWireSession(const Napi::CallbackInfo& info);
     ~PipeWireSession();
 
     Napi::Value start(const Napi::CallbackInfo& info);
     Napi::Value destroy(const Napi::CallbackInfo& info);
+    Napi::Value getLoops(const Napi::CallbackInfo& info);
 
     void withThreadLock(std::function<void()> fn);
     pw_loop* getLoop();
     uint32_t getFramesPerQuantum();
 
+    // JS thread; the loop with the fewest streams. Release it when the
+    // stream is destroyed.
+    SessionLoop* acquireLoop();
+    void releaseLoop(SessionLoop* loop);
+
     Napi::Value createAudioOutputStream(const Napi::CallbackInfo& info);
+    Napi::Value createAudioInputStream(const Napi::CallbackInfo& info);
+    Napi::Value createAudioOutputStreams(const Napi::CallbackInfo& info);
+    Napi::Value connectStreams(const Napi::CallbackInfo& info);
+
+    Napi::Value loadSample(const Napi::CallbackInfo& info);
+    Napi::Value unloadSample(const Napi::CallbackInfo& info);
+    // JS thread; NULL when nothing is loaded under id
+    std::shared_ptr<const CachedSample> findSample(const std::string& id);
 
 private:
-    pw_thread_loop* loop;
+    // loops[0] also runs the session's own context and core
+    std::vector<std::unique_ptr<SessionLoop>> loops;
     pw_context* context;
     pw_core* core;
     volatile bool isStopping;
+    SampleCache samples; // Shared by every stream of the session
+
+    void pinThread(SessionLoop* loop);
 };
 
 #endif // PIPEWIRE_SESSION_HPP
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <atomic>
+
+#include "shared-ring.hpp"
+
+SharedRing::SharedRing()
+    : header(NULL)
+    , samples(NULL)
+    , capacityFrames(0)
+    , frameSize(0)
+{
+}
+
+const char* SharedRing::attach(uint8_t* memory, size_t size, uint32_t channels, uint32_t bytesPerSample)
+{
+    if (size < SHARED_RING_HEADER_BYTES || ((uintptr_t)memory % alignof(uint32_t)) != 0) {
+        return "sharedRing is too small to hold a ring header";
+    }
+
+    auto fields = (uint32_t*)memory;
+    auto capacity = fields[SHARED_RING_CAPACITY];
+    if (!capacity || (capacity & (capacity - 1))) {
+        return "sharedRing capacity must be a power of two";
+    }
+    if (fields[SHARED_RING_CHANNELS] != channels || fields[SHARED_RING_SAMPLE_BYTES] != bytesPerSample) {
+        return "sharedRing channel count or sample format does not match the stream";
+    }
+    if (size < SHARED_RING_HEADER_BYTES + (size_t)capacity * channels * bytesPerSample) {
+        return "sharedRing is smaller than its declared capacity";
+    }
+
+    header = fields;
+    samples = memory + SHARED_RING_HEADER_BYTES;
+    capacityFrames = capacity;
+    frameSize = channels * bytesPerSample;
+    return NULL;
+}
+
+bool SharedRing::isAttached() const
+{
+    return header != NULL;
+}
+
+uint32_t SharedRing::capacity() const
+{
+    return capacityFrames;
+}
+
+uint32_t SharedRing::readableFrames() const
+{
+    auto written = std::atomic_ref<uint32_t>(header[SHARED_RING_WRITE_INDEX]).load(std::memory_order_acquire);
+    auto read = std::atomic_ref<uint32_t>(header[SHARED_RING_READ_INDEX]).load(std::memory_order_acquire);
+    // Both indices live in memory JS can write. A producer claiming more
+    // than the ring holds has broken the protocol, so nothing it claims is
+    // read; peek() never spans past the end of the ring.
+    auto readable = written - read;
+    return readable <= capacityFrames ? readable : 0;
+}
+
+void SharedRing::publishRate(uint32_t rate)
+{
+    std::atomic_ref<uint32_t>(header[SHARED_RING_RATE]).store(rate, std::memory_order_release);
+}
+
+size_t SharedRing::peek(size_t size, RingSpans& spans)
+{
+    auto read = std::atomic_ref<uint32_t>(header[SHARED_RING_READ_INDEX]).load(std::memory_order_relaxed);
+    auto frames = std::min((uint32_t)(size / frameSize), readableFrames());
+
+    auto offset = read & (capacityFrames - 1);
+    auto firstPart = std::min(frames, capacityFrames - offset);
+    spans.parts[0] = { samples + (size_t)offset * frameSize, (size_t)firstPart * frameSize };
+    spans.parts[1] = { samples, (size_t)(frames - firstPart) * frameSize };
+    return (size_t)frames * frameSize;
+}
+
+void SharedRing::skip(size_t size)
+{
+    auto index = std::atomic_ref<uint32_t>(header[SHARED_RING_READ_INDEX]);
+    index.store(index.load(std::memory_order_relaxed) + size / frameSize, std::memory_order_release);
+}
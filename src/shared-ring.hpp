@@ -0,0 +1,47 @@
+#ifndef PIPEWIRE_SHARED_RING_HPP
+#define PIPEWIRE_SHARED_RING_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ring-buffer.hpp"
+
+// Layout shared with lib/shared-ring.mts. All header fields are 32-bit;
+// the indices are free-running frame counters that wrap at 2^32, which is
+// why the capacity must be a power of two.
+#define SHARED_RING_HEADER_BYTES 128
+#define SHARED_RING_WRITE_INDEX 0 // Producer cache line
+#define SHARED_RING_CAPACITY 1
+#define SHARED_RING_CHANNELS 2
+#define SHARED_RING_SAMPLE_BYTES 3
+#define SHARED_RING_READ_INDEX 16 // Consumer cache line
+#define SHARED_RING_RATE 17
+
+// Consumer view of a ring living in a SharedArrayBuffer that a JS worker
+// fills with Atomics. The RT thread reads it directly, so steady-state
+// playback needs no N-API calls.
+class SharedRing {
+
+public:
+    SharedRing();
+
+    // Validates the header written by JS; returns an error message or NULL
+    const char* attach(uint8_t* memory, size_t size, uint32_t channels, uint32_t bytesPerSample);
+    bool isAttached() const;
+
+    uint32_t capacity() const;
+    uint32_t readableFrames() const; // 0 when the indices claim more than the capacity
+    void publishRate(uint32_t rate);
+
+    // Consumer side; sizes are in bytes to match RingBuffer
+    size_t peek(size_t size, RingSpans& spans);
+    void skip(size_t size);
+
+private:
+    uint32_t* header;
+    uint8_t* samples;
+    uint32_t capacityFrames;
+    uint32_t frameSize;
+};
+
+#endif // PIPEWIRE_SHARED_RING_HPP
@@ -0,0 +1,56 @@
+#include "stream-clock.hpp"
+
+StreamClock::StreamClock()
+    : sequence(0)
+    , cycle(0)
+    , nowNs(0)
+    , rateNum(0)
+    , rateDenom(0)
+    , ticks(0)
+    , delay(0)
+    , buffered(0)
+    , queued(0)
+    , renderStart(0)
+{
+}
+
+void StreamClock::publish(const ClockSample& sample)
+{
+    auto start = sequence.load(std::memory_order_relaxed);
+    sequence.store(start + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    cycle.store(cycle.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    nowNs.store(sample.nowNs, std::memory_order_relaxed);
+    rateNum.store(sample.rateNum, std::memory_order_relaxed);
+    rateDenom.store(sample.rateDenom, std::memory_order_relaxed);
+    ticks.store(sample.ticks, std::memory_order_relaxed);
+    delay.store(sample.delay, std::memory_order_relaxed);
+    buffered.store(sample.buffered, std::memory_order_relaxed);
+    queued.store(sample.queued, std::memory_order_relaxed);
+    renderStart.store(sample.renderStart, std::memory_order_relaxed);
+    sequence.store(start + 2, std::memory_order_release);
+}
+
+bool StreamClock::read(ClockSample& sample) const
+{
+    for (;;) {
+        auto before = sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        sample.cycle = cycle.load(std::memory_order_relaxed);
+        sample.nowNs = nowNs.load(std::memory_order_relaxed);
+        sample.rateNum = rateNum.load(std::memory_order_relaxed);
+        sample.rateDenom = rateDenom.load(std::memory_order_relaxed);
+        sample.ticks = ticks.load(std::memory_order_relaxed);
+        sample.delay = delay.load(std::memory_order_relaxed);
+        sample.buffered = buffered.load(std::memory_order_relaxed);
+        sample.queued = queued.load(std::memory_order_relaxed);
+        sample.renderStart = renderStart.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before) {
+            return sample.cycle != 0;
+        }
+    }
+}
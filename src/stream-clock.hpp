@@ -0,0 +1,71 @@
+#ifndef PIPEWIRE_STREAM_CLOCK_HPP
+#define PIPEWIRE_STREAM_CLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+
+// What pw_stream_get_time_n() reported during one process cycle, plus where
+// the render timeline stood when that cycle started
+struct ClockSample {
+    uint64_t cycle; // Cycles sampled so far; 0 until the first one
+    int64_t nowNs; // CLOCK_MONOTONIC when PipeWire took its time values
+    uint32_t rateNum; // Graph clock: one tick lasts rateNum / rateDenom seconds
+    uint32_t rateDenom;
+    uint64_t ticks;
+    int64_t delay; // Ticks until this cycle's first frame reaches the device
+    uint64_t buffered; // Frames held in PipeWire's converter or resampler
+    uint64_t queued; // Frames queued in the stream but not yet consumed
+    uint64_t renderStart; // Render position of this cycle's first frame
+};
+
+// A clock sample resolved against the render timeline: frame renderStart
+// is heard at startNs and later frames follow at the source rate
+struct PlaybackTiming {
+    ClockSample sample;
+    uint64_t rendered; // Render position when the sample was read
+    uint32_t ringFrames; // Written but not yet rendered
+    uint32_t sourceRate;
+    double latencyNs; // From leaving the stream to reaching the device
+    double startNs;
+
+    double frameAt(double ns) const
+    {
+        return (double)sample.renderStart + (ns - startNs) * sourceRate / 1e9;
+    }
+
+    double timeOf(double frame) const
+    {
+        return startNs + (frame - (double)sample.renderStart) * 1e9 / sourceRate;
+    }
+};
+
+// The latest pw_stream_get_time_n() reading, taken by the RT thread in
+// every process callback and published under a sequence counter (a seqlock)
+// as LevelMeter does. Sampling inside the callback ties PipeWire's times to
+// the exact frames the cycle rendered, so JS can extrapolate the play
+// position to any moment without timing callbacks itself.
+class StreamClock {
+
+public:
+    StreamClock();
+
+    // RT thread
+    void publish(const ClockSample& sample);
+
+    // JS thread; returns false before the first cycle
+    bool read(ClockSample& sample) const;
+
+private:
+    std::atomic<uint32_t> sequence; // Odd while a sample is being published
+    std::atomic<uint64_t> cycle;
+    std::atomic<int64_t> nowNs;
+    std::atomic<uint32_t> rateNum;
+    std::atomic<uint32_t> rateDenom;
+    std::atomic<uint64_t> ticks;
+    std::atomic<int64_t> delay;
+    std::atomic<uint64_t> buffered;
+    std::atomic<uint64_t> queued;
+    std::atomic<uint64_t> renderStart;
+};
+
+#endif // PIPEWIRE_STREAM_CLOCK_HPP
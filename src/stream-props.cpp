@@ -0,0 +1,174 @@
+#include <cstring>
+#include <spa/param/props.h>
+#include <spa/pod/iter.h>
+#include <spa/pod/parser.h>
+
+#include "stream-props.hpp"
+
+namespace {
+
+PropsParam toParam(const spa_pod* pod)
+{
+    PropsParam param = { PropsParam::UNSUPPORTED, 0.0, false, {} };
+    if (spa_pod_is_int(pod)) {
+        int32_t value;
+        spa_pod_get_int(pod, &value);
+        param.type = PropsParam::NUMBER;
+        param.number = value;
+    } else if (spa_pod_is_float(pod)) {
+        float value;
+        spa_pod_get_float(pod, &value);
+        param.type = PropsParam::NUMBER;
+        param.number = value;
+    } else if (spa_pod_is_bool(pod)) {
+        bool value;
+        spa_pod_get_bool(pod, &value);
+        param.type = PropsParam::BOOLEAN;
+        param.boolean = value;
+    } else if (spa_pod_is_string(pod)) {
+        const char* value;
+        spa_pod_get_string(pod, &value);
+        param.type = PropsParam::STRING;
+        param.text = value;
+    }
+    return param;
+}
+
+template <typename T>
+void copyArray(const spa_pod* pod, std::vector<T>& dest)
+{
+    uint32_t count;
+    auto values = (const T*)spa_pod_get_array(pod, &count);
+    dest.assign(values, values + (values ? count : 0));
+}
+
+void copyBool(const spa_pod* pod, std::optional<bool>& dest)
+{
+    bool value;
+    if (spa_pod_get_bool(pod, &value) >= 0) {
+        dest = value;
+    }
+}
+
+template <typename Array, typename T>
+Array toTypedArray(Napi::Env env, const std::vector<T>& values)
+{
+    auto array = Array::New(env, values.size());
+    if (!values.empty()) {
+        memcpy(array.Data(), values.data(), values.size() * sizeof(T));
+    }
+    return array;
+}
+
+} // namespace
+
+void StreamProps::update(const spa_pod* param)
+{
+    if (!param || !spa_pod_is_object(param)) {
+        return;
+    }
+
+    // Keys missing from this change keep their previous values
+    std::lock_guard lock(mutex);
+    const spa_pod_prop* prop;
+    SPA_POD_OBJECT_FOREACH((const spa_pod_object*)param, prop)
+    {
+        auto value = &prop->value;
+        switch (prop->key) {
+        case SPA_PROP_volume: {
+            float volume;
+            if (spa_pod_get_float(value, &volume) >= 0) {
+                this->volume = volume;
+            }
+        } break;
+        case SPA_PROP_mute:
+            copyBool(value, mute);
+            break;
+        case SPA_PROP_monitorMute:
+            copyBool(value, monitorMute);
+            break;
+        case SPA_PROP_softMute:
+            copyBool(value, softMute);
+            break;
+        case SPA_PROP_channelVolumes:
+            copyArray(value, channelVolumes);
+            break;
+        case SPA_PROP_channelMap:
+            copyArray(value, channelMap);
+            break;
+        case SPA_PROP_monitorVolumes:
+            copyArray(value, monitorVolumes);
+            break;
+        case SPA_PROP_softVolumes:
+            copyArray(value, softVolumes);
+            break;
+        case SPA_PROP_params: {
+            std::vector<std::pair<std::string, PropsParam>> parsed;
+            spa_pod_parser parser;
+            spa_pod_frame frame;
+            spa_pod_parser_pod(&parser, value);
+            spa_pod_parser_push_struct(&parser, &frame);
+            while (true) {
+                const char* name;
+                if (spa_pod_parser_get_string(&parser, &name) < 0) {
+                    break;
+                }
+                spa_pod* pod;
+                if (spa_pod_parser_get_pod(&parser, &pod) < 0) {
+                    break;
+                }
+                parsed.emplace_back(name, toParam(pod));
+            }
+            params = std::move(parsed);
+        } break;
+        default:
+            // Unhandled prop - silently ignore
+            break;
+        }
+    }
+}
+
+Napi::Object StreamProps::toObject(Napi::Env env)
+{
+    auto result = Napi::Object::New(env);
+    std::lock_guard lock(mutex);
+
+    if (volume) {
+        result.Set("volume", *volume);
+    }
+    if (mute) {
+        result.Set("mute", *mute);
+    }
+    if (monitorMute) {
+        result.Set("monitorMute", *monitorMute);
+    }
+    if (softMute) {
+        result.Set("softMute", *softMute);
+    }
+    result.Set("channelVolumes", toTypedArray<Napi::Float32Array>(env, channelVolumes));
+    result.Set("channelMap", toTypedArray<Napi::Uint32Array>(env, channelMap));
+    result.Set("monitorVolumes", toTypedArray<Napi::Float32Array>(env, monitorVolumes));
+    result.Set("softVolumes", toTypedArray<Napi::Float32Array>(env, softVolumes));
+
+    if (params) {
+        auto paramsObj = Napi::Object::New(env);
+        for (auto& [name, param] : *params) {
+            switch (param.type) {
+            case PropsParam::NUMBER:
+                paramsObj.Set(name, param.number);
+                break;
+            case PropsParam::BOOLEAN:
+                paramsObj.Set(name, param.boolean);
+                break;
+            case PropsParam::STRING:
+                paramsObj.Set(name, param.text);
+                break;
+            default:
+                paramsObj.Set(name, env.Undefined());
+                break;
+            }
+        }
+        result.Set("params", paramsObj);
+    }
+    return result;
+}
@@ -0,0 +1,49 @@
+#ifndef PIPEWIRE_STREAM_PROPS_HPP
+#define PIPEWIRE_STREAM_PROPS_HPP
+
+#include <mutex>
+#include <napi.h>
+#include <optional>
+#include <spa/pod/pod.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A value in the Props params struct
+struct PropsParam {
+    enum { NUMBER, BOOLEAN, STRING, UNSUPPORTED } type;
+    double number;
+    bool boolean;
+    std::string text;
+};
+
+// A stream's Props as PipeWire last reported them.
+//
+// Each props change is merged into a plain C++ snapshot on the loop thread,
+// under a mutex that only the loop thread and the JS thread take. JS builds
+// an object from the snapshot only when it is read, so a burst of changes
+// (someone dragging a volume slider) costs one object instead of one tree
+// per change. Per-channel values are delivered as typed arrays.
+class StreamProps {
+
+public:
+    // Loop thread
+    void update(const spa_pod* param);
+
+    // JS thread
+    Napi::Object toObject(Napi::Env env);
+
+private:
+    std::mutex mutex;
+    std::optional<float> volume;
+    std::optional<bool> mute;
+    std::optional<bool> monitorMute;
+    std::optional<bool> softMute;
+    std::vector<float> channelVolumes;
+    std::vector<uint32_t> channelMap;
+    std::vector<float> monitorVolumes;
+    std::vector<float> softVolumes;
+    std::optional<std::vector<std::pair<std::string, PropsParam>>> params;
+};
+
+#endif // PIPEWIRE_STREAM_PROPS_HPP
@@ -0,0 +1,113 @@
+#include <bit>
+
+#include "stream-stats.hpp"
+
+namespace {
+
+inline void bump(std::atomic<uint64_t>& counter, uint64_t amount)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+} // namespace
+
+StreamStats::StreamStats()
+    : cycles(0)
+    , requestedFrames(0)
+    , deliveredFrames(0)
+    , producedFrames(0)
+    , zeroFilledFrames(0)
+    , underruns(0)
+    , dequeueFailures(0)
+    , slowCycles(0)
+    , maxDurationNs(0)
+    , totalDurationNs(0)
+    , wakeups(0)
+    , maxWakeupNs(0)
+    , totalWakeupNs(0)
+    , playing(false)
+    , pendingSilence(0)
+{
+    for (auto& bucket : durationHistogram) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+bool StreamStats::recordCycle(uint32_t requested, uint32_t delivered, uint32_t produced)
+{
+    bump(cycles, 1);
+    bump(requestedFrames, requested);
+    bump(deliveredFrames, delivered);
+    bump(producedFrames, produced);
+
+    // A gap is only an underrun once audio resumes after it; the silence
+    // after the last write of a stream is not a dropout
+    auto underran = false;
+    if (produced > 0) {
+        if (pendingSilence > 0) {
+            bump(underruns, 1);
+            bump(zeroFilledFrames, pendingSilence);
+            pendingSilence = 0;
+            underran = true;
+        }
+        playing = true;
+    }
+    if (playing && produced < delivered) {
+        pendingSilence += delivered - produced;
+    }
+    return underran;
+}
+
+void StreamStats::recordDuration(uint64_t durationNs, uint64_t budgetNs)
+{
+    auto micros = durationNs / 1000;
+    auto bucket = micros ? std::bit_width(micros) - 1 : 0;
+    if (bucket >= STATS_DURATION_BUCKETS) {
+        bucket = STATS_DURATION_BUCKETS - 1;
+    }
+    bump(durationHistogram[bucket], 1);
+    bump(totalDurationNs, durationNs);
+
+    if (durationNs > maxDurationNs.load(std::memory_order_relaxed)) {
+        maxDurationNs.store(durationNs, std::memory_order_relaxed);
+    }
+    if (budgetNs && durationNs > budgetNs) {
+        bump(slowCycles, 1);
+    }
+}
+
+void StreamStats::recordDequeueFailure()
+{
+    bump(dequeueFailures, 1);
+}
+
+void StreamStats::recordWakeup(uint64_t latencyNs)
+{
+    bump(wakeups, 1);
+    bump(totalWakeupNs, latencyNs);
+    if (latencyNs > maxWakeupNs.load(std::memory_order_relaxed)) {
+        maxWakeupNs.store(latencyNs, std::memory_order_relaxed);
+    }
+}
+
+StreamStatsSnapshot StreamStats::snapshot() const
+{
+    StreamStatsSnapshot snapshot;
+    snapshot.cycles = cycles.load(std::memory_order_relaxed);
+    snapshot.requestedFrames = requestedFrames.load(std::memory_order_relaxed);
+    snapshot.deliveredFrames = deliveredFrames.load(std::memory_order_relaxed);
+    snapshot.producedFrames = producedFrames.load(std::memory_order_relaxed);
+    snapshot.zeroFilledFrames = zeroFilledFrames.load(std::memory_order_relaxed);
+    snapshot.underruns = underruns.load(std::memory_order_relaxed);
+    snapshot.dequeueFailures = dequeueFailures.load(std::memory_order_relaxed);
+    snapshot.slowCycles = slowCycles.load(std::memory_order_relaxed);
+    snapshot.maxDurationNs = maxDurationNs.load(std::memory_order_relaxed);
+    snapshot.totalDurationNs = totalDurationNs.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < STATS_DURATION_BUCKETS; i++) {
+        snapshot.durationHistogram[i] = durationHistogram[i].load(std::memory_order_relaxed);
+    }
+    snapshot.wakeups = wakeups.load(std::memory_order_relaxed);
+    snapshot.maxWakeupNs = maxWakeupNs.load(std::memory_order_relaxed);
+    snapshot.totalWakeupNs = totalWakeupNs.load(std::memory_order_relaxed);
+    return snapshot;
+}
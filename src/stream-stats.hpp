@@ -0,0 +1,75 @@
+#ifndef PIPEWIRE_STREAM_STATS_HPP
+#define PIPEWIRE_STREAM_STATS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Bucket i counts process callbacks that took [2^i, 2^(i+1)) microseconds;
+// the first bucket also takes anything faster and the last anything slower
+#define STATS_DURATION_BUCKETS 16
+
+// Monotonic nanoseconds; a vDSO read, so safe on the RT thread
+inline int64_t steadyNanos()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+struct StreamStatsSnapshot {
+    uint64_t cycles;
+    uint64_t requestedFrames; // What PipeWire asked for
+    uint64_t deliveredFrames; // What we handed back, silence included
+    uint64_t producedFrames; // Delivered frames that came from JS
+    uint64_t zeroFilledFrames;
+    uint64_t underruns;
+    uint64_t dequeueFailures;
+    uint64_t slowCycles; // Callbacks that took longer than the audio they delivered
+    uint64_t maxDurationNs;
+    uint64_t totalDurationNs;
+    uint64_t durationHistogram[STATS_DURATION_BUCKETS];
+    uint64_t wakeups; // waitForBuffer() promises resolved by the RT thread
+    uint64_t maxWakeupNs;
+    uint64_t totalWakeupNs;
+};
+
+// Counters for one stream. Each counter has a single writer (the RT thread,
+// or the JS thread for wakeups), so updates are plain relaxed load/store
+// pairs rather than locked read-modify-writes; snapshots may be taken from
+// the JS thread at any time.
+class StreamStats {
+
+public:
+    StreamStats();
+
+    // RT thread
+    bool recordCycle(uint32_t requested, uint32_t delivered, uint32_t produced); // True on an underrun
+    void recordDuration(uint64_t durationNs, uint64_t budgetNs);
+    void recordDequeueFailure();
+
+    // JS thread
+    void recordWakeup(uint64_t latencyNs);
+    StreamStatsSnapshot snapshot() const;
+
+private:
+    std::atomic<uint64_t> cycles;
+    std::atomic<uint64_t> requestedFrames;
+    std::atomic<uint64_t> deliveredFrames;
+    std::atomic<uint64_t> producedFrames;
+    std::atomic<uint64_t> zeroFilledFrames;
+    std::atomic<uint64_t> underruns;
+    std::atomic<uint64_t> dequeueFailures;
+    std::atomic<uint64_t> slowCycles;
+    std::atomic<uint64_t> maxDurationNs;
+    std::atomic<uint64_t> totalDurationNs;
+    std::atomic<uint64_t> durationHistogram[STATS_DURATION_BUCKETS];
+    std::atomic<uint64_t> wakeups;
+    std::atomic<uint64_t> maxWakeupNs;
+    std::atomic<uint64_t> totalWakeupNs;
+
+    // RT thread only
+    bool playing;
+    uint64_t pendingSilence; // Zero-filled since audio last played
+};
+
+#endif // PIPEWIRE_STREAM_STATS_HPP
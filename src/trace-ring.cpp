@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <bit>
+
+#include "trace-ring.hpp"
+
+TraceRing::TraceRing()
+    : capacity(0)
+    , head(0)
+{
+}
+
+void TraceRing::configure(uint32_t requested)
+{
+    capacity = std::bit_ceil(std::clamp<uint32_t>(requested, TRACE_MIN_RECORDS, TRACE_MAX_RECORDS));
+    slots = std::make_unique<Slot[]>(capacity);
+    head.store(0, std::memory_order_relaxed);
+}
+
+bool TraceRing::isEnabled() const
+{
+    return capacity != 0;
+}
+
+void TraceRing::record(const TraceRecord& record)
+{
+    if (!capacity) {
+        return;
+    }
+
+    auto ticket = head.fetch_add(1, std::memory_order_relaxed);
+    auto& slot = slots[ticket & (capacity - 1)];
+    slot.sequence.store(ticket * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.startNs.store(record.startNs, std::memory_order_relaxed);
+    slot.durationNs.store(record.durationNs, std::memory_order_relaxed);
+    slot.kind.store(record.kind, std::memory_order_relaxed);
+    slot.requested.store(record.requested, std::memory_order_relaxed);
+    slot.delivered.store(record.delivered, std::memory_order_relaxed);
+    slot.produced.store(record.produced, std::memory_order_relaxed);
+    slot.queued.store(record.queued, std::memory_order_relaxed);
+    slot.detail.store(record.detail, std::memory_order_relaxed);
+    slot.flags.store(record.flags, std::memory_order_relaxed);
+    slot.sequence.store(ticket * 2 + 2, std::memory_order_release);
+}
+
+uint64_t TraceRing::read(std::vector<TraceRecord>& records) const
+{
+    if (!capacity) {
+        return 0;
+    }
+
+    // Oldest first; tickets older than one lap have been overwritten
+    auto end = head.load(std::memory_order_acquire);
+    auto begin = end > capacity ? end - capacity : 0;
+    uint64_t lost = begin;
+    records.reserve(records.size() + (size_t)(end - begin));
+
+    for (auto ticket = begin; ticket < end; ticket++) {
+        auto& slot = slots[ticket & (capacity - 1)];
+        auto before = slot.sequence.load(std::memory_order_acquire);
+        if (before != ticket * 2 + 2) {
+            lost += before > ticket * 2 + 2; // Lapped while we read; a record still being written is not lost
+            continue;
+        }
+
+        TraceRecord record;
+        record.startNs = slot.startNs.load(std::memory_order_relaxed);
+        record.durationNs = slot.durationNs.load(std::memory_order_relaxed);
+        record.kind = slot.kind.load(std::memory_order_relaxed);
+        record.requested = slot.requested.load(std::memory_order_relaxed);
+        record.delivered = slot.delivered.load(std::memory_order_relaxed);
+        record.produced = slot.produced.load(std::memory_order_relaxed);
+        record.queued = slot.queued.load(std::memory_order_relaxed);
+        record.detail = slot.detail.load(std::memory_order_relaxed);
+        record.flags = slot.flags.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before) {
+            lost++;
+            continue;
+        }
+        records.push_back(record);
+    }
+    return lost;
+}
@@ -0,0 +1,78 @@
+#ifndef PIPEWIRE_TRACE_RING_HPP
+#define PIPEWIRE_TRACE_RING_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#define TRACE_MIN_RECORDS 256
+#define TRACE_MAX_RECORDS (1u << 20)
+
+// What a trace record describes
+#define TRACE_CYCLE 0 // A process callback (RT thread)
+#define TRACE_WRITE 1 // A write(), writePlanar() or commit() call (JS thread)
+#define TRACE_WAKEUP 2 // A waitForBuffer() the RT thread resolved, from signal to resolve
+#define TRACE_GC 3 // A garbage collection pause, reported by JS
+
+// Flags on cycle records
+#define TRACE_UNDERRUN (1u << 0) // Audio resumed after a gap
+#define TRACE_SLOW (1u << 1) // The callback took longer than the audio it delivered
+
+// Fields a record leaves out are 0
+struct TraceRecord {
+    int64_t startNs = 0; // steady_clock, i.e. CLOCK_MONOTONIC
+    uint64_t durationNs = 0;
+    uint32_t kind = 0;
+    uint32_t requested = 0; // Cycles: frames PipeWire asked for; writes: frames offered
+    uint32_t delivered = 0; // Cycles: frames handed back; writes: frames accepted; wakeups: frames free
+    uint32_t produced = 0; // Cycles: delivered frames that were real audio
+    uint32_t queued = 0; // Frames queued in the ring afterwards
+    uint32_t detail = 0; // Cycles: WAKE_* events raised; GC: the V8 GC kind
+    uint32_t flags = 0;
+};
+
+// A fixed-size, overwriting log of individual cycles and the JS calls around
+// them, for finding the one bad cycle that aggregate stats average away.
+//
+// Both the RT thread and the JS thread append, so each record claims a
+// ticket with a single fetch_add and is published under its own sequence
+// number (a per-slot seqlock), as LevelMeter publishes whole windows. The
+// writer never waits; a reader skips any slot that is being rewritten.
+// Nothing is allocated after configure(), and tracing is opt-in because even
+// a wait-free append is a few cache lines of traffic per cycle.
+class TraceRing {
+
+public:
+    TraceRing();
+
+    // JS thread, before the RT thread can record
+    void configure(uint32_t capacity); // TRACE_MIN_RECORDS to TRACE_MAX_RECORDS, rounded up to a power of two
+    bool isEnabled() const;
+
+    // Any thread
+    void record(const TraceRecord& record);
+
+    // JS thread; returns how many records were overwritten before they could be read
+    uint64_t read(std::vector<TraceRecord>& records) const;
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence; // 2 * ticket + 1 while writing, + 2 once written
+        std::atomic<int64_t> startNs;
+        std::atomic<uint64_t> durationNs;
+        std::atomic<uint32_t> kind;
+        std::atomic<uint32_t> requested;
+        std::atomic<uint32_t> delivered;
+        std::atomic<uint32_t> produced;
+        std::atomic<uint32_t> queued;
+        std::atomic<uint32_t> detail;
+        std::atomic<uint32_t> flags;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    uint32_t capacity;
+    std::atomic<uint64_t> head; // Next ticket
+};
+
+#endif // PIPEWIRE_TRACE_RING_HPP
@@ -0,0 +1,80 @@
+#include "wakeup-channel.hpp"
+
+WakeupChannel::WakeupChannel()
+    : armed(0)
+    , subscribed(0)
+    , pending(0)
+{
+}
+
+void WakeupChannel::open(Napi::Env env, const char* name, Handler handler)
+{
+    this->handler = std::move(handler);
+    signal = Napi::ThreadSafeFunction::New(
+        env,
+        Napi::Function::New(env, [this](const Napi::CallbackInfo& info) {
+            // Take everything raised so far; events raised from here on queue
+            // a fresh call, so none are lost
+            auto events = pending.exchange(0, std::memory_order_acq_rel);
+            events &= armed.load(std::memory_order_acquire) | subscribed.load(std::memory_order_acquire);
+            if (events) {
+                this->handler(info.Env(), events);
+            }
+        }),
+        name, 0, 1);
+    signal.Unref(env);
+}
+
+void WakeupChannel::arm(Napi::Env env, uint32_t events)
+{
+    if (!signal) {
+        return;
+    }
+    auto previous = armed.fetch_or(events, std::memory_order_acq_rel);
+    if (!previous) {
+        signal.Ref(env);
+    }
+}
+
+void WakeupChannel::disarm(Napi::Env env, uint32_t events)
+{
+    if (!signal) {
+        return;
+    }
+    auto previous = armed.fetch_and(~events, std::memory_order_acq_rel);
+    if (previous && !(previous & ~events)) {
+        signal.Unref(env);
+    }
+}
+
+void WakeupChannel::subscribe(uint32_t events)
+{
+    subscribed.fetch_or(events, std::memory_order_acq_rel);
+}
+
+bool WakeupChannel::isArmed(uint32_t events) const
+{
+    return armed.load(std::memory_order_acquire) & events;
+}
+
+uint32_t WakeupChannel::notify(uint32_t events)
+{
+    events &= armed.load(std::memory_order_acquire) | subscribed.load(std::memory_order_acquire);
+    if (!events) {
+        return 0;
+    }
+    if (!pending.fetch_or(events, std::memory_order_acq_rel)) {
+        signal.NonBlockingCall();
+    }
+    return events;
+}
+
+void WakeupChannel::close()
+{
+    armed.store(0, std::memory_order_release);
+    subscribed.store(0, std::memory_order_release);
+    if (signal) {
+        signal.Release();
+        signal = nullptr;
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef PIPEWIRE_WAKEUP_CHANNEL_HPP
+#define PIPEWIRE_WAKEUP_CHANNEL_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <napi.h>
+
+// Events a stream can wake JavaScript for; one bit each
+#define WAKE_BUFFER (1u << 0) // Space freed for write()
+#define WAKE_DATA (1u << 1) // Captured frames ready for read()
+#define WAKE_MIXER (1u << 2) // Space freed in mixer inputs
+#define WAKE_FINISHED (1u << 3) // Playback drained
+#define WAKE_DISCONNECTED (1u << 4) // Stream reached the unconnected state
+#define WAKE_BUFFER_ADJUSTED (1u << 5) // Adaptive buffering resized the buffer
+#define WAKE_QUANTUM_CHANGED (1u << 6) // The graph cycle size or rate changed
+#define WAKE_LEVELS (1u << 7) // The level meter published a reading
+#define WAKE_PROPS (1u << 8) // PipeWire reported new Props
+#define WAKE_INPUT_ENDED (1u << 9) // A file, scheduled clip or voice played to its end
+
+// One long-lived, coalescing RT -> JS notification per stream.
+//
+// JS arms the events it is waiting for. The RT thread raises events into a
+// pending word and queues a call on the ThreadSafeFunction (itself a
+// uv_async) only when the word was empty, so however many cycles and events
+// happen before the JS thread runs, it is woken once and handles them all
+// together. The function is only referenced while something is armed, so an
+// idle stream does not keep the event loop alive; subscribed events are
+// delivered whenever they happen but never hold the loop open.
+class WakeupChannel {
+
+public:
+    using Handler = std::function<void(Napi::Env env, uint32_t events)>;
+
+    WakeupChannel();
+
+    // JS thread
+    void open(Napi::Env env, const char* name, Handler handler);
+    void arm(Napi::Env env, uint32_t events);
+    void disarm(Napi::Env env, uint32_t events);
+    void subscribe(uint32_t events);
+
+    // Any thread
+    bool isArmed(uint32_t events) const;
+    uint32_t notify(uint32_t events); // Returns the events JS will hear about
+    void close();
+
+private:
+    Napi::ThreadSafeFunction signal;
+    Handler handler;
+    std::atomic<uint32_t> armed; // Events JS is waiting for
+    std::atomic<uint32_t> subscribed; // Events JS always wants, unreferenced
+    std::atomic<uint32_t> pending; // Raised but not yet delivered to JS
+};
+
+#endif // PIPEWIRE_WAKEUP_CHANNEL_HPP